@@ -0,0 +1,164 @@
+#include "AddressFormatter.h"
+#include <QStringList>
+#include <QVector>
+
+AddressFormatter::AddressFormatter(std::size_t capacity)
+    : capacity(capacity == 0 ? 1 : capacity)
+{
+}
+
+const QString &AddressFormatter::format(const IpAddress &address)
+{
+    auto it = index.find(address);
+    if (it != index.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    entries.emplace_front(address, toText(address));
+    index.emplace(address, entries.begin());
+    return entries.front().second;
+}
+
+void AddressFormatter::clear()
+{
+    entries.clear();
+    index.clear();
+}
+
+QString AddressFormatter::toText(const IpAddress &address)
+{
+    if (address.isV4()) {
+        const std::uint32_t v = address.v4();
+        return QString("%1.%2.%3.%4").arg(v >> 24).arg((v >> 16) & 0xff).arg((v >> 8) & 0xff).arg(v & 0xff);
+    }
+
+    std::uint16_t groups[8];
+    for (int i = 0; i < 4; ++i) {
+        groups[i] = static_cast<std::uint16_t>(address.hi >> (48 - i * 16));
+        groups[i + 4] = static_cast<std::uint16_t>(address.lo >> (48 - i * 16));
+    }
+
+    // 最长的连续零组 (至少两组) 压缩为 "::"
+    int bestStart = -1;
+    int bestLen = 0;
+    for (int i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            ++i;
+            continue;
+        }
+        int j = i;
+        while (j < 8 && groups[j] == 0) {
+            ++j;
+        }
+        if (j - i > bestLen && j - i >= 2) {
+            bestStart = i;
+            bestLen = j - i;
+        }
+        i = j;
+    }
+    QString text;
+    for (int i = 0; i < 8; ++i) {
+        if (i == bestStart) {
+            text += "::";
+            i += bestLen - 1;
+            continue;
+        }
+        if (!text.isEmpty() && !text.endsWith(':')) {
+            text += ':';
+        }
+        text += QString::number(groups[i], 16);
+    }
+    return text;
+}
+
+bool AddressFormatter::parse(const QString &text, IpAddress &out)
+{
+    const QString s = text.trimmed();
+    if (!s.contains(':')) {
+        const QStringList parts = s.split('.');
+        if (parts.size() != 4) {
+            return false;
+        }
+        std::uint32_t v = 0;
+        for (const QString &part : parts) {
+            bool ok = false;
+            const uint octet = part.toUInt(&ok);
+            if (!ok || octet > 255) {
+                return false;
+            }
+            v = (v << 8) | octet;
+        }
+        out = IpAddress::fromV4(v);
+        return true;
+    }
+
+    // IPv6: 最多一个 "::", 每组1-4位十六进制
+    const int gap = s.indexOf("::");
+    if (gap >= 0 && s.indexOf("::", gap + 1) >= 0) {
+        return false;
+    }
+    auto parseGroups = [](const QString &part, QVector<std::uint16_t> &groups) {
+        if (part.isEmpty()) {
+            return true;
+        }
+        for (const QString &g : part.split(':')) {
+            bool ok = false;
+            const uint v = g.toUInt(&ok, 16);
+            if (!ok || g.size() > 4) {
+                return false;
+            }
+            groups.append(static_cast<std::uint16_t>(v));
+        }
+        return true;
+    };
+    QVector<std::uint16_t> head;
+    QVector<std::uint16_t> tail;
+    if (gap >= 0) {
+        if (!parseGroups(s.left(gap), head) || !parseGroups(s.mid(gap + 2), tail)
+            || head.size() + tail.size() > 7) {
+            return false;
+        }
+    } else if (!parseGroups(s, head) || head.size() != 8) {
+        return false;
+    }
+    std::uint16_t groups[8] = {};
+    for (int i = 0; i < head.size(); ++i) {
+        groups[i] = head[i];
+    }
+    for (int i = 0; i < tail.size(); ++i) {
+        groups[8 - tail.size() + i] = tail[i];
+    }
+    out = IpAddress();
+    for (int i = 0; i < 4; ++i) {
+        out.hi = (out.hi << 16) | groups[i];
+        out.lo = (out.lo << 16) | groups[i + 4];
+    }
+    return true;
+}
+
+bool AddressFormatter::parseCidr(const QString &text, IpAddress &prefix, int &prefixLen)
+{
+    const QString s = text.trimmed();
+    const int slash = s.indexOf('/');
+    IpAddress address;
+    if (!parse(slash < 0 ? s : s.left(slash), address)) {
+        return false;
+    }
+    const int maxLen = address.isV4() ? 32 : 128;
+    int len = maxLen;
+    if (slash >= 0) {
+        bool ok = false;
+        len = s.mid(slash + 1).toInt(&ok);
+        if (!ok || len < 0 || len > maxLen) {
+            return false;
+        }
+    }
+    prefixLen = address.isV4() ? len + 96 : len;
+    prefix = address.masked(prefixLen);
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef ADDRESSFORMATTER_H
+#define ADDRESSFORMATTER_H
+
+#include "IpAddress.h"
+#include <QString>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// 地址的文本格式化, 带一个小的LRU缓存。不能跨线程共用: 界面线程为可见行使用, 输出端的写线程各用一个
+class AddressFormatter
+{
+public:
+    explicit AddressFormatter(std::size_t capacity = 4096);
+
+    const QString &format(const IpAddress &address);
+    void clear();
+
+    static QString toText(const IpAddress &address);
+    // 解析IPv4点分或IPv6文本
+    static bool parse(const QString &text, IpAddress &out);
+    // 解析 "地址" 或 "地址/前缀", 前缀统一换算成128位长度
+    static bool parseCidr(const QString &text, IpAddress &prefix, int &prefixLen);
+
+private:
+    using Entry = std::pair<IpAddress, QString>;
+
+    std::size_t capacity;
+    std::list<Entry> entries; // 最近使用的在前
+    std::unordered_map<IpAddress, std::list<Entry>::iterator, IpAddressHash> index;
+};
+
+#endif // ADDRESSFORMATTER_H
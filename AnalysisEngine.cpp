@@ -0,0 +1,953 @@
+#include "AnalysisEngine.h"
+#include "Checkpoint.h"
+#include "Checksum.h"
+#include "DissectorRegistry.h"
+#include "FlowTable.h"
+#include "FragmentReassembler.h"
+#include "GeoDatabase.h"
+#include "HttpScanner.h"
+#include "LiveCaptureSource.h"
+#include "MemoryBudget.h"
+#include "MergedPacketSource.h"
+#include "PacketSampler.h"
+#include "ParallelPcapSource.h"
+#include "PcapFileSource.h"
+#include "OutputSink.h"
+#include "PcapRingWriter.h"
+#include "ScanDetector.h"
+#include "SubnetGroupMap.h"
+#include <QFileInfo>
+#include <QStringList>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// 每批最多的行数和最长的攒批时间
+constexpr int kBatchRows = 512;
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+// 分组流量矩阵按分组数平方增长, 不必每次刷新都发送
+constexpr auto kGroupMatrixInterval = std::chrono::seconds(1);
+// 每次推进流超时最多结束的流数
+constexpr std::size_t kFlowExpiryBudget = 8;
+// 小文件单线程就很快, 不值得启动线程池
+constexpr std::size_t kParallelDecodeMinBytes = 64 * 1024 * 1024;
+
+AppProtocol classifyByPort(std::uint8_t l4Proto, std::uint16_t port)
+{
+    switch (port) {
+    case 80:
+    case 8080:
+        return l4Proto == ProtoTcp ? AppProtocol::Http : AppProtocol::None;
+    case 443:
+        return AppProtocol::Https;
+    case 20:
+    case 21:
+        return l4Proto == ProtoTcp ? AppProtocol::Ftp : AppProtocol::None;
+    case 22:
+        return l4Proto == ProtoTcp ? AppProtocol::Ssh : AppProtocol::None;
+    case 53:
+        return AppProtocol::Dns;
+    default:
+        return AppProtocol::None;
+    }
+}
+
+AppProtocol classify(const DecodedPacket &pkt)
+{
+    AppProtocol app = classifyByPort(pkt.l4Proto, pkt.dstPort);
+    if (app == AppProtocol::None) {
+        app = classifyByPort(pkt.l4Proto, pkt.srcPort);
+    }
+    return app;
+}
+
+QString httpDescription(const HttpMetadata &http)
+{
+    QString text;
+    if (http.isRequest) {
+        text = QString("%1 %2%3")
+                   .arg(QString::fromLatin1(http.method.data(), static_cast<int>(http.method.size())))
+                   .arg(QString::fromLatin1(http.host.data(), static_cast<int>(http.host.size())))
+                   .arg(QString::fromLatin1(http.uri.data(), static_cast<int>(http.uri.size())));
+    } else {
+        text = QString("HTTP %1").arg(http.statusCode);
+    }
+    if (http.contentLength >= 0) {
+        text += QString(" (%1 字节)").arg(http.contentLength);
+    }
+    return text;
+}
+
+QString tlsDescription(const TlsClientHello &tls)
+{
+    QString text = QString("加密Web %1").arg(TlsParser::versionName(tls.maxSupportedVersion));
+    if (!tls.sni.empty()) {
+        text += " " + QString::fromStdString(tls.sni);
+    }
+    if (!tls.alpn.empty()) {
+        QStringList protocols;
+        for (const std::string &p : tls.alpn) {
+            protocols << QString::fromStdString(p);
+        }
+        text += " [" + protocols.join(',') + "]";
+    }
+    text += QString(" JA3=%1 JA4=%2")
+                .arg(QString::fromStdString(tls.ja3Hash))
+                .arg(QString::fromStdString(tls.ja4));
+    return text;
+}
+
+QString trafficType(AppProtocol app)
+{
+    // 固定标签共享同一份字符串数据, 不为每行分配
+    static const QString web = "Web浏览";
+    static const QString encryptedWeb = "加密Web";
+    static const QString fileTransfer = "文件传输";
+    static const QString remoteLogin = "远程登录";
+    static const QString nameResolution = "域名解析";
+    static const QString other = "其他";
+    switch (app) {
+    case AppProtocol::Http: return web;
+    case AppProtocol::Https: return encryptedWeb;
+    case AppProtocol::Ftp: return fileTransfer;
+    case AppProtocol::Ssh: return remoteLogin;
+    case AppProtocol::Dns: return nameResolution;
+    case AppProtocol::None: break;
+    }
+    return other;
+}
+
+// 协议过滤条件在启动和换用新配置时解析, 逐包只比较整数
+struct ProtocolFilter
+{
+    enum Kind { All, Tcp, Udp, App, Plugin } kind = All;
+    AppProtocol app = AppProtocol::None;
+    std::uint8_t dissector = 0;
+
+    // 内置协议名之外, 还可以是协议解析插件的协议名
+    ProtocolFilter(const QString &text, const DissectorRegistry *dissectors)
+    {
+        if (text == "TCP") {
+            kind = Tcp;
+        } else if (text == "UDP") {
+            kind = Udp;
+        } else {
+            for (AppProtocol p : {AppProtocol::Http, AppProtocol::Https, AppProtocol::Ftp,
+                                  AppProtocol::Ssh, AppProtocol::Dns}) {
+                if (protocolName(0, p) == text) {
+                    kind = App;
+                    app = p;
+                }
+            }
+            if (kind == All && dissectors != nullptr) {
+                dissector = static_cast<std::uint8_t>(dissectors->findProtocol(text));
+                kind = dissector != 0 ? Plugin : All;
+            }
+        }
+    }
+
+    // packetDissector 为认领这个包的插件编号加一
+    bool matches(const DecodedPacket &pkt, AppProtocol packetApp, std::uint8_t packetDissector) const
+    {
+        switch (kind) {
+        case Tcp: return pkt.l4Proto == ProtoTcp;
+        case Udp: return pkt.l4Proto == ProtoUdp;
+        case App: return packetApp == app;
+        case Plugin: return packetDissector == dissector;
+        case All: break;
+        }
+        return true;
+    }
+};
+
+// 应用层协议对应的吞吐量曲线, 没有单独曲线时返回 -1
+int throughputSeries(AppProtocol app)
+{
+    switch (app) {
+    case AppProtocol::Http: return SeriesHttp;
+    case AppProtocol::Https: return SeriesHttps;
+    case AppProtocol::Dns: return SeriesDns;
+    case AppProtocol::Ssh: return SeriesSsh;
+    case AppProtocol::Ftp: return SeriesFtp;
+    case AppProtocol::None: break;
+    }
+    return -1;
+}
+
+void countChecksum(TrafficStats &stats, const DecodedPacket &pkt, const Checksum::Result &result, quint32 weight)
+{
+    if (result.ip == Checksum::Status::Bad) {
+        stats.badIpChecksums += weight;
+    }
+    if (result.l4 == Checksum::Status::Bad) {
+        if (pkt.l4Proto == ProtoTcp) {
+            stats.badTcpChecksums += weight;
+        } else {
+            stats.badUdpChecksums += weight;
+        }
+    }
+    if (result.ip == Checksum::Status::Offloaded || result.l4 == Checksum::Status::Offloaded) {
+        stats.offloadedChecksums += weight;
+    }
+}
+
+// 95%置信区间的半宽
+double errorBound(double variance)
+{
+    return 1.96 * std::sqrt(variance);
+}
+
+} // namespace
+
+AnalysisEngine::AnalysisEngine(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QVector<ResultRow>>("QVector<ResultRow>");
+    qRegisterMetaType<TrafficStats>("TrafficStats");
+    qRegisterMetaType<QVector<ThroughputSample>>("QVector<ThroughputSample>");
+    qRegisterMetaType<QVector<SecurityAlert>>("QVector<SecurityAlert>");
+    qRegisterMetaType<GroupTrafficMatrix>("GroupTrafficMatrix");
+    qRegisterMetaType<QVector<FlowSummary>>("QVector<FlowSummary>");
+}
+
+AnalysisEngine::~AnalysisEngine()
+{
+    stop();
+}
+
+namespace {
+
+int resolveDecodeThreads(int requested)
+{
+    if (requested > 0) {
+        return requested;
+    }
+    // 分析线程和索引线程各占一个核
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::min(std::max(cores - 2, 1), 16);
+}
+
+// 存在的文件按离线抓包文件处理, 否则视为网络接口名。decodeThreads 大于1且文件足够大时并行解码
+std::unique_ptr<PacketSource> openSource(const QString &source, int decodeThreads, const AnalysisOptions &options,
+                                         QString *error)
+{
+    if (QFileInfo(source).isFile()) {
+        auto file = std::make_unique<PcapFileSource>();
+        file->setReadMode(options.fileReadMode);
+        if (!file->open(source, error)) {
+            return nullptr;
+        }
+        // 压缩文件和逐块读取时数据所在的缓冲区循环使用, 不能交给解码线程池
+        if (decodeThreads > 1 && file->isMapped() && file->fileSize() >= kParallelDecodeMinBytes) {
+            return std::make_unique<ParallelPcapSource>(std::move(file), decodeThreads, options.config.validateChecksums);
+        }
+        return file;
+    }
+    auto live = std::make_unique<LiveCaptureSource>();
+    if (!live->open(source, error)) {
+        return nullptr;
+    }
+    return live;
+}
+
+} // namespace
+
+bool AnalysisEngine::start(const QString &source, const AnalysisOptions &options, QString *error)
+{
+    stop();
+
+    // 多个数据源用分号分隔, 各自在读线程中读取后按时间戳合并
+    QStringList names;
+    for (const QString &part : source.split(';')) {
+        if (!part.trimmed().isEmpty()) {
+            names.append(part.trimmed());
+        }
+    }
+    if (names.size() > MergedPacketSource::kMaxInputs) {
+        if (error != nullptr) {
+            *error = QString("最多同时分析 %1 个数据源").arg(MergedPacketSource::kMaxInputs);
+        }
+        return false;
+    }
+    // 多个数据源已经各占一个读线程, 只有单个文件时才并行解码
+    const int decodeThreads = names.size() == 1 ? resolveDecodeThreads(options.decodeThreads) : 1;
+    std::vector<std::unique_ptr<PacketSource>> inputs;
+    for (const QString &name : names) {
+        std::unique_ptr<PacketSource> input = openSource(name, decodeThreads, options, error);
+        if (!input) {
+            return false;
+        }
+        inputs.push_back(std::move(input));
+    }
+    if (inputs.empty()) {
+        if (error != nullptr) {
+            *error = "没有指定数据源";
+        }
+        return false;
+    }
+    std::unique_ptr<PacketSource> packetSource;
+    if (inputs.size() == 1) {
+        packetSource = std::move(inputs.front());
+    } else {
+        packetSource = std::make_unique<MergedPacketSource>(std::move(inputs));
+    }
+
+    // 录制目录在这里就检查, 不可写时不开始分析
+    std::unique_ptr<PcapRingWriter> recorder;
+    if (!options.record.directory.isEmpty()) {
+        recorder = std::make_unique<PcapRingWriter>();
+        if (!recorder->open(options.record, error)) {
+            return false;
+        }
+    }
+
+    // 检查点在分析线程中读取, 写线程在这里启动; 第一段写成功之前不会改动已有的文件
+    std::unique_ptr<CheckpointWriter> checkpoint;
+    if (!options.checkpoint.path.isEmpty()) {
+        checkpoint = std::make_unique<CheckpointWriter>();
+        if (!checkpoint->open(options.checkpoint.path, error)) {
+            return false;
+        }
+    }
+
+    // 输出端也在这里打开, 导出目录不可写等错误时不开始分析; 套接字的对端可以之后再出现
+    std::unique_ptr<OutputFanout> outputs;
+    if (!options.outputs.isEmpty()) {
+        outputs = std::make_unique<OutputFanout>();
+        if (!outputs->open(options.outputs, error)) {
+            return false;
+        }
+    }
+
+    engineConfig.publish(std::make_unique<const EngineConfig>(options.config));
+    stopRequested = false;
+    running = true;
+    worker = std::thread(&AnalysisEngine::run, this, std::move(packetSource), std::move(recorder),
+                         std::move(checkpoint), std::move(outputs), names.join(';'), options);
+    return true;
+}
+
+void AnalysisEngine::stop()
+{
+    stopRequested = true;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    running = false;
+}
+
+bool AnalysisEngine::isRunning() const
+{
+    return running;
+}
+
+void AnalysisEngine::setGeoDatabase(std::shared_ptr<const GeoDatabase> database)
+{
+    std::atomic_store(&geoDatabase, std::move(database));
+}
+
+void AnalysisEngine::setSubnetGroups(std::shared_ptr<const SubnetGroupMap> groups)
+{
+    std::atomic_store(&subnetGroups, std::move(groups));
+}
+
+void AnalysisEngine::setDissectors(std::shared_ptr<const DissectorRegistry> registry)
+{
+    std::atomic_store(&dissectorRegistry, std::move(registry));
+}
+
+void AnalysisEngine::setConfig(const EngineConfig &config)
+{
+    engineConfig.publish(std::make_unique<const EngineConfig>(config));
+}
+
+void AnalysisEngine::run(std::unique_ptr<PacketSource> source, std::unique_ptr<PcapRingWriter> recorder,
+                         std::unique_ptr<CheckpointWriter> checkpoint, std::unique_ptr<OutputFanout> outputs,
+                         QString sourceName, AnalysisOptions options)
+{
+    // 配置快照只在刷新时检查是否有新的, 逐包处理读取 config 不加锁
+    SnapshotCell<EngineConfig>::Reader configReader(engineConfig);
+    const EngineConfig *config = &configReader.acquire();
+    // 并行解码线程按开始时的设置计算校验和, 中途开启时改在这里计算
+    const bool prefetchedChecksums = options.config.validateChecksums;
+
+    emit logMessage(QString("HTTP头部扫描实现: %1").arg(HttpScanner::implementationName()));
+    if (config->validateChecksums) {
+        emit logMessage(QString("校验和验证已开启, 实现: %1").arg(Checksum::implementationName()));
+    }
+    if (auto *parallel = dynamic_cast<const ParallelPcapSource *>(source.get())) {
+        emit logMessage(QString("并行解码: %1 个线程").arg(parallel->threadCount()));
+    } else if (auto *file = dynamic_cast<const PcapFileSource *>(source.get())) {
+        if (file->codec() != DecompressionStream::Codec::None) {
+            emit logMessage(QString("边解压边分析, 压缩格式: %1").arg(DecompressionStream::codecName(file->codec())));
+        } else if (file->readMode() == FileReadMode::IoUring) {
+            emit logMessage(QString("文件读取: io_uring预读"));
+        } else if (file->readMode() == FileReadMode::Buffered) {
+            emit logMessage(QString("文件读取: 普通读取"));
+        }
+    }
+
+    if (recorder) {
+        emit logMessage(QString("录制数据包到 %1%2")
+                            .arg(options.record.directory, options.record.filteredOnly ? " (只录制符合过滤条件的包)" : ""));
+    }
+    const bool recordAll = recorder && !options.record.filteredOnly;
+    const bool recordFiltered = recorder && options.record.filteredOnly;
+    bool recordErrorLogged = false;
+    QString recordBackend; // 写线程打开第一个文件后才确定
+
+    // 连续输出的逐包记录不受结果表内存预算限制, 单独攒一批
+    const bool outputPackets = outputs && outputs->wants(OutputPackets);
+    QVector<ResultRow> outputRows;
+    QString outputError;
+    if (outputs) {
+        emit logMessage(QString("连续输出到 %1 个目的地").arg(options.outputs.size()));
+    }
+
+    // 插件在整个分析过程中不变, 设置页换用新的插件目录时下一次分析才生效
+    std::unique_ptr<DissectorDispatcher> plugins;
+    if (std::shared_ptr<const DissectorRegistry> registry = std::atomic_load(&dissectorRegistry)) {
+        plugins = std::make_unique<DissectorDispatcher>(std::move(registry));
+        QStringList names;
+        for (int i = 0; i < plugins->registry().size(); ++i) {
+            names.append(plugins->registry().at(i).name);
+        }
+        emit logMessage(QString("协议解析插件: %1").arg(names.join(", ")));
+    }
+    const DissectorRegistry *dissectors = plugins ? &plugins->registry() : nullptr;
+
+    QVector<ResultRow> batch;
+    batch.reserve(kBatchRows);
+    ProtocolFilter filter(config->protocolFilter, dissectors);
+    TrafficStats stats;
+    stats.checksumsValidated = config->validateChecksums;
+    stats.sources.resize(source->inputCount());
+    for (int i = 0; i < stats.sources.size(); ++i) {
+        stats.sources[i].name = source->inputName(i);
+    }
+    int lastProgress = -1;
+    auto lastFlush = std::chrono::steady_clock::now();
+    QVector<ThroughputSample> samples;
+    ThroughputSample currentSecond;
+    bool haveSecond = false;
+    QVector<SecurityAlert> alerts;
+    ScanDetector scanDetector;
+    std::shared_ptr<const GeoDatabase> geo = std::atomic_load(&geoDatabase);
+    bool reassemble = config->fragmentMemoryLimit > 0;
+    FragmentReassembler fragments(static_cast<std::size_t>(config->fragmentMemoryLimit));
+    std::uint64_t lastPacketNs = 0;
+    std::shared_ptr<const SubnetGroupMap> groups;
+    GroupTrafficMatrix groupTraffic;
+    bool groupTrafficDirty = false;
+    auto lastGroupEmit = std::chrono::steady_clock::now();
+    auto reloadGroups = [&]() {
+        std::shared_ptr<const SubnetGroupMap> current = std::atomic_load(&subnetGroups);
+        if (current == groups) {
+            return;
+        }
+        groups = std::move(current);
+        groupTraffic = GroupTrafficMatrix();
+        if (groups) {
+            const int n = groups->names().size();
+            groupTraffic.groups = groups->names();
+            groupTraffic.bytes.fill(0, n * n);
+            groupTraffic.packets.fill(0, n * n);
+        }
+        groupTrafficDirty = true; // 分组被关闭时也发送一次空矩阵
+    };
+    reloadGroups();
+    FlowTable flows(config->flowIdleTimeoutNs, config->flowActiveTimeoutNs);
+    QVector<FlowSummary> expiredFlows;
+    MemoryBudget &budget = MemoryBudget::global();
+    quint64 batchBytes = 0; // 已接收但还没交给结果表记账的结果行
+    const bool sampling = options.samplingMode != SamplingMode::Off && options.samplingRate > 1;
+    PacketSampler sampler(sampling ? options.samplingRate : 1, options.samplingMode == SamplingMode::Adaptive,
+                          options.samplingPerFlow,
+                          static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    // 估计值的方差: 每个保留的包贡献 N(N-1); 按流采样时同一条流的包一起进出样本,
+    // 第 c 个包贡献 N(N-1)(2c-1), 累计起来是 N(N-1)c^2
+    double tcpVariance = 0;
+    double udpVariance = 0;
+    double httpVariance = 0;
+
+    // 检查点: 引擎自己保留一份吞吐量历史, 完整段写它, 增量段只写新结束的整秒。
+    // 每次分析重新计数的部分 (分片、未建表的包、数据源丢包) 从检查点继续时加在 resumed 上
+    std::unique_ptr<ThroughputHistory> checkpointHistory;
+    QVector<ThroughputSample> checkpointSamples;
+    TrafficStats resumed;
+    resumed.sources.resize(stats.sources.size());
+    std::uint64_t skipPackets = 0;
+    auto lastCheckpoint = std::chrono::steady_clock::now();
+    const auto checkpointInterval = std::chrono::seconds(std::max<quint32>(options.checkpoint.intervalSeconds, 1));
+    QString checkpointError;
+    if (checkpoint) {
+        checkpointHistory = std::make_unique<ThroughputHistory>();
+    }
+    if (checkpoint && options.checkpoint.resume) {
+        CheckpointState saved;
+        QString loadError;
+        if (!Checkpoint::load(options.checkpoint.path, saved, &loadError)) {
+            emit logMessage("没有从检查点继续: " + loadError);
+        } else if (saved.source != sourceName) {
+            emit logMessage(QString("检查点的数据源是 %1, 与本次不同, 从头开始分析").arg(saved.source));
+        } else {
+            const QVector<SourceStats> inputs = stats.sources;
+            stats = saved.stats;
+            stats.checksumsValidated = config->validateChecksums;
+            if (stats.sources.size() != inputs.size()) {
+                stats.sources = inputs;
+            }
+            resumed = stats;
+            std::size_t restoredFlows = 0;
+            for (const FlowSnapshot &flow : saved.flows) {
+                if (!flows.restore(flow)) {
+                    break; // 内存预算不够时只恢复一部分
+                }
+                ++restoredFlows;
+            }
+            scanDetector.sourceTable().restore(saved.scanSourceState, saved.scanSources);
+            scanDetector.targetTable().restore(saved.scanTargetState, saved.scanTargets);
+            if (groups && saved.groupTraffic.groups == groupTraffic.groups) {
+                groupTraffic = saved.groupTraffic;
+                groupTrafficDirty = true;
+            }
+            *checkpointHistory = std::move(saved.history);
+            haveSecond = saved.haveSecond;
+            currentSecond = saved.currentSecond;
+            lastPacketNs = saved.lastPacketNs;
+            tcpVariance = saved.tcpVariance;
+            udpVariance = saved.udpVariance;
+            httpVariance = saved.httpVariance;
+            // 离线文件按顺序重读, 已经计入统计的数据包跳过; 实时抓包直接接着计数
+            skipPackets = source->isLive() ? 0 : saved.stats.total;
+            emit logMessage(QString("从检查点继续: %1 个包, %2 条流%3")
+                                .arg(stats.total)
+                                .arg(restoredFlows)
+                                .arg(skipPackets > 0 ? QString(", 跳过已分析的 %1 个数据包").arg(skipPackets) : QString()));
+        }
+    }
+    if (checkpoint) {
+        flows.setChangeTracking(true);
+        scanDetector.sourceTable().setChangeTracking(true);
+        scanDetector.targetTable().setChangeTracking(true);
+    }
+
+    // 只收集上一段以来的变化, 交给写线程编码写盘; 上一段还没写完时跳过这一次
+    auto saveCheckpoint = [&](bool final) {
+        if (final) {
+            checkpoint->waitIdle();
+        } else if (checkpoint->isBusy()) {
+            return;
+        }
+        auto segment = std::make_unique<CheckpointSegment>();
+        segment->full = checkpoint->wantsFull();
+        segment->source = sourceName;
+        segment->stats = stats;
+        segment->lastPacketNs = lastPacketNs;
+        segment->tcpVariance = tcpVariance;
+        segment->udpVariance = udpVariance;
+        segment->httpVariance = httpVariance;
+        segment->haveSecond = haveSecond;
+        segment->currentSecond = currentSecond;
+        segment->groupTraffic = groupTraffic;
+        flows.takeChanges(segment->full, segment->flows, segment->removedFlows);
+        ScanStateTable &scanSources = scanDetector.sourceTable();
+        ScanStateTable &scanTargets = scanDetector.targetTable();
+        scanSources.takeChanges(segment->full, segment->scanSourceSlots, segment->scanSourceEntries);
+        scanTargets.takeChanges(segment->full, segment->scanTargetSlots, segment->scanTargetEntries);
+        segment->scanSourceState = scanSources.state();
+        segment->scanTargetState = scanTargets.state();
+        if (segment->full) {
+            checkpointHistory->save(segment->history);
+        } else {
+            segment->samples = checkpointSamples;
+        }
+        checkpointSamples.clear();
+        checkpoint->submit(std::move(segment));
+        lastCheckpoint = std::chrono::steady_clock::now();
+
+        const QString writeError = checkpoint->errorString();
+        if (!writeError.isEmpty() && writeError != checkpointError) {
+            emit logMessage("检查点写入失败: " + writeError);
+        }
+        checkpointError = writeError;
+    };
+
+    // 换用新发布的配置快照。缩短的超时在流的定时器下一次到期时生效
+    auto applyConfig = [&]() {
+        config = &configReader.acquire();
+        filter = ProtocolFilter(config->protocolFilter, dissectors);
+        stats.checksumsValidated = config->validateChecksums;
+        reassemble = config->fragmentMemoryLimit > 0;
+        fragments.setMemoryLimit(static_cast<std::size_t>(config->fragmentMemoryLimit));
+        flows.setTimeouts(config->flowIdleTimeoutNs, config->flowActiveTimeoutNs);
+        emit logMessage(QString("已应用新的分析配置: 协议过滤 %1, 校验和验证%2, 分片重组内存 %3 MB, 流空闲超时 %4 秒")
+                            .arg(config->protocolFilter.isEmpty() ? QString("全部") : config->protocolFilter)
+                            .arg(config->validateChecksums ? "开启" : "关闭")
+                            .arg(config->fragmentMemoryLimit / (1024 * 1024))
+                            .arg(config->flowIdleTimeoutNs / 1000000000));
+    };
+
+    // 结束时的最后一次刷新不受矩阵发送间隔限制
+    auto flush = [&](bool final = false) {
+        // 交给各输出端的队列, 不等待写出; 最后一次刷新时等它们写完
+        if (outputs) {
+            outputs->publish(outputRows, expiredFlows, alerts);
+            outputRows.clear();
+            if (final) {
+                outputs->close();
+            }
+            const OutputSink::Stats outputStats = outputs->stats();
+            stats.outputting = true;
+            stats.outputRecords = outputStats.written;
+            stats.outputDrops = outputStats.dropped;
+            stats.outputBacklog = outputStats.backlog;
+            const QString writeError = outputs->errorString();
+            if (!writeError.isEmpty() && writeError != outputError) {
+                emit logMessage("输出失败: " + writeError);
+            }
+            outputError = writeError;
+        }
+        if (!batch.isEmpty()) {
+            emit rowsReady(batch);
+            batch.clear();
+            batchBytes = 0;
+        }
+        if (!samples.isEmpty()) {
+            emit throughputReady(samples);
+            samples.clear();
+        }
+        if (!alerts.isEmpty()) {
+            stats.alerts += static_cast<quint64>(alerts.size());
+            emit alertsRaised(alerts);
+            alerts.clear();
+        }
+        if (!expiredFlows.isEmpty()) {
+            emit flowsExpired(expiredFlows);
+            expiredFlows.clear();
+        }
+        stats.scanStateEvictions = scanDetector.evictions();
+        for (int i = 0; i < stats.sources.size(); ++i) {
+            stats.sources[i].dropped = resumed.sources[i].dropped + source->inputDrops(i);
+            stats.sources[i].late = resumed.sources[i].late + source->inputLatePackets(i);
+        }
+        stats.untrackedPackets = resumed.untrackedPackets + flows.untrackedPackets();
+        if (plugins) {
+            stats.dissectors = plugins->stats();
+        }
+        if (recorder) {
+            if (source->isLive()) {
+                recorder->flushPending();
+            }
+            const PcapRingWriter::Stats recordStats = recorder->takeStats();
+            stats.recording = true;
+            stats.recordedPackets = recordStats.packets;
+            stats.recordedBytes = recordStats.bytes;
+            stats.recordDrops = recordStats.dropped;
+            stats.recordBacklogBytes = recordStats.backlogBytes;
+            stats.recordLatencyUs = recordStats.maxLatencyUs;
+            stats.recordFiles = recordStats.files;
+            if (recordBackend.isEmpty()) {
+                recordBackend = recorder->backendName();
+                if (!recordBackend.isEmpty()) {
+                    emit logMessage("录制写入方式: " + recordBackend);
+                }
+            }
+            if (!recordErrorLogged && !recorder->errorString().isEmpty()) {
+                emit logMessage("录制已停止: " + recorder->errorString());
+                recordErrorLogged = true;
+            }
+        }
+        if (sampling) {
+            if (sampler.adjust(source->backlog())) {
+                emit logMessage(QString("采样率调整为 1/%1").arg(sampler.rate()));
+            }
+            stats.samplingRate = sampler.rate();
+            stats.tcpError = errorBound(tcpVariance);
+            stats.udpError = errorBound(udpVariance);
+            stats.httpError = errorBound(httpVariance);
+        }
+        if (reassemble) {
+            fragments.expire(lastPacketNs);
+            const FragmentStats &fragmentStats = fragments.stats();
+            stats.fragmentsReassembled = resumed.fragmentsReassembled + fragmentStats.reassembled;
+            stats.fragmentTimeouts = resumed.fragmentTimeouts + fragmentStats.timedOut;
+            stats.fragmentDrops = resumed.fragmentDrops + fragmentStats.overlaps + fragmentStats.invalid
+                                  + fragmentStats.memoryDrops;
+        }
+        geo = std::atomic_load(&geoDatabase);
+        if (configReader.stale()) {
+            applyConfig();
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (groupTrafficDirty && (final || now - lastGroupEmit >= kGroupMatrixInterval)) {
+            emit groupTrafficUpdated(groupTraffic);
+            groupTrafficDirty = false;
+            lastGroupEmit = now;
+        }
+        reloadGroups();
+        if (checkpoint && !final && now - lastCheckpoint >= checkpointInterval) {
+            saveCheckpoint(false);
+        }
+        emit statsUpdated(stats);
+        const int percent = source->progress();
+        if (percent != lastProgress) {
+            lastProgress = percent;
+            emit progressChanged(percent);
+        }
+        lastFlush = std::chrono::steady_clock::now();
+    };
+
+    RawPacket raw;
+    DecodedPacket pkt;
+    DecodedPacket datagram;
+    HttpMetadata http;
+    while (!stopRequested) {
+        if (!source->next(raw)) {
+            if (!source->isLive()) {
+                break;
+            }
+            // 实时抓包空闲时也要按时刷新统计, 流超时改按系统时间推进
+            if (std::chrono::steady_clock::now() - lastFlush >= kFlushInterval) {
+                const auto wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch());
+                flows.expire(std::max(lastPacketNs, static_cast<std::uint64_t>(wallNs.count())), expiredFlows,
+                             kFlowExpiryBudget);
+                flush();
+            }
+            continue;
+        }
+        // 按时刷新放在最前面: 后面解不开、被重组吞掉、被采样或过滤掉的包都会提前 continue,
+        // 放在循环末尾时选择性的过滤会让统计、告警、配置重载和检查点一直停着
+        if (std::chrono::steady_clock::now() - lastFlush >= kFlushInterval) {
+            flush();
+        }
+        if (skipPackets > 0) {
+            --skipPackets; // 跳过大文件的前半部分时进度条照常前进
+            continue;
+        }
+        ++stats.total;
+        SourceStats &input = stats.sources[raw.source];
+        ++input.packets;
+        input.bytes += raw.origLen;
+        if (recordAll) {
+            recorder->write(raw);
+        }
+        // 并行解码时解码、校验和和HTTP扫描已经在线程池中做完
+        const PrefetchedPacket *prefetched = source->prefetched();
+        if (prefetched != nullptr) {
+            if (!prefetched->decoded) {
+                continue;
+            }
+            pkt = prefetched->pkt;
+        } else if (!PacketDecoder::decode(raw, pkt)) {
+            continue;
+        }
+        lastPacketNs = pkt.tsNs;
+        // 分片在重组完成前看不出协议, 按过滤条件录制时也全部录制, 保证录下的数据报能重组
+        bool recorded = false;
+        if (recordFiltered && pkt.isFragment) {
+            recorder->write(raw);
+            recorded = true;
+        }
+        // 分片先交给重组, 完整的数据报再按普通数据包走后面的流程
+        if (reassemble && pkt.isFragment) {
+            const FragmentReassembler::Result result = fragments.add(pkt, datagram);
+            if (result == FragmentReassembler::Result::Consumed) {
+                continue;
+            }
+            if (result == FragmentReassembler::Result::Completed) {
+                pkt = datagram;
+                prefetched = nullptr; // 预先算好的结果属于最后一个分片, 不适用于完整数据报
+            }
+        }
+        // 采样放在重组之后, 按流采样时能看到完整数据报的端口。weight 是该包代表的包数
+        const quint32 weight = sampler.sample(pkt);
+        if (weight == 0) {
+            continue;
+        }
+        stats.sampled = stats.sampled || weight > 1;
+        if (pkt.l4Proto == ProtoTcp) {
+            stats.tcp += weight;
+        } else if (pkt.l4Proto == ProtoUdp) {
+            stats.udp += weight;
+        }
+
+        Checksum::Result checksum;
+        if (config->validateChecksums) {
+            checksum = prefetched != nullptr && prefetchedChecksums ? prefetched->checksum
+                                                                    : Checksum::validate(pkt, raw.flags);
+            countChecksum(stats, pkt, checksum, weight);
+        }
+
+        // 每个数据包只处理少量到期的流, 积压留给后面的数据包, 避免集中清理造成停顿
+        flows.expire(pkt.tsNs, expiredFlows, kFlowExpiryBudget);
+        bool fromInitiator = true;
+        // 按流采样时保留下来的流是完整的, 流内计数不放大
+        FlowRecord &flow = flows.update(pkt, fromInitiator, sampler.perFlow() ? 1 : weight);
+        FlowInspector::inspectTls(flow, pkt, fromInitiator);
+        scanDetector.inspect(pkt, flow, fromInitiator, alerts);
+
+        AppProtocol app = flow.tlsState == TlsState::Parsed ? AppProtocol::Https : classify(pkt);
+        bool isHttp = false;
+        if (prefetched != nullptr) {
+            isHttp = prefetched->isHttp;
+            http = prefetched->http;
+        } else {
+            isHttp = pkt.l4Proto == ProtoTcp && pkt.payloadLen > 0
+                     && HttpScanner::scan(pkt.payload, pkt.payloadLen, http);
+        }
+        if (isHttp) {
+            app = AppProtocol::Http;
+        }
+        if (app == AppProtocol::Http) {
+            stats.http += weight;
+        }
+        if (app != AppProtocol::None) {
+            flow.app = app;
+        }
+        // 插件认领的包在协议列中显示插件的协议名, 吞吐量和计数仍按内置识别归类
+        std::uint8_t dissector = 0;
+        if (plugins) {
+            dissector = plugins->dissect(pkt, flow, fromInitiator, app != AppProtocol::None);
+        }
+        if (weight > 1) {
+            // 按流采样时整条流一起保留或丢弃, 第 n 个包让这条流的方差从 w(w-1)(n-1)² 增加到 w(w-1)n²;
+            // n 用整条流的包数, 活动超时分段导出后继续累计。不在流表中的流不知道已有多少包,
+            // 按每包 w² 保守估计
+            const double w = static_cast<double>(weight);
+            double variance = w * (w - 1);
+            if (sampler.perFlow()) {
+                variance = flows.isUntracked(flow) ? w * w
+                                                   : variance * (2.0 * static_cast<double>(flow.sampledPackets) - 1);
+            }
+            if (pkt.l4Proto == ProtoTcp) {
+                tcpVariance += variance;
+            } else if (pkt.l4Proto == ProtoUdp) {
+                udpVariance += variance;
+            }
+            if (app == AppProtocol::Http) {
+                httpVariance += variance;
+            }
+        }
+
+        // 吞吐量按整秒累计, 跨秒时把上一秒交给下次刷新; 图表统计不受协议过滤影响
+        const qint64 second = static_cast<qint64>(pkt.tsNs / 1000000000);
+        if (!haveSecond || second != currentSecond.second) {
+            if (haveSecond) {
+                samples.append(currentSecond);
+                if (checkpointHistory) {
+                    checkpointHistory->append(currentSecond);
+                    checkpointSamples.append(currentSecond);
+                }
+            }
+            currentSecond = ThroughputSample();
+            currentSecond.second = second;
+            haveSecond = true;
+        }
+        const quint64 scaledBytes = static_cast<quint64>(pkt.wireLen) * weight;
+        currentSecond.samplingRate = std::max(currentSecond.samplingRate, weight);
+        currentSecond.bytes[SeriesTotal] += scaledBytes;
+        currentSecond.packets[SeriesTotal] += weight;
+        const int l4Series = pkt.l4Proto == ProtoTcp ? SeriesTcp : pkt.l4Proto == ProtoUdp ? SeriesUdp : -1;
+        if (l4Series >= 0) {
+            currentSecond.bytes[l4Series] += scaledBytes;
+            currentSecond.packets[l4Series] += weight;
+        }
+        const int appSeries = throughputSeries(app);
+        if (appSeries >= 0) {
+            currentSecond.bytes[appSeries] += scaledBytes;
+            currentSecond.packets[appSeries] += weight;
+        }
+
+        // 分组流量同样不受协议过滤影响
+        const IpAddress srcIp = IpAddress::fromBytes(pkt.srcAddr, pkt.ipVersion);
+        const IpAddress dstIp = IpAddress::fromBytes(pkt.dstAddr, pkt.ipVersion);
+        quint16 srcGroup = 0;
+        quint16 dstGroup = 0;
+        if (groups) {
+            srcGroup = groups->lookup(srcIp);
+            dstGroup = groups->lookup(dstIp);
+            const int cell = groupTraffic.cell(srcGroup, dstGroup);
+            groupTraffic.bytes[cell] += scaledBytes;
+            groupTraffic.packets[cell] += weight;
+            groupTrafficDirty = true;
+        }
+
+        if (!filter.matches(pkt, app, dissector)) {
+            continue;
+        }
+        if (recordFiltered && !recorded) {
+            recorder->write(raw);
+        }
+
+        ResultRow row;
+        row.tsNs = pkt.tsNs;
+        row.srcIp = srcIp;
+        row.dstIp = dstIp;
+        row.srcPort = pkt.srcPort;
+        row.dstPort = pkt.dstPort;
+        row.l4Proto = pkt.l4Proto;
+        row.app = app;
+        row.srcGroup = srcGroup;
+        row.dstGroup = dstGroup;
+        row.source = raw.source;
+        if (geo) {
+            row.srcGeo = geo->lookup(row.srcIp);
+            row.dstGeo = geo->lookup(row.dstIp);
+        }
+        if (isHttp) {
+            row.trafficType = httpDescription(http);
+        } else if (flow.tls) {
+            row.trafficType = tlsDescription(*flow.tls);
+        } else {
+            row.trafficType = trafficType(app);
+        }
+        row.dissector = dissector;
+        if (dissector != 0) {
+            plugins->apply(row);
+        }
+        row.checksumBad = checksum.bad();
+        // 结果表只在清空时释放内存, 等待没有意义; 预算用完后结果行直接丢弃并计数
+        if (outputPackets) {
+            outputRows.append(row);
+        }
+        const quint64 rowBytes = memoryCost(row);
+        if (budget.wouldFit(batchBytes + rowBytes)) {
+            batchBytes += rowBytes;
+            batch.append(row);
+        } else {
+            budget.recordFailure(MemoryBudget::Results);
+            ++stats.droppedRows;
+        }
+
+        if (batch.size() >= kBatchRows || outputRows.size() >= kBatchRows) {
+            flush();
+        }
+    }
+    if (!stopRequested && !source->errorString().isEmpty()) {
+        emit logMessage("读取数据源出错, 分析提前结束: " + source->errorString());
+    }
+    // 最后一段检查点在导出剩余的流之前写, 下次继续时流表还在
+    if (checkpoint) {
+        saveCheckpoint(true);
+        checkpoint->close();
+        if (checkpoint->errorString().isEmpty()) {
+            emit logMessage("分析状态已保存到检查点 " + options.checkpoint.path);
+        }
+    }
+    if (haveSecond) {
+        samples.append(currentSecond);
+    }
+    flows.drain(expiredFlows);
+    if (recorder) {
+        recorder->close(); // 写完剩余数据后再做最后一次统计
+    }
+    flush(true);
+
+    running = false;
+    emit analysisFinished();
+}
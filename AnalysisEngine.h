@@ -0,0 +1,73 @@
+#ifndef ANALYSISENGINE_H
+#define ANALYSISENGINE_H
+
+#include "AnalysisTypes.h"
+#include "PacketDecoder.h"
+#include "SnapshotCell.h"
+#include <QObject>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+class CheckpointWriter;
+class DissectorRegistry;
+class GeoDatabase;
+class OutputFanout;
+class PacketSource;
+class PcapRingWriter;
+class SubnetGroupMap;
+
+// 分析引擎: 在后台线程中读取数据源、解码并分类, 按批次把结果送回界面线程
+class AnalysisEngine final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AnalysisEngine(QObject *parent = nullptr);
+    ~AnalysisEngine() override;
+
+    bool start(const QString &source, const AnalysisOptions &options, QString *error = nullptr);
+    void stop();
+    bool isRunning() const;
+
+    // 可在分析进行中替换, 工作线程在下一次刷新时换用新库; 传空指针关闭ASN/国家查询
+    void setGeoDatabase(std::shared_ptr<const GeoDatabase> database);
+    // 同样可在分析进行中替换; 换用新分组时流量矩阵从零开始累计
+    void setSubnetGroups(std::shared_ptr<const SubnetGroupMap> groups);
+    // 协议解析插件, 下一次开始分析时生效; 传空指针不使用插件
+    void setDissectors(std::shared_ptr<const DissectorRegistry> registry);
+    // 发布新的配置快照, 分析线程在下一次刷新时换用, 逐包处理时读取配置不加锁。
+    // start 时以 AnalysisOptions::config 为准
+    void setConfig(const EngineConfig &config);
+
+signals:
+    void rowsReady(const QVector<ResultRow> &rows);
+    void statsUpdated(const TrafficStats &stats);
+    // 已经结束的整秒吞吐量样本, 按数据包时间划分
+    void throughputReady(const QVector<ThroughputSample> &samples);
+    void alertsRaised(const QVector<SecurityAlert> &alerts);
+    // 本次分析开始以来的累计值, 约每秒发送一次
+    void groupTrafficUpdated(const GroupTrafficMatrix &matrix);
+    // 空闲/活动超时的流, 分析结束时剩余的流也从这里导出
+    void flowsExpired(const QVector<FlowSummary> &flows);
+    void progressChanged(int percent);
+    void logMessage(const QString &message);
+    void analysisFinished();
+
+private:
+    // recorder 为空时不录制, checkpoint 为空时不写检查点, outputs 为空时不连续输出;
+    // sourceName 用于核对检查点的数据源
+    void run(std::unique_ptr<PacketSource> source, std::unique_ptr<PcapRingWriter> recorder,
+             std::unique_ptr<CheckpointWriter> checkpoint, std::unique_ptr<OutputFanout> outputs, QString sourceName,
+             AnalysisOptions options);
+
+    std::thread worker;
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> running{false};
+    std::shared_ptr<const GeoDatabase> geoDatabase; // 通过 std::atomic_load/store 访问
+    std::shared_ptr<const SubnetGroupMap> subnetGroups; // 同上
+    std::shared_ptr<const DissectorRegistry> dissectorRegistry; // 同上
+    SnapshotCell<EngineConfig> engineConfig;
+};
+
+#endif // ANALYSISENGINE_H
@@ -0,0 +1,389 @@
+#ifndef ANALYSISTYPES_H
+#define ANALYSISTYPES_H
+
+#include "IpAddress.h"
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// 端口或内容识别出的应用层协议
+enum class AppProtocol : quint8 {
+    None,
+    Http,
+    Https,
+    Ftp,
+    Ssh,
+    Dns
+};
+
+// 地址所属的自治系统和国家/地区, asn 为0表示库中没有该地址
+struct GeoInfo
+{
+    quint32 asn = 0;
+    char country[2] = {0, 0}; // ISO 3166 两位代码
+
+    bool isValid() const { return asn != 0 || country[0] != 0; }
+    QString countryCode() const { return country[0] ? QString::fromLatin1(country, 2) : QString(); }
+};
+
+// 结果表中的一行。地址、端口和时间保持整数形式, 只在显示可见行时才格式化
+struct ResultRow
+{
+    quint64 tsNs = 0;
+    IpAddress srcIp;
+    IpAddress dstIp;
+    quint16 srcPort = 0;
+    quint16 dstPort = 0;
+    quint8 l4Proto = 0;
+    AppProtocol app = AppProtocol::None;
+    bool checksumBad = false;
+    GeoInfo srcGeo;
+    GeoInfo dstGeo;
+    quint16 srcGroup = 0; // 网段分组编号, 0 表示不属于任何分组
+    quint16 dstGroup = 0;
+    quint8 source = 0; // 同时分析多个数据源时输入的下标
+    quint8 dissector = 0; // 认领这个包的协议解析插件编号加一, 0 表示内置识别
+    QString trafficType;
+    QStringList pluginColumns; // 插件写入的自定义列, 下标为所有插件的列按加载顺序排列后的列号
+};
+
+// 结果行在内存预算中的记账大小; 引擎按它决定是否接收, 结果表按它记账和归还
+inline quint64 memoryCost(const ResultRow &row)
+{
+    quint64 bytes = sizeof(ResultRow) + static_cast<quint64>(row.trafficType.size()) * sizeof(QChar);
+    for (const QString &column : row.pluginColumns) {
+        bytes += sizeof(QString) + static_cast<quint64>(column.size()) * sizeof(QChar);
+    }
+    return bytes;
+}
+
+// 每个数据源各自的计数。dropped 为读线程队列满或超出内存预算时丢弃的包,
+// late 为超出重排窗口才到达、没能按时间顺序交出的包
+struct SourceStats
+{
+    QString name;
+    quint64 packets = 0;
+    quint64 bytes = 0;
+    quint64 dropped = 0;
+    quint64 late = 0;
+};
+
+// 协议解析插件在一个阶段 (端口、启发式、已认领的流) 的调用次数、认领的包数和累计耗时
+struct DissectorStageStats
+{
+    quint64 calls = 0;
+    quint64 accepted = 0;
+    quint64 ns = 0;
+};
+
+// 一个协议解析插件本次分析的统计, 显示在调试面板中
+struct DissectorStats
+{
+    QString name;
+    DissectorStageStats stages[3]; // 下标为 ta_stage, 见 DissectorPlugin.h
+    QStringList counterNames;
+    QVector<quint64> counters;
+};
+
+// 状态栏上展示的累计计数
+struct TrafficStats
+{
+    quint64 total = 0;
+    quint64 tcp = 0;
+    quint64 udp = 0;
+    quint64 http = 0;
+
+    // 校验和验证开启时才统计
+    bool checksumsValidated = false;
+    quint64 badIpChecksums = 0;
+    quint64 badTcpChecksums = 0;
+    quint64 badUdpChecksums = 0;
+    quint64 offloadedChecksums = 0;
+
+    quint64 alerts = 0;
+    quint64 scanStateEvictions = 0; // 扫描检测状态表满时淘汰的条目数
+
+    // 分片重组: 完成的数据报, 超时的数据报, 因重叠/不合法/内存上限丢弃的数据报
+    quint64 fragmentsReassembled = 0;
+    quint64 fragmentTimeouts = 0;
+    quint64 fragmentDrops = 0;
+
+    // 内存预算用完时: 没有建流表的包, 没有交给界面的结果行
+    quint64 untrackedPackets = 0;
+    quint64 droppedRows = 0;
+
+    // 采样时 tcp/udp/http、校验和等计数都是按采样率放大的估计值, total 仍是实际读到的包数。
+    // samplingRate 为当前采样率 (1 表示未采样), sampled 表示本次分析中出现过采样;
+    // *Error 为对应估计值95%置信区间的半宽
+    quint32 samplingRate = 1;
+    bool sampled = false;
+    double tcpError = 0;
+    double udpError = 0;
+    double httpError = 0;
+
+    // 按数据源拆分, 下标与 ResultRow::source 相同
+    QVector<SourceStats> sources;
+
+    // 录制原始数据包: 写入的包数和字节数, 缓冲区用完或写入出错而没有录制的包,
+    // 已交给写线程还没写完的字节数, 最近一个刷新周期内单批写入的最长耗时
+    bool recording = false;
+    quint64 recordedPackets = 0;
+    quint64 recordedBytes = 0;
+    quint64 recordDrops = 0;
+    quint64 recordBacklogBytes = 0;
+    quint64 recordLatencyUs = 0;
+    quint32 recordFiles = 0;
+
+    // 连续输出: 各输出端合计写出和丢弃的记录数, 排队等待写出的记录数
+    bool outputting = false;
+    quint64 outputRecords = 0;
+    quint64 outputDrops = 0;
+    quint64 outputBacklog = 0;
+
+    // 已加载的协议解析插件, 没有插件时为空
+    QVector<DissectorStats> dissectors;
+};
+
+// 吞吐量图表的曲线, 总计之外按协议拆分
+enum ThroughputSeries {
+    SeriesTotal,
+    SeriesTcp,
+    SeriesUdp,
+    SeriesHttp,
+    SeriesHttps,
+    SeriesDns,
+    SeriesSsh,
+    SeriesFtp,
+    ThroughputSeriesCount
+};
+
+// 按数据包时间统计的一秒内的字节数和包数
+struct ThroughputSample
+{
+    qint64 second = 0;
+    quint64 bytes[ThroughputSeriesCount] = {};
+    quint64 packets[ThroughputSeriesCount] = {};
+    quint32 samplingRate = 1; // 这一秒内用过的最大采样率, 大于1时数值是估计值
+};
+
+// 用户定义的命名网段分组, 例如 "DMZ" 包含 10.1.0.0/16 和 2001:db8:1::/48
+struct SubnetGroup
+{
+    QString name;
+    QStringList prefixes;
+};
+
+// 网段分组之间的流量矩阵, 行为源分组, 列为目的分组; 第0组是不属于任何分组的地址
+struct GroupTrafficMatrix
+{
+    QStringList groups;
+    QVector<quint64> bytes;
+    QVector<quint64> packets;
+
+    int size() const { return groups.size(); }
+    int cell(int src, int dst) const { return src * groups.size() + dst; }
+};
+
+// 扫描/泛洪检测的告警类型
+enum class AlertKind : quint8 {
+    VerticalScan,   // 一个源探测同一主机的大量端口
+    HorizontalScan, // 一个源在大量主机上探测少数端口
+    SynFlood,       // 一个目标在窗口内收到大量SYN且很少完成握手
+    HalfOpen        // 一个目标上未完成握手的连接持续堆积
+};
+
+struct SecurityAlert
+{
+    quint64 tsNs = 0;
+    AlertKind kind = AlertKind::VerticalScan;
+    IpAddress subject; // 扫描类为源地址, 泛洪类为目标地址
+    quint32 distinctPorts = 0;
+    quint32 distinctHosts = 0; // 扫描类为目的主机数, 泛洪类为源地址数
+    quint32 syns = 0;
+    quint32 halfOpen = 0;
+};
+
+enum class FlowEndReason : quint8 {
+    Idle,       // 空闲超时, 流已结束
+    Active,     // 活动超时, 只导出这一段, 流仍在继续
+    CaptureEnd  // 分析结束时仍未超时的流
+};
+
+// 导出的一条流记录, 计数是本段 (firstNs 到 lastNs) 内双向的合计
+struct FlowSummary
+{
+    quint64 firstNs = 0;
+    quint64 lastNs = 0;
+    IpAddress client;
+    IpAddress server;
+    quint16 clientPort = 0;
+    quint16 serverPort = 0;
+    quint8 l4Proto = 0;
+    AppProtocol app = AppProtocol::None;
+    FlowEndReason reason = FlowEndReason::Idle;
+    quint64 packets = 0;
+    quint64 bytes = 0;
+};
+
+enum class SamplingMode : quint8 {
+    Off,
+    Fixed,   // 固定 1/N
+    Adaptive // 按数据源接收队列的占用在 1 到 1/N 之间调整
+};
+
+// 未压缩的离线抓包文件的读取方式
+enum class FileReadMode : quint8 {
+    Mmap,     // 整个文件映射到内存, 可以并行解码
+    IoUring,  // 多个大块读取同时在途 (不支持io_uring时退回普通读取)
+    Buffered  // 按需逐块读取
+};
+
+// 边分析边把原始数据包录制成轮转的pcap文件, directory 为空时不录制
+struct RecordOptions
+{
+    QString directory;
+    bool filteredOnly = false; // 只录制符合协议过滤的包
+    quint64 maxFileBytes = 256ULL * 1024 * 1024;
+    quint64 maxFileNs = 0; // 按数据包时间切换文件, 0 表示只按大小切换
+    quint64 maxTotalBytes = 4ULL * 1024 * 1024 * 1024; // 所有文件的上限, 超出时删除最早的文件
+};
+
+// 连续输出的记录种类, 可以组合
+enum OutputRecord : quint8 {
+    OutputPackets = 0x1, // 逐包的结果行, 不受结果表内存预算限制
+    OutputFlows = 0x2,   // 超时导出的流记录
+    OutputAlerts = 0x4
+};
+
+enum class OutputFormat : quint8 {
+    Csv,
+    Ndjson, // 每行一个JSON对象
+    Binary  // 定长字段的小端记录, 见 OutputSink.h
+};
+
+enum class OutputTarget : quint8 {
+    File,       // path 为目录, 每次分析新建一个文件
+    Stdout,
+    UnixSocket, // path 为套接字路径, 断开后自动重连
+    Syslog      // 每条记录一条日志, 只支持文本格式
+};
+
+// 输出端的队列满时丢弃哪一批: 文件保留较早的连续数据, 实时的管道和套接字保留最新的数据
+enum class OutputDropPolicy : quint8 {
+    DropNewest,
+    DropOldest
+};
+
+// 一个输出端。每个输出端有自己的有界队列和写线程, 写得慢只会让它自己丢弃记录, 不会拖住分析
+struct OutputSinkOptions
+{
+    OutputTarget target = OutputTarget::File;
+    OutputFormat format = OutputFormat::Ndjson;
+    QString path;
+    quint8 records = OutputPackets | OutputFlows | OutputAlerts;
+    quint32 queueRecords = 65536; // 排队等待写出的记录上限
+    OutputDropPolicy dropPolicy = OutputDropPolicy::DropNewest;
+};
+
+// 定期把分析状态写成检查点, path 为空时不写。resume 为true且检查点的数据源与本次相同时,
+// 从检查点中的计数、流表和历史继续; 离线文件还会跳过已经分析过的数据包
+struct CheckpointOptions
+{
+    QString path;
+    quint32 intervalSeconds = 60;
+    bool resume = false;
+};
+
+// 分析进行中也可以替换的配置。界面线程整体发布新的快照, 分析线程在下一次刷新时换用
+struct EngineConfig
+{
+    QString protocolFilter;
+    bool validateChecksums = false;
+    quint64 fragmentMemoryLimit = 64 * 1024 * 1024; // 分片重组可用的内存, 0 表示不重组
+    // 按数据包时间计算: 流空闲超过 idle 即结束; 持续超过 active 时先导出一段计数, 流继续保留
+    quint64 flowIdleTimeoutNs = 30ULL * 1000000000;
+    quint64 flowActiveTimeoutNs = 1800ULL * 1000000000;
+};
+
+// 启动分析时的选项
+struct AnalysisOptions
+{
+    EngineConfig config; // 开始时的配置, 之后可通过 AnalysisEngine::setConfig 替换
+    SamplingMode samplingMode = SamplingMode::Off;
+    quint32 samplingRate = 16;
+    bool samplingPerFlow = true; // 按流采样, 否则逐包随机
+    // 单个大抓包文件的解码线程数, 0 表示按CPU核数自动选择, 1 表示不并行
+    int decodeThreads = 0;
+    FileReadMode fileReadMode = FileReadMode::Mmap;
+    RecordOptions record;
+    CheckpointOptions checkpoint;
+    QVector<OutputSinkOptions> outputs; // 为空时不连续输出
+};
+
+// 协议列的显示名称, 也用于协议过滤
+inline QString protocolName(quint8 l4Proto, AppProtocol app)
+{
+    switch (app) {
+    case AppProtocol::Http: return QStringLiteral("HTTP");
+    case AppProtocol::Https: return QStringLiteral("HTTPS");
+    case AppProtocol::Ftp: return QStringLiteral("FTP");
+    case AppProtocol::Ssh: return QStringLiteral("SSH");
+    case AppProtocol::Dns: return QStringLiteral("DNS");
+    case AppProtocol::None: break;
+    }
+    if (l4Proto == 6) {
+        return QStringLiteral("TCP");
+    }
+    if (l4Proto == 17) {
+        return QStringLiteral("UDP");
+    }
+    return QString("IP(%1)").arg(l4Proto);
+}
+
+inline QString alertKindName(AlertKind kind)
+{
+    switch (kind) {
+    case AlertKind::VerticalScan: return QStringLiteral("纵向端口扫描");
+    case AlertKind::HorizontalScan: return QStringLiteral("横向端口扫描");
+    case AlertKind::SynFlood: return QStringLiteral("SYN泛洪");
+    case AlertKind::HalfOpen: return QStringLiteral("半开连接堆积");
+    }
+    return QString();
+}
+
+inline QString flowEndReasonName(FlowEndReason reason)
+{
+    switch (reason) {
+    case FlowEndReason::Idle: return QStringLiteral("空闲超时");
+    case FlowEndReason::Active: return QStringLiteral("活动超时");
+    case FlowEndReason::CaptureEnd: return QStringLiteral("分析结束");
+    }
+    return QString();
+}
+
+// 告警详情, 计数都是检测窗口内的估计值
+inline QString alertDetail(const SecurityAlert &alert)
+{
+    switch (alert.kind) {
+    case AlertKind::VerticalScan:
+    case AlertKind::HorizontalScan:
+        return QString("约 %1 个端口, %2 台主机, %3 个SYN")
+            .arg(alert.distinctPorts).arg(alert.distinctHosts).arg(alert.syns);
+    case AlertKind::SynFlood:
+    case AlertKind::HalfOpen:
+        return QString("%1 个SYN, %2 个未完成握手, 约 %3 个源地址")
+            .arg(alert.syns).arg(alert.halfOpen).arg(alert.distinctHosts);
+    }
+    return QString();
+}
+
+Q_DECLARE_METATYPE(ResultRow)
+Q_DECLARE_METATYPE(QVector<ResultRow>)
+Q_DECLARE_METATYPE(TrafficStats)
+Q_DECLARE_METATYPE(QVector<ThroughputSample>)
+Q_DECLARE_METATYPE(QVector<SecurityAlert>)
+Q_DECLARE_METATYPE(GroupTrafficMatrix)
+Q_DECLARE_METATYPE(QVector<FlowSummary>)
+
+#endif // ANALYSISTYPES_H
@@ -0,0 +1,300 @@
+#include "AppStyle.h"
+#include <QApplication>
+#include <QGroupBox>
+#include <QHash>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPainter>
+#include <QPointer>
+#include <QProxyStyle>
+#include <QTableView>
+#include <QTextEdit>
+
+namespace {
+
+// 各页面自己的规则, 与主题无关
+const char *const kPageRules = R"(
+    LoginWidget, LoginWidget QWidget, RegisterWidget, RegisterWidget QWidget {
+        background-color: #f0f0f0;
+    }
+
+    QLabel#pageTitle {
+        font-size: 24px;
+        font-weight: bold;
+        color: #2c3e50;
+        margin: 20px;
+    }
+    QLabel#analyzerTitle {
+        font-size: 20px;
+        font-weight: bold;
+        color: #2c3e50;
+        margin: 10px;
+    }
+    QGroupBox#formBox {
+        font-size: 14px;
+        font-weight: bold;
+        padding: 10px;
+    }
+    QGroupBox#panel {
+        font-weight: bold;
+    }
+    QLineEdit#formEdit {
+        padding: 8px;
+        border: 1px solid #ccc;
+        border-radius: 4px;
+    }
+    QLineEdit#controlInput, QComboBox#controlInput {
+        padding: 5px;
+        border: 1px solid #ccc;
+        border-radius: 3px;
+    }
+    QLineEdit#filterEdit {
+        padding: 3px;
+        border: 1px solid #ccc;
+        border-radius: 3px;
+    }
+
+    QPushButton#primaryBtn, QPushButton#confirmBtn, QPushButton#secondaryBtn {
+        color: white;
+        padding: 8px 20px;
+        border: none;
+        border-radius: 4px;
+    }
+    QPushButton#startBtn, QPushButton#stopBtn, QPushButton#clearBtn, QPushButton#exportBtn {
+        color: white;
+        padding: 8px 15px;
+        border: none;
+        border-radius: 4px;
+    }
+    QPushButton#primaryBtn, QPushButton#exportBtn { background-color: #3498db; }
+    QPushButton#primaryBtn:hover, QPushButton#exportBtn:hover { background-color: #2980b9; }
+    QPushButton#confirmBtn, QPushButton#startBtn { background-color: #27ae60; }
+    QPushButton#confirmBtn:hover, QPushButton#startBtn:hover { background-color: #219a52; }
+    QPushButton#secondaryBtn { background-color: #95a5a6; }
+    QPushButton#secondaryBtn:hover { background-color: #7f8c8d; }
+    QPushButton#stopBtn { background-color: #e74c3c; }
+    QPushButton#stopBtn:hover { background-color: #c0392b; }
+    QPushButton#stopBtn:disabled { background-color: #bdc3c7; }
+    QPushButton#clearBtn { background-color: #f39c12; }
+    QPushButton#clearBtn:hover { background-color: #e67e22; }
+
+    QLabel#statusLabel {
+        color: #27ae60;
+        font-weight: bold;
+    }
+    QLabel#statusLabel[state="running"] { color: #f39c12; }
+    QLabel#statusLabel[state="stopped"] { color: #e74c3c; }
+    QProgressBar#analysisProgress {
+        border: 1px solid #ccc;
+        border-radius: 3px;
+    }
+    QProgressBar#analysisProgress::chunk { background-color: #3498db; }
+)";
+
+const char *const kDarkWindowRules = R"(
+    QMainWindow {
+        background-color: #2b2b2b;
+        color: #ffffff;
+    }
+    QMenuBar {
+        background-color: #3c3c3c;
+        color: #ffffff;
+        border-bottom: 1px solid #555555;
+    }
+    QMenuBar::item {
+        background-color: transparent;
+        padding: 4px 8px;
+    }
+    QMenuBar::item:selected {
+        background-color: #555555;
+        border: 1px solid #777777;
+    }
+    QMenu {
+        background-color: #3c3c3c;
+        color: #ffffff;
+        border: 1px solid #555555;
+    }
+    QMenu::item:selected {
+        background-color: #555555;
+    }
+    QToolBar {
+        background-color: #3c3c3c;
+        border: none;
+        spacing: 2px;
+    }
+    QToolBar::separator {
+        background-color: #555555;
+        width: 1px;
+        margin: 4px 2px;
+    }
+)";
+
+const char *const kLightWindowRules = R"(
+    QMainWindow {
+        background-color: #f8f9fa;
+        color: #212529;
+    }
+    QMenuBar {
+        background-color: #ffffff;
+        color: #212529;
+        border-bottom: 1px solid #dee2e6;
+    }
+    QMenuBar::item {
+        background-color: transparent;
+        padding: 4px 8px;
+    }
+    QMenuBar::item:selected {
+        background-color: #e9ecef;
+        border: 1px solid #ced4da;
+    }
+    QMenu {
+        background-color: #ffffff;
+        color: #212529;
+        border: 1px solid #dee2e6;
+    }
+    QMenu::item:selected {
+        background-color: #e9ecef;
+    }
+    QToolBar {
+        background-color: #ffffff;
+        border: none;
+        spacing: 2px;
+    }
+    QToolBar::separator {
+        background-color: #dee2e6;
+        width: 1px;
+        margin: 4px 2px;
+    }
+)";
+
+constexpr QRgb kGridColor = 0xffd0d0d0;
+constexpr QRgb kHeaderColor = 0xffecf0f1;
+
+// 数据表格的网格线和表头由代理样式直接给出, 不经过样式表
+class ViewStyle final : public QProxyStyle
+{
+public:
+    int styleHint(StyleHint hint, const QStyleOption *option, const QWidget *widget,
+                  QStyleHintReturn *returnData) const override
+    {
+        if (hint == SH_Table_GridLineColor) {
+            return static_cast<int>(kGridColor);
+        }
+        return QProxyStyle::styleHint(hint, option, widget, returnData);
+    }
+
+    void drawControl(ControlElement element, const QStyleOption *option, QPainter *painter,
+                     const QWidget *widget) const override
+    {
+        if (element == CE_HeaderSection) {
+            const QRect &rect = option->rect;
+            painter->fillRect(rect, QColor(kHeaderColor));
+            painter->setPen(QColor(kGridColor));
+            painter->drawLine(rect.topRight(), rect.bottomRight());
+            painter->drawLine(rect.bottomLeft(), rect.bottomRight());
+            return;
+        }
+        QProxyStyle::drawControl(element, option, painter, widget);
+    }
+};
+
+// 所有数据表格共用一个代理样式, 随应用程序对象释放
+QStyle *viewStyle()
+{
+    static QPointer<QStyle> style;
+    if (!style) {
+        style = new ViewStyle;
+        style->setParent(qApp);
+    }
+    return style;
+}
+
+} // namespace
+
+const QString &AppStyle::chromeStyleSheet(const QString &theme)
+{
+    static QHash<QString, QString> cache;
+    auto found = cache.find(theme);
+    if (found == cache.end()) {
+        QString sheet;
+        if (theme == "深色主题") {
+            sheet = kDarkWindowRules;
+        } else if (theme == "浅色主题") {
+            sheet = kLightWindowRules;
+        }
+        found = cache.insert(theme, sheet);
+    }
+    return found.value();
+}
+
+QColor AppStyle::windowColor(const QString &theme)
+{
+    if (theme == "深色主题") {
+        return QColor(0x2b, 0x2b, 0x2b);
+    }
+    if (theme == "浅色主题") {
+        return QColor(0xf8, 0xf9, 0xfa);
+    }
+    return QColor();
+}
+
+const QString &AppStyle::pageStyleSheet()
+{
+    static const QString sheet = QString::fromUtf8(kPageRules);
+    return sheet;
+}
+
+void AppStyle::setStyleState(QWidget *widget, const char *state)
+{
+    widget->setProperty("state", QString::fromLatin1(state));
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+}
+
+void AppStyle::setPageBackground(QWidget *page, const QColor &color)
+{
+    QPalette palette = page->palette();
+    palette.setColor(QPalette::Window, color);
+    palette.setColor(QPalette::Base, color);
+    page->setPalette(palette);
+    page->setAutoFillBackground(true);
+}
+
+void AppStyle::styleDataView(QTableView *view)
+{
+    view->setStyle(viewStyle());
+    for (QHeaderView *header : {view->horizontalHeader(), view->verticalHeader()}) {
+        QFont font = header->font();
+        font.setBold(true);
+        header->setFont(font);
+    }
+}
+
+void AppStyle::styleLogView(QTextEdit *edit)
+{
+    QPalette palette = edit->palette();
+    palette.setColor(QPalette::Base, QColor(0x2c, 0x3e, 0x50));
+    palette.setColor(QPalette::Text, QColor(0xec, 0xf0, 0xf1));
+    edit->setPalette(palette);
+    QFont font("Courier New");
+    font.setStyleHint(QFont::Monospace);
+    edit->setFont(font);
+}
+
+void AppStyle::styleHintLabel(QLabel *label)
+{
+    QPalette palette = label->palette();
+    palette.setColor(QPalette::WindowText, QColor(0x7f, 0x8c, 0x8d));
+    label->setPalette(palette);
+}
+
+void AppStyle::setPanelTitleBold(QGroupBox *panel, QWidget *content)
+{
+    // 字体会传给子控件, 内容先显式定下普通字重, 保留它自己的字体族
+    QFont contentFont = content->font();
+    contentFont.setBold(false);
+    content->setFont(contentFont);
+    QFont font = panel->font();
+    font.setBold(true);
+    panel->setFont(font);
+}
@@ -0,0 +1,41 @@
+#ifndef APPSTYLE_H
+#define APPSTYLE_H
+
+#include <QColor>
+#include <QString>
+
+class QGroupBox;
+class QLabel;
+class QTableView;
+class QTextEdit;
+class QWidget;
+
+// 界面样式。登录、注册页和分析页的按钮、输入框只设置对象名, 规则集中在页面样式表里;
+// 分析页中高频刷新的视图 (数据表格、统计标签、日志) 用调色板和代理样式着色, 祖先上不设样式表,
+// 否则它们每次重绘和布局都要经过样式表引擎
+namespace AppStyle {
+
+// 主窗口菜单栏、工具栏和托盘菜单的样式表, 按主题缓存
+const QString &chromeStyleSheet(const QString &theme);
+// 主窗口底色, 未知主题返回无效颜色
+QColor windowColor(const QString &theme);
+// 页面控件的样式表, 与主题无关
+const QString &pageStyleSheet();
+
+// 设置用于样式选择的动态属性, 例如状态标签的 state, 并重新套用样式
+void setStyleState(QWidget *widget, const char *state);
+
+// 页面底色, 输入框和表格的底色也随之一致
+void setPageBackground(QWidget *page, const QColor &color);
+// 数据表格的网格线、表头底色和表头粗体
+void styleDataView(QTableView *view);
+// 深色底的等宽日志区域
+void styleLogView(QTextEdit *edit);
+// 灰色的次要说明文字
+void styleHintLabel(QLabel *label);
+// 分组框标题加粗, content 是分组框内唯一的子控件, 保持普通字重; 在设置 content 的字体之后调用
+void setPanelTitleBold(QGroupBox *panel, QWidget *content);
+
+} // namespace AppStyle
+
+#endif // APPSTYLE_H
@@ -0,0 +1,26 @@
+#ifndef BYTESTREAM_H
+#define BYTESTREAM_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+
+// 按顺序读取的字节流。抓包文件不能整个映射时 (压缩文件、异步预读), 解析器用 peek/consume
+// 逐条取出连续的记录
+class ByteStream
+{
+public:
+    virtual ~ByteStream() = default;
+
+    // 返回指向接下来 len 个连续字节的指针, 数据不足 (文件结束或出错) 时返回nullptr。
+    // 指针在下一次 peek() 之前有效
+    virtual const std::uint8_t *peek(std::size_t len) = 0;
+    virtual void consume(std::size_t len) = 0;
+
+    // 按已读取的文件字节估计的进度 0-100
+    virtual int progress() const = 0;
+    // 读取出错时的说明, 正常结束时为空
+    virtual QString errorString() const = 0;
+};
+
+#endif // BYTESTREAM_H
@@ -0,0 +1,721 @@
+#include "Checkpoint.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+
+constexpr char kFileMagic[8] = {'N', 'A', 'C', 'K', 'P', 'T', '\r', '\n'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kSegmentMagic = 0x31474553; // "SEG1"
+
+enum SegmentKind : std::uint8_t {
+    SegmentFull = 1,
+    SegmentDelta = 2
+};
+
+enum SectionId : std::uint32_t {
+    SectionMeta = 1,
+    SectionCounters,
+    SectionSources,
+    SectionGroups,
+    SectionFlows,
+    SectionRemovedFlows,
+    SectionScanSources,
+    SectionScanTargets,
+    SectionHistory,
+    SectionSamples
+};
+
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t layout;
+    std::int64_t createdMs;
+    std::uint64_t reserved;
+};
+
+struct SegmentHeader
+{
+    std::uint32_t magic;
+    std::uint8_t kind;
+    std::uint8_t pad[3];
+    std::uint64_t sequence;
+    std::int64_t savedAtMs;
+    std::uint64_t payloadBytes;
+    std::uint64_t checksum;
+};
+
+struct SectionHeader
+{
+    std::uint32_t id;
+    std::uint32_t reserved;
+    std::uint64_t bytes;
+};
+
+// 直接写出的结构体大小变化时旧文件不能再按原样读取
+std::uint32_t layoutTag()
+{
+    return static_cast<std::uint32_t>((sizeof(FlowSnapshot) << 22) ^ (sizeof(ScanEntry) << 11)
+                                      ^ sizeof(ThroughputSample) ^ (ThroughputSeriesCount << 28));
+}
+
+// 按8字节一组混合, 用于发现写了一半的段, 不防篡改
+std::uint64_t checksum(const std::uint8_t *p, std::size_t len)
+{
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    while (len >= 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        h = ((h ^ w) * 0x100000001b3ULL);
+        h ^= h >> 29;
+        p += 8;
+        len -= 8;
+    }
+    while (len > 0) {
+        h = (h ^ *p++) * 0x100000001b3ULL;
+        --len;
+    }
+    return h;
+}
+
+class Encoder
+{
+public:
+    template<typename T>
+    void put(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "只能直接写出平凡类型");
+        putBytes(&value, sizeof(T));
+    }
+
+    void putBytes(const void *data, std::size_t len)
+    {
+        const auto *p = static_cast<const std::uint8_t *>(data);
+        out.insert(out.end(), p, p + len);
+    }
+
+    void putString(const QString &text)
+    {
+        const QByteArray utf8 = text.toUtf8();
+        put(static_cast<std::uint32_t>(utf8.size()));
+        putBytes(utf8.constData(), static_cast<std::size_t>(utf8.size()));
+    }
+
+    template<typename T>
+    void putArray(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "只能直接写出平凡类型");
+        put(static_cast<std::uint64_t>(values.size()));
+        putBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    // 节的长度在写完后回填, 每节按8字节对齐
+    void beginSection(SectionId id)
+    {
+        sectionStart = out.size();
+        SectionHeader header{id, 0, 0};
+        put(header);
+    }
+
+    void endSection()
+    {
+        while (out.size() % 8 != 0) {
+            out.push_back(0);
+        }
+        const std::uint64_t bytes = out.size() - sectionStart - sizeof(SectionHeader);
+        std::memcpy(out.data() + sectionStart + offsetof(SectionHeader, bytes), &bytes, sizeof(bytes));
+    }
+
+    std::vector<std::uint8_t> out;
+
+private:
+    std::size_t sectionStart = 0;
+};
+
+class Decoder
+{
+public:
+    Decoder(const std::uint8_t *data, std::size_t len)
+        : p(data)
+        , end(data + len)
+    {
+    }
+
+    template<typename T>
+    bool take(T &value)
+    {
+        const std::uint8_t *bytes = takeBytes(sizeof(T));
+        if (bytes == nullptr) {
+            return false;
+        }
+        std::memcpy(&value, bytes, sizeof(T));
+        return true;
+    }
+
+    const std::uint8_t *takeBytes(std::size_t len)
+    {
+        if (static_cast<std::size_t>(end - p) < len) {
+            p = end;
+            ok = false;
+            return nullptr;
+        }
+        const std::uint8_t *start = p;
+        p += len;
+        return start;
+    }
+
+    bool takeString(QString &text)
+    {
+        std::uint32_t len = 0;
+        const std::uint8_t *bytes = take(len) ? takeBytes(len) : nullptr;
+        if (bytes == nullptr) {
+            return false;
+        }
+        text = QString::fromUtf8(reinterpret_cast<const char *>(bytes), static_cast<int>(len));
+        return true;
+    }
+
+    // 读出数组, 元素直接从映射的文件中复制
+    template<typename T>
+    bool takeArray(std::vector<T> &values)
+    {
+        std::uint64_t count = 0;
+        if (!take(count) || count > static_cast<std::uint64_t>(end - p) / sizeof(T)) {
+            ok = false;
+            return false;
+        }
+        values.resize(static_cast<std::size_t>(count));
+        if (count > 0) {
+            std::memcpy(values.data(), takeBytes(values.size() * sizeof(T)), values.size() * sizeof(T));
+        }
+        return true;
+    }
+
+    bool atEnd() const { return p >= end; }
+    std::size_t remaining() const { return static_cast<std::size_t>(end - p); }
+
+    bool ok = true;
+
+private:
+    const std::uint8_t *p;
+    const std::uint8_t *end;
+};
+
+void encodeCounters(Encoder &out, const TrafficStats &stats)
+{
+    const quint64 counters[] = {
+        stats.total, stats.tcp, stats.udp, stats.http,
+        stats.checksumsValidated ? 1u : 0u, stats.badIpChecksums, stats.badTcpChecksums, stats.badUdpChecksums,
+        stats.offloadedChecksums, stats.alerts, stats.scanStateEvictions, stats.fragmentsReassembled,
+        stats.fragmentTimeouts, stats.fragmentDrops, stats.untrackedPackets, stats.droppedRows,
+        stats.samplingRate, stats.sampled ? 1u : 0u,
+    };
+    out.put(static_cast<std::uint32_t>(sizeof(counters) / sizeof(counters[0])));
+    out.put(static_cast<std::uint32_t>(0));
+    out.putBytes(counters, sizeof(counters));
+}
+
+bool decodeCounters(Decoder &in, TrafficStats &stats)
+{
+    std::uint32_t count = 0;
+    std::uint32_t reserved = 0;
+    if (!in.take(count) || !in.take(reserved)) {
+        return false;
+    }
+    std::vector<quint64> counters(18, 0);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        quint64 value = 0;
+        if (!in.take(value)) {
+            return false;
+        }
+        if (i < counters.size()) {
+            counters[i] = value;
+        }
+    }
+    stats.total = counters[0];
+    stats.tcp = counters[1];
+    stats.udp = counters[2];
+    stats.http = counters[3];
+    stats.checksumsValidated = counters[4] != 0;
+    stats.badIpChecksums = counters[5];
+    stats.badTcpChecksums = counters[6];
+    stats.badUdpChecksums = counters[7];
+    stats.offloadedChecksums = counters[8];
+    stats.alerts = counters[9];
+    stats.scanStateEvictions = counters[10];
+    stats.fragmentsReassembled = counters[11];
+    stats.fragmentTimeouts = counters[12];
+    stats.fragmentDrops = counters[13];
+    stats.untrackedPackets = counters[14];
+    stats.droppedRows = counters[15];
+    stats.samplingRate = static_cast<quint32>(counters[16] > 0 ? counters[16] : 1);
+    stats.sampled = counters[17] != 0;
+    return true;
+}
+
+void encodeScanTable(Encoder &out, const ScanTableState &state, const std::vector<std::uint32_t> &slots,
+                     const std::vector<ScanEntry> &entries)
+{
+    out.put(state);
+    out.putArray(slots);
+    while (out.out.size() % 8 != 0) {
+        out.out.push_back(0);
+    }
+    out.putArray(entries);
+}
+
+bool decodeScanTable(Decoder &in, ScanTableState &state, std::vector<ScanEntry> &table)
+{
+    std::vector<std::uint32_t> slots;
+    std::vector<ScanEntry> entries;
+    if (!in.take(state) || !in.takeArray(slots)) {
+        return false;
+    }
+    if (slots.size() % 2 != 0) {
+        in.takeBytes(sizeof(std::uint32_t)); // 对齐填充
+    }
+    if (!in.takeArray(entries) || entries.size() != slots.size() || state.capacity > (1u << 24)) {
+        return false;
+    }
+    if (table.size() != state.capacity) {
+        table.assign(state.capacity, ScanEntry());
+    }
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i] >= table.size()) {
+            return false;
+        }
+        table[slots[i]] = entries[i];
+    }
+    return true;
+}
+
+void encodeSegment(const CheckpointSegment &segment, Encoder &out)
+{
+    out.beginSection(SectionMeta);
+    out.putString(segment.source);
+    out.put(segment.lastPacketNs);
+    out.put(segment.tcpVariance);
+    out.put(segment.udpVariance);
+    out.put(segment.httpVariance);
+    out.put(static_cast<std::uint64_t>(segment.haveSecond ? 1 : 0));
+    out.put(segment.currentSecond);
+    out.endSection();
+
+    out.beginSection(SectionCounters);
+    encodeCounters(out, segment.stats);
+    out.endSection();
+
+    out.beginSection(SectionSources);
+    out.put(static_cast<std::uint32_t>(segment.stats.sources.size()));
+    for (const SourceStats &source : segment.stats.sources) {
+        out.putString(source.name);
+        out.put(source.packets);
+        out.put(source.bytes);
+        out.put(source.dropped);
+        out.put(source.late);
+    }
+    out.endSection();
+
+    const GroupTrafficMatrix &groups = segment.groupTraffic;
+    out.beginSection(SectionGroups);
+    out.put(static_cast<std::uint32_t>(groups.size()));
+    for (const QString &name : groups.groups) {
+        out.putString(name);
+    }
+    out.putBytes(groups.bytes.constData(), static_cast<std::size_t>(groups.bytes.size()) * sizeof(quint64));
+    out.putBytes(groups.packets.constData(), static_cast<std::size_t>(groups.packets.size()) * sizeof(quint64));
+    out.endSection();
+
+    if (!segment.full) {
+        out.beginSection(SectionRemovedFlows);
+        out.putArray(segment.removedFlows);
+        out.endSection();
+    }
+    out.beginSection(SectionFlows);
+    out.putArray(segment.flows);
+    out.endSection();
+
+    out.beginSection(SectionScanSources);
+    encodeScanTable(out, segment.scanSourceState, segment.scanSourceSlots, segment.scanSourceEntries);
+    out.endSection();
+    out.beginSection(SectionScanTargets);
+    encodeScanTable(out, segment.scanTargetState, segment.scanTargetSlots, segment.scanTargetEntries);
+    out.endSection();
+
+    if (segment.full) {
+        out.beginSection(SectionHistory);
+        out.putBytes(segment.history.data(), segment.history.size());
+        out.endSection();
+    } else {
+        out.beginSection(SectionSamples);
+        out.put(static_cast<std::uint64_t>(segment.samples.size()));
+        out.putBytes(segment.samples.constData(), static_cast<std::size_t>(segment.samples.size()) * sizeof(ThroughputSample));
+        out.endSection();
+    }
+}
+
+using FlowMap = std::unordered_map<FlowKey, FlowSnapshot, FlowKeyHash>;
+
+// 把一段合并进 state; 完整段先清空之前的内容
+bool applySegment(const std::uint8_t *payload, std::size_t len, bool full, CheckpointState &state, FlowMap &flows)
+{
+    if (full) {
+        flows.clear();
+        state.scanSources.clear();
+        state.scanTargets.clear();
+    }
+    Decoder in(payload, len);
+    while (!in.atEnd()) {
+        SectionHeader header;
+        if (!in.take(header) || header.bytes > in.remaining()) {
+            return false;
+        }
+        const std::uint8_t *data = in.takeBytes(static_cast<std::size_t>(header.bytes));
+        Decoder section(data, static_cast<std::size_t>(header.bytes));
+        switch (header.id) {
+        case SectionMeta: {
+            std::uint64_t haveSecond = 0;
+            section.takeString(state.source);
+            section.take(state.lastPacketNs);
+            section.take(state.tcpVariance);
+            section.take(state.udpVariance);
+            section.take(state.httpVariance);
+            section.take(haveSecond);
+            section.take(state.currentSecond);
+            state.haveSecond = haveSecond != 0;
+            break;
+        }
+        case SectionCounters:
+            decodeCounters(section, state.stats);
+            break;
+        case SectionSources: {
+            std::uint32_t count = 0;
+            section.take(count);
+            state.stats.sources.clear();
+            for (std::uint32_t i = 0; i < count && section.ok; ++i) {
+                SourceStats source;
+                section.takeString(source.name);
+                section.take(source.packets);
+                section.take(source.bytes);
+                section.take(source.dropped);
+                section.take(source.late);
+                state.stats.sources.append(source);
+            }
+            break;
+        }
+        case SectionGroups: {
+            std::uint32_t count = 0;
+            GroupTrafficMatrix matrix;
+            if (!section.take(count) || count > 4096) {
+                return false;
+            }
+            for (std::uint32_t i = 0; i < count && section.ok; ++i) {
+                QString name;
+                section.takeString(name);
+                matrix.groups.append(name);
+            }
+            const int cells = static_cast<int>(count * count);
+            matrix.bytes.resize(cells);
+            matrix.packets.resize(cells);
+            for (int i = 0; i < cells && section.ok; ++i) {
+                section.take(matrix.bytes[i]);
+            }
+            for (int i = 0; i < cells && section.ok; ++i) {
+                section.take(matrix.packets[i]);
+            }
+            state.groupTraffic = matrix;
+            break;
+        }
+        case SectionFlows: {
+            std::vector<FlowSnapshot> changed;
+            section.takeArray(changed);
+            flows.reserve(flows.size() + changed.size());
+            for (const FlowSnapshot &flow : changed) {
+                flows[flow.key] = flow;
+            }
+            break;
+        }
+        case SectionRemovedFlows: {
+            // 增量段里删除写在更新之前: 同一个键先结束又重新出现时, 更新里的是新流
+            std::vector<FlowKey> removed;
+            section.takeArray(removed);
+            for (const FlowKey &key : removed) {
+                flows.erase(key);
+            }
+            break;
+        }
+        case SectionScanSources:
+            if (!decodeScanTable(section, state.scanSourceState, state.scanSources)) {
+                return false;
+            }
+            break;
+        case SectionScanTargets:
+            if (!decodeScanTable(section, state.scanTargetState, state.scanTargets)) {
+                return false;
+            }
+            break;
+        case SectionHistory:
+            if (!state.history.restore(data, static_cast<std::size_t>(header.bytes))) {
+                return false;
+            }
+            break;
+        case SectionSamples: {
+            std::uint64_t count = 0;
+            section.take(count);
+            for (std::uint64_t i = 0; i < count && section.ok; ++i) {
+                ThroughputSample sample;
+                if (section.take(sample)) {
+                    state.history.append(sample);
+                }
+            }
+            break;
+        }
+        default:
+            break; // 新版本增加的节
+        }
+        if (!section.ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool Checkpoint::load(const QString &path, CheckpointState &state, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error != nullptr) {
+            *error = message;
+        }
+        return false;
+    };
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("无法打开检查点文件: %1").arg(file.errorString()));
+    }
+    const qint64 size = file.size();
+    if (size < static_cast<qint64>(sizeof(FileHeader) + sizeof(SegmentHeader))) {
+        return fail("检查点文件不完整");
+    }
+    // 整个文件映射进来, 流表和扫描状态直接从映射中复制, 不经过逐条解析
+    const std::uint8_t *base = file.map(0, size);
+    if (base == nullptr) {
+        return fail("无法映射检查点文件");
+    }
+    FileHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) {
+        file.unmap(const_cast<std::uint8_t *>(base));
+        return fail("不是检查点文件");
+    }
+    if (header.version != kVersion || header.layout != layoutTag()) {
+        file.unmap(const_cast<std::uint8_t *>(base));
+        return fail(QString("检查点文件版本 %1 与当前程序不兼容").arg(header.version));
+    }
+
+    FlowMap flows;
+    std::size_t offset = sizeof(FileHeader);
+    std::uint64_t lastSequence = 0;
+    state.segments = 0;
+    bool broken = false;
+    // 读到第一个不完整或校验失败的段为止, 之前的段仍然有效
+    while (static_cast<std::size_t>(size) - offset >= sizeof(SegmentHeader)) {
+        SegmentHeader segment;
+        std::memcpy(&segment, base + offset, sizeof(segment));
+        const std::size_t available = static_cast<std::size_t>(size) - offset - sizeof(SegmentHeader);
+        const std::uint8_t *payload = base + offset + sizeof(SegmentHeader);
+        if (segment.magic != kSegmentMagic || segment.payloadBytes > available
+            || checksum(payload, static_cast<std::size_t>(segment.payloadBytes)) != segment.checksum) {
+            break;
+        }
+        const bool full = segment.kind == SegmentFull;
+        if (state.segments == 0 ? !full : segment.sequence != lastSequence + 1) {
+            break;
+        }
+        if (!applySegment(payload, static_cast<std::size_t>(segment.payloadBytes), full, state, flows)) {
+            broken = true;
+            break;
+        }
+        ++state.segments;
+        lastSequence = segment.sequence;
+        state.savedAtMs = segment.savedAtMs;
+        offset += sizeof(SegmentHeader) + static_cast<std::size_t>(segment.payloadBytes);
+    }
+    file.unmap(const_cast<std::uint8_t *>(base));
+    if (broken || state.segments == 0) {
+        return fail("检查点文件已损坏");
+    }
+
+    state.flows.clear();
+    state.flows.reserve(flows.size());
+    for (const auto &entry : flows) {
+        state.flows.push_back(entry.second);
+    }
+    return true;
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    close();
+}
+
+bool CheckpointWriter::open(const QString &filePath, QString *errorOut)
+{
+    close();
+    const QFileInfo info(filePath);
+    if (!QDir().mkpath(info.absolutePath())) {
+        if (errorOut != nullptr) {
+            *errorOut = QString("无法创建检查点目录: %1").arg(info.absolutePath());
+        }
+        return false;
+    }
+    path = filePath;
+    stopping = false;
+    writing = false;
+    error.clear();
+    needFull = true;
+    sequence = 0;
+    fullBytes = deltaBytes = 0;
+    deltas = 0;
+    worker = std::thread(&CheckpointWriter::writeLoop, this);
+    return true;
+}
+
+void CheckpointWriter::close()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+    pending.reset();
+}
+
+bool CheckpointWriter::isBusy() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return writing || pending != nullptr;
+}
+
+void CheckpointWriter::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return !writing && pending == nullptr; });
+}
+
+bool CheckpointWriter::submit(std::unique_ptr<CheckpointSegment> segment)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (writing || pending != nullptr) {
+        return false;
+    }
+    pending = std::move(segment);
+    lock.unlock();
+    changed.notify_all();
+    return true;
+}
+
+QString CheckpointWriter::errorString() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+void CheckpointWriter::writeLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return stopping || pending != nullptr; });
+        if (pending == nullptr) {
+            return; // 停止时已经没有待写的段
+        }
+        std::unique_ptr<CheckpointSegment> segment = std::move(pending);
+        writing = true;
+        lock.unlock();
+        const bool ok = writeSegment(*segment);
+        segment.reset();
+        lock.lock();
+        writing = false;
+        if (ok) {
+            error.clear();
+        }
+        changed.notify_all();
+    }
+}
+
+bool CheckpointWriter::writeSegment(const CheckpointSegment &segment)
+{
+    Encoder payload;
+    encodeSegment(segment, payload);
+
+    SegmentHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kSegmentMagic;
+    header.kind = segment.full ? SegmentFull : SegmentDelta;
+    header.sequence = segment.full ? 1 : sequence + 1;
+    header.savedAtMs = QDateTime::currentMSecsSinceEpoch();
+    header.payloadBytes = payload.out.size();
+    header.checksum = checksum(payload.out.data(), payload.out.size());
+    const quint64 bytes = sizeof(SegmentHeader) + payload.out.size();
+
+    auto failed = [this](const QString &message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = message;
+        needFull = true; // 追加了一半的段之后不能再接增量, 下次重写完整状态
+        return false;
+    };
+
+    if (segment.full) {
+        // 写到临时文件后原子替换, 写入过程中退出时旧的检查点仍然完整
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return failed(QString("无法写入检查点: %1").arg(file.errorString()));
+        }
+        FileHeader fileHeader;
+        std::memset(&fileHeader, 0, sizeof(fileHeader));
+        std::memcpy(fileHeader.magic, kFileMagic, sizeof(kFileMagic));
+        fileHeader.version = kVersion;
+        fileHeader.layout = layoutTag();
+        fileHeader.createdMs = header.savedAtMs;
+        file.write(reinterpret_cast<const char *>(&fileHeader), sizeof(fileHeader));
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(payload.out.data()), static_cast<qint64>(payload.out.size()));
+        if (!file.commit()) {
+            return failed(QString("无法写入检查点: %1").arg(file.errorString()));
+        }
+        fullBytes = bytes;
+        deltaBytes = 0;
+        deltas = 0;
+    } else {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            return failed(QString("无法写入检查点: %1").arg(file.errorString()));
+        }
+        const bool ok = file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header)
+                        && file.write(reinterpret_cast<const char *>(payload.out.data()),
+                                      static_cast<qint64>(payload.out.size()))
+                               == static_cast<qint64>(payload.out.size())
+                        && file.flush();
+        if (!ok) {
+            return failed(QString("无法写入检查点: %1").arg(file.errorString()));
+        }
+        deltaBytes += bytes;
+        ++deltas;
+    }
+    sequence = header.sequence;
+    segmentBytes = bytes;
+    needFull = deltas >= kMaxDeltas || deltaBytes > fullBytes;
+    return true;
+}
@@ -0,0 +1,132 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "AnalysisTypes.h"
+#include "FlowTable.h"
+#include "ScanDetector.h"
+#include "ThroughputHistory.h"
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 分析状态的检查点, 长时间分析时定期写入, 程序重启后恢复计数、流表、扫描检测状态和吞吐量历史。
+// 文件是一个日志: 文件头之后先是一段完整状态, 再追加若干增量段, 每段只含上一段以来变化的流和
+// 扫描状态槽位、新结束的整秒样本以及全部计数。增量积累过多时写一个新的完整段, 通过临时文件
+// 原子替换旧文件。每段带校验和, 程序在写入中途退出时读取到最后一个完整的段为止。
+// 流和扫描状态按内存布局直接写出, 布局变化时版本号和布局标记都会拒绝旧文件
+
+// 写入一段检查点所需的数据, 分析线程填写后交给写线程编码
+struct CheckpointSegment
+{
+    bool full = false;
+    QString source;
+    TrafficStats stats;
+    quint64 lastPacketNs = 0;
+    double tcpVariance = 0;
+    double udpVariance = 0;
+    double httpVariance = 0;
+    bool haveSecond = false;
+    ThroughputSample currentSecond; // 还没结束的一秒
+    GroupTrafficMatrix groupTraffic;
+
+    std::vector<FlowSnapshot> flows;
+    std::vector<FlowKey> removedFlows; // 只在增量段中
+    ScanTableState scanSourceState;
+    ScanTableState scanTargetState;
+    std::vector<std::uint32_t> scanSourceSlots;
+    std::vector<ScanEntry> scanSourceEntries;
+    std::vector<std::uint32_t> scanTargetSlots;
+    std::vector<ScanEntry> scanTargetEntries;
+
+    std::vector<std::uint8_t> history;  // 完整段: ThroughputHistory::save 的结果
+    QVector<ThroughputSample> samples;  // 增量段: 上一段以来结束的整秒
+};
+
+// 从文件读出并合并后的状态
+struct CheckpointState
+{
+    QString source;
+    qint64 savedAtMs = 0; // 最后一个有效段的写入时间
+    int segments = 0;
+    TrafficStats stats;
+    quint64 lastPacketNs = 0;
+    double tcpVariance = 0;
+    double udpVariance = 0;
+    double httpVariance = 0;
+    bool haveSecond = false;
+    ThroughputSample currentSecond;
+    GroupTrafficMatrix groupTraffic;
+    std::vector<FlowSnapshot> flows;
+    ScanTableState scanSourceState;
+    ScanTableState scanTargetState;
+    std::vector<ScanEntry> scanSources; // 按槽位, 大小等于表容量
+    std::vector<ScanEntry> scanTargets;
+    ThroughputHistory history;
+};
+
+namespace Checkpoint {
+
+// 映射文件读取; 文件不存在、版本不符或第一段就损坏时返回false
+bool load(const QString &path, CheckpointState &state, QString *error = nullptr);
+
+} // namespace Checkpoint
+
+// 检查点写线程。编码和写盘都在这里进行, 分析线程只复制变化的部分
+class CheckpointWriter
+{
+public:
+    // 追加这么多个增量段, 或增量的总大小超过完整段时, 下一段改写完整状态
+    static constexpr int kMaxDeltas = 32;
+
+    CheckpointWriter() = default;
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter &) = delete;
+    CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+    // 创建所在目录并启动写线程; 第一段总是完整状态, 写成功后才替换已有的文件
+    bool open(const QString &path, QString *error = nullptr);
+    // 写完已经交出的段后结束写线程
+    void close();
+    bool isOpen() const { return worker.joinable(); }
+
+    // 上一段还没写完
+    bool isBusy() const;
+    void waitIdle();
+    // 下一段应当写完整状态; 只在空闲时读取才准确
+    bool wantsFull() const { return needFull.load(); }
+    // 交给写线程; 上一段还没写完时返回false, 调用方应先检查 isBusy() 再收集变化
+    bool submit(std::unique_ptr<CheckpointSegment> segment);
+
+    // 最近一次写入失败的原因, 之后写成功时清空
+    QString errorString() const;
+    quint64 lastSegmentBytes() const { return segmentBytes.load(); }
+
+private:
+    void writeLoop();
+    bool writeSegment(const CheckpointSegment &segment);
+
+    QString path;
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::unique_ptr<CheckpointSegment> pending;
+    bool writing = false;
+    bool stopping = false;
+    QString error;
+    std::atomic<bool> needFull{true};
+    std::atomic<quint64> segmentBytes{0};
+
+    // 以下只由写线程访问
+    std::uint64_t sequence = 0;
+    quint64 fullBytes = 0;
+    quint64 deltaBytes = 0;
+    int deltas = 0;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,197 @@
+#include "Checksum.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cstring>
+
+#if TA_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using SumFn = std::uint64_t (*)(const std::uint8_t *, std::size_t);
+
+// 以32位字累加到64位累加器, 折叠后与按16位字求和的结果相同
+std::uint64_t sumScalar(const std::uint8_t *p, std::size_t len)
+{
+    std::uint64_t acc = 0;
+    while (len >= 4) {
+        std::uint32_t w;
+        std::memcpy(&w, p, sizeof(w));
+        acc += w;
+        p += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        std::uint16_t w;
+        std::memcpy(&w, p, sizeof(w));
+        acc += w;
+        p += 2;
+        len -= 2;
+    }
+    if (len == 1) {
+        // 奇数长度时末尾补零
+        const std::uint8_t tail[2] = {p[0], 0};
+        std::uint16_t w;
+        std::memcpy(&w, tail, sizeof(w));
+        acc += w;
+    }
+    return acc;
+}
+
+#if TA_X86
+TA_TARGET("avx2")
+std::uint64_t sumAvx2(const std::uint8_t *p, std::size_t len)
+{
+    // 每个32位通道每轮最多增加 2 * 0xffff, 32768轮以内不会溢出
+    constexpr std::size_t kMaxRounds = 32768;
+    const __m256i lowMask = _mm256_set1_epi32(0xffff);
+    std::uint64_t total = 0;
+
+    while (len >= 32) {
+        const std::size_t rounds = std::min(len / 32, kMaxRounds);
+        __m256i acc = _mm256_setzero_si256();
+        for (std::size_t i = 0; i < rounds; ++i) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            acc = _mm256_add_epi32(acc, _mm256_and_si256(v, lowMask));
+            acc = _mm256_add_epi32(acc, _mm256_srli_epi32(v, 16));
+            p += 32;
+        }
+        len -= rounds * 32;
+
+        alignas(32) std::uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        for (std::uint32_t lane : lanes) {
+            total += lane;
+        }
+    }
+    return total + sumScalar(p, len);
+}
+#endif
+
+struct Implementation
+{
+    SumFn sum;
+    const char *name;
+};
+
+const Implementation &implementation()
+{
+    static const Implementation impl = []() -> Implementation {
+#if TA_X86
+        if (CpuFeatures::hasAvx2()) {
+            return {sumAvx2, "avx2"};
+        }
+#endif
+        return {sumScalar, "scalar"};
+    }();
+    return impl;
+}
+
+std::uint16_t loadField(const std::uint8_t *p)
+{
+    std::uint16_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// TCP/UDP伪首部的部分和
+std::uint64_t pseudoHeaderSum(const DecodedPacket &pkt)
+{
+    const std::size_t addrLen = pkt.ipVersion == 6 ? 16 : 4;
+    const auto l4Len = static_cast<std::uint32_t>(pkt.l4Len);
+    std::uint64_t acc = Checksum::sum(pkt.srcAddr, addrLen) + Checksum::sum(pkt.dstAddr, addrLen);
+    if (pkt.ipVersion == 6) {
+        const std::uint8_t tail[8] = {
+            static_cast<std::uint8_t>(l4Len >> 24), static_cast<std::uint8_t>(l4Len >> 16),
+            static_cast<std::uint8_t>(l4Len >> 8), static_cast<std::uint8_t>(l4Len),
+            0, 0, 0, pkt.l4Proto
+        };
+        acc += Checksum::sum(tail, sizeof(tail));
+    } else {
+        const std::uint8_t tail[4] = {
+            0, pkt.l4Proto, static_cast<std::uint8_t>(l4Len >> 8), static_cast<std::uint8_t>(l4Len)
+        };
+        acc += Checksum::sum(tail, sizeof(tail));
+    }
+    return acc;
+}
+
+Checksum::Status validateTransport(const DecodedPacket &pkt, std::uint8_t rawFlags)
+{
+    using Checksum::Status;
+    if (pkt.isFragment || pkt.l4 == nullptr) {
+        return Status::Unchecked;
+    }
+
+    std::size_t fieldOffset = 0;
+    if (pkt.l4Proto == ProtoTcp) {
+        fieldOffset = 16;
+    } else if (pkt.l4Proto == ProtoUdp) {
+        fieldOffset = 6;
+    } else {
+        return Status::Unchecked;
+    }
+    if (pkt.l4Len < fieldOffset + 2) {
+        return Status::Unchecked;
+    }
+    if (rawFlags & PacketChecksumPartial) {
+        return Status::Offloaded;
+    }
+
+    const std::uint16_t field = loadField(pkt.l4 + fieldOffset);
+    if (field == 0) {
+        // IPv4上UDP校验和为0表示未使用; TCP为0几乎只会出现在发送卸载的捕获中
+        return pkt.l4Proto == ProtoUdp && pkt.ipVersion == 4 ? Status::Unchecked : Status::Offloaded;
+    }
+
+    const std::uint64_t pseudo = pseudoHeaderSum(pkt);
+    if (Checksum::fold(pseudo + Checksum::sum(pkt.l4, pkt.l4Len)) == 0xffff) {
+        return Status::Ok;
+    }
+    // 发送卸载时字段里只有伪首部的和, 等网卡补全
+    const std::uint16_t pseudoFolded = Checksum::fold(pseudo);
+    if (field == pseudoFolded || field == static_cast<std::uint16_t>(~pseudoFolded)) {
+        return Status::Offloaded;
+    }
+    return Status::Bad;
+}
+
+} // namespace
+
+std::uint64_t Checksum::sum(const std::uint8_t *data, std::size_t len)
+{
+    return implementation().sum(data, len);
+}
+
+std::uint16_t Checksum::fold(std::uint64_t partial)
+{
+    while (partial >> 16) {
+        partial = (partial & 0xffff) + (partial >> 16);
+    }
+    return static_cast<std::uint16_t>(partial);
+}
+
+Checksum::Result Checksum::validate(const DecodedPacket &pkt, std::uint8_t rawFlags)
+{
+    Result result;
+    if (pkt.l3Truncated) {
+        return result;
+    }
+
+    if (pkt.ipVersion == 4) {
+        const std::size_t headerLen = static_cast<std::size_t>(pkt.l3[0] & 0x0f) * 4;
+        if (loadField(pkt.l3 + 10) == 0) {
+            result.ip = Status::Offloaded;
+        } else {
+            result.ip = fold(sum(pkt.l3, headerLen)) == 0xffff ? Status::Ok : Status::Bad;
+        }
+    }
+    result.l4 = validateTransport(pkt, rawFlags);
+    return result;
+}
+
+const char *Checksum::implementationName()
+{
+    return implementation().name;
+}
@@ -0,0 +1,37 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include "PacketDecoder.h"
+
+namespace Checksum {
+
+enum class Status : std::uint8_t {
+    Unchecked, // 截断、分片或协议没有校验和
+    Ok,
+    Bad,
+    Offloaded  // 网卡校验和卸载, 捕获到的值尚未计算
+};
+
+struct Result
+{
+    Status ip = Status::Unchecked;
+    Status l4 = Status::Unchecked;
+
+    bool bad() const { return ip == Status::Bad || l4 == Status::Bad; }
+};
+
+// 反码求和 (RFC 1071), 结果按主机字节序累加, 折叠前的64位部分和
+std::uint64_t sum(const std::uint8_t *data, std::size_t len);
+
+// 把部分和折叠成16位
+std::uint16_t fold(std::uint64_t partial);
+
+// 校验IPv4头部以及TCP/UDP校验和, rawFlags 为 RawPacket::flags
+Result validate(const DecodedPacket &pkt, std::uint8_t rawFlags);
+
+// 运行时选中的求和实现: "avx2" 或 "scalar"
+const char *implementationName();
+
+} // namespace Checksum
+
+#endif // CHECKSUM_H
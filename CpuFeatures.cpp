@@ -0,0 +1,46 @@
+#include "CpuFeatures.h"
+
+#if TA_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct Features
+{
+    bool sse42 = false;
+    bool avx2 = false;
+};
+
+Features detect()
+{
+    Features f;
+#if TA_X86 && defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    f.sse42 = (info[2] & (1 << 20)) != 0;
+    // AVX2还要求操作系统保存YMM寄存器状态
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        f.avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#elif TA_X86 && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    f.sse42 = __builtin_cpu_supports("sse4.2");
+    f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return f;
+}
+
+const Features &features()
+{
+    static const Features f = detect();
+    return f;
+}
+
+} // namespace
+
+bool CpuFeatures::hasSse42() { return features().sse42; }
+bool CpuFeatures::hasAvx2() { return features().avx2; }
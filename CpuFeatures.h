@@ -0,0 +1,26 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// 运行时CPU特性检测, 用于在SIMD实现和标量实现之间选择
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TA_X86 1
+#else
+#define TA_X86 0
+#endif
+
+// GCC/Clang需要为使用高级指令集的函数单独声明目标, MSVC可以直接使用内建函数
+#if TA_X86 && (defined(__GNUC__) || defined(__clang__))
+#define TA_TARGET(features) __attribute__((target(features)))
+#else
+#define TA_TARGET(features)
+#endif
+
+namespace CpuFeatures {
+
+bool hasSse42();
+bool hasAvx2();
+
+} // namespace CpuFeatures
+
+#endif // CPUFEATURES_H
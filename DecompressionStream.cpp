@@ -0,0 +1,441 @@
+#include "DecompressionStream.h"
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <cstring>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace {
+
+constexpr std::size_t kInputChunk = 1024 * 1024;
+// 单条记录的上限, 超过时按文件损坏处理, 避免一个错误的长度字段把整个文件读进内存
+constexpr std::size_t kMaxPeek = 64 * 1024 * 1024;
+
+// 各压缩格式的统一接口: 从 in 取数据写到 out, 两边的指针和剩余长度都会前移
+class Inflater
+{
+public:
+    virtual ~Inflater() = default;
+    // 出错返回false; inLen 为0时只输出解压器内部还没交出的数据
+    virtual bool run(const std::uint8_t *&in, std::size_t &inLen, std::uint8_t *&out, std::size_t &outLen,
+                     QString &error) = 0;
+    // 最后一个 gzip 成员或 zstd/lz4 帧已经解到结束标记。文件读完时不在结束处说明文件被截断
+    bool atEnd() const { return ended; }
+
+protected:
+    bool ended = false;
+};
+
+#ifdef HAVE_ZLIB
+class GzipInflater final : public Inflater
+{
+public:
+    GzipInflater()
+    {
+        std::memset(&stream, 0, sizeof(stream));
+        ready = inflateInit2(&stream, 15 + 32) == Z_OK; // 自动识别gzip/zlib头
+    }
+    ~GzipInflater() override { inflateEnd(&stream); }
+
+    bool run(const std::uint8_t *&in, std::size_t &inLen, std::uint8_t *&out, std::size_t &outLen,
+             QString &error) override
+    {
+        if (!ready) {
+            error = "zlib初始化失败";
+            return false;
+        }
+        stream.next_in = const_cast<Bytef *>(in);
+        stream.avail_in = static_cast<uInt>(std::min<std::size_t>(inLen, UINT32_MAX));
+        stream.next_out = out;
+        stream.avail_out = static_cast<uInt>(std::min<std::size_t>(outLen, UINT32_MAX));
+        const uInt availIn = stream.avail_in;
+        const uInt availOut = stream.avail_out;
+        const int rc = inflate(&stream, Z_NO_FLUSH);
+        const std::size_t used = availIn - stream.avail_in;
+        const std::size_t produced = availOut - stream.avail_out;
+        in += used;
+        inLen -= used;
+        out += produced;
+        outLen -= produced;
+        if (rc == Z_STREAM_END) {
+            ended = true;
+            inflateReset(&stream); // 多个gzip成员首尾相接, 继续解下一个
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            error = QString("gzip数据损坏: %1").arg(stream.msg != nullptr ? stream.msg : "");
+            return false;
+        } else if (used > 0) {
+            ended = false; // 开始解下一个成员
+        }
+        return true;
+    }
+
+private:
+    z_stream stream;
+    bool ready = false;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+class ZstdInflater final : public Inflater
+{
+public:
+    ZstdInflater() : stream(ZSTD_createDStream()) {}
+    ~ZstdInflater() override { ZSTD_freeDStream(stream); }
+
+    bool run(const std::uint8_t *&in, std::size_t &inLen, std::uint8_t *&out, std::size_t &outLen,
+             QString &error) override
+    {
+        ZSTD_inBuffer input{in, inLen, 0};
+        ZSTD_outBuffer output{out, outLen, 0};
+        const std::size_t rc = ZSTD_decompressStream(stream, &output, &input);
+        if (ZSTD_isError(rc)) {
+            error = QString("zstd数据损坏: %1").arg(ZSTD_getErrorName(rc));
+            return false;
+        }
+        // 返回0表示一帧已经解完并全部交出
+        if (input.pos > 0 || output.pos > 0) {
+            ended = rc == 0;
+        }
+        in += input.pos;
+        inLen -= input.pos;
+        out += output.pos;
+        outLen -= output.pos;
+        return true;
+    }
+
+private:
+    ZSTD_DStream *stream;
+};
+#endif
+
+#ifdef HAVE_LZ4
+class Lz4Inflater final : public Inflater
+{
+public:
+    Lz4Inflater() { ready = !LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)); }
+    ~Lz4Inflater() override { LZ4F_freeDecompressionContext(context); }
+
+    bool run(const std::uint8_t *&in, std::size_t &inLen, std::uint8_t *&out, std::size_t &outLen,
+             QString &error) override
+    {
+        if (!ready) {
+            error = "lz4初始化失败";
+            return false;
+        }
+        std::size_t used = inLen;
+        std::size_t produced = outLen;
+        const std::size_t rc = LZ4F_decompress(context, out, &produced, in, &used, nullptr);
+        if (LZ4F_isError(rc)) {
+            error = QString("lz4数据损坏: %1").arg(LZ4F_getErrorName(rc));
+            return false;
+        }
+        // 与zstd相同, 返回0表示一帧已经解完并全部交出
+        if (used > 0 || produced > 0) {
+            ended = rc == 0;
+        }
+        in += used;
+        inLen -= used;
+        out += produced;
+        outLen -= produced;
+        return true;
+    }
+
+private:
+    LZ4F_dctx *context = nullptr;
+    bool ready = false;
+};
+#endif
+
+std::unique_ptr<Inflater> makeInflater(DecompressionStream::Codec codec)
+{
+    switch (codec) {
+#ifdef HAVE_ZLIB
+    case DecompressionStream::Codec::Gzip: return std::make_unique<GzipInflater>();
+#endif
+#ifdef HAVE_ZSTD
+    case DecompressionStream::Codec::Zstd: return std::make_unique<ZstdInflater>();
+#endif
+#ifdef HAVE_LZ4
+    case DecompressionStream::Codec::Lz4: return std::make_unique<Lz4Inflater>();
+#endif
+    default: return nullptr;
+    }
+}
+
+} // namespace
+
+DecompressionStream::Codec DecompressionStream::detect(const std::uint8_t *data, std::size_t len)
+{
+    if (len >= 2 && data[0] == 0x1f && data[1] == 0x8b) {
+        return Codec::Gzip;
+    }
+    if (len >= 4 && data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd) {
+        return Codec::Zstd;
+    }
+    if (len >= 4 && data[0] == 0x04 && data[1] == 0x22 && data[2] == 0x4d && data[3] == 0x18) {
+        return Codec::Lz4;
+    }
+    return Codec::None;
+}
+
+const char *DecompressionStream::codecName(Codec codec)
+{
+    switch (codec) {
+    case Codec::Gzip: return "gzip";
+    case Codec::Zstd: return "zstd";
+    case Codec::Lz4: return "lz4";
+    case Codec::None: break;
+    }
+    return "none";
+}
+
+bool DecompressionStream::isSupported(Codec codec)
+{
+    switch (codec) {
+    case Codec::Gzip:
+#ifdef HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case Codec::Zstd:
+#ifdef HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case Codec::Lz4:
+#ifdef HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    case Codec::None: break;
+    }
+    return true;
+}
+
+DecompressionStream::~DecompressionStream()
+{
+    close();
+}
+
+bool DecompressionStream::open(const QString &path, Codec codec, QString *errorOut)
+{
+    close();
+    if (!isSupported(codec)) {
+        if (errorOut != nullptr) {
+            *errorOut = QString("编译时没有启用%1解压支持").arg(codecName(codec));
+        }
+        return false;
+    }
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorOut != nullptr) {
+            *errorOut = QString("无法打开文件: %1").arg(file.errorString());
+        }
+        return false;
+    }
+    compressedSize = static_cast<std::uint64_t>(file.size());
+    compressedRead = 0;
+
+    // 缓冲区一次分配好, 整个环计入内存预算
+    ring.clear();
+    for (int i = 0; i < kRingBuffers; ++i) {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->storage.resize(kHeadroom + kBufferBytes);
+        freeBuffers.push_back(buffer.get());
+        ring.push_back(std::move(buffer));
+    }
+    MemoryBudget::global().charge(MemoryBudget::Packets, kRingBuffers * (kHeadroom + kBufferBytes));
+    MemoryBudget::global().addSlabs(MemoryBudget::Packets, kRingBuffers);
+
+    worker = std::thread(&DecompressionStream::inflateLoop, this, codec);
+    return true;
+}
+
+void DecompressionStream::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    freeReady.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (!ring.empty()) {
+        MemoryBudget::global().release(MemoryBudget::Packets, ring.size() * (kHeadroom + kBufferBytes));
+        MemoryBudget::global().addSlabs(MemoryBudget::Packets, -static_cast<std::int64_t>(ring.size()));
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    ring.clear();
+    filledBuffers.clear();
+    freeBuffers.clear();
+    oversized.clear();
+    current = nullptr;
+    pos = end = nullptr;
+    finished = false;
+    stopping = false;
+    error.clear();
+}
+
+void DecompressionStream::inflateLoop(Codec codec)
+{
+    std::unique_ptr<Inflater> inflater = makeInflater(codec);
+    std::vector<std::uint8_t> input(kInputChunk);
+    const std::uint8_t *in = input.data();
+    std::size_t inLen = 0;
+    bool fileEnd = false; // 压缩数据已经全部读入
+    bool eof = false;     // 解压器也已经交出全部数据
+    QString failure;
+
+    while (!eof && failure.isEmpty()) {
+        Buffer *buffer = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            freeReady.wait(lock, [this]() { return stopping || !freeBuffers.empty(); });
+            if (stopping) {
+                return;
+            }
+            buffer = freeBuffers.front();
+            freeBuffers.pop_front();
+        }
+
+        std::uint8_t *out = buffer->data();
+        std::size_t outLen = kBufferBytes;
+        while (outLen > 0) {
+            if (inLen == 0 && !fileEnd) {
+                const qint64 n = file.read(reinterpret_cast<char *>(input.data()), static_cast<qint64>(input.size()));
+                if (n < 0) {
+                    // 读取出错不能当作文件结束, 否则抓包会被悄悄截断
+                    failure = QString("读取文件失败: %1").arg(file.errorString());
+                    break;
+                }
+                fileEnd = n == 0;
+                in = input.data();
+                inLen = static_cast<std::size_t>(n);
+                compressedRead += static_cast<std::uint64_t>(n);
+            }
+            // 文件读完后继续以空输入调用, 交出解压器内部剩下的数据
+            const std::size_t before = outLen;
+            const std::size_t inBefore = inLen;
+            if (!inflater->run(in, inLen, out, outLen, failure)) {
+                break;
+            }
+            if (outLen == before && inLen == inBefore) {
+                if (fileEnd) {
+                    if (!inflater->atEnd()) {
+                        failure = QString("%1数据不完整, 文件可能被截断").arg(codecName(codec));
+                    }
+                    eof = true;
+                    break;
+                }
+                inLen = 0; // 解压器不再前进 (末尾多余的字节), 读下一块
+            }
+        }
+        buffer->len = kBufferBytes - outLen;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            filledBuffers.push_back(buffer);
+        }
+        filledReady.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        error = failure;
+    }
+    filledReady.notify_one();
+}
+
+DecompressionStream::Buffer *DecompressionStream::takeFilled()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    filledReady.wait(lock, [this]() { return !filledBuffers.empty() || finished; });
+    if (filledBuffers.empty()) {
+        return nullptr;
+    }
+    Buffer *buffer = filledBuffers.front();
+    filledBuffers.pop_front();
+    return buffer;
+}
+
+void DecompressionStream::recycle(Buffer *buffer)
+{
+    if (buffer == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(buffer);
+    }
+    freeReady.notify_one();
+}
+
+const std::uint8_t *DecompressionStream::peek(std::size_t len)
+{
+    if (static_cast<std::size_t>(end - pos) >= len) {
+        return pos;
+    }
+    if (len > kMaxPeek || ring.empty()) {
+        return nullptr;
+    }
+    while (static_cast<std::size_t>(end - pos) < len) {
+        Buffer *next = takeFilled();
+        if (next == nullptr) {
+            return nullptr;
+        }
+        const std::size_t remaining = static_cast<std::size_t>(end - pos);
+        if (remaining <= kHeadroom) {
+            // 把上一个缓冲区剩下的尾部放到新缓冲区前面的预留空间里
+            std::uint8_t *start = next->data() - remaining;
+            if (remaining > 0) {
+                std::memmove(start, pos, remaining);
+            }
+            recycle(current);
+            oversized.clear();
+            current = next;
+            pos = start;
+            end = next->data() + next->len;
+        } else {
+            // 预留空间放不下, 拼到单独的缓冲区里
+            std::vector<std::uint8_t> joined;
+            joined.reserve(remaining + next->len);
+            joined.insert(joined.end(), pos, end);
+            joined.insert(joined.end(), next->data(), next->data() + next->len);
+            recycle(current);
+            recycle(next);
+            current = nullptr;
+            oversized.swap(joined);
+            pos = oversized.data();
+            end = pos + oversized.size();
+        }
+    }
+    return pos;
+}
+
+int DecompressionStream::progress() const
+{
+    if (compressedSize == 0) {
+        return 100;
+    }
+    return static_cast<int>(static_cast<double>(compressedRead.load()) * 100.0 / static_cast<double>(compressedSize));
+}
+
+QString DecompressionStream::errorString() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
@@ -0,0 +1,89 @@
+#ifndef DECOMPRESSIONSTREAM_H
+#define DECOMPRESSIONSTREAM_H
+
+#include "ByteStream.h"
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 压缩的抓包文件 (.gz/.zst/.lz4) 的流式解压。解压在独立线程中进行, 结果写进一组大缓冲区
+// 组成的环, 读取方按顺序取用, 解压和分析同时进行, 不需要临时文件。
+// 每个缓冲区前面留有空间, 跨缓冲区的记录只把前一个缓冲区剩下的尾部复制过去就能连续读取
+class DecompressionStream final : public ByteStream
+{
+public:
+    enum class Codec {
+        None,
+        Gzip,
+        Zstd,
+        Lz4
+    };
+
+    // 按文件开头的魔数判断压缩格式
+    static Codec detect(const std::uint8_t *data, std::size_t len);
+    static const char *codecName(Codec codec);
+    // 编译时是否带了该格式的解压库
+    static bool isSupported(Codec codec);
+
+    DecompressionStream() = default;
+    ~DecompressionStream() override;
+
+    DecompressionStream(const DecompressionStream &) = delete;
+    DecompressionStream &operator=(const DecompressionStream &) = delete;
+
+    bool open(const QString &path, Codec codec, QString *error = nullptr);
+    void close();
+
+    const std::uint8_t *peek(std::size_t len) override;
+    void consume(std::size_t len) override { pos += len; }
+
+    // 按已读取的压缩数据估计
+    int progress() const override;
+    QString errorString() const override;
+
+private:
+    struct Buffer
+    {
+        std::vector<std::uint8_t> storage; // 前 kHeadroom 字节留给上一个缓冲区的尾部
+        std::size_t len = 0;
+        std::uint8_t *data() { return storage.data() + kHeadroom; }
+    };
+
+    static constexpr std::size_t kBufferBytes = 4 * 1024 * 1024;
+    static constexpr std::size_t kHeadroom = 256 * 1024;
+    static constexpr int kRingBuffers = 4;
+
+    void inflateLoop(Codec codec);
+    Buffer *takeFilled();
+    void recycle(Buffer *buffer);
+
+    QFile file;
+    std::uint64_t compressedSize = 0;
+    std::atomic<std::uint64_t> compressedRead{0};
+    std::vector<std::unique_ptr<Buffer>> ring;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable filledReady;
+    std::condition_variable freeReady;
+    std::deque<Buffer *> filledBuffers;
+    std::deque<Buffer *> freeBuffers;
+    bool finished = false; // 解压线程已经送出最后一个缓冲区
+    bool stopping = false;
+    QString error;
+
+    // 以下只由读取方访问
+    Buffer *current = nullptr;
+    std::vector<std::uint8_t> oversized; // 超过预留空间的记录在这里拼接
+    const std::uint8_t *pos = nullptr;
+    const std::uint8_t *end = nullptr;
+};
+
+#endif // DECOMPRESSIONSTREAM_H
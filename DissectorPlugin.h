@@ -0,0 +1,119 @@
+#ifndef DISSECTORPLUGIN_H
+#define DISSECTORPLUGIN_H
+
+/*
+ * 协议解析插件的C接口。插件是放在插件目录下的动态库, 只需包含这个头文件, 不依赖Qt和程序的其他头文件,
+ * 可以用任何能导出C函数的编译器构建。插件导出两个函数:
+ *
+ *   uint32_t ta_dissector_abi_version(void);
+ *       返回编译时的 TA_DISSECTOR_ABI_VERSION, 与程序不同时不加载
+ *   int ta_dissector_init(const ta_host_api *host, ta_registrar *registrar, ta_dissector *dissector);
+ *       填写 dissector, 并通过 host 的注册函数登记端口、启发式、自定义列和计数器; 返回0表示成功。
+ *       只在加载时调用一次, registrar 在返回后失效
+ *
+ * 分析时只由分析线程调用 dissect, 不需要加锁。数据包视图中的指针指向抓包缓冲区, 只在本次调用内有效,
+ * 需要保留的内容要自己拷贝。
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TA_DISSECTOR_ABI_VERSION 1
+
+#if defined(_WIN32)
+#define TA_DISSECTOR_EXPORT __declspec(dllexport)
+#else
+#define TA_DISSECTOR_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* 调用 dissect 的原因 */
+typedef enum ta_stage {
+    TA_STAGE_PORT = 0,      /* 源端口或目的端口是登记过的端口 */
+    TA_STAGE_HEURISTIC = 1, /* 没有插件认领的流, 按负载内容试探 */
+    TA_STAGE_FLOW = 2,      /* 插件已经认领的流中的后续数据包 */
+    TA_STAGE_COUNT
+} ta_stage;
+
+/* dissect 的返回值 */
+typedef enum ta_verdict {
+    TA_REJECT = 0,     /* 不是本协议, 试探的交给下一个插件, 其余按内置识别处理 */
+    TA_ACCEPT = 1,     /* 本包是本协议 */
+    TA_ACCEPT_FLOW = 2 /* 本包是本协议, 并认领整条流: 之后的包直接以 TA_STAGE_FLOW 交给本插件 */
+} ta_verdict;
+
+/* 解码后的数据包, 不做拷贝 */
+typedef struct ta_packet_view {
+    const uint8_t *payload; /* 传输层负载, TCP/UDP之外为IP负载 */
+    uint32_t payload_len;
+    uint32_t wire_len;      /* 线路上的原始长度 */
+    uint64_t ts_ns;
+    const uint8_t *src_addr; /* IPv4为4字节, IPv6为16字节, 网络序 */
+    const uint8_t *dst_addr;
+    uint8_t ip_version;
+    uint8_t l4_proto;
+    uint8_t tcp_flags;
+    uint8_t from_client;     /* 由流的发起方发出 */
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint32_t tcp_seq;
+} ta_packet_view;
+
+/* 数据包所属的流, 计数已经包含本包 */
+typedef struct ta_flow_view {
+    uint64_t first_ns;
+    uint64_t packets;
+    uint64_t bytes;
+    /* 插件可以在流上保存一个64位值 (例如自己的状态表下标), 新的流为0。流被认领后只有认领的插件能看到它;
+     * 流结束时不会通知插件, 不要在这里保存需要释放的指针 */
+    uint64_t *cookie;
+} ta_flow_view;
+
+typedef struct ta_registrar ta_registrar;
+typedef struct ta_dissect_ctx ta_dissect_ctx;
+
+/* 程序提供给插件的函数 */
+typedef struct ta_host_api {
+    uint32_t abi_version;
+    uint32_t struct_size; /* sizeof(ta_host_api), 之后的版本只会在末尾追加函数 */
+
+    /* 以下只能在 ta_dissector_init 中调用, 成功返回0 */
+    /* l4_proto 为6 (TCP) 或17 (UDP)。每个端口只能由一个插件登记, 先加载的插件优先 */
+    int (*register_port)(ta_registrar *registrar, uint8_t l4_proto, uint16_t port);
+    /* 该协议上没有被认领、内置识别也认不出的流, 前几个有负载的包交给插件试探 */
+    int (*register_heuristic)(ta_registrar *registrar, uint8_t l4_proto);
+    /* 结果表中追加一列, 返回插件内的列号 (从0开始), 失败返回-1 */
+    int (*add_column)(ta_registrar *registrar, const char *name);
+    /* 调试面板中显示的计数器, 返回插件内的计数器号 (从0开始), 失败返回-1 */
+    int (*add_counter)(ta_registrar *registrar, const char *name);
+
+    /* 以下只能在 dissect 中调用。文字为UTF-8, len 为字节数; 列和摘要只在返回 ACCEPT 时写入结果行 */
+    void (*set_column)(ta_dissect_ctx *ctx, int column, const char *text, size_t len);
+    /* 替换流量类型列的文字 */
+    void (*set_summary)(ta_dissect_ctx *ctx, const char *text, size_t len);
+    void (*add_count)(ta_dissect_ctx *ctx, int counter, uint64_t delta);
+} ta_host_api;
+
+typedef ta_verdict (*ta_dissect_fn)(void *state, ta_stage stage, const ta_packet_view *packet, ta_flow_view *flow,
+                                    ta_dissect_ctx *ctx);
+
+/* 由 ta_dissector_init 填写 */
+typedef struct ta_dissector {
+    const char *name;     /* 插件名, 显示在日志和调试面板中 */
+    const char *protocol; /* 认领的包在协议列中显示的名称, 也出现在协议过滤中; 为空时沿用内置协议名 */
+    void *state;          /* 原样传给 dissect 和 destroy */
+    ta_dissect_fn dissect;
+    void (*destroy)(void *state); /* 卸载前调用, 可以为空 */
+} ta_dissector;
+
+typedef uint32_t (*ta_dissector_abi_version_fn)(void);
+typedef int (*ta_dissector_init_fn)(const ta_host_api *host, ta_registrar *registrar, ta_dissector *dissector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISSECTORPLUGIN_H */
@@ -0,0 +1,404 @@
+#include "DissectorRegistry.h"
+#include "FlowTable.h"
+#include "PacketDecoder.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QLibrary>
+#include <algorithm>
+#include <chrono>
+
+// 插件在 ta_dissector_init 中登记的内容, 初始化成功后才并入插件表
+struct ta_registrar
+{
+    std::vector<std::pair<std::uint8_t, std::uint16_t>> ports; // (传输层协议, 端口)
+    std::vector<std::uint8_t> heuristics;
+    QStringList columns;
+    QStringList counters;
+};
+
+// 一次 dissect 调用中插件写入的内容。插件拒绝时丢弃, 认领时由 apply 写到结果行
+struct ta_dissect_ctx
+{
+    const DissectorRegistry::Dissector *dissector = nullptr; // 正在调用的插件
+    DissectorStats *stats = nullptr;
+    int columnCount = 0; // 所有插件的列数
+    QString summary;
+    bool hasSummary = false;
+    QStringList columns; // 有插件写入列时才分配
+};
+
+namespace {
+
+// 丢弃插件拒绝前写入的内容
+void discard(ta_dissect_ctx &ctx)
+{
+    if (ctx.hasSummary) {
+        ctx.summary.clear();
+        ctx.hasSummary = false;
+    }
+    if (!ctx.columns.isEmpty()) {
+        ctx.columns.clear();
+    }
+}
+
+bool isTransport(std::uint8_t l4Proto)
+{
+    return l4Proto == ProtoTcp || l4Proto == ProtoUdp;
+}
+
+int registerPort(ta_registrar *registrar, std::uint8_t l4Proto, std::uint16_t port)
+{
+    if (registrar == nullptr || !isTransport(l4Proto)) {
+        return -1;
+    }
+    registrar->ports.emplace_back(l4Proto, port);
+    return 0;
+}
+
+int registerHeuristic(ta_registrar *registrar, std::uint8_t l4Proto)
+{
+    if (registrar == nullptr || !isTransport(l4Proto)) {
+        return -1;
+    }
+    registrar->heuristics.push_back(l4Proto);
+    return 0;
+}
+
+int addColumn(ta_registrar *registrar, const char *name)
+{
+    if (registrar == nullptr || name == nullptr) {
+        return -1;
+    }
+    registrar->columns.append(QString::fromUtf8(name));
+    return registrar->columns.size() - 1;
+}
+
+int addCounter(ta_registrar *registrar, const char *name)
+{
+    if (registrar == nullptr || name == nullptr) {
+        return -1;
+    }
+    registrar->counters.append(QString::fromUtf8(name));
+    return registrar->counters.size() - 1;
+}
+
+void setColumn(ta_dissect_ctx *ctx, int column, const char *text, std::size_t len)
+{
+    if (ctx == nullptr || ctx->dissector == nullptr || text == nullptr || column < 0
+        || column >= ctx->dissector->columns.size()) {
+        return;
+    }
+    if (ctx->columns.isEmpty()) {
+        ctx->columns.reserve(ctx->columnCount);
+        for (int i = 0; i < ctx->columnCount; ++i) {
+            ctx->columns.append(QString());
+        }
+    }
+    ctx->columns[ctx->dissector->firstColumn + column] = QString::fromUtf8(text, static_cast<int>(len));
+}
+
+void setSummary(ta_dissect_ctx *ctx, const char *text, std::size_t len)
+{
+    if (ctx == nullptr || ctx->dissector == nullptr || text == nullptr) {
+        return;
+    }
+    ctx->summary = QString::fromUtf8(text, static_cast<int>(len));
+    ctx->hasSummary = true;
+}
+
+void addCount(ta_dissect_ctx *ctx, int counter, std::uint64_t delta)
+{
+    if (ctx == nullptr || ctx->stats == nullptr || counter < 0 || counter >= ctx->stats->counters.size()) {
+        return;
+    }
+    ctx->stats->counters[counter] += delta;
+}
+
+const ta_host_api kHostApi = {
+    TA_DISSECTOR_ABI_VERSION,
+    sizeof(ta_host_api),
+    registerPort,
+    registerHeuristic,
+    addColumn,
+    addCounter,
+    setColumn,
+    setSummary,
+    addCount,
+};
+
+} // namespace
+
+DissectorRegistry::DissectorRegistry()
+    : tcpPorts(65536, 0)
+    , udpPorts(65536, 0)
+{
+}
+
+DissectorRegistry::~DissectorRegistry()
+{
+    // 后加载的先卸载
+    for (std::size_t i = dissectors.size(); i-- > 0;) {
+        if (dissectors[i].destroy != nullptr) {
+            dissectors[i].destroy(dissectors[i].state);
+        }
+        libraries[i]->unload();
+    }
+}
+
+std::shared_ptr<const DissectorRegistry> DissectorRegistry::load(const QString &directory, QStringList *errors)
+{
+    const QDir dir(directory);
+    if (directory.isEmpty() || !dir.exists()) {
+        return nullptr;
+    }
+    std::shared_ptr<DissectorRegistry> registry(new DissectorRegistry());
+    QStringList messages;
+    // 按文件名顺序加载, 端口冲突时的优先顺序因此是确定的
+    for (const QFileInfo &info : dir.entryInfoList(QDir::Files, QDir::Name)) {
+        if (!QLibrary::isLibrary(info.fileName())) {
+            continue;
+        }
+        if (registry->size() >= kMaxDissectors) {
+            messages.append(QString("插件超过 %1 个, 其余的没有加载").arg(kMaxDissectors));
+            break;
+        }
+        registry->loadLibrary(info.absoluteFilePath(), messages);
+    }
+    if (errors != nullptr) {
+        errors->append(messages);
+    }
+    if (registry->dissectors.empty()) {
+        return nullptr;
+    }
+    return registry;
+}
+
+bool DissectorRegistry::loadLibrary(const QString &path, QStringList &messages)
+{
+    const QString fileName = QFileInfo(path).fileName();
+    auto library = std::make_unique<QLibrary>(path);
+    if (!library->load()) {
+        messages.append(QString("%1: 无法加载: %2").arg(fileName, library->errorString()));
+        return false;
+    }
+    auto abiVersion = reinterpret_cast<ta_dissector_abi_version_fn>(library->resolve("ta_dissector_abi_version"));
+    auto init = reinterpret_cast<ta_dissector_init_fn>(library->resolve("ta_dissector_init"));
+    if (abiVersion == nullptr || init == nullptr) {
+        messages.append(QString("%1: 不是协议解析插件, 缺少 ta_dissector_abi_version 或 ta_dissector_init").arg(fileName));
+        library->unload();
+        return false;
+    }
+    const std::uint32_t version = abiVersion();
+    if (version != TA_DISSECTOR_ABI_VERSION) {
+        messages.append(QString("%1: 插件接口版本 %2 与程序的版本 %3 不同")
+                            .arg(fileName).arg(version).arg(TA_DISSECTOR_ABI_VERSION));
+        library->unload();
+        return false;
+    }
+
+    ta_registrar registrar;
+    ta_dissector info = {};
+    const int result = init(&kHostApi, &registrar, &info);
+    if (result != 0 || info.dissect == nullptr) {
+        if (result == 0 && info.destroy != nullptr) {
+            info.destroy(info.state);
+        }
+        messages.append(QString("%1: 初始化失败 (%2)").arg(fileName).arg(result));
+        library->unload();
+        return false;
+    }
+
+    const auto index = static_cast<std::uint8_t>(dissectors.size());
+    Dissector dissector;
+    dissector.name = info.name != nullptr ? QString::fromUtf8(info.name) : QFileInfo(path).baseName();
+    dissector.protocol = info.protocol != nullptr ? QString::fromUtf8(info.protocol) : QString();
+    dissector.fileName = fileName;
+    dissector.dissect = info.dissect;
+    dissector.state = info.state;
+    dissector.destroy = info.destroy;
+    dissector.firstColumn = columns.size();
+    dissector.columns = registrar.columns;
+    dissector.counters = registrar.counters;
+
+    for (const auto &port : registrar.ports) {
+        std::vector<std::uint8_t> &table = port.first == ProtoTcp ? tcpPorts : udpPorts;
+        std::uint8_t &owner = table[port.second];
+        if (owner != 0 && owner != index + 1) {
+            messages.append(QString("%1: %2 端口 %3 已由插件 %4 登记")
+                                .arg(fileName, protocolName(port.first, AppProtocol::None))
+                                .arg(port.second)
+                                .arg(dissectors[owner - 1].name));
+            continue;
+        }
+        owner = static_cast<std::uint8_t>(index + 1);
+    }
+    for (std::uint8_t l4Proto : registrar.heuristics) {
+        std::vector<std::uint8_t> &list = l4Proto == ProtoTcp ? tcpHeuristics : udpHeuristics;
+        if (std::find(list.begin(), list.end(), index) == list.end()) {
+            list.push_back(index);
+        }
+    }
+    columns.append(registrar.columns);
+    dissectors.push_back(std::move(dissector));
+    libraries.push_back(std::move(library));
+    return true;
+}
+
+QStringList DissectorRegistry::protocolNames() const
+{
+    QStringList names;
+    for (const Dissector &dissector : dissectors) {
+        names.append(dissector.protocol);
+    }
+    return names;
+}
+
+int DissectorRegistry::findProtocol(const QString &protocol) const
+{
+    if (protocol.isEmpty()) {
+        return 0;
+    }
+    for (std::size_t i = 0; i < dissectors.size(); ++i) {
+        if (dissectors[i].protocol == protocol) {
+            return static_cast<int>(i) + 1;
+        }
+    }
+    return 0;
+}
+
+const std::vector<std::uint8_t> *DissectorRegistry::portTable(std::uint8_t l4Proto) const
+{
+    if (l4Proto == ProtoTcp) {
+        return &tcpPorts;
+    }
+    if (l4Proto == ProtoUdp) {
+        return &udpPorts;
+    }
+    return nullptr;
+}
+
+const std::vector<std::uint8_t> &DissectorRegistry::heuristics(std::uint8_t l4Proto) const
+{
+    static const std::vector<std::uint8_t> none;
+    if (l4Proto == ProtoTcp) {
+        return tcpHeuristics;
+    }
+    if (l4Proto == ProtoUdp) {
+        return udpHeuristics;
+    }
+    return none;
+}
+
+DissectorDispatcher::DissectorDispatcher(std::shared_ptr<const DissectorRegistry> registry)
+    : dissectors(std::move(registry))
+    , context(std::make_unique<ta_dissect_ctx>())
+{
+    context->columnCount = dissectors->columnNames().size();
+    counters.resize(dissectors->size());
+    for (int i = 0; i < dissectors->size(); ++i) {
+        const DissectorRegistry::Dissector &dissector = dissectors->at(i);
+        counters[i].name = dissector.name;
+        counters[i].counterNames = dissector.counters;
+        counters[i].counters.fill(0, dissector.counters.size());
+    }
+}
+
+DissectorDispatcher::~DissectorDispatcher() = default;
+
+bool DissectorDispatcher::call(int index, ta_stage stage, const ta_packet_view &view, FlowRecord &flow)
+{
+    const DissectorRegistry::Dissector &dissector = dissectors->at(index);
+    DissectorStats &stats = counters[index];
+    context->dissector = &dissector;
+    context->stats = &stats;
+
+    ta_flow_view flowView;
+    flowView.first_ns = flow.firstSeenNs;
+    flowView.packets = flow.packets;
+    flowView.bytes = flow.bytes;
+    flowView.cookie = &flow.dissectorCookie;
+
+    const auto started = std::chrono::steady_clock::now();
+    const ta_verdict verdict = dissector.dissect(dissector.state, stage, &view, &flowView, context.get());
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+
+    DissectorStageStats &stageStats = stats.stages[stage];
+    ++stageStats.calls;
+    stageStats.ns += static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    context->dissector = nullptr;
+    context->stats = nullptr;
+    if (verdict != TA_ACCEPT && verdict != TA_ACCEPT_FLOW) {
+        discard(*context);
+        return false;
+    }
+    ++stageStats.accepted;
+    if (verdict == TA_ACCEPT_FLOW) {
+        flow.dissector = static_cast<std::uint8_t>(index + 1);
+    }
+    return true;
+}
+
+std::uint8_t DissectorDispatcher::dissect(const DecodedPacket &pkt, FlowRecord &flow, bool fromInitiator,
+                                          bool builtinRecognized)
+{
+    ta_packet_view view;
+    view.payload = pkt.payload;
+    view.payload_len = static_cast<std::uint32_t>(pkt.payloadLen);
+    view.wire_len = pkt.wireLen;
+    view.ts_ns = pkt.tsNs;
+    view.src_addr = pkt.srcAddr;
+    view.dst_addr = pkt.dstAddr;
+    view.ip_version = pkt.ipVersion;
+    view.l4_proto = pkt.l4Proto;
+    view.tcp_flags = pkt.tcpFlags;
+    view.from_client = fromInitiator ? 1 : 0;
+    view.src_port = pkt.srcPort;
+    view.dst_port = pkt.dstPort;
+    view.tcp_seq = pkt.tcpSeq;
+    // 上一个被认领的包可能没有生成结果行 (被协议过滤掉), 它的摘要和列不能留给这个包
+    discard(*context);
+
+    // 认领了流的插件拒绝某个包时, 这个包按内置识别处理, 流仍归它
+    if (flow.dissector != 0) {
+        return call(flow.dissector - 1, TA_STAGE_FLOW, view, flow) ? flow.dissector : 0;
+    }
+
+    std::uint8_t owner = dissectors->portOwner(pkt.l4Proto, pkt.dstPort);
+    if (owner == 0) {
+        owner = dissectors->portOwner(pkt.l4Proto, pkt.srcPort);
+    }
+    if (owner != 0 && call(owner - 1, TA_STAGE_PORT, view, flow)) {
+        return owner;
+    }
+
+    if (builtinRecognized || pkt.payloadLen == 0 || flow.dissectorProbes >= kMaxProbes) {
+        return 0;
+    }
+    const std::vector<std::uint8_t> &candidates = dissectors->heuristics(pkt.l4Proto);
+    if (candidates.empty()) {
+        return 0;
+    }
+    ++flow.dissectorProbes;
+    for (std::uint8_t index : candidates) {
+        if (index + 1 != owner && call(index, TA_STAGE_HEURISTIC, view, flow)) {
+            return static_cast<std::uint8_t>(index + 1);
+        }
+    }
+    return 0;
+}
+
+void DissectorDispatcher::apply(ResultRow &row)
+{
+    if (context->hasSummary) {
+        row.trafficType = context->summary;
+    }
+    if (!context->columns.isEmpty()) {
+        row.pluginColumns = context->columns;
+    }
+    discard(*context);
+}
+
+QVector<DissectorStats> DissectorDispatcher::stats() const
+{
+    return counters;
+}
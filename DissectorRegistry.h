@@ -0,0 +1,110 @@
+#ifndef DISSECTORREGISTRY_H
+#define DISSECTORREGISTRY_H
+
+#include "AnalysisTypes.h"
+#include "DissectorPlugin.h"
+#include <QStringList>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class QLibrary;
+struct DecodedPacket;
+struct FlowRecord;
+
+// 从插件目录加载的协议解析插件。加载后不再修改, 可以被多次分析共用;
+// 最后一个持有者释放时调用各插件的 destroy 并卸载动态库
+class DissectorRegistry
+{
+public:
+    // 编号存放在 ResultRow 和 FlowRecord 的一个字节中, 0 表示没有插件
+    static constexpr int kMaxDissectors = 255;
+
+    struct Dissector
+    {
+        QString name;
+        QString protocol; // 为空时协议列沿用内置识别的结果
+        QString fileName;
+        ta_dissect_fn dissect = nullptr;
+        void *state = nullptr;
+        void (*destroy)(void *state) = nullptr;
+        int firstColumn = 0; // 在所有插件的列中的起点
+        QStringList columns;
+        QStringList counters;
+    };
+
+    ~DissectorRegistry();
+
+    DissectorRegistry(const DissectorRegistry &) = delete;
+    DissectorRegistry &operator=(const DissectorRegistry &) = delete;
+
+    // 加载目录下的所有动态库, 不兼容或初始化失败的跳过并把原因追加到 errors。
+    // 目录不存在或没有可用的插件时返回空指针
+    static std::shared_ptr<const DissectorRegistry> load(const QString &directory, QStringList *errors = nullptr);
+
+    int size() const { return static_cast<int>(dissectors.size()); }
+    const Dissector &at(int index) const { return dissectors[static_cast<std::size_t>(index)]; }
+    // 所有插件的自定义列, 按加载顺序排列
+    const QStringList &columnNames() const { return columns; }
+    // 各插件协议列的名称, 下标为插件编号, 没有协议名的为空
+    QStringList protocolNames() const;
+    // 按协议名查找, 返回插件编号加一, 找不到返回0
+    int findProtocol(const QString &protocol) const;
+
+    // 登记了该端口的插件编号加一, 0 表示没有; l4Proto 不是TCP/UDP时也返回0
+    std::uint8_t portOwner(std::uint8_t l4Proto, std::uint16_t port) const
+    {
+        const std::vector<std::uint8_t> *table = portTable(l4Proto);
+        return table != nullptr ? (*table)[port] : 0;
+    }
+    // 在该协议上登记了启发式的插件编号, 按加载顺序
+    const std::vector<std::uint8_t> &heuristics(std::uint8_t l4Proto) const;
+
+private:
+    DissectorRegistry();
+    // 失败时返回 false; 端口冲突等不影响加载的问题也追加到 messages
+    bool loadLibrary(const QString &path, QStringList &messages);
+    const std::vector<std::uint8_t> *portTable(std::uint8_t l4Proto) const;
+
+    std::vector<Dissector> dissectors;
+    std::vector<std::unique_ptr<QLibrary>> libraries; // 与 dissectors 一一对应
+    std::vector<std::uint8_t> tcpPorts; // 下标为端口
+    std::vector<std::uint8_t> udpPorts;
+    std::vector<std::uint8_t> tcpHeuristics;
+    std::vector<std::uint8_t> udpHeuristics;
+    QStringList columns;
+};
+
+// 一次分析中的插件调用和统计, 只由分析线程使用。逐包只查端口表和流上记下的插件编号,
+// 再通过函数指针调用插件, 没有按插件逐个询问的调用链
+class DissectorDispatcher
+{
+public:
+    // 流在前几个有负载的包里都没有被认领时, 不再交给启发式试探
+    static constexpr int kMaxProbes = 8;
+
+    explicit DissectorDispatcher(std::shared_ptr<const DissectorRegistry> registry);
+    ~DissectorDispatcher();
+
+    DissectorDispatcher(const DissectorDispatcher &) = delete;
+    DissectorDispatcher &operator=(const DissectorDispatcher &) = delete;
+
+    const DissectorRegistry &registry() const { return *dissectors; }
+
+    // 依次交给认领了这条流的插件、登记了端口的插件、启发式插件 (builtinRecognized 为真时不试探),
+    // 返回认领本包的插件编号加一, 0 表示没有插件认领。认领时插件写入的摘要和列由 apply 写到结果行
+    std::uint8_t dissect(const DecodedPacket &pkt, FlowRecord &flow, bool fromInitiator, bool builtinRecognized);
+    // 把最近一次认领的插件写入的摘要和列写到结果行
+    void apply(ResultRow &row);
+
+    QVector<DissectorStats> stats() const;
+
+private:
+    bool call(int index, ta_stage stage, const ta_packet_view &view, FlowRecord &flow);
+
+    std::shared_ptr<const DissectorRegistry> dissectors;
+    std::unique_ptr<ta_dissect_ctx> context;
+    QVector<DissectorStats> counters; // 下标为插件编号
+};
+
+#endif // DISSECTORREGISTRY_H
@@ -0,0 +1,107 @@
+#include "FlowModel.h"
+#include <QDateTime>
+#include <QLocale>
+
+FlowModel::FlowModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int FlowModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int FlowModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant FlowModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return QVariant();
+    }
+    const FlowSummary &flow = rows[index.row()];
+    const quint64 durationMs = (flow.lastNs - flow.firstNs) / 1000000;
+
+    if (role == SortRole) {
+        switch (index.column()) {
+        case ColStart: return flow.firstNs;
+        case ColDuration: return durationMs;
+        case ColClient: return AddressFormatter::toText(flow.client);
+        case ColClientPort: return flow.clientPort;
+        case ColServer: return AddressFormatter::toText(flow.server);
+        case ColServerPort: return flow.serverPort;
+        case ColProtocol: return protocolName(flow.l4Proto, flow.app);
+        case ColPackets: return flow.packets;
+        case ColBytes: return flow.bytes;
+        case ColReason: return static_cast<int>(flow.reason);
+        default: break;
+        }
+    } else if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case ColStart:
+            return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(flow.firstNs / 1000000))
+                .toString("yyyy-MM-dd hh:mm:ss");
+        case ColDuration: return QString::number(durationMs / 1000.0, 'f', 1) + " s";
+        case ColClient: return formatter.format(flow.client);
+        case ColClientPort: return flow.clientPort;
+        case ColServer: return formatter.format(flow.server);
+        case ColServerPort: return flow.serverPort;
+        case ColProtocol: return protocolName(flow.l4Proto, flow.app);
+        case ColPackets: return flow.packets;
+        case ColBytes: return QLocale().formattedDataSize(static_cast<qint64>(flow.bytes));
+        case ColReason: return flowEndReasonName(flow.reason);
+        default: break;
+        }
+    } else if (role == Qt::TextAlignmentRole) {
+        if (index.column() == ColDuration || index.column() == ColPackets || index.column() == ColBytes) {
+            return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+        }
+    } else if (role == Qt::ToolTipRole && flow.reason == FlowEndReason::Active) {
+        return QString("流仍在继续, 这里只是本段的计数");
+    }
+    return QVariant();
+}
+
+QVariant FlowModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList headers = {"开始时间", "持续时间", "客户端", "客户端端口", "服务端",
+                                        "服务端端口", "协议", "包数", "字节数", "结束原因"};
+    return headers.value(section);
+}
+
+void FlowModel::appendFlows(const QVector<FlowSummary> &flows)
+{
+    if (flows.isEmpty()) {
+        return;
+    }
+    const int excess = rows.size() + flows.size() - kMaxRows;
+    if (excess > 0) {
+        const int removed = qMin(excess, rows.size());
+        if (removed > 0) {
+            beginRemoveRows(QModelIndex(), 0, removed - 1);
+            rows.remove(0, removed);
+            endRemoveRows();
+        }
+    }
+    // 一次到达的流比上限还多时只保留最后的部分
+    const int skip = qMax(0, flows.size() - kMaxRows);
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + flows.size() - skip - 1);
+    for (int i = skip; i < flows.size(); ++i) {
+        rows.append(flows[i]);
+    }
+    endInsertRows();
+}
+
+void FlowModel::clear()
+{
+    beginResetModel();
+    rows.clear();
+    formatter.clear();
+    endResetModel();
+}
@@ -0,0 +1,47 @@
+#ifndef FLOWMODEL_H
+#define FLOWMODEL_H
+
+#include "AddressFormatter.h"
+#include "AnalysisTypes.h"
+#include <QAbstractTableModel>
+
+// 已导出流记录的表格模型。只保留最近的 kMaxRows 条, 超出时丢弃最早的
+class FlowModel final : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColStart,
+        ColDuration,
+        ColClient,
+        ColClientPort,
+        ColServer,
+        ColServerPort,
+        ColProtocol,
+        ColPackets,
+        ColBytes,
+        ColReason,
+        ColumnCount
+    };
+
+    static constexpr int kMaxRows = 100000;
+    // 排序时使用的原始值
+    static constexpr int SortRole = Qt::UserRole;
+
+    explicit FlowModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void appendFlows(const QVector<FlowSummary> &flows);
+    void clear();
+
+private:
+    QVector<FlowSummary> rows;
+    mutable AddressFormatter formatter;
+};
+
+#endif // FLOWMODEL_H
@@ -0,0 +1,405 @@
+#include "FlowTable.h"
+#include <algorithm>
+
+namespace {
+
+std::uint64_t load64(const std::uint8_t *p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint64_t mix(std::uint64_t h, std::uint64_t v)
+{
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+FlowKey makeKey(const DecodedPacket &pkt, bool &senderIsA)
+{
+    FlowKey key;
+    std::memset(&key, 0, sizeof(key));
+    const std::size_t addrLen = pkt.ipVersion == 6 ? 16 : 4;
+
+    int cmp = std::memcmp(pkt.srcAddr, pkt.dstAddr, addrLen);
+    if (cmp == 0) {
+        cmp = pkt.srcPort < pkt.dstPort ? -1 : (pkt.srcPort > pkt.dstPort ? 1 : 0);
+    }
+    senderIsA = cmp <= 0;
+
+    const std::uint8_t *a = senderIsA ? pkt.srcAddr : pkt.dstAddr;
+    const std::uint8_t *b = senderIsA ? pkt.dstAddr : pkt.srcAddr;
+    std::memcpy(key.addrA, a, addrLen);
+    std::memcpy(key.addrB, b, addrLen);
+    key.portA = senderIsA ? pkt.srcPort : pkt.dstPort;
+    key.portB = senderIsA ? pkt.dstPort : pkt.srcPort;
+    key.l4Proto = pkt.l4Proto;
+    key.ipVersion = pkt.ipVersion;
+    return key;
+}
+
+constexpr std::uint8_t kTcpSyn = 0x02;
+constexpr std::uint8_t kTcpAck = 0x10;
+
+// 单次 expire 最多推进的时间格数, 数据包时间跳跃很大时分几次追上
+constexpr std::uint64_t kMaxTicksPerExpire = 256;
+
+// libstdc++/libc++ 的哈希表节点是 next 指针 + 缓存的哈希值 + 元素
+constexpr std::size_t kFlowNodeBytes = sizeof(std::pair<const FlowKey, FlowRecord>) + 2 * sizeof(void *);
+
+// 解析结果占用的堆内存, 按容量估算
+std::uint64_t helloBytes(const TlsClientHello &hello)
+{
+    std::uint64_t bytes = sizeof(TlsClientHello) + hello.sni.capacity() + hello.ja3.capacity()
+                          + hello.ja3Hash.capacity() + hello.ja4.capacity()
+                          + (hello.ciphers.capacity() + hello.extensions.capacity() + hello.groups.capacity()
+                             + hello.signatureAlgorithms.capacity())
+                                * sizeof(std::uint16_t)
+                          + hello.pointFormats.capacity();
+    for (const std::string &protocol : hello.alpn) {
+        bytes += sizeof(std::string) + protocol.capacity();
+    }
+    return bytes;
+}
+
+// 拼接缓冲区再放下 extra 字节; 预算不够时返回false, 缓冲区不变
+bool growStash(FlowRecord &flow, std::size_t extra)
+{
+    const std::size_t needed = flow.tlsStash.size() + extra;
+    if (needed <= flow.tlsStash.capacity()) {
+        return true;
+    }
+    if (needed > TlsParser::kMaxRecordBytes) {
+        return false;
+    }
+    const std::size_t capacity =
+        std::min(std::max(needed, flow.tlsStash.capacity() * 2), TlsParser::kMaxRecordBytes);
+    if (!flow.tlsCharge.resize(flow.tlsCharge.bytes() + capacity - flow.tlsStash.capacity())) {
+        return false;
+    }
+    flow.tlsStash.reserve(capacity);
+    return true;
+}
+
+} // namespace
+
+std::size_t FlowKeyHash::operator()(const FlowKey &key) const
+{
+    const auto *p = reinterpret_cast<const std::uint8_t *>(&key);
+    std::uint64_t h = 0;
+    for (std::size_t i = 0; i + 8 <= sizeof(FlowKey); i += 8) {
+        h = mix(h, load64(p + i));
+    }
+    return static_cast<std::size_t>(h);
+}
+
+FlowTable::FlowTable(std::uint64_t idleTimeoutNs, std::uint64_t activeTimeoutNs)
+    : idleTimeoutNs(std::max<std::uint64_t>(idleTimeoutNs, kTickNs))
+    , activeTimeoutNs(std::max<std::uint64_t>(activeTimeoutNs, kTickNs))
+    , nodePool(kFlowNodeBytes, MemoryBudget::Flows)
+    , flows(0, FlowKeyHash(), std::equal_to<FlowKey>(), FlowMap::allocator_type(&nodePool))
+    , wheel(kTickNs)
+{
+}
+
+void FlowTable::setTimeouts(std::uint64_t idle, std::uint64_t active)
+{
+    idleTimeoutNs = std::max<std::uint64_t>(idle, kTickNs);
+    activeTimeoutNs = std::max<std::uint64_t>(active, kTickNs);
+}
+
+FlowRecord &FlowTable::update(const DecodedPacket &pkt, bool &fromInitiator, std::uint32_t weight)
+{
+    bool senderIsA = true;
+    const FlowKey key = makeKey(pkt, senderIsA);
+
+    auto found = flows.find(key);
+    if (found == flows.end() && !nodePool.reserve()) {
+        ++untracked;
+        overflow = FlowRecord();
+        overflow.key = key;
+        overflow.initiatorIsA = senderIsA;
+        overflow.firstSeenNs = overflow.lastSeenNs = pkt.tsNs;
+        overflow.packets = weight;
+        overflow.bytes = static_cast<std::uint64_t>(pkt.wireLen) * weight;
+        fromInitiator = true;
+        return overflow;
+    }
+    const bool created = found == flows.end();
+    if (created) {
+        found = flows.try_emplace(key).first;
+    }
+    FlowRecord &flow = found->second;
+    if (created) {
+        flow.key = key;
+        flow.initiatorIsA = senderIsA;
+        assignTimer(flow);
+        arm(flow, pkt.tsNs + std::min(idleTimeoutNs, activeTimeoutNs));
+    }
+    markChanged(flow);
+    // 中途开始抓包时第一个包不一定来自客户端, 以纯SYN为准纠正
+    if (pkt.l4Proto == ProtoTcp && (pkt.tcpFlags & (kTcpSyn | kTcpAck)) == kTcpSyn) {
+        flow.initiatorIsA = senderIsA;
+    }
+    if (flow.packets == 0) {
+        flow.firstSeenNs = pkt.tsNs; // 新流或刚导出过一段
+    }
+    flow.lastSeenNs = pkt.tsNs;
+    ++flow.sampledPackets;
+    flow.packets += weight;
+    flow.bytes += static_cast<std::uint64_t>(pkt.wireLen) * weight;
+
+    fromInitiator = senderIsA == flow.initiatorIsA;
+    return flow;
+}
+
+void FlowTable::assignTimer(FlowRecord &flow)
+{
+    if (freeTimerIds.empty()) {
+        flow.timerId = static_cast<std::uint32_t>(byTimer.size());
+        byTimer.push_back(&flow);
+    } else {
+        flow.timerId = freeTimerIds.back();
+        freeTimerIds.pop_back();
+        byTimer[flow.timerId] = &flow;
+    }
+}
+
+void FlowTable::markChanged(FlowRecord &flow)
+{
+    if (tracking && !flow.changed) {
+        flow.changed = true;
+        changedTimers.push_back(flow.timerId);
+    }
+}
+
+void FlowTable::arm(FlowRecord &flow, std::uint64_t deadlineNs)
+{
+    // 定时器按格触发, 挂到截止时间之后的那一格, 触发时截止时间一定已经过去
+    wheel.schedule(flow.timerId, (deadlineNs / kTickNs + 1) * kTickNs);
+}
+
+void FlowTable::release(FlowRecord &flow)
+{
+    if (tracking) {
+        removedKeys.push_back(flow.key);
+    }
+    byTimer[flow.timerId] = nullptr;
+    freeTimerIds.push_back(flow.timerId);
+    flows.erase(flow.key);
+}
+
+FlowSummary FlowTable::summarize(const FlowRecord &flow, FlowEndReason reason)
+{
+    const FlowKey &key = flow.key;
+    FlowSummary summary;
+    summary.firstNs = flow.firstSeenNs;
+    summary.lastNs = flow.lastSeenNs;
+    const IpAddress a = IpAddress::fromBytes(key.addrA, key.ipVersion);
+    const IpAddress b = IpAddress::fromBytes(key.addrB, key.ipVersion);
+    summary.client = flow.initiatorIsA ? a : b;
+    summary.server = flow.initiatorIsA ? b : a;
+    summary.clientPort = flow.initiatorIsA ? key.portA : key.portB;
+    summary.serverPort = flow.initiatorIsA ? key.portB : key.portA;
+    summary.l4Proto = key.l4Proto;
+    summary.app = flow.app;
+    summary.reason = reason;
+    summary.packets = flow.packets;
+    summary.bytes = flow.bytes;
+    return summary;
+}
+
+bool FlowTable::expire(std::uint64_t nowNs, QVector<FlowSummary> &out, std::size_t maxFlows)
+{
+    const bool more = wheel.advance(nowNs, fired, maxFlows, kMaxTicksPerExpire);
+    for (std::uint32_t id : fired) {
+        FlowRecord &flow = *byTimer[id];
+        const std::uint64_t idleDeadline = flow.lastSeenNs + idleTimeoutNs;
+        const std::uint64_t activeDeadline = flow.firstSeenNs + activeTimeoutNs;
+        if (nowNs >= idleDeadline) {
+            // 活动超时刚导出过、之后没有新数据包的流不再重复导出空记录
+            if (flow.packets > 0) {
+                out.append(summarize(flow, FlowEndReason::Idle));
+            }
+            release(flow);
+        } else if (nowNs >= activeDeadline) {
+            out.append(summarize(flow, FlowEndReason::Active));
+            flow.firstSeenNs = nowNs;
+            flow.packets = 0;
+            flow.bytes = 0;
+            markChanged(flow);
+            arm(flow, std::min(idleDeadline, nowNs + activeTimeoutNs));
+        } else {
+            arm(flow, std::min(idleDeadline, activeDeadline)); // 期间有新数据包, 顺延
+        }
+    }
+    return more;
+}
+
+void FlowTable::drain(QVector<FlowSummary> &out)
+{
+    for (const auto &entry : flows) {
+        if (entry.second.packets > 0) {
+            out.append(summarize(entry.second, FlowEndReason::CaptureEnd));
+        }
+    }
+    clear();
+}
+
+void FlowTable::clear()
+{
+    flows.clear();
+    byTimer.clear();
+    freeTimerIds.clear();
+    wheel.clear();
+    overflow = FlowRecord();
+    untracked = 0;
+    changedTimers.clear();
+    removedKeys.clear();
+}
+
+void FlowTable::setChangeTracking(bool enabled)
+{
+    tracking = enabled;
+    changedTimers.clear();
+    removedKeys.clear();
+    for (auto &entry : flows) {
+        entry.second.changed = false;
+    }
+}
+
+FlowSnapshot FlowTable::snapshotOf(const FlowRecord &flow)
+{
+    FlowSnapshot snapshot;
+    std::memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.key = flow.key;
+    snapshot.firstSeenNs = flow.firstSeenNs;
+    snapshot.lastSeenNs = flow.lastSeenNs;
+    snapshot.packets = flow.packets;
+    snapshot.bytes = flow.bytes;
+    snapshot.initiatorIsA = flow.initiatorIsA ? 1 : 0;
+    snapshot.handshake = flow.handshake;
+    snapshot.app = flow.app;
+    snapshot.tlsState = flow.tlsState == TlsState::Pending && !flow.tlsStash.empty() ? TlsState::NotTls : flow.tlsState;
+    return snapshot;
+}
+
+void FlowTable::takeChanges(bool all, std::vector<FlowSnapshot> &changed, std::vector<FlowKey> &removed)
+{
+    changed.clear();
+    removed.clear();
+    if (all) {
+        changed.reserve(flows.size());
+        for (auto &entry : flows) {
+            entry.second.changed = false;
+            changed.push_back(snapshotOf(entry.second));
+        }
+    } else {
+        // 同一编号可能因为流结束后被复用而出现两次, 以记录上的标记为准
+        for (std::uint32_t id : changedTimers) {
+            FlowRecord *flow = byTimer[id];
+            if (flow != nullptr && flow->changed) {
+                flow->changed = false;
+                changed.push_back(snapshotOf(*flow));
+            }
+        }
+        removed.swap(removedKeys);
+    }
+    changedTimers.clear();
+    removedKeys.clear();
+}
+
+bool FlowTable::restore(const FlowSnapshot &snapshot)
+{
+    auto found = flows.find(snapshot.key);
+    if (found == flows.end()) {
+        if (!nodePool.reserve()) {
+            return false;
+        }
+        found = flows.try_emplace(snapshot.key).first;
+        found->second.key = snapshot.key;
+        assignTimer(found->second);
+    }
+    FlowRecord &flow = found->second;
+    flow.firstSeenNs = snapshot.firstSeenNs;
+    flow.lastSeenNs = snapshot.lastSeenNs;
+    flow.packets = snapshot.packets;
+    flow.bytes = snapshot.bytes;
+    // 检查点不保存整条流的包数, 以当前一段的包数代替
+    flow.sampledPackets = snapshot.packets;
+    flow.initiatorIsA = snapshot.initiatorIsA != 0;
+    flow.handshake = snapshot.handshake;
+    flow.app = snapshot.app;
+    flow.tlsState = snapshot.tlsState;
+    // 时间轮还没开始推进, 定时器先放进待处理列表, 到期与否在第一次 expire 时按实际时间判断
+    arm(flow, std::min(flow.lastSeenNs + idleTimeoutNs, flow.firstSeenNs + activeTimeoutNs));
+    return true;
+}
+
+bool FlowCharge::resize(std::uint64_t bytes)
+{
+    MemoryBudget &budget = MemoryBudget::global();
+    if (bytes > charged) {
+        if (!budget.tryCharge(MemoryBudget::Flows, bytes - charged)) {
+            return false;
+        }
+    } else if (bytes < charged) {
+        budget.release(MemoryBudget::Flows, charged - bytes);
+    }
+    charged = bytes;
+    return true;
+}
+
+void FlowInspector::inspectTls(FlowRecord &flow, const DecodedPacket &pkt, bool fromInitiator)
+{
+    if (flow.tlsState != TlsState::Pending || !fromInitiator
+        || pkt.l4Proto != ProtoTcp || pkt.payloadLen == 0) {
+        return;
+    }
+
+    auto finish = [&flow](TlsParser::Result result, TlsClientHello &hello) {
+        if (result == TlsParser::Result::NeedMore) {
+            return;
+        }
+        std::vector<std::uint8_t>().swap(flow.tlsStash);
+        flow.tlsCharge.resize(0);
+        // 预算不够保存解析结果时与拼接失败一样放弃这条流
+        if (result == TlsParser::Result::Complete && flow.tlsCharge.resize(helloBytes(hello))) {
+            flow.tls = std::make_unique<TlsClientHello>(std::move(hello));
+            flow.tlsState = TlsState::Parsed;
+        } else {
+            flow.tlsState = TlsState::NotTls;
+        }
+    };
+
+    TlsClientHello hello;
+    if (flow.tlsStash.empty()) {
+        // 常见情况: ClientHello在一个段内, 直接在数据包缓冲区上解析
+        auto result = TlsParser::parseClientHello(pkt.payload, pkt.payloadLen, hello);
+        if (result == TlsParser::Result::NeedMore) {
+            if (growStash(flow, pkt.payloadLen)) {
+                flow.tlsStash.assign(pkt.payload, pkt.payload + pkt.payloadLen);
+                flow.tlsNextSeq = pkt.tcpSeq + static_cast<std::uint32_t>(pkt.payloadLen);
+            } else {
+                result = TlsParser::Result::NotTls;
+            }
+        }
+        finish(result, hello);
+        return;
+    }
+
+    // 跨段: 只接受按序到达的下一段, 重传的旧段直接忽略
+    const auto delta = static_cast<std::int32_t>(pkt.tcpSeq - flow.tlsNextSeq);
+    if (delta < 0) {
+        return;
+    }
+    if (delta > 0 || flow.tlsStash.size() + pkt.payloadLen > TlsParser::kMaxRecordBytes
+        || !growStash(flow, pkt.payloadLen)) {
+        finish(TlsParser::Result::NotTls, hello); // 有丢包、记录过大或内存预算用完, 放弃
+        return;
+    }
+    flow.tlsStash.insert(flow.tlsStash.end(), pkt.payload, pkt.payload + pkt.payloadLen);
+    flow.tlsNextSeq += static_cast<std::uint32_t>(pkt.payloadLen);
+    finish(TlsParser::parseClientHello(flow.tlsStash.data(), flow.tlsStash.size(), hello), hello);
+}
@@ -0,0 +1,200 @@
+#ifndef FLOWTABLE_H
+#define FLOWTABLE_H
+
+#include "AnalysisTypes.h"
+#include "PacketDecoder.h"
+#include "SlabPool.h"
+#include "TimerWheel.h"
+#include "TlsClientHello.h"
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// 双向流的规范化键: 地址/端口较小的一端总是放在 a 侧
+struct FlowKey
+{
+    std::uint8_t addrA[16];
+    std::uint8_t addrB[16];
+    std::uint16_t portA;
+    std::uint16_t portB;
+    std::uint8_t l4Proto;
+    std::uint8_t ipVersion;
+    std::uint8_t pad[2];
+
+    bool operator==(const FlowKey &other) const
+    {
+        return std::memcmp(this, &other, sizeof(FlowKey)) == 0;
+    }
+};
+
+struct FlowKeyHash
+{
+    std::size_t operator()(const FlowKey &key) const;
+};
+
+// 流上的TLS解析状态
+enum class TlsState : std::uint8_t {
+    Pending,  // 还没看到客户端的第一个记录
+    Parsed,   // 已解析, 结果在 tls 中
+    NotTls
+};
+
+// TCP三次握手进度, 由 ScanDetector 推进, 用于统计半开连接
+enum class TcpHandshake : std::uint8_t {
+    None,
+    SynSent,
+    SynAckSeen,
+    Established
+};
+
+// 流记录上按需分配的内存在预算中的记账, 随记录析构或被覆盖时归还
+class FlowCharge
+{
+public:
+    FlowCharge() = default;
+    FlowCharge(FlowCharge &&other) noexcept
+        : charged(other.charged)
+    {
+        other.charged = 0;
+    }
+    FlowCharge &operator=(FlowCharge &&other) noexcept
+    {
+        if (this != &other) {
+            resize(0);
+            charged = other.charged;
+            other.charged = 0;
+        }
+        return *this;
+    }
+    ~FlowCharge() { resize(0); }
+
+    // 把记账调整到 bytes; 需要增加而预算不够时保持不变并返回false, 减少总是成功
+    bool resize(std::uint64_t bytes);
+    std::uint64_t bytes() const { return charged; }
+
+private:
+    std::uint64_t charged = 0;
+};
+
+struct FlowRecord
+{
+    FlowKey key;
+    // firstSeenNs 和计数从上一次活动超时导出后重新开始
+    std::uint64_t firstSeenNs = 0;
+    std::uint64_t lastSeenNs = 0;
+    std::uint64_t packets = 0;
+    std::uint64_t bytes = 0;
+    // 建表以来经过的包数 (不乘权重), 活动超时导出时不清零; 按流采样的误差估计按它累计
+    std::uint64_t sampledPackets = 0;
+    std::uint32_t timerId = 0;
+    bool initiatorIsA = true; // 发起方 (客户端) 是否为键中的 a 侧
+    TcpHandshake handshake = TcpHandshake::None;
+    AppProtocol app = AppProtocol::None; // 由引擎按最近一次识别结果填写
+
+    TlsState tlsState = TlsState::Pending;
+    std::unique_ptr<TlsClientHello> tls;
+    // ClientHello跨越多个TCP段时才会使用的拼接缓冲区
+    std::vector<std::uint8_t> tlsStash;
+    std::uint32_t tlsNextSeq = 0;
+    // tls 和 tlsStash 不在流表的slab里, 单独计入 MemoryBudget::Flows
+    FlowCharge tlsCharge;
+
+    // 协议解析插件: 认领这条流的插件编号加一, 已经试探过的负载包数, 插件保存在流上的值。
+    // 检查点不保存, 恢复后的流重新试探
+    std::uint8_t dissector = 0;
+    std::uint8_t dissectorProbes = 0;
+    std::uint64_t dissectorCookie = 0;
+
+    bool changed = false; // 上一次检查点之后有更新
+};
+
+// 检查点中保存的流, 定长便于直接映射读取。TLS只保存解析状态: 解析出的ClientHello不保存,
+// 恢复后按HTTPS计数但不再显示SNI; 正在跨段拼接的ClientHello按不是TLS处理
+struct FlowSnapshot
+{
+    FlowKey key;
+    std::uint64_t firstSeenNs;
+    std::uint64_t lastSeenNs;
+    std::uint64_t packets;
+    std::uint64_t bytes;
+    std::uint8_t initiatorIsA;
+    TcpHandshake handshake;
+    AppProtocol app;
+    TlsState tlsState;
+    std::uint8_t pad[4];
+};
+
+// 流表和按数据包时间推进的超时。每个流只在创建时挂一个定时器, 之后的数据包只更新
+// lastSeenNs; 定时器到期时再按实际的空闲/活动时间决定结束、分段导出还是重新挂上
+class FlowTable
+{
+public:
+    static constexpr std::uint64_t kTickNs = 100000000; // 超时精度 100ms
+
+    FlowTable(std::uint64_t idleTimeoutNs, std::uint64_t activeTimeoutNs);
+
+    // 查找或创建数据包所属的流, fromInitiator 返回该包是否由发起方发出。
+    // 返回的引用在下一次 update/expire/drain/clear 之前有效。内存预算用完时新流不再建表,
+    // 返回一条每次重置的临时记录, 只对本包有效, 并计入 untrackedPackets。
+    // weight 为该包代表的包数, 逐包采样时计数按它放大
+    FlowRecord &update(const DecodedPacket &pkt, bool &fromInitiator, std::uint32_t weight = 1);
+
+    // 把时间推进到 nowNs, 超时的流追加到 out。每次最多处理 maxFlows 个到期定时器,
+    // 处理不完的留到下一次调用, 返回true表示还有积压
+    bool expire(std::uint64_t nowNs, QVector<FlowSummary> &out, std::size_t maxFlows);
+    // 分析结束时导出所有剩余的流并清空
+    void drain(QVector<FlowSummary> &out);
+
+    // 新的超时在流的定时器下一次到期时生效
+    void setTimeouts(std::uint64_t idleTimeoutNs, std::uint64_t activeTimeoutNs);
+
+    std::size_t size() const { return flows.size(); }
+    std::uint64_t untrackedPackets() const { return untracked; }
+    // update 返回的是否为内存不足时的临时记录
+    bool isUntracked(const FlowRecord &flow) const { return &flow == &overflow; }
+    void clear();
+
+    // 检查点: 开启后记录上一次 takeChanges 以来新建、更新过和已经结束的流
+    void setChangeTracking(bool enabled);
+    // all 为true时取出全部流, 否则只取有更新的流和已结束的流的键; 之后重新开始记录
+    void takeChanges(bool all, std::vector<FlowSnapshot> &changed, std::vector<FlowKey> &removed);
+    // 从检查点恢复一条流并重新挂上定时器, 第一次推进时间时按实际空闲时间处理; 内存预算用完时返回false
+    bool restore(const FlowSnapshot &snapshot);
+
+private:
+    using FlowMap = std::unordered_map<FlowKey, FlowRecord, FlowKeyHash, std::equal_to<FlowKey>,
+                                       PoolAllocator<std::pair<const FlowKey, FlowRecord>>>;
+
+    void arm(FlowRecord &flow, std::uint64_t deadlineNs);
+    void release(FlowRecord &flow);
+    void assignTimer(FlowRecord &flow);
+    void markChanged(FlowRecord &flow);
+    static FlowSnapshot snapshotOf(const FlowRecord &flow);
+    static FlowSummary summarize(const FlowRecord &flow, FlowEndReason reason);
+
+    std::uint64_t idleTimeoutNs;
+    std::uint64_t activeTimeoutNs;
+    // 哈希表节点从slab池分配, 池必须比表先构造、后析构。
+    // 节点式容器里元素地址稳定, 定时器编号直接映射到记录指针
+    SlabPool nodePool;
+    FlowMap flows;
+    FlowRecord overflow;
+    std::uint64_t untracked = 0;
+    std::vector<FlowRecord *> byTimer;
+    std::vector<std::uint32_t> freeTimerIds;
+    HierarchicalTimerWheel wheel;
+    std::vector<std::uint32_t> fired;
+    bool tracking = false;
+    std::vector<std::uint32_t> changedTimers; // 有更新的流的定时器编号, 可能重复或已经失效
+    std::vector<FlowKey> removedKeys;
+};
+
+namespace FlowInspector {
+
+// 在客户端方向的负载上尝试解析ClientHello, 每个流只会成功一次
+void inspectTls(FlowRecord &flow, const DecodedPacket &pkt, bool fromInitiator);
+
+} // namespace FlowInspector
+
+#endif // FLOWTABLE_H
@@ -0,0 +1,327 @@
+#include "FragmentReassembler.h"
+#include "Checksum.h"
+#include <algorithm>
+
+using PacketDecoder::readBe16;
+
+namespace {
+
+// 同时重组的数据报上限, 大量伪造的首片只会加快淘汰
+constexpr std::size_t kMaxDatagrams = 8192;
+// 与常见协议栈一致: IPv4 30秒, IPv6 60秒 (RFC 8200)
+constexpr std::uint64_t kIpv4TimeoutNs = 30ULL * 1000000000ULL;
+constexpr std::uint64_t kIpv6TimeoutNs = 60ULL * 1000000000ULL;
+constexpr std::uint64_t kWheelTickNs = 1000000000ULL;
+constexpr std::uint32_t kWheelSlots = 128; // 大于最长超时, 定时器不会绕圈
+constexpr std::uint32_t kMaxDatagramBytes = 65535;
+// 回收的缓冲区个数和单个容量上限, 超过的直接释放
+constexpr std::size_t kMaxPooledBuffers = 32;
+constexpr std::size_t kPooledCapacity = 16 * 1024;
+// 缓冲区按该粒度预留, 顺序到达的分片不必每片都重新分配
+constexpr std::size_t kBufferGranule = 2048;
+
+void writeBe16(std::uint8_t *p, std::uint32_t v)
+{
+    p[0] = static_cast<std::uint8_t>(v >> 8);
+    p[1] = static_cast<std::uint8_t>(v);
+}
+
+} // namespace
+
+std::size_t FragmentReassembler::KeyHash::operator()(const Key &key) const
+{
+    const auto *p = reinterpret_cast<const std::uint8_t *>(&key);
+    std::uint64_t h = 1469598103934665603ULL;
+    for (std::size_t i = 0; i < sizeof(Key); ++i) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return static_cast<std::size_t>(h);
+}
+
+FragmentReassembler::FragmentReassembler(std::size_t memoryLimit)
+    : memoryLimit(memoryLimit)
+    , wheel(kWheelTickNs, kWheelSlots)
+{
+}
+
+FragmentReassembler::~FragmentReassembler()
+{
+    clear();
+}
+
+FragmentReassembler::Result FragmentReassembler::add(const DecodedPacket &pkt, DecodedPacket &out)
+{
+    expire(pkt.tsNs);
+    if (!pkt.isFragment || pkt.l3Truncated || pkt.fragData == nullptr) {
+        return Result::PassThrough;
+    }
+
+    Key key;
+    std::memset(&key, 0, sizeof(key));
+    const std::size_t addrLen = pkt.ipVersion == 6 ? 16 : 4;
+    std::memcpy(key.src, pkt.srcAddr, addrLen);
+    std::memcpy(key.dst, pkt.dstAddr, addrLen);
+    key.id = pkt.fragId;
+    key.proto = pkt.ipVersion == 4 ? pkt.fragNextHeader : 0; // IPv6只按标识区分
+    key.version = pkt.ipVersion;
+    key.source = pkt.source;
+
+    const std::uint64_t timeout = pkt.ipVersion == 6 ? kIpv6TimeoutNs : kIpv4TimeoutNs;
+    const std::uint32_t slot = acquire(key, pkt.tsNs, timeout);
+    switch (insert(slot, pkt)) {
+    case Insert::Ok:
+        break;
+    case Insert::Duplicate:
+        return Result::Consumed;
+    case Insert::Overlap:
+        ++counters.overlaps;
+        release(slot);
+        return Result::Consumed;
+    case Insert::Invalid:
+        ++counters.invalid;
+        release(slot);
+        return Result::Consumed;
+    case Insert::OutOfMemory:
+        ++counters.memoryDrops;
+        release(slot);
+        return Result::Consumed;
+    }
+
+    const Datagram &datagram = datagrams[slot];
+    if (datagram.headerLen == 0 || datagram.totalLen == 0 || datagram.ranges.size() != 1
+        || datagram.ranges.front().begin != 0 || datagram.ranges.front().end != datagram.totalLen) {
+        return Result::Consumed;
+    }
+    const bool ok = build(datagram, pkt.tsNs, out);
+    release(slot);
+    if (!ok) {
+        ++counters.invalid;
+        return Result::Consumed;
+    }
+    ++counters.reassembled;
+    return Result::Completed;
+}
+
+void FragmentReassembler::expire(std::uint64_t nowNs)
+{
+    wheel.advance(nowNs, expired);
+    for (std::uint32_t slot : expired) {
+        ++counters.timedOut;
+        release(slot);
+    }
+}
+
+void FragmentReassembler::clear()
+{
+    for (std::uint32_t slot = 0; slot < datagrams.size(); ++slot) {
+        if (datagrams[slot].used) {
+            release(slot);
+        }
+    }
+    wheel.clear();
+    counters = FragmentStats();
+    MemoryBudget::global().release(MemoryBudget::Fragments, pooledBytes);
+    bufferPool.clear();
+    pooledBytes = 0;
+}
+
+void FragmentReassembler::setMemoryLimit(std::size_t limit)
+{
+    memoryLimit = limit;
+    while (counters.bytesInUse > memoryLimit && evictOldest(TimerWheel::kNone)) {
+        ++counters.memoryDrops;
+    }
+    // 回收待用的缓冲区超过新上限的部分还给全局预算
+    while (!bufferPool.empty() && counters.bytesInUse + pooledBytes > memoryLimit) {
+        const std::size_t capacity = bufferPool.back().capacity();
+        bufferPool.pop_back();
+        pooledBytes -= capacity;
+        MemoryBudget::global().release(MemoryBudget::Fragments, capacity);
+    }
+}
+
+std::uint32_t FragmentReassembler::acquire(const Key &key, std::uint64_t nowNs, std::uint64_t timeoutNs)
+{
+    auto found = index.find(key);
+    if (found != index.end()) {
+        return found->second;
+    }
+    if (index.size() >= kMaxDatagrams && evictOldest(TimerWheel::kNone)) {
+        ++counters.memoryDrops;
+    }
+
+    std::uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<std::uint32_t>(datagrams.size());
+        datagrams.emplace_back();
+    }
+    Datagram &datagram = datagrams[slot];
+    datagram.key = key;
+    datagram.used = true;
+    datagram.headerLen = 0;
+    datagram.totalLen = 0;
+    datagram.nextHeader = 0;
+    datagram.wireBytes = 0;
+    datagram.firstSeenNs = nowNs;
+    // 回收的缓冲区已经计入全局预算, 这里只需要遵守本模块的上限
+    if (!bufferPool.empty() && counters.bytesInUse + bufferPool.back().capacity() <= memoryLimit) {
+        datagram.data.swap(bufferPool.back());
+        bufferPool.pop_back();
+        pooledBytes -= datagram.data.capacity();
+        counters.bytesInUse += datagram.data.capacity();
+    }
+    index.emplace(key, slot);
+    MemoryBudget::global().addObjects(MemoryBudget::Fragments, 1);
+    wheel.schedule(slot, nowNs + timeoutNs);
+    return slot;
+}
+
+void FragmentReassembler::release(std::uint32_t slot)
+{
+    Datagram &datagram = datagrams[slot];
+    wheel.cancel(slot);
+    index.erase(datagram.key);
+    const std::size_t capacity = datagram.data.capacity();
+    counters.bytesInUse -= capacity;
+    if (bufferPool.size() < kMaxPooledBuffers && capacity <= kPooledCapacity) {
+        datagram.data.clear();
+        bufferPool.push_back(std::move(datagram.data));
+        pooledBytes += capacity;
+    } else {
+        MemoryBudget::global().release(MemoryBudget::Fragments, capacity);
+    }
+    MemoryBudget::global().addObjects(MemoryBudget::Fragments, -1);
+    datagram.data = std::vector<std::uint8_t>();
+    datagram.ranges.clear();
+    datagram.used = false;
+    freeSlots.push_back(slot);
+}
+
+bool FragmentReassembler::evictOldest(std::uint32_t keep)
+{
+    // 最早建立的数据报最早到期, 也是最可能已经丢了分片的那个
+    std::uint32_t victim = wheel.earliest();
+    if (victim == keep) {
+        wheel.cancel(keep);
+        victim = wheel.earliest();
+        const Datagram &kept = datagrams[keep];
+        wheel.schedule(keep, kept.firstSeenNs + (kept.key.version == 6 ? kIpv6TimeoutNs : kIpv4TimeoutNs));
+    }
+    if (victim == TimerWheel::kNone) {
+        return false;
+    }
+    release(victim);
+    return true;
+}
+
+FragmentReassembler::Insert FragmentReassembler::insert(std::uint32_t slot, const DecodedPacket &pkt)
+{
+    const std::uint32_t len = static_cast<std::uint32_t>(pkt.fragDataLen);
+    const std::uint32_t begin = pkt.fragOffset;
+    const std::uint32_t end = begin + len;
+    const std::size_t l3HeaderLen = pkt.ipVersion == 4 ? static_cast<std::size_t>(pkt.fragData - pkt.l3) : 0;
+
+    // 空分片、非末片长度不是8的倍数、超出最大数据报长度 (ping of death) 都不合法
+    if (len == 0 || (pkt.moreFragments && len % 8 != 0) || l3HeaderLen + end > kMaxDatagramBytes) {
+        return Insert::Invalid;
+    }
+
+    Datagram &datagram = datagrams[slot];
+    if (!pkt.moreFragments) {
+        if (datagram.totalLen != 0 && datagram.totalLen != end) {
+            return Insert::Invalid;
+        }
+        if (!datagram.ranges.empty() && datagram.ranges.back().end > end) {
+            return Insert::Invalid;
+        }
+        datagram.totalLen = end;
+    } else if (datagram.totalLen != 0 && end > datagram.totalLen) {
+        return Insert::Invalid;
+    }
+
+    auto pos = std::lower_bound(datagram.ranges.begin(), datagram.ranges.end(), begin,
+                                [](const Range &r, std::uint32_t value) { return r.end <= value; });
+    if (pos != datagram.ranges.end() && pos->begin < end) {
+        // 完全相同的分片视为重传; 其余任何重叠都可能被用来让不同系统看到不同内容
+        return pos->begin == begin && pos->end == end ? Insert::Duplicate : Insert::Overlap;
+    }
+
+    if (end > datagram.data.capacity()) {
+        const std::size_t before = datagram.data.capacity();
+        const std::size_t capacity = std::min<std::size_t>((end + kBufferGranule - 1) & ~(kBufferGranule - 1),
+                                                           kMaxDatagramBytes);
+        const std::size_t growth = capacity - before;
+        while (counters.bytesInUse + growth > memoryLimit
+               || !MemoryBudget::global().tryCharge(MemoryBudget::Fragments, growth)) {
+            if (!evictOldest(slot)) {
+                return Insert::OutOfMemory;
+            }
+            ++counters.memoryDrops;
+        }
+        datagram.data.reserve(capacity);
+        // 标准库可能多给, 多出的部分也要记账, 释放时按实际容量归还
+        if (datagram.data.capacity() > capacity) {
+            MemoryBudget::global().charge(MemoryBudget::Fragments, datagram.data.capacity() - capacity);
+        }
+        counters.bytesInUse += datagram.data.capacity() - before;
+    }
+    if (end > datagram.data.size()) {
+        datagram.data.resize(end);
+    }
+    std::memcpy(datagram.data.data() + begin, pkt.fragData, len);
+    datagram.wireBytes += pkt.wireLen;
+    datagram.nextHeader = pkt.fragNextHeader;
+    if (begin == 0) {
+        datagram.headerLen = pkt.ipVersion == 4 ? l3HeaderLen : 40;
+        std::memcpy(datagram.header, pkt.l3, datagram.headerLen);
+    }
+
+    // 插入并与相邻区间合并, 通常只剩一两个区间
+    pos = datagram.ranges.insert(pos, Range{begin, end});
+    if (pos + 1 != datagram.ranges.end() && (pos + 1)->begin == end) {
+        pos->end = (pos + 1)->end;
+        datagram.ranges.erase(pos + 1);
+    }
+    if (pos != datagram.ranges.begin() && (pos - 1)->end == begin) {
+        (pos - 1)->end = pos->end;
+        datagram.ranges.erase(pos);
+    }
+    return Insert::Ok;
+}
+
+bool FragmentReassembler::build(const Datagram &datagram, std::uint64_t tsNs, DecodedPacket &out)
+{
+    const std::size_t total = datagram.headerLen + datagram.totalLen;
+    if (datagram.key.version == 4 && total > kMaxDatagramBytes) {
+        return false;
+    }
+    output.resize(total);
+    std::uint8_t *p = output.data();
+    std::memcpy(p, datagram.header, datagram.headerLen);
+    std::memcpy(p + datagram.headerLen, datagram.data.data(), datagram.totalLen);
+
+    if (datagram.key.version == 4) {
+        // 改写为未分片的数据报: 总长度、只保留DF标志, 重新计算头部校验和
+        writeBe16(p + 2, static_cast<std::uint32_t>(total));
+        writeBe16(p + 6, readBe16(p + 6) & 0x4000u);
+        p[10] = p[11] = 0;
+        const std::uint16_t checksum = static_cast<std::uint16_t>(~Checksum::fold(Checksum::sum(p, datagram.headerLen)));
+        std::memcpy(p + 10, &checksum, sizeof(checksum));
+    } else {
+        // 不可分片部分的扩展头部不保留, 固定头部直接指向上层协议
+        writeBe16(p + 4, datagram.totalLen);
+        p[6] = datagram.nextHeader;
+    }
+
+    out = DecodedPacket();
+    if (!PacketDecoder::decodeIp(p, total, out)) {
+        return false;
+    }
+    out.tsNs = tsNs;
+    out.wireLen = datagram.wireBytes;
+    out.source = datagram.key.source;
+    return true;
+}
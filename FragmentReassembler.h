@@ -0,0 +1,118 @@
+#ifndef FRAGMENTREASSEMBLER_H
+#define FRAGMENTREASSEMBLER_H
+
+#include "MemoryBudget.h"
+#include "PacketDecoder.h"
+#include "TimerWheel.h"
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// 分片重组的累计计数
+struct FragmentStats
+{
+    std::uint64_t reassembled = 0; // 重组完成的数据报
+    std::uint64_t timedOut = 0;    // 超时仍不完整而丢弃的数据报
+    std::uint64_t overlaps = 0;    // 分片重叠 (含teardrop类) 而整体丢弃的数据报
+    std::uint64_t invalid = 0;     // 长度或偏移不合法的分片
+    std::uint64_t memoryDrops = 0; // 超出内存上限而丢弃的数据报
+    std::size_t bytesInUse = 0;
+};
+
+// IPv4/IPv6分片重组。数据报按 (源, 目的, 标识, 协议) 归并, 分片数据直接写进
+// 每个数据报的连续缓冲区, 缓冲区用完后回收复用; 超时由哈希时间轮按数据包时间驱动。
+// 任何重叠都丢弃整个数据报 (RFC 5722), 重复的同一分片忽略。
+// 缓冲区 (包括回收待用的) 同时受 memoryLimit 和全局内存预算约束
+class FragmentReassembler
+{
+public:
+    enum class Result {
+        PassThrough, // 不参与重组 (截断的捕获等), 按原样处理
+        Consumed,    // 已收下, 数据报还不完整或已被丢弃
+        Completed    // 数据报完整, 结果在 out 中
+    };
+
+    explicit FragmentReassembler(std::size_t memoryLimit);
+    ~FragmentReassembler();
+
+    FragmentReassembler(const FragmentReassembler &) = delete;
+    FragmentReassembler &operator=(const FragmentReassembler &) = delete;
+
+    // pkt 必须是 isFragment 的包。Completed 时 out 是重组后数据报的解码结果,
+    // 指向内部缓冲区, 在下一次调用 add 之前有效; wireLen 为所有分片之和
+    Result add(const DecodedPacket &pkt, DecodedPacket &out);
+
+    // 按数据包时间丢弃超时的数据报; add 内部也会调用
+    void expire(std::uint64_t nowNs);
+
+    void clear();
+    const FragmentStats &stats() const { return counters; }
+    // 调低上限时立即丢弃最早的数据报, 直到占用不超过新上限
+    void setMemoryLimit(std::size_t limit);
+
+private:
+    struct Key
+    {
+        std::uint8_t src[16];
+        std::uint8_t dst[16];
+        std::uint32_t id;
+        std::uint8_t proto;
+        std::uint8_t version;
+        std::uint8_t source; // 不同输入上看到的同一个分片各自重组, 不当作重叠
+        std::uint8_t pad;
+
+        bool operator==(const Key &other) const { return std::memcmp(this, &other, sizeof(Key)) == 0; }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &key) const;
+    };
+
+    struct Range
+    {
+        std::uint32_t begin;
+        std::uint32_t end;
+    };
+
+    struct Datagram
+    {
+        Key key;
+        bool used = false;
+        std::uint8_t header[60];   // 首片的IPv4头部或IPv6固定头部
+        std::size_t headerLen = 0; // 0 表示还没收到首片
+        std::uint8_t nextHeader = 0;
+        std::uint32_t totalLen = 0; // 0 表示还没收到最后一片
+        std::vector<Range> ranges;  // 已收到的区间, 按起点排序
+        std::vector<std::uint8_t> data;
+        std::uint32_t wireBytes = 0;
+        std::uint64_t firstSeenNs = 0;
+    };
+
+    enum class Insert {
+        Ok,
+        Duplicate,
+        Overlap,
+        Invalid,
+        OutOfMemory
+    };
+
+    std::uint32_t acquire(const Key &key, std::uint64_t nowNs, std::uint64_t timeoutNs);
+    void release(std::uint32_t slot);
+    bool evictOldest(std::uint32_t keep);
+    Insert insert(std::uint32_t slot, const DecodedPacket &pkt);
+    bool build(const Datagram &datagram, std::uint64_t tsNs, DecodedPacket &out);
+
+    std::size_t memoryLimit;
+    std::vector<Datagram> datagrams;
+    std::vector<std::uint32_t> freeSlots;
+    std::unordered_map<Key, std::uint32_t, KeyHash> index;
+    std::vector<std::vector<std::uint8_t>> bufferPool;
+    std::size_t pooledBytes = 0; // 回收待用的缓冲区容量, 同样计入全局预算
+    std::vector<std::uint8_t> output;
+    TimerWheel wheel;
+    std::vector<std::uint32_t> expired;
+    FragmentStats counters;
+};
+
+#endif // FRAGMENTREASSEMBLER_H
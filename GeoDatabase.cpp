@@ -0,0 +1,126 @@
+#include "GeoDatabase.h"
+#include <cstring>
+
+namespace {
+
+template<typename T>
+const T *sectionData(const std::uint8_t *base, std::size_t size, const GeoImage::Section &section,
+                     std::uint64_t expectedCount = 0)
+{
+    if (section.offset % alignof(T) != 0 || section.offset > size
+        || section.count > (size - section.offset) / sizeof(T)
+        || (expectedCount != 0 && section.count != expectedCount)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const T *>(base + section.offset);
+}
+
+} // namespace
+
+GeoDatabase::~GeoDatabase()
+{
+    if (base != nullptr) {
+        file.unmap(const_cast<std::uint8_t *>(base));
+    }
+}
+
+std::shared_ptr<const GeoDatabase> GeoDatabase::open(const QString &path, QString *error)
+{
+    std::shared_ptr<GeoDatabase> db(new GeoDatabase());
+    if (!db->map(path, error)) {
+        return nullptr;
+    }
+    return db;
+}
+
+bool GeoDatabase::map(const QString &path, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error != nullptr) {
+            *error = message;
+        }
+        return false;
+    };
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("无法打开地址库 %1: %2").arg(path, file.errorString()));
+    }
+    const std::size_t size = static_cast<std::size_t>(file.size());
+    if (size < sizeof(GeoImage::Header)) {
+        return fail("地址库文件过小");
+    }
+    base = file.map(0, file.size());
+    if (base == nullptr) {
+        return fail("无法映射地址库文件");
+    }
+
+    header = reinterpret_cast<const GeoImage::Header *>(base);
+    if (std::memcmp(header->magic, GeoImage::kMagic, sizeof(GeoImage::kMagic)) != 0
+        || header->version != GeoImage::kVersion) {
+        return fail("不是受支持的地址库文件, 请重新导入CSV");
+    }
+
+    using namespace GeoImage;
+    using PrefixTrie::kNodeFlag;
+    using PrefixTrie::popcount64;
+    const std::uint64_t directCount = 1u << PrefixTrie::kDirectBits;
+    records = sectionData<Record>(base, size, header->sections[Records]);
+    v4.direct = sectionData<std::uint32_t>(base, size, header->sections[V4Direct], directCount);
+    v4.nodes = sectionData<Node>(base, size, header->sections[V4Nodes]);
+    v4.leaves = sectionData<std::uint32_t>(base, size, header->sections[V4Leaves]);
+    v6.direct = sectionData<std::uint32_t>(base, size, header->sections[V6Direct], directCount);
+    v6.nodes = sectionData<Node>(base, size, header->sections[V6Nodes]);
+    v6.leaves = sectionData<std::uint32_t>(base, size, header->sections[V6Leaves]);
+    if (records == nullptr || v4.direct == nullptr || v6.direct == nullptr
+        || (v4.nodes == nullptr) || (v4.leaves == nullptr) || (v6.nodes == nullptr) || (v6.leaves == nullptr)) {
+        return fail("地址库文件已损坏");
+    }
+
+    // 只做一遍线性的下标检查, 保证损坏的文件不会让查询越界
+    const std::uint64_t recordCount = header->sections[Records].count;
+    auto checkTrie = [&](const Trie &trie, SectionId nodeSection, SectionId leafSection) {
+        const std::uint64_t nodeCount = header->sections[nodeSection].count;
+        const std::uint64_t leafCount = header->sections[leafSection].count;
+        for (std::uint64_t i = 0; i < directCount; ++i) {
+            const std::uint32_t entry = trie.direct[i];
+            if ((entry & kNodeFlag) ? (entry & ~kNodeFlag) >= nodeCount : entry >= recordCount) {
+                return false;
+            }
+        }
+        for (std::uint64_t i = 0; i < nodeCount; ++i) {
+            const Node &node = trie.nodes[i];
+            const std::uint64_t leafPositions = ~node.vector;
+            if ((node.leafvec & node.vector) != 0
+                || (leafPositions != 0 && (node.leafvec & (leafPositions & (0 - leafPositions))) == 0)
+                || node.childBase + static_cast<std::uint64_t>(popcount64(node.vector)) > nodeCount
+                || node.leafBase + static_cast<std::uint64_t>(popcount64(node.leafvec)) > leafCount) {
+                return false;
+            }
+        }
+        for (std::uint64_t i = 0; i < leafCount; ++i) {
+            if (trie.leaves[i] >= recordCount) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (recordCount == 0 || !checkTrie(v4, V4Nodes, V4Leaves) || !checkTrie(v6, V6Nodes, V6Leaves)) {
+        return fail("地址库文件已损坏");
+    }
+    return true;
+}
+
+GeoInfo GeoDatabase::lookup(const IpAddress &address) const
+{
+    const PrefixTrie::Key key = PrefixTrie::keyOf(address);
+    const std::uint32_t index = key.v4 ? v4.find(key) : v6.find(key);
+    GeoInfo info;
+    if (index != 0) {
+        const GeoImage::Record &record = records[index];
+        info.asn = record.asn;
+        info.country[0] = record.country[0];
+        info.country[1] = record.country[1];
+    }
+    return info;
+}
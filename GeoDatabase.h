@@ -0,0 +1,89 @@
+#ifndef GEODATABASE_H
+#define GEODATABASE_H
+
+#include "AnalysisTypes.h"
+#include "PrefixTrie.h"
+#include <QFile>
+#include <cstdint>
+#include <memory>
+
+// 编译后的地址库镜像格式。文件按本机字节序写出, 各段64字节对齐,
+// 映射后直接当作数组使用, 加载时只检查边界, 不做解析
+namespace GeoImage {
+
+constexpr char kMagic[8] = {'T', 'A', 'G', 'E', 'O', 'D', 'B', '1'};
+constexpr std::uint32_t kVersion = 1;
+using PrefixTrie::Node;
+
+struct Record
+{
+    std::uint32_t asn;
+    char country[2];
+    std::uint16_t reserved;
+};
+
+struct Section
+{
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+enum SectionId {
+    Records,
+    V4Direct,
+    V4Nodes,
+    V4Leaves,
+    V6Direct,
+    V6Nodes,
+    V6Leaves,
+    SectionCount
+};
+
+struct Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t prefixCount;
+    std::uint64_t buildTime;
+    Section sections[SectionCount];
+};
+
+} // namespace GeoImage
+
+// 只读的ASN/国家查询库, 查询只读映射内存, 可以被多个线程同时使用
+class GeoDatabase
+{
+public:
+    ~GeoDatabase();
+
+    static std::shared_ptr<const GeoDatabase> open(const QString &path, QString *error = nullptr);
+
+    GeoInfo lookup(const IpAddress &address) const;
+    std::uint32_t prefixCount() const { return header->prefixCount; }
+    QString fileName() const { return file.fileName(); }
+
+private:
+    struct Trie
+    {
+        const std::uint32_t *direct = nullptr;
+        const PrefixTrie::Node *nodes = nullptr;
+        const std::uint32_t *leaves = nullptr;
+
+        std::uint32_t find(const PrefixTrie::Key &key) const
+        {
+            return PrefixTrie::find(direct, nodes, leaves, key.hi, key.lo);
+        }
+    };
+
+    GeoDatabase() = default;
+    bool map(const QString &path, QString *error);
+
+    QFile file;
+    const std::uint8_t *base = nullptr;
+    const GeoImage::Header *header = nullptr;
+    const GeoImage::Record *records = nullptr;
+    Trie v4;
+    Trie v6;
+};
+
+#endif // GEODATABASE_H
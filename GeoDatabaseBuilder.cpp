@@ -0,0 +1,250 @@
+#include "GeoDatabaseBuilder.h"
+#include "AddressFormatter.h"
+#include "GeoDatabase.h"
+#include "PrefixTrie.h"
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Prefix
+{
+    IpAddress address;
+    int length = 0; // 128位长度
+    std::uint32_t record = 0;
+};
+
+// 低 bits 位全为1的掩码
+IpAddress lowMask(int bits)
+{
+    IpAddress mask;
+    if (bits >= 128) {
+        mask.hi = mask.lo = ~0ULL;
+    } else if (bits > 64) {
+        mask.hi = (1ULL << (bits - 64)) - 1;
+        mask.lo = ~0ULL;
+    } else if (bits == 64) {
+        mask.lo = ~0ULL;
+    } else if (bits > 0) {
+        mask.lo = (1ULL << bits) - 1;
+    }
+    return mask;
+}
+
+int trailingZeros(const IpAddress &a)
+{
+    int n = 0;
+    for (std::uint64_t word : {a.lo, a.hi}) {
+        if (word == 0) {
+            n += 64;
+            continue;
+        }
+        while ((word & 1) == 0) {
+            word >>= 1;
+            ++n;
+        }
+        break;
+    }
+    return n;
+}
+
+// 把 [first, last] 地址区间拆成最少的CIDR块
+void rangeToPrefixes(IpAddress first, const IpAddress &last, std::uint32_t record, std::vector<Prefix> &out)
+{
+    const int maxBits = first.isV4() ? 32 : 128;
+    while (!(last < first)) {
+        int bits = std::min(trailingZeros(first), maxBits);
+        for (;; --bits) {
+            const IpAddress mask = lowMask(bits);
+            IpAddress end = first;
+            end.hi |= mask.hi;
+            end.lo |= mask.lo;
+            if (!(last < end)) {
+                out.push_back({first, 128 - bits, record});
+                // end + 1, 到达地址空间末尾时结束
+                first = end;
+                if (++first.lo == 0 && ++first.hi == 0) {
+                    return;
+                }
+                if (maxBits == 32 && !first.isV4()) {
+                    return;
+                }
+                break;
+            }
+        }
+    }
+}
+
+QString unquote(const QString &field)
+{
+    QString s = field.trimmed();
+    if (s.size() >= 2 && s.startsWith('"') && s.endsWith('"')) {
+        s = s.mid(1, s.size() - 2).trimmed();
+    }
+    return s;
+}
+
+std::size_t alignUp(std::size_t n)
+{
+    return (n + 63) & ~static_cast<std::size_t>(63);
+}
+
+} // namespace
+
+bool GeoDatabaseBuilder::compileCsv(const QString &csvPath, const QString &imagePath, QString *error,
+                                    int *prefixCount)
+{
+    auto fail = [error](const QString &message) {
+        if (error != nullptr) {
+            *error = message;
+        }
+        return false;
+    };
+
+    QFile csv(csvPath);
+    if (!csv.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return fail(QString("无法打开 %1: %2").arg(csvPath, csv.errorString()));
+    }
+
+    // 记录0保留给"库中没有"
+    std::vector<GeoImage::Record> records(1, GeoImage::Record{0, {0, 0}, 0});
+    std::map<std::pair<std::uint32_t, std::uint16_t>, std::uint32_t> recordIndex;
+    std::vector<Prefix> prefixes;
+
+    QTextStream in(&csv);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QStringList fields = line.split(',');
+        if (fields.size() < 3) {
+            continue;
+        }
+
+        IpAddress first;
+        IpAddress last;
+        int length = 0;
+        int next = 0;
+        const QString head = unquote(fields[0]);
+        if (head.contains('/')) {
+            if (!AddressFormatter::parseCidr(head, first, length)) {
+                continue;
+            }
+            next = 1;
+        } else if (fields.size() >= 4 && AddressFormatter::parse(head, first)
+                   && AddressFormatter::parse(unquote(fields[1]), last) && first.isV4() == last.isV4()
+                   && !(last < first)) {
+            next = 2;
+        } else {
+            continue;
+        }
+
+        QString asnText = unquote(fields[next]);
+        if (asnText.startsWith("AS", Qt::CaseInsensitive)) {
+            asnText = asnText.mid(2);
+        }
+        const std::uint32_t asn = asnText.toUInt();
+        const QString country = unquote(fields[next + 1]).toUpper();
+        char code[2] = {0, 0};
+        if (country.size() == 2 && country != "ZZ" && country[0].isLetter() && country[1].isLetter()) {
+            code[0] = static_cast<char>(country[0].toLatin1());
+            code[1] = static_cast<char>(country[1].toLatin1());
+        }
+        if (asn == 0 && code[0] == 0) {
+            continue; // 未分配或未路由的地址段
+        }
+
+        const std::uint16_t packedCountry = static_cast<std::uint16_t>((static_cast<std::uint8_t>(code[0]) << 8)
+                                                                       | static_cast<std::uint8_t>(code[1]));
+        auto inserted = recordIndex.emplace(std::make_pair(asn, packedCountry),
+                                            static_cast<std::uint32_t>(records.size()));
+        if (inserted.second) {
+            records.push_back(GeoImage::Record{asn, {code[0], code[1]}, 0});
+        }
+        const std::uint32_t record = inserted.first->second;
+
+        if (next == 1) {
+            prefixes.push_back({first, length, record});
+        } else {
+            rangeToPrefixes(first, last, record, prefixes);
+        }
+    }
+    if (prefixes.empty()) {
+        return fail("CSV中没有可用的网段记录");
+    }
+
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const Prefix &a, const Prefix &b) { return a.length < b.length; });
+    PrefixTrie::Builder v4Builder;
+    PrefixTrie::Builder v6Builder;
+    for (const Prefix &prefix : prefixes) {
+        const PrefixTrie::Key key = PrefixTrie::keyOf(prefix.address, prefix.length);
+        (key.v4 ? v4Builder : v6Builder).insert(key.hi, key.lo, key.length, prefix.record);
+    }
+
+    PrefixTrie::Table v4;
+    PrefixTrie::Table v6;
+    v4Builder.serialize(v4);
+    v6Builder.serialize(v6);
+
+    GeoImage::Header header{};
+    std::copy(std::begin(GeoImage::kMagic), std::end(GeoImage::kMagic), header.magic);
+    header.version = GeoImage::kVersion;
+    header.prefixCount = static_cast<std::uint32_t>(prefixes.size());
+    header.buildTime = static_cast<std::uint64_t>(QDateTime::currentSecsSinceEpoch());
+
+    struct Chunk
+    {
+        const void *data;
+        std::size_t bytes;
+        std::size_t count;
+    };
+    const Chunk chunks[GeoImage::SectionCount] = {
+        {records.data(), records.size() * sizeof(GeoImage::Record), records.size()},
+        {v4.direct.data(), v4.direct.size() * sizeof(std::uint32_t), v4.direct.size()},
+        {v4.nodes.data(), v4.nodes.size() * sizeof(PrefixTrie::Node), v4.nodes.size()},
+        {v4.leaves.data(), v4.leaves.size() * sizeof(std::uint32_t), v4.leaves.size()},
+        {v6.direct.data(), v6.direct.size() * sizeof(std::uint32_t), v6.direct.size()},
+        {v6.nodes.data(), v6.nodes.size() * sizeof(PrefixTrie::Node), v6.nodes.size()},
+        {v6.leaves.data(), v6.leaves.size() * sizeof(std::uint32_t), v6.leaves.size()},
+    };
+    std::size_t offset = alignUp(sizeof(header));
+    for (int i = 0; i < GeoImage::SectionCount; ++i) {
+        header.sections[i].offset = offset;
+        header.sections[i].count = chunks[i].count;
+        offset = alignUp(offset + chunks[i].bytes);
+    }
+
+    QSaveFile out(imagePath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return fail(QString("无法写入 %1: %2").arg(imagePath, out.errorString()));
+    }
+    const QByteArray padding(64, '\0');
+    std::size_t written = 0;
+    auto write = [&](const void *data, std::size_t bytes) {
+        out.write(static_cast<const char *>(data), static_cast<qint64>(bytes));
+        written += bytes;
+        out.write(padding.constData(), static_cast<qint64>(alignUp(written) - written));
+        written = alignUp(written);
+    };
+    write(&header, sizeof(header));
+    for (const Chunk &chunk : chunks) {
+        write(chunk.data, chunk.bytes);
+    }
+    if (!out.commit()) {
+        return fail(QString("无法写入 %1: %2").arg(imagePath, out.errorString()));
+    }
+
+    if (prefixCount != nullptr) {
+        *prefixCount = static_cast<int>(prefixes.size());
+    }
+    return true;
+}
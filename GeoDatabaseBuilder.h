@@ -0,0 +1,18 @@
+#ifndef GEODATABASEBUILDER_H
+#define GEODATABASEBUILDER_H
+
+#include <QString>
+
+// 把CSV格式的网段库编译成 GeoDatabase 可以直接映射的镜像文件。
+// 支持两种行格式 (多余的列忽略, 无法解析的行如表头直接跳过):
+//   网段,ASN,国家               例如 1.0.0.0/24,13335,AU
+//   起始地址,结束地址,ASN,国家   例如 1.0.0.0,1.0.0.255,AS13335,AU
+namespace GeoDatabaseBuilder {
+
+// 输出先写临时文件再替换, 正在使用旧镜像的映射不受影响
+bool compileCsv(const QString &csvPath, const QString &imagePath, QString *error = nullptr,
+                int *prefixCount = nullptr);
+
+} // namespace GeoDatabaseBuilder
+
+#endif // GEODATABASEBUILDER_H
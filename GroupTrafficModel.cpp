@@ -0,0 +1,141 @@
+#include "GroupTrafficModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QLocale>
+#include <algorithm>
+
+GroupTrafficModel::GroupTrafficModel(Layout layout, QObject *parent)
+    : QAbstractTableModel(parent)
+    , layout(layout)
+{
+}
+
+int GroupTrafficModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : matrix.size();
+}
+
+int GroupTrafficModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return layout == Summary ? SummaryColumnCount : matrix.size();
+}
+
+QVariant GroupTrafficModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= matrix.size()) {
+        return QVariant();
+    }
+    return layout == Summary ? summaryData(index.row(), index.column(), role)
+                             : matrixData(index.row(), index.column(), role);
+}
+
+QVariant GroupTrafficModel::summaryData(int row, int column, int role) const
+{
+    quint64 value = 0;
+    switch (column) {
+    case ColGroup:
+        return role == Qt::DisplayRole || role == SortRole ? QVariant(matrix.groups[row]) : QVariant();
+    case ColSentBytes: value = sentBytes[row]; break;
+    case ColReceivedBytes: value = receivedBytes[row]; break;
+    case ColSentPackets: value = sentPackets[row]; break;
+    case ColReceivedPackets: value = receivedPackets[row]; break;
+    default: return QVariant();
+    }
+
+    if (role == SortRole) {
+        return value;
+    }
+    if (role == Qt::DisplayRole) {
+        const bool isBytes = column == ColSentBytes || column == ColReceivedBytes;
+        return isBytes ? QLocale().formattedDataSize(static_cast<qint64>(value)) : QString::number(value);
+    }
+    if (role == Qt::TextAlignmentRole) {
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    return QVariant();
+}
+
+QVariant GroupTrafficModel::matrixData(int src, int dst, int role) const
+{
+    if (dst >= matrix.size()) {
+        return QVariant();
+    }
+    const int cell = matrix.cell(src, dst);
+    const quint64 bytes = matrix.bytes[cell];
+    switch (role) {
+    case Qt::DisplayRole:
+        return bytes != 0 ? QLocale().formattedDataSize(static_cast<qint64>(bytes)) : QString();
+    case SortRole:
+        return bytes;
+    case Qt::TextAlignmentRole:
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    case Qt::ToolTipRole:
+        return QString("%1 → %2\n%3 字节, %4 个包")
+            .arg(matrix.groups[src], matrix.groups[dst])
+            .arg(bytes).arg(matrix.packets[cell]);
+    case Qt::BackgroundRole:
+        if (bytes != 0 && maxCellBytes != 0) {
+            // 颜色深浅按占最大单元格的比例
+            const int alpha = 24 + static_cast<int>(160.0 * static_cast<double>(bytes) / static_cast<double>(maxCellBytes));
+            return QBrush(QColor(52, 152, 219, alpha));
+        }
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+QVariant GroupTrafficModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    if (layout == Matrix) {
+        return matrix.groups.value(section);
+    }
+    if (orientation == Qt::Vertical) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList headers = {"分组", "发送字节", "接收字节", "发送包数", "接收包数"};
+    return headers.value(section);
+}
+
+void GroupTrafficModel::setMatrix(const GroupTrafficMatrix &newMatrix)
+{
+    const bool reshaped = newMatrix.groups != matrix.groups;
+    if (reshaped) {
+        beginResetModel();
+    }
+    matrix = newMatrix;
+
+    const int n = matrix.size();
+    sentBytes.fill(0, n);
+    receivedBytes.fill(0, n);
+    sentPackets.fill(0, n);
+    receivedPackets.fill(0, n);
+    maxCellBytes = 0;
+    for (int src = 0; src < n; ++src) {
+        for (int dst = 0; dst < n; ++dst) {
+            const int cell = matrix.cell(src, dst);
+            sentBytes[src] += matrix.bytes[cell];
+            receivedBytes[dst] += matrix.bytes[cell];
+            sentPackets[src] += matrix.packets[cell];
+            receivedPackets[dst] += matrix.packets[cell];
+            maxCellBytes = std::max(maxCellBytes, matrix.bytes[cell]);
+        }
+    }
+
+    if (reshaped) {
+        endResetModel();
+    } else if (n > 0) {
+        emit dataChanged(index(0, 0), index(n - 1, columnCount() - 1));
+    }
+}
+
+void GroupTrafficModel::clear()
+{
+    setMatrix(GroupTrafficMatrix());
+}
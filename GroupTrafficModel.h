@@ -0,0 +1,54 @@
+#ifndef GROUPTRAFFICMODEL_H
+#define GROUPTRAFFICMODEL_H
+
+#include "AnalysisTypes.h"
+#include <QAbstractTableModel>
+
+// 网段分组流量的表格模型。同一份矩阵可以按分组汇总显示, 也可以按源/目的分组矩阵显示;
+// 只保存整数计数, 文本在绘制可见单元格时生成
+class GroupTrafficModel final : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Layout {
+        Summary, // 每个分组一行: 发送/接收的字节数和包数
+        Matrix   // 行为源分组, 列为目的分组
+    };
+
+    enum SummaryColumn {
+        ColGroup,
+        ColSentBytes,
+        ColReceivedBytes,
+        ColSentPackets,
+        ColReceivedPackets,
+        SummaryColumnCount
+    };
+
+    // 排序时使用的原始计数
+    static constexpr int SortRole = Qt::UserRole;
+
+    explicit GroupTrafficModel(Layout layout, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void setMatrix(const GroupTrafficMatrix &newMatrix);
+    void clear();
+
+private:
+    QVariant summaryData(int row, int column, int role) const;
+    QVariant matrixData(int src, int dst, int role) const;
+
+    Layout layout;
+    GroupTrafficMatrix matrix;
+    QVector<quint64> sentBytes;
+    QVector<quint64> receivedBytes;
+    QVector<quint64> sentPackets;
+    QVector<quint64> receivedPackets;
+    quint64 maxCellBytes = 0;
+};
+
+#endif // GROUPTRAFFICMODEL_H
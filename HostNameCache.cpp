@@ -0,0 +1,68 @@
+#include "HostNameCache.h"
+#include "AddressFormatter.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QPointer>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+HostNameCache::HostNameCache(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void HostNameCache::loadAsync(const QString &path)
+{
+    const quint64 current = ++generation;
+    if (path.isEmpty()) {
+        install(current, std::make_shared<NameMap>());
+        return;
+    }
+
+    QPointer<HostNameCache> self(this);
+    QThread *loader = QThread::create([self, path, current]() {
+        auto loaded = std::make_shared<NameMap>();
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream in(&file);
+            while (!in.atEnd()) {
+                QString line = in.readLine();
+                const int comment = line.indexOf('#');
+                if (comment >= 0) {
+                    line.truncate(comment);
+                }
+                const QStringList fields = line.simplified().split(' ');
+                IpAddress address;
+                if (fields.size() < 2 || !AddressFormatter::parse(fields[0], address)) {
+                    continue;
+                }
+                // 同一地址以第一次出现的名称为准, 与hosts文件的解析习惯一致
+                loaded->emplace(address, fields[1]);
+            }
+        }
+        // 回到界面线程安装结果
+        QMetaObject::invokeMethod(qApp, [self, current, loaded]() {
+            if (self) {
+                self->install(current, loaded);
+            }
+        }, Qt::QueuedConnection);
+    });
+    connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+    loader->start(QThread::LowPriority);
+}
+
+QString HostNameCache::lookup(const IpAddress &address) const
+{
+    const auto it = names.find(address);
+    return it == names.end() ? QString() : it->second;
+}
+
+void HostNameCache::install(quint64 loadGeneration, std::shared_ptr<NameMap> loaded)
+{
+    if (loadGeneration != generation) {
+        return;
+    }
+    names = std::move(*loaded);
+    emit namesChanged(static_cast<int>(names.size()));
+}
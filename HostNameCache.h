@@ -0,0 +1,37 @@
+#ifndef HOSTNAMECACHE_H
+#define HOSTNAMECACHE_H
+
+#include "IpAddress.h"
+#include <QObject>
+#include <QString>
+#include <memory>
+#include <unordered_map>
+
+// 反向名称缓存: 在后台线程读取hosts格式文件 ("地址 名称 [别名...]"),
+// 读取完成后在界面线程中整体替换, 查询不需要加锁
+class HostNameCache final : public QObject
+{
+    Q_OBJECT
+
+public:
+    using NameMap = std::unordered_map<IpAddress, QString, IpAddressHash>;
+
+    explicit HostNameCache(QObject *parent = nullptr);
+
+    // 空路径表示关闭名称解析
+    void loadAsync(const QString &path);
+    // 没有名称时返回空串
+    QString lookup(const IpAddress &address) const;
+    bool isEmpty() const { return names.empty(); }
+
+signals:
+    void namesChanged(int count);
+
+private:
+    void install(quint64 loadGeneration, std::shared_ptr<NameMap> loaded);
+
+    NameMap names;
+    quint64 generation = 0; // 丢弃过期的加载结果
+};
+
+#endif // HOSTNAMECACHE_H
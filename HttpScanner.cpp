@@ -0,0 +1,254 @@
+#include "HttpScanner.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if TA_X86
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// 只扫描前8KB, 更长的头部在展示上没有意义
+constexpr std::size_t kMaxHeaderBytes = 8192;
+
+// 查找下一个换行符或冒号, 找不到时返回end
+using FindDelimFn = const std::uint8_t *(*)(const std::uint8_t *, const std::uint8_t *);
+
+const std::uint8_t *findDelimScalar(const std::uint8_t *p, const std::uint8_t *end)
+{
+    for (; p < end; ++p) {
+        if (*p == '\n' || *p == ':') {
+            return p;
+        }
+    }
+    return end;
+}
+
+#if TA_X86
+TA_TARGET("sse4.2")
+const std::uint8_t *findDelimSse42(const std::uint8_t *p, const std::uint8_t *end)
+{
+    const __m128i set = _mm_setr_epi8('\n', ':', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    while (end - p >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int idx = _mm_cmpestri(set, 2, chunk, 16,
+                                     _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (idx < 16) {
+            return p + idx;
+        }
+        p += 16;
+    }
+    return findDelimScalar(p, end);
+}
+
+TA_TARGET("avx2")
+const std::uint8_t *findDelimAvx2(const std::uint8_t *p, const std::uint8_t *end)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i colon = _mm256_set1_epi8(':');
+    while (end - p >= 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline),
+                                             _mm256_cmpeq_epi8(chunk, colon));
+        const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+#if defined(_MSC_VER)
+            unsigned long idx;
+            _BitScanForward(&idx, mask);
+            return p + idx;
+#else
+            return p + __builtin_ctz(mask);
+#endif
+        }
+        p += 32;
+    }
+    return findDelimScalar(p, end);
+}
+#endif
+
+struct Implementation
+{
+    FindDelimFn findDelim;
+    const char *name;
+};
+
+Implementation selectImplementation()
+{
+#if TA_X86
+    if (CpuFeatures::hasAvx2()) {
+        return {findDelimAvx2, "avx2"};
+    }
+    if (CpuFeatures::hasSse42()) {
+        return {findDelimSse42, "sse4.2"};
+    }
+#endif
+    return {findDelimScalar, "scalar"};
+}
+
+const Implementation &implementation()
+{
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+
+// 跳过冒号, 返回行尾换行符的位置 (URI和头部值里都可能出现冒号)
+const std::uint8_t *findLineEnd(FindDelimFn findDelim, const std::uint8_t *p, const std::uint8_t *end)
+{
+    const std::uint8_t *q = findDelim(p, end);
+    while (q < end && *q == ':') {
+        q = findDelim(q + 1, end);
+    }
+    return q;
+}
+
+std::string_view makeView(const std::uint8_t *begin, const std::uint8_t *end)
+{
+    return {reinterpret_cast<const char *>(begin), static_cast<std::size_t>(end - begin)};
+}
+
+// 去掉头部值两端的空白和行尾的 '\r'
+std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == '\r' || s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view lowerB)
+{
+    if (a.size() != lowerB.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        if (c != lowerB[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isKnownMethod(std::string_view m)
+{
+    static constexpr std::string_view methods[] = {
+        "GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH", "CONNECT", "TRACE"
+    };
+    return std::find(std::begin(methods), std::end(methods), m) != std::end(methods);
+}
+
+bool parseStartLine(std::string_view line, HttpMetadata &out)
+{
+    if (line.size() >= 12 && line.compare(0, 7, "HTTP/1.") == 0) {
+        // HTTP/1.1 200 OK
+        if (line[8] != ' ') {
+            return false;
+        }
+        int code = 0;
+        for (std::size_t i = 9; i < 12; ++i) {
+            if (line[i] < '0' || line[i] > '9') {
+                return false;
+            }
+            code = code * 10 + (line[i] - '0');
+        }
+        out.isRequest = false;
+        out.statusCode = code;
+        return true;
+    }
+
+    // GET /index.html HTTP/1.1
+    const std::size_t sp1 = line.find(' ');
+    if (sp1 == std::string_view::npos || !isKnownMethod(line.substr(0, sp1))) {
+        return false;
+    }
+    const std::size_t sp2 = line.rfind(' ');
+    if (sp2 == sp1 || line.compare(sp2 + 1, 7, "HTTP/1.") != 0) {
+        return false;
+    }
+    out.isRequest = true;
+    out.method = line.substr(0, sp1);
+    out.uri = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    return true;
+}
+
+std::int64_t parseContentLength(std::string_view value)
+{
+    if (value.empty()) {
+        return -1;
+    }
+    std::int64_t n = 0;
+    for (char c : value) {
+        if (c < '0' || c > '9' || n > (INT64_MAX - 9) / 10) {
+            return -1;
+        }
+        n = n * 10 + (c - '0');
+    }
+    return n;
+}
+
+} // namespace
+
+bool HttpScanner::scan(const std::uint8_t *data, std::size_t len, HttpMetadata &out)
+{
+    out = HttpMetadata();
+    if (data == nullptr || len < 14) {
+        return false;
+    }
+
+    const FindDelimFn findDelim = implementation().findDelim;
+    const std::uint8_t *p = data;
+    const std::uint8_t *end = data + std::min(len, kMaxHeaderBytes);
+
+    // 起始行必须完整
+    const std::uint8_t *lineEnd = findLineEnd(findDelim, p, end);
+    if (lineEnd == end || !parseStartLine(trim(makeView(p, lineEnd)), out)) {
+        return false;
+    }
+    p = lineEnd + 1;
+
+    // 只提取展示用到的 Host 和 Content-Length
+    const bool wantHost = out.isRequest;
+    while (p < end && *p != '\r' && *p != '\n') {
+        const std::uint8_t *delim = findDelim(p, end);
+        if (delim == end) {
+            break; // 头部被截断
+        }
+        if (*delim == '\n') {
+            p = delim + 1; // 没有冒号的畸形行, 跳过
+            continue;
+        }
+        const std::string_view name = makeView(p, delim);
+        lineEnd = findLineEnd(findDelim, delim + 1, end);
+        const std::string_view value = trim(makeView(delim + 1, lineEnd));
+
+        if (wantHost && out.host.empty() && equalsIgnoreCase(name, "host")) {
+            out.host = value;
+        } else if (out.contentLength < 0 && equalsIgnoreCase(name, "content-length")) {
+            out.contentLength = parseContentLength(value);
+        }
+        if ((!wantHost || !out.host.empty()) && out.contentLength >= 0) {
+            break;
+        }
+        if (lineEnd == end) {
+            break;
+        }
+        p = lineEnd + 1;
+    }
+    return true;
+}
+
+const char *HttpScanner::implementationName()
+{
+    return implementation().name;
+}
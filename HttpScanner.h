@@ -0,0 +1,32 @@
+#ifndef HTTPSCANNER_H
+#define HTTPSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 结果表需要展示的HTTP/1.x字段, 字符串均为指向数据包缓冲区的视图,
+// 生命周期不超过该缓冲区
+struct HttpMetadata
+{
+    bool isRequest = false;
+    std::string_view method;
+    std::string_view uri;
+    std::string_view host;
+    int statusCode = 0;
+    std::int64_t contentLength = -1; // -1 表示没有 Content-Length
+};
+
+namespace HttpScanner {
+
+// 解析负载开头的HTTP/1.x请求行或状态行以及头部, 负载不是HTTP时返回false。
+// 头部被截断时返回已经解析出的字段。分析引擎没有TCP流重组, 传入的是单个TCP段的负载,
+// 跨段的头部只能解析到段尾
+bool scan(const std::uint8_t *data, std::size_t len, HttpMetadata &out);
+
+// 运行时选中的分隔符扫描实现: "avx2", "sse4.2" 或 "scalar"
+const char *implementationName();
+
+} // namespace HttpScanner
+
+#endif // HTTPSCANNER_H
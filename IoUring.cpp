@@ -0,0 +1,161 @@
+#include "IoUring.h"
+
+#ifdef TA_IO_URING
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+IoUring::~IoUring()
+{
+    shutdown();
+}
+
+bool IoUring::init(unsigned entries)
+{
+    shutdown();
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return false;
+    }
+    sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap) {
+        sqRingBytes = cqRingBytes = std::max(sqRingBytes, cqRingBytes);
+    }
+    void *map = ::mmap(nullptr, sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (map == MAP_FAILED) {
+        shutdown();
+        return false;
+    }
+    sqRing = map;
+    if (singleMmap) {
+        cqRing = sqRing;
+    } else {
+        map = ::mmap(nullptr, cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (map == MAP_FAILED) {
+            shutdown();
+            return false;
+        }
+        cqRing = map;
+    }
+    sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    map = ::mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (map == MAP_FAILED) {
+        shutdown();
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe *>(map);
+
+    auto *sq = static_cast<std::uint8_t *>(sqRing);
+    auto *cq = static_cast<std::uint8_t *>(cqRing);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    capacity = params.sq_entries;
+    prepared = 0;
+    pending = 0;
+    return true;
+}
+
+void IoUring::shutdown()
+{
+    // 关闭文件描述符时内核会取消还在进行的请求
+    if (sqes != nullptr) {
+        ::munmap(sqes, sqesBytes);
+        sqes = nullptr;
+    }
+    if (cqRing != nullptr && cqRing != sqRing) {
+        ::munmap(cqRing, cqRingBytes);
+    }
+    if (sqRing != nullptr) {
+        ::munmap(sqRing, sqRingBytes);
+    }
+    sqRing = cqRing = nullptr;
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    capacity = prepared = pending = 0;
+}
+
+bool IoUring::registerBuffers(const iovec *buffers, unsigned count)
+{
+    return fd >= 0 && ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
+
+io_uring_sqe *IoUring::prepare()
+{
+    // 在途请求不超过队列长度, 完成队列 (默认是提交队列的两倍) 就不会溢出
+    if (fd < 0 || pending >= capacity) {
+        return nullptr;
+    }
+    const unsigned tail = *sqTail + prepared;
+    const unsigned index = tail & sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[index] = index;
+    ++prepared;
+    ++pending;
+    return sqe;
+}
+
+bool IoUring::submit(unsigned minComplete)
+{
+    if (fd < 0) {
+        return false;
+    }
+    unsigned toSubmit = prepared;
+    if (toSubmit > 0) {
+        __atomic_store_n(sqTail, *sqTail + toSubmit, __ATOMIC_RELEASE);
+        prepared = 0;
+    }
+    for (;;) {
+        // 已经有足够的完成结果时不再等待
+        const unsigned ready = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) - *cqHead;
+        const unsigned wait = ready >= minComplete ? 0 : minComplete;
+        if (toSubmit == 0 && wait == 0) {
+            return true;
+        }
+        const int rc = static_cast<int>(
+            ::syscall(__NR_io_uring_enter, fd, toSubmit, wait, wait > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0));
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        toSubmit -= std::min<unsigned>(toSubmit, static_cast<unsigned>(rc));
+        if (wait > 0 && toSubmit == 0) {
+            return true;
+        }
+    }
+}
+
+bool IoUring::reap(std::uint64_t &userData, int &result)
+{
+    if (fd < 0) {
+        return false;
+    }
+    const unsigned head = *cqHead;
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const io_uring_cqe &cqe = cqes[head & cqMask];
+    userData = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    --pending;
+    return true;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define TA_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+// 直接用系统调用的最小io_uring封装, 不依赖liburing。提交和收割必须在同一个线程中进行。
+// 用法: prepare() 取得并填写提交项, submit() 一次提交全部并可等待若干完成, reap() 逐个取出完成结果
+class IoUring
+{
+public:
+    IoUring() = default;
+    ~IoUring();
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    // 内核不支持或被安全策略禁用时返回false
+    bool init(unsigned entries);
+    void shutdown();
+    bool isReady() const { return fd >= 0; }
+    unsigned entries() const { return capacity; }
+
+    // 注册固定缓冲区, 之后可以用 IORING_OP_READ_FIXED/WRITE_FIXED; 超出锁定内存上限等失败时返回false
+    bool registerBuffers(const iovec *buffers, unsigned count);
+
+    // 取一个清零的提交项; 提交队列或在途请求已满时返回nullptr
+    io_uring_sqe *prepare();
+    // 提交所有已准备的请求, 并等待至少 minComplete 个完成; 系统调用失败时返回false
+    bool submit(unsigned minComplete = 0);
+    // 取出一个完成结果, 没有时返回false
+    bool reap(std::uint64_t &userData, int &result);
+    // 已提交 (或已准备) 但还没取出结果的请求数
+    unsigned inFlight() const { return pending; }
+
+private:
+    int fd = -1;
+    unsigned capacity = 0;
+    unsigned prepared = 0; // 已准备还没提交
+    unsigned pending = 0;
+    void *sqRing = nullptr;
+    void *cqRing = nullptr;
+    std::size_t sqRingBytes = 0;
+    std::size_t cqRingBytes = 0;
+    std::size_t sqesBytes = 0;
+    io_uring_sqe *sqes = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned *sqArray = nullptr;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+};
+
+#endif
+
+#endif // IOURING_H
@@ -0,0 +1,71 @@
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 128位整数形式的IP地址, IPv4以 ::ffff:a.b.c.d 映射形式保存,
+// 比较和排序都直接比较整数
+struct IpAddress
+{
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+
+    static IpAddress fromV4(std::uint32_t v4)
+    {
+        IpAddress a;
+        a.lo = 0x0000ffff00000000ULL | v4;
+        return a;
+    }
+
+    // bytes 为网络字节序, version 为 4 或 6
+    static IpAddress fromBytes(const std::uint8_t *bytes, int version)
+    {
+        if (version == 4) {
+            return fromV4((static_cast<std::uint32_t>(bytes[0]) << 24) | (static_cast<std::uint32_t>(bytes[1]) << 16)
+                          | (static_cast<std::uint32_t>(bytes[2]) << 8) | bytes[3]);
+        }
+        IpAddress a;
+        for (int i = 0; i < 8; ++i) {
+            a.hi = (a.hi << 8) | bytes[i];
+            a.lo = (a.lo << 8) | bytes[i + 8];
+        }
+        return a;
+    }
+
+    bool isV4() const { return hi == 0 && (lo >> 32) == 0xffff; }
+    std::uint32_t v4() const { return static_cast<std::uint32_t>(lo); }
+
+    // 只保留前 prefixLen 位 (0-128, IPv4前缀需要加96)
+    IpAddress masked(int prefixLen) const
+    {
+        IpAddress a = *this;
+        if (prefixLen <= 0) {
+            a.hi = 0;
+            a.lo = 0;
+        } else if (prefixLen <= 64) {
+            a.hi &= ~0ULL << (64 - prefixLen);
+            a.lo = 0;
+        } else if (prefixLen < 128) {
+            a.lo &= ~0ULL << (128 - prefixLen);
+        }
+        return a;
+    }
+
+    bool operator==(const IpAddress &o) const { return hi == o.hi && lo == o.lo; }
+    bool operator!=(const IpAddress &o) const { return !(*this == o); }
+    bool operator<(const IpAddress &o) const { return hi < o.hi || (hi == o.hi && lo < o.lo); }
+};
+
+struct IpAddressHash
+{
+    std::size_t operator()(const IpAddress &a) const
+    {
+        std::uint64_t h = a.hi * 0x9e3779b97f4a7c15ULL ^ a.lo;
+        h ^= h >> 31;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        return static_cast<std::size_t>(h ^ (h >> 29));
+    }
+};
+
+#endif // IPADDRESS_H
@@ -0,0 +1,186 @@
+#include "LiveCaptureSource.h"
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/sock_diag.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#endif
+
+namespace {
+constexpr int kPollTimeoutMs = 100;
+constexpr std::size_t kMaxFrameBytes = 65536 + 64;
+}
+
+LiveCaptureSource::LiveCaptureSource()
+    : buffer(kMaxFrameBytes)
+{
+}
+
+LiveCaptureSource::~LiveCaptureSource()
+{
+    close();
+}
+
+#ifdef __linux__
+
+bool LiveCaptureSource::open(const QString &name, QString *error)
+{
+    close();
+    const QByteArray ifName = name.toLocal8Bit();
+    const unsigned int ifIndex = if_nametoindex(ifName.constData());
+    if (ifIndex == 0) {
+        if (error) {
+            *error = QString("网络接口不存在: %1").arg(name);
+        }
+        return false;
+    }
+
+    fd = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (fd < 0) {
+        if (error) {
+            *error = QString("无法创建抓包套接字 (需要root或CAP_NET_RAW权限): %1").arg(std::strerror(errno));
+        }
+        return false;
+    }
+
+    // 请求内核附带校验和状态和纳秒时间戳
+    const int one = 1;
+    ::setsockopt(fd, SOL_PACKET, PACKET_AUXDATA, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one));
+
+    sockaddr_ll addr{};
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = static_cast<int>(ifIndex);
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+        if (error) {
+            *error = QString("无法绑定网络接口 %1: %2").arg(name, std::strerror(errno));
+        }
+        close();
+        return false;
+    }
+    interfaceName = name;
+    return true;
+}
+
+void LiveCaptureSource::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool LiveCaptureSource::next(RawPacket &packet)
+{
+    if (fd < 0) {
+        return false;
+    }
+    pollfd pfd{fd, POLLIN, 0};
+    if (::poll(&pfd, 1, kPollTimeoutMs) <= 0) {
+        return false;
+    }
+
+    sockaddr_ll from{};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(tpacket_auxdata)) + CMSG_SPACE(sizeof(timespec))];
+    iovec iov{buffer.data(), buffer.size()};
+    msghdr msg{};
+    msg.msg_name = &from;
+    msg.msg_namelen = sizeof(from);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const ssize_t n = ::recvmsg(fd, &msg, MSG_TRUNC);
+    if (n <= 0) {
+        return false;
+    }
+
+    packet.data = buffer.data();
+    packet.origLen = static_cast<std::uint32_t>(n);
+    packet.capLen = static_cast<std::uint32_t>(std::min<std::size_t>(static_cast<std::size_t>(n), buffer.size()));
+    packet.flags = from.sll_pkttype == PACKET_OUTGOING ? PacketOutgoing : 0;
+    packet.linkType = (from.sll_hatype == ARPHRD_NONE || from.sll_hatype == ARPHRD_RAWIP) ? LinkRaw : LinkEthernet;
+    packet.tsNs = 0;
+
+    for (cmsghdr *c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_PACKET && c->cmsg_type == PACKET_AUXDATA) {
+            tpacket_auxdata aux;
+            std::memcpy(&aux, CMSG_DATA(c), sizeof(aux));
+            if (aux.tp_status & TP_STATUS_CSUMNOTREADY) {
+                packet.flags |= PacketChecksumPartial;
+            }
+            packet.origLen = aux.tp_len;
+        } else if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            packet.tsNs = static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+        }
+    }
+    if (packet.tsNs == 0) {
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        packet.tsNs = static_cast<std::uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(now.tv_nsec);
+    }
+    return true;
+}
+
+double LiveCaptureSource::backlog() const
+{
+#ifdef SO_MEMINFO
+    if (fd < 0) {
+        return -1.0;
+    }
+    // 套接字接收队列已占用的内存和上限 (Linux 4.6+)
+    std::uint32_t meminfo[SK_MEMINFO_VARS] = {};
+    socklen_t len = sizeof(meminfo);
+    if (::getsockopt(fd, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0 || meminfo[SK_MEMINFO_RCVBUF] == 0) {
+        return -1.0;
+    }
+    return static_cast<double>(meminfo[SK_MEMINFO_RMEM_ALLOC]) / meminfo[SK_MEMINFO_RCVBUF];
+#else
+    return -1.0;
+#endif
+}
+
+#else
+
+bool LiveCaptureSource::open(const QString &name, QString *error)
+{
+    Q_UNUSED(name)
+    if (error) {
+        *error = "当前平台暂不支持实时抓包";
+    }
+    return false;
+}
+
+void LiveCaptureSource::close() {}
+
+bool LiveCaptureSource::next(RawPacket &packet)
+{
+    Q_UNUSED(packet)
+    return false;
+}
+
+double LiveCaptureSource::backlog() const
+{
+    return -1.0;
+}
+
+#endif
+
+QString LiveCaptureSource::description() const
+{
+    return interfaceName;
+}
@@ -0,0 +1,29 @@
+#ifndef LIVECAPTURESOURCE_H
+#define LIVECAPTURESOURCE_H
+
+#include "PacketSource.h"
+#include <vector>
+
+// 从网络接口实时抓包 (Linux AF_PACKET), 需要 CAP_NET_RAW 权限
+class LiveCaptureSource final : public PacketSource
+{
+public:
+    LiveCaptureSource();
+    ~LiveCaptureSource() override;
+
+    bool open(const QString &interfaceName, QString *error = nullptr);
+    void close();
+
+    // 最多等待100ms, 超时返回false, 由调用方决定是否继续
+    bool next(RawPacket &packet) override;
+    bool isLive() const override { return true; }
+    double backlog() const override;
+    QString description() const override;
+
+private:
+    int fd = -1;
+    QString interfaceName;
+    std::vector<std::uint8_t> buffer;
+};
+
+#endif // LIVECAPTURESOURCE_H
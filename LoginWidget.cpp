@@ -1,4 +1,5 @@
 #include "LoginWidget.h"
+#include "AppStyle.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -8,7 +9,7 @@
 LoginWidget::LoginWidget(QWidget *parent)
     : QWidget(parent)
 {
-    setStyleSheet("QWidget { background-color: #f0f0f0; }");
+    setStyleSheet(AppStyle::pageStyleSheet());
 
     auto *mainLayout = new QVBoxLayout(this);
     mainLayout->setAlignment(Qt::AlignCenter);
@@ -16,23 +17,23 @@ LoginWidget::LoginWidget(QWidget *parent)
     // 标题
     auto *titleLabel = new QLabel("网络流量分析系统");
     titleLabel->setAlignment(Qt::AlignCenter);
-    titleLabel->setStyleSheet("font-size: 24px; font-weight: bold; color: #2c3e50; margin: 20px;");
+    titleLabel->setObjectName("pageTitle");
 
     // 登录框
     auto *loginBox = new QGroupBox("用户登录");
     loginBox->setFixedSize(350, 200);
-    loginBox->setStyleSheet("QGroupBox { font-size: 14px; font-weight: bold; padding: 10px; }");
+    loginBox->setObjectName("formBox");
 
     auto *formLayout = new QFormLayout(loginBox);
 
     usernameEdit = new QLineEdit();
     usernameEdit->setPlaceholderText("请输入用户名");
-    usernameEdit->setStyleSheet("padding: 8px; border: 1px solid #ccc; border-radius: 4px;");
+    usernameEdit->setObjectName("formEdit");
 
     passwordEdit = new QLineEdit();
     passwordEdit->setEchoMode(QLineEdit::Password);
     passwordEdit->setPlaceholderText("请输入密码");
-    passwordEdit->setStyleSheet("padding: 8px; border: 1px solid #ccc; border-radius: 4px;");
+    passwordEdit->setObjectName("formEdit");
 
     formLayout->addRow("用户名:", usernameEdit);
     formLayout->addRow("密码:", passwordEdit);
@@ -41,10 +42,10 @@ LoginWidget::LoginWidget(QWidget *parent)
     auto *buttonLayout = new QHBoxLayout();
 
     loginBtn = new QPushButton("登录");
-    loginBtn->setStyleSheet("QPushButton { background-color: #3498db; color: white; padding: 8px 20px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #2980b9; }");
+    loginBtn->setObjectName("primaryBtn");
 
     registerBtn = new QPushButton("注册");
-    registerBtn->setStyleSheet("QPushButton { background-color: #95a5a6; color: white; padding: 8px 20px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #7f8c8d; }");
+    registerBtn->setObjectName("secondaryBtn");
 
     buttonLayout->addWidget(loginBtn);
     buttonLayout->addWidget(registerBtn);
@@ -3,12 +3,29 @@
 #include "RegisterWidget.h"
 #include "TrafficAnalyzerWidget.h"
 #include "SettingsWidget.h"
+#include "AppStyle.h"
+#include "Checkpoint.h"
+#include "StartupTrace.h"
 #include <QVBoxLayout>
 #include <QApplication>
 #include <QMessageBox>
 #include <QCloseEvent>
 #include <QSettings>
 #include <QIcon>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPointer>
+#include <QThread>
+
+struct MainWindow::CheckpointPreload
+{
+    // 读取线程写完后才在界面线程置为true, 之后只由界面线程访问
+    bool finished = false;
+    bool loaded = false;
+    CheckpointState state;
+    QString error;
+    qint64 elapsedMs = 0;
+};
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -19,16 +36,21 @@ MainWindow::MainWindow(QWidget *parent)
     , settingsWidget(nullptr)
     , toolBar(nullptr)
     , trayIcon(nullptr)
+    , trayMenu(nullptr)
     , currentTheme("浅色主题")
     , currentLanguage("简体中文")
     , isLoggedIn(false)
 {
     setupUI();
+    StartupTrace::mark("登录页");
     setupMenuBar();
     setupToolBar();
     setupSystemTray();
+    StartupTrace::mark("菜单、工具栏和托盘");
     loadSettings();
     restoreWindowState();
+    preloadAnalysisState();
+    StartupTrace::mark("恢复窗口设置");
 }
 
 MainWindow::~MainWindow()
@@ -45,34 +67,17 @@ void MainWindow::setupUI()
     stackedWidget = new QStackedWidget(this);
     setCentralWidget(stackedWidget);
 
-    // 创建各个界面
+    // 启动时只创建登录界面, 其余页面第一次切换过去时再创建
     loginWidget = new LoginWidget(this);
-    registerWidget = new RegisterWidget(this);
-    trafficWidget = new TrafficAnalyzerWidget(this);
-    settingsWidget = new SettingsWidget(this);
-
-    // 添加到堆栈窗口
     stackedWidget->addWidget(loginWidget);
-    stackedWidget->addWidget(registerWidget);
-    stackedWidget->addWidget(trafficWidget);
-    stackedWidget->addWidget(settingsWidget);
 
     // 连接登录相关信号槽
     connect(loginWidget, &LoginWidget::registerRequested, this, &MainWindow::showRegister);
     connect(loginWidget, &LoginWidget::loginSuccess, this, &MainWindow::showTrafficAnalyzer);
-    connect(registerWidget, &RegisterWidget::backToLogin, this, &MainWindow::showLogin);
-
-    // 连接设置相关信号槽
-    connect(settingsWidget, &SettingsWidget::backRequested, this, &MainWindow::showTrafficAnalyzer);
-    connect(settingsWidget, &SettingsWidget::settingsChanged, this, &MainWindow::onSettingsChanged);
-    connect(settingsWidget, &SettingsWidget::themeChanged, this, &MainWindow::onThemeChanged);
-    connect(settingsWidget, &SettingsWidget::languageChanged, this, &MainWindow::onLanguageChanged);
 
     // 默认显示登录界面
     stackedWidget->setCurrentWidget(loginWidget);
-
-    // 应用默认主题
-    applyTheme(currentTheme);
+    // 主题在 loadSettings 中按保存的设置应用一次
 }
 
 void MainWindow::setupMenuBar()
@@ -181,6 +186,48 @@ void MainWindow::setupSystemTray()
     trayIcon->show();
 }
 
+void MainWindow::ensureRegisterWidget()
+{
+    if (registerWidget) {
+        return;
+    }
+    registerWidget = new RegisterWidget(this);
+    stackedWidget->addWidget(registerWidget);
+    connect(registerWidget, &RegisterWidget::backToLogin, this, &MainWindow::showLogin);
+    StartupTrace::mark("创建注册页");
+}
+
+void MainWindow::ensureSettingsWidget()
+{
+    if (settingsWidget) {
+        return;
+    }
+    settingsWidget = new SettingsWidget(this);
+    stackedWidget->addWidget(settingsWidget);
+
+    // 连接设置相关信号槽
+    connect(settingsWidget, &SettingsWidget::backRequested, this, &MainWindow::showTrafficAnalyzer);
+    connect(settingsWidget, &SettingsWidget::settingsChanged, this, &MainWindow::onSettingsChanged);
+    connect(settingsWidget, &SettingsWidget::themeChanged, this, &MainWindow::onThemeChanged);
+    connect(settingsWidget, &SettingsWidget::languageChanged, this, &MainWindow::onLanguageChanged);
+    StartupTrace::mark("创建设置页");
+}
+
+void MainWindow::ensureTrafficWidget()
+{
+    if (trafficWidget) {
+        return;
+    }
+    trafficWidget = new TrafficAnalyzerWidget(this);
+    stackedWidget->addWidget(trafficWidget);
+    StartupTrace::mark("创建分析页");
+
+    // 分析选项保存在设置页里, 设置页不显示也要先创建出来读取
+    ensureSettingsWidget();
+    applyAnalyzerSettings();
+    restoreAnalysisState();
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     if (trayIcon && trayIcon->isVisible()) {
@@ -195,6 +242,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
 void MainWindow::showRegister()
 {
+    ensureRegisterWidget();
     stackedWidget->setCurrentWidget(registerWidget);
 }
 
@@ -217,6 +265,7 @@ void MainWindow::showLogin()
 
 void MainWindow::showTrafficAnalyzer()
 {
+    ensureTrafficWidget();
     stackedWidget->setCurrentWidget(trafficWidget);
     // Fix: Remove const qualifier from function to allow modification
     isLoggedIn = true;
@@ -238,13 +287,15 @@ void MainWindow::showSettings()
         QMessageBox::warning(this, "提示", "请先登录后再访问设置页面。");
         return;
     }
+    ensureSettingsWidget();
     stackedWidget->setCurrentWidget(settingsWidget);
 }
 
 void MainWindow::onSettingsChanged()
 {
     // 设置发生变化时的处理
-    QMessageBox::information(this, "提示", "设置已更新，部分更改将在重启后生效。");
+    applyAnalyzerSettings();
+    QMessageBox::information(this, "提示", "设置已更新，超时和分片重组内存立即生效，其余分析选项在下一次开始分析时生效。");
 }
 
 void MainWindow::onThemeChanged(const QString &theme)
@@ -308,87 +359,21 @@ void MainWindow::exitApplication()
 
 void MainWindow::applyTheme(const QString &theme)
 {
-    QString styleSheet;
-
-    if (theme == "深色主题") {
-        styleSheet = R"(
-            QMainWindow {
-                background-color: #2b2b2b;
-                color: #ffffff;
-            }
-            QMenuBar {
-                background-color: #3c3c3c;
-                color: #ffffff;
-                border-bottom: 1px solid #555555;
-            }
-            QMenuBar::item {
-                background-color: transparent;
-                padding: 4px 8px;
-            }
-            QMenuBar::item:selected {
-                background-color: #555555;
-                border: 1px solid #777777;
-            }
-            QMenu {
-                background-color: #3c3c3c;
-                color: #ffffff;
-                border: 1px solid #555555;
-            }
-            QMenu::item:selected {
-                background-color: #555555;
-            }
-            QToolBar {
-                background-color: #3c3c3c;
-                border: none;
-                spacing: 2px;
-            }
-            QToolBar::separator {
-                background-color: #555555;
-                width: 1px;
-                margin: 4px 2px;
-            }
-        )";
-    } else if (theme == "浅色主题") {
-        styleSheet = R"(
-            QMainWindow {
-                background-color: #f8f9fa;
-                color: #212529;
-            }
-            QMenuBar {
-                background-color: #ffffff;
-                color: #212529;
-                border-bottom: 1px solid #dee2e6;
-            }
-            QMenuBar::item {
-                background-color: transparent;
-                padding: 4px 8px;
-            }
-            QMenuBar::item:selected {
-                background-color: #e9ecef;
-                border: 1px solid #ced4da;
-            }
-            QMenu {
-                background-color: #ffffff;
-                color: #212529;
-                border: 1px solid #dee2e6;
-            }
-            QMenu::item:selected {
-                background-color: #e9ecef;
-            }
-            QToolBar {
-                background-color: #ffffff;
-                border: none;
-                spacing: 2px;
-            }
-            QToolBar::separator {
-                background-color: #dee2e6;
-                width: 1px;
-                margin: 4px 2px;
-            }
-        )";
+    // 样式表只设在菜单栏、工具栏和托盘菜单上, 主窗口本身用调色板; 主窗口是所有页面的祖先,
+    // 在它上面设样式表会让分析页的表格和日志每次重绘都经过样式表引擎
+    const QColor background = AppStyle::windowColor(theme);
+    if (background.isValid()) {
+        QPalette windowPalette = palette();
+        windowPalette.setColor(QPalette::Window, background);
+        setPalette(windowPalette);
+    }
+    const QString &sheet = AppStyle::chromeStyleSheet(theme);
+    for (QWidget *chrome : {static_cast<QWidget *>(menuBar()), static_cast<QWidget *>(toolBar),
+                            static_cast<QWidget *>(trayMenu)}) {
+        if (chrome && chrome->styleSheet() != sheet) {
+            chrome->setStyleSheet(sheet);
+        }
     }
-
-    setStyleSheet(styleSheet);
 }
 
 void MainWindow::updateLanguage(const QString &language)
@@ -427,6 +412,27 @@ void MainWindow::loadSettings()
     updateLanguage(currentLanguage);
 }
 
+void MainWindow::applyAnalyzerSettings()
+{
+    // 把设置页中与分析相关的选项推送给分析界面
+    trafficWidget->setHostsFile(settingsWidget->getHostsFile());
+    trafficWidget->setGeoDatabase(settingsWidget->getGeoDatabasePath());
+    trafficWidget->setPluginDirectory(settingsWidget->getPluginDirectory());
+    trafficWidget->setSubnetGroups(settingsWidget->getSubnetGroups());
+    trafficWidget->setFragmentMemoryLimit(static_cast<quint64>(settingsWidget->getFragmentMemoryMb()) * 1024 * 1024);
+    trafficWidget->setFlowIdleTimeout(settingsWidget->getTimeout());
+    trafficWidget->setSampling(settingsWidget->getSamplingMode(), static_cast<quint32>(settingsWidget->getSamplingRate()),
+                               settingsWidget->isSamplingPerFlow());
+    trafficWidget->setDecodeThreads(settingsWidget->getDecodeThreads());
+    trafficWidget->setFileReadMode(settingsWidget->getFileReadMode());
+    trafficWidget->setRecording(settingsWidget->getRecordOptions());
+    trafficWidget->setCheckpoint(settingsWidget->getCheckpointOptions());
+    trafficWidget->setOutputs(settingsWidget->getOutputSinks());
+    trafficWidget->setMemoryBudget(static_cast<quint64>(settingsWidget->getMemoryBudgetMb()) * 1024 * 1024);
+    trafficWidget->setDebugMode(settingsWidget->isDebugModeEnabled());
+    trafficWidget->applyConfig();
+}
+
 void MainWindow::saveWindowState()
 {
     QSettings settings("NetworkAnalyzer", "MainWindow");
@@ -444,3 +450,52 @@ void MainWindow::restoreWindowState()
     restoreGeometry(settings.value("geometry").toByteArray());
     restoreState(settings.value("windowState").toByteArray());
 }
+
+void MainWindow::preloadAnalysisState()
+{
+    // 窗口状态之外, 开启检查点时还在后台读取上次退出前的分析计数和图表, 与登录同时进行
+    const QString path = SettingsWidget::savedCheckpointOptions().path;
+    if (path.isEmpty() || !QFileInfo::exists(path)) {
+        return;
+    }
+    auto preload = std::make_shared<CheckpointPreload>();
+    checkpointPreload = preload;
+    QPointer<MainWindow> self(this);
+    QThread *loader = QThread::create([self, path, preload]() {
+        QElapsedTimer timer;
+        timer.start();
+        preload->loaded = Checkpoint::load(path, preload->state, &preload->error);
+        preload->elapsedMs = timer.elapsed();
+        QMetaObject::invokeMethod(qApp, [self, preload]() {
+            preload->finished = true;
+            if (self && self->checkpointPreload == preload) {
+                self->deliverAnalysisState();
+            }
+        }, Qt::QueuedConnection);
+    });
+    connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+    loader->start(QThread::LowPriority);
+}
+
+void MainWindow::restoreAnalysisState()
+{
+    // 分析页创建时检查点可能还在读取, 读完后再显示; 登录前在设置页关掉了检查点时不再恢复
+    if (!checkpointPreload) {
+        return;
+    }
+    if (settingsWidget->getCheckpointOptions().path.isEmpty()) {
+        checkpointPreload.reset();
+        return;
+    }
+    trafficWidget->expectCheckpoint();
+    deliverAnalysisState();
+}
+
+void MainWindow::deliverAnalysisState()
+{
+    if (!trafficWidget || !checkpointPreload->finished) {
+        return;
+    }
+    const std::shared_ptr<CheckpointPreload> preload = std::move(checkpointPreload);
+    trafficWidget->installCheckpoint(preload->loaded, preload->state, preload->error, preload->elapsedMs);
+}
@@ -9,6 +9,7 @@
 #include <QToolBar>
 #include <QSystemTrayIcon>
 #include <QString>
+#include <memory>
 
 // 前向声明
 class LoginWidget;
@@ -54,14 +55,24 @@ private:
     void setupToolBar();
     void setupSystemTray();
 
+    // 页面在第一次切换过去时创建
+    void ensureRegisterWidget();
+    void ensureTrafficWidget();
+    void ensureSettingsWidget();
+
     // 主题和语言相关函数
     void applyTheme(const QString &theme);
     void updateLanguage(const QString &language);
 
     // 设置保存和恢复
     void loadSettings();
+    void applyAnalyzerSettings();
     void saveWindowState();
     void restoreWindowState();
+    // 开启检查点时启动后就在后台读取, 不等登录; 分析页创建后交给它显示
+    void preloadAnalysisState();
+    void restoreAnalysisState();
+    void deliverAnalysisState();
 
     // 主要UI组件
     QStackedWidget *stackedWidget;
@@ -94,6 +105,10 @@ private:
     QString currentTheme;
     QString currentLanguage;
     bool isLoggedIn;
+
+    // 启动时在后台读取的检查点, 交给分析页后清空
+    struct CheckpointPreload;
+    std::shared_ptr<CheckpointPreload> checkpointPreload;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,78 @@
+#include "MemoryBudget.h"
+
+MemoryBudget &MemoryBudget::global()
+{
+    static MemoryBudget budget;
+    return budget;
+}
+
+bool MemoryBudget::tryCharge(Category category, std::uint64_t bytes)
+{
+    std::uint64_t current = usedBytes.load(std::memory_order_relaxed);
+    do {
+        if (current + bytes > limit()) {
+            recordFailure(category);
+            return false;
+        }
+    } while (!usedBytes.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+    raisePeak(peakUsedBytes, current + bytes);
+    account(category, bytes);
+    return true;
+}
+
+void MemoryBudget::charge(Category category, std::uint64_t bytes)
+{
+    raisePeak(peakUsedBytes, usedBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    account(category, bytes);
+}
+
+void MemoryBudget::release(Category category, std::uint64_t bytes)
+{
+    usedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    counters[category].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void MemoryBudget::recordFailure(Category category)
+{
+    counters[category].failures.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryBudget::addObjects(Category category, std::int64_t delta)
+{
+    counters[category].objects.fetch_add(static_cast<std::uint64_t>(delta), std::memory_order_relaxed);
+}
+
+void MemoryBudget::addSlabs(Category category, std::int64_t delta)
+{
+    counters[category].slabs.fetch_add(static_cast<std::uint64_t>(delta), std::memory_order_relaxed);
+}
+
+void MemoryBudget::account(Category category, std::uint64_t bytes)
+{
+    Counters &c = counters[category];
+    raisePeak(c.peakBytes, c.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void MemoryBudget::raisePeak(std::atomic<std::uint64_t> &peak, std::uint64_t value)
+{
+    std::uint64_t current = peak.load(std::memory_order_relaxed);
+    while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+MemoryBudget::Snapshot MemoryBudget::snapshot() const
+{
+    Snapshot s;
+    s.limit = limit();
+    s.used = used();
+    s.peak = peakUsedBytes.load(std::memory_order_relaxed);
+    for (int i = 0; i < CategoryCount; ++i) {
+        const Counters &c = counters[i];
+        s.categories[i].bytes = c.bytes.load(std::memory_order_relaxed);
+        s.categories[i].peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+        s.categories[i].objects = c.objects.load(std::memory_order_relaxed);
+        s.categories[i].slabs = c.slabs.load(std::memory_order_relaxed);
+        s.categories[i].failures = c.failures.load(std::memory_order_relaxed);
+    }
+    return s;
+}
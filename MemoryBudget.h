@@ -0,0 +1,80 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <atomic>
+#include <cstdint>
+
+// 整个进程共用的内存预算。各模块在申请大块内存 (slab、重组缓冲区、结果行) 之前先记账,
+// 超出上限时由调用方丢弃并计数, 而不是继续申请直到内存耗尽。所有计数都是原子的,
+// 分析线程记账、界面线程读取统计可以同时进行
+class MemoryBudget
+{
+public:
+    enum Category {
+        Packets,   // 数据包副本
+        Flows,     // 流表记录
+        Fragments, // 分片重组缓冲区
+        Results,   // 已交给界面的结果行
+        CategoryCount
+    };
+
+    struct CategoryStats
+    {
+        std::uint64_t bytes = 0;
+        std::uint64_t peakBytes = 0;
+        std::uint64_t objects = 0;  // 正在使用的对象
+        std::uint64_t slabs = 0;    // 已从系统申请的slab
+        std::uint64_t failures = 0; // 因超出预算被拒绝的申请
+    };
+
+    struct Snapshot
+    {
+        std::uint64_t limit = 0;
+        std::uint64_t used = 0;
+        std::uint64_t peak = 0;
+        CategoryStats categories[CategoryCount];
+    };
+
+    static constexpr std::uint64_t kDefaultLimit = 512ULL * 1024 * 1024;
+
+    static MemoryBudget &global();
+
+    // 可以随时修改; 调低到已用量以下时不回收, 只是之后的申请都会失败直到用量降下来
+    void setLimit(std::uint64_t bytes) { limitBytes.store(bytes, std::memory_order_relaxed); }
+    std::uint64_t limit() const { return limitBytes.load(std::memory_order_relaxed); }
+    std::uint64_t used() const { return usedBytes.load(std::memory_order_relaxed); }
+
+    // 预算足够时记账并返回true, 否则记一次失败
+    bool tryCharge(Category category, std::uint64_t bytes);
+    // 不检查上限直接记账, 用于无法拒绝的申请 (例如哈希表扩容), 仍然计入用量
+    void charge(Category category, std::uint64_t bytes);
+    void release(Category category, std::uint64_t bytes);
+    // 只检查不记账, 用于决定是否接收一条还没有真正分配的数据
+    bool wouldFit(std::uint64_t bytes) const { return used() + bytes <= limit(); }
+    void recordFailure(Category category);
+
+    void addObjects(Category category, std::int64_t delta);
+    void addSlabs(Category category, std::int64_t delta);
+
+    Snapshot snapshot() const;
+
+private:
+    struct Counters
+    {
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<std::uint64_t> peakBytes{0};
+        std::atomic<std::uint64_t> objects{0};
+        std::atomic<std::uint64_t> slabs{0};
+        std::atomic<std::uint64_t> failures{0};
+    };
+
+    void account(Category category, std::uint64_t bytes);
+    static void raisePeak(std::atomic<std::uint64_t> &peak, std::uint64_t value);
+
+    std::atomic<std::uint64_t> limitBytes{kDefaultLimit};
+    std::atomic<std::uint64_t> usedBytes{0};
+    std::atomic<std::uint64_t> peakUsedBytes{0};
+    Counters counters[CategoryCount];
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,358 @@
+#include "MergedPacketSource.h"
+#include "MemoryBudget.h"
+#include <QStringList>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+// 实时输入没有数据时分析线程最多等待的时间, 与实时抓包源的超时一致
+constexpr auto kIdleWait = std::chrono::milliseconds(100);
+// 读线程每读这么多个包更新一次进度和积压
+constexpr std::uint64_t kProgressInterval = 1024;
+
+std::uint64_t wallClockNs()
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::system_clock::now().time_since_epoch())
+                                          .count());
+}
+
+} // namespace
+
+MergedPacketSource::MergedPacketSource(std::vector<std::unique_ptr<PacketSource>> sources)
+{
+    const std::size_t count = std::min<std::size_t>(sources.size(), kMaxInputs);
+    inputs.reserve(count);
+    // 缓冲区在这里一次分配并记账, 读线程和分析线程之间只传递指针, 逐包不再申请内存。
+    // 没有写过的页不占物理内存
+    MemoryBudget &budget = MemoryBudget::global();
+    for (std::size_t i = 0; i < count; ++i) {
+        auto input = std::make_unique<Input>();
+        input->live = sources[i]->isLive();
+        input->source = std::move(sources[i]);
+        input->buffers.reset(new std::uint8_t[kBuffersPerInput * kBufferBytes]);
+        input->largeBuffers.reset(new std::uint8_t[kLargeBuffersPerInput * kSnapLen]);
+        input->slots.reset(new Held[kBuffersPerInput + kLargeBuffersPerInput]);
+        for (std::size_t j = kBuffersPerInput + kLargeBuffersPerInput; j-- > 0;) {
+            Held &held = input->slots[j];
+            held.large = j >= kBuffersPerInput;
+            Held *&list = held.large ? input->freeLarge : input->freeList;
+            held.data = held.large ? input->largeBuffers.get() + (j - kBuffersPerInput) * kSnapLen
+                                   : input->buffers.get() + j * kBufferBytes;
+            held.next = list;
+            list = &held;
+        }
+        budget.charge(MemoryBudget::Packets, poolBytes());
+        budget.addSlabs(MemoryBudget::Packets, 1);
+        live = live || input->live;
+        inputs.push_back(std::move(input));
+    }
+    heap = decltype(heap)(Later(), [count]() {
+        std::vector<Held *> storage;
+        storage.reserve(count * (kBuffersPerInput + kLargeBuffersPerInput));
+        return storage;
+    }());
+    // 所有输入就位后再启动读线程
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        inputs[i]->reader = std::thread(&MergedPacketSource::readLoop, this, std::ref(*inputs[i]),
+                                        static_cast<std::uint8_t>(i));
+    }
+}
+
+MergedPacketSource::~MergedPacketSource()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    spaceFree.notify_all();
+    for (auto &input : inputs) {
+        if (input->reader.joinable()) {
+            input->reader.join();
+        }
+    }
+
+    // 队列、堆和 current 中的包都还在各输入的缓冲区里, 只需减去对象计数再整块归还
+    MemoryBudget &budget = MemoryBudget::global();
+    std::int64_t inUse = static_cast<std::int64_t>(heap.size()) + (current != nullptr ? 1 : 0);
+    for (auto &input : inputs) {
+        for (const Held *held = input->queueHead; held != nullptr; held = held->next) {
+            ++inUse;
+        }
+        budget.release(MemoryBudget::Packets, poolBytes());
+        budget.addSlabs(MemoryBudget::Packets, -1);
+    }
+    budget.addObjects(MemoryBudget::Packets, -inUse);
+}
+
+std::uint64_t MergedPacketSource::poolBytes()
+{
+    return kBuffersPerInput * static_cast<std::uint64_t>(kBufferBytes)
+           + kLargeBuffersPerInput * static_cast<std::uint64_t>(kSnapLen)
+           + (kBuffersPerInput + kLargeBuffersPerInput) * sizeof(Held);
+}
+
+MergedPacketSource::Held *MergedPacketSource::takeFree(Input &input, std::uint32_t length)
+{
+    Held *&list = length <= kBufferBytes ? input.freeList : input.freeLarge;
+    Held *held = list;
+    if (held != nullptr) {
+        list = held->next;
+    }
+    return held;
+}
+
+void MergedPacketSource::readLoop(Input &input, std::uint8_t index)
+{
+    MemoryBudget &budget = MemoryBudget::global();
+    RawPacket raw;
+    std::uint64_t seq = 0;
+    // 读线程手上的一个普通缓冲区, 放进队列时顺便取下一个, 普通的包稳定时每个只加一次锁
+    Held *spare = nullptr;
+    while (!stopping) {
+        if (seq % kProgressInterval == 0) {
+            input.progress.store(input.source->progress(), std::memory_order_relaxed);
+            input.backlog.store(input.source->backlog(), std::memory_order_relaxed);
+        }
+        if (!input.source->next(raw)) {
+            if (input.live) {
+                input.backlog.store(input.source->backlog(), std::memory_order_relaxed);
+                continue; // 只是等待超时
+            }
+            break;
+        }
+
+        const std::uint32_t capLen = std::min(raw.capLen, kSnapLen);
+        Held *held = capLen <= kBufferBytes ? spare : nullptr;
+        if (held != nullptr) {
+            spare = nullptr;
+        } else {
+            std::unique_lock<std::mutex> lock(mutex);
+            held = takeFree(input, capLen);
+            if (held == nullptr && !input.live) {
+                // 离线输入的缓冲区用完时等待, 等待本身就是背压。归并要知道本输入读不动了,
+                // 不能再按它的水位线等它; 分析线程还回缓冲区时清掉标记, 醒来仍然取不到时重新标记
+                spaceFree.wait(lock, [&]() {
+                    if (stopping || (held = takeFree(input, capLen)) != nullptr) {
+                        return true;
+                    }
+                    if (!input.waiting) {
+                        input.waiting = true;
+                        dataReady.notify_one();
+                    }
+                    return false;
+                });
+                input.waiting = false;
+            }
+            if (stopping) {
+                break;
+            }
+        }
+        if (held == nullptr) {
+            // 实时输入不能让网卡等待, 缓冲区都在排队时丢弃
+            input.dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        std::memcpy(held->data, raw.data, capLen);
+        held->raw = raw;
+        held->raw.data = held->data;
+        held->raw.capLen = capLen;
+        held->raw.source = index;
+        held->seq = seq++;
+        held->next = nullptr;
+        budget.addObjects(MemoryBudget::Packets, 1);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (input.queueTail != nullptr) {
+                input.queueTail->next = held;
+            } else {
+                input.queueHead = held;
+            }
+            input.queueTail = held;
+            if (spare == nullptr) {
+                spare = takeFree(input, 0);
+            }
+        }
+        dataReady.notify_one();
+    }
+
+    input.progress.store(input.source->progress(), std::memory_order_relaxed);
+    input.backlog.store(input.source->backlog(), std::memory_order_relaxed);
+    const QString failure = input.source->errorString();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        input.error = failure;
+        if (spare != nullptr) {
+            spare->next = input.freeList;
+            input.freeList = spare;
+        }
+        input.finished = true;
+    }
+    dataReady.notify_one();
+}
+
+void MergedPacketSource::pullQueued()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &input : inputs) {
+        while (input->queueHead != nullptr) {
+            Held *held = input->queueHead;
+            input->queueHead = held->next;
+            if (held->raw.tsNs < emittedNs) {
+                ++input->late; // 已经有更晚的包交出, 只能乱序交出
+            }
+            input->maxTsNs = std::max(input->maxTsNs, held->raw.tsNs);
+            input->seenPacket = true;
+            heap.push(held);
+        }
+        input->queueTail = nullptr;
+    }
+}
+
+bool MergedPacketSource::watermark(std::uint64_t &ns) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::uint64_t now = live ? wallClockNs() : 0;
+    ns = UINT64_MAX;
+    for (const auto &input : inputs) {
+        if (input->finished && input->queueHead == nullptr) {
+            continue; // 读完的输入不再限制其他输入
+        }
+        if (input->waiting && input->queueHead == nullptr) {
+            continue; // 缓冲区都在堆中, 要等堆顶交出后才能再读, 不能再让其他输入等它
+        }
+        std::uint64_t seen = input->maxTsNs;
+        if (input->live) {
+            seen = std::max(seen, now); // 空闲的接口按系统时间推进
+        } else if (!input->seenPacket) {
+            return false;
+        }
+        ns = std::min(ns, seen > kReorderWindowNs ? seen - kReorderWindowNs : 0);
+    }
+    return true;
+}
+
+bool MergedPacketSource::allDrained() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return heap.empty()
+           && std::all_of(inputs.begin(), inputs.end(),
+                          [](const std::unique_ptr<Input> &input) {
+                              return input->finished && input->queueHead == nullptr;
+                          });
+}
+
+void MergedPacketSource::releaseCurrent()
+{
+    if (current == nullptr) {
+        return;
+    }
+    Input &input = *inputs[current->raw.source];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Held *&list = current->large ? input.freeLarge : input.freeList;
+        current->next = list;
+        list = current;
+        input.waiting = false;
+    }
+    current = nullptr;
+    MemoryBudget::global().addObjects(MemoryBudget::Packets, -1);
+    spaceFree.notify_all();
+}
+
+bool MergedPacketSource::next(RawPacket &packet)
+{
+    releaseCurrent();
+    const auto deadline = std::chrono::steady_clock::now() + kIdleWait;
+    for (;;) {
+        pullQueued();
+
+        if (!heap.empty()) {
+            std::uint64_t limit = 0;
+            if (watermark(limit) && heap.top()->raw.tsNs <= limit) {
+                current = heap.top();
+                heap.pop();
+                emittedNs = std::max(emittedNs, current->raw.tsNs);
+                packet = current->raw;
+                return true;
+            }
+        } else if (allDrained()) {
+            return false;
+        }
+
+        // 等读线程送来新数据; 实时输入的水位线随时间推进, 所以定时醒来重新检查
+        std::unique_lock<std::mutex> lock(mutex);
+        const bool hasQueued = std::any_of(inputs.begin(), inputs.end(), [](const std::unique_ptr<Input> &input) {
+            return input->queueHead != nullptr;
+        });
+        if (!hasQueued) {
+            if (live && std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            dataReady.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+}
+
+int MergedPacketSource::progress() const
+{
+    if (live) {
+        return -1;
+    }
+    int total = 0;
+    for (const auto &input : inputs) {
+        const int percent = input->progress.load(std::memory_order_relaxed);
+        total += percent < 0 ? 0 : percent;
+    }
+    return inputs.empty() ? 100 : total / static_cast<int>(inputs.size());
+}
+
+double MergedPacketSource::backlog() const
+{
+    double worst = -1.0;
+    for (const auto &input : inputs) {
+        worst = std::max(worst, input->backlog.load(std::memory_order_relaxed));
+    }
+    return worst;
+}
+
+QString MergedPacketSource::description() const
+{
+    QStringList names;
+    for (const auto &input : inputs) {
+        names.append(input->source->description());
+    }
+    return names.join(" + ");
+}
+
+QString MergedPacketSource::errorString() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    QStringList errors;
+    for (const auto &input : inputs) {
+        if (!input->error.isEmpty()) {
+            errors.append(QString("%1: %2").arg(input->source->description(), input->error));
+        }
+    }
+    return errors.join("; ");
+}
+
+QString MergedPacketSource::inputName(int index) const
+{
+    return inputs[static_cast<std::size_t>(index)]->source->description();
+}
+
+std::uint64_t MergedPacketSource::inputDrops(int index) const
+{
+    return inputs[static_cast<std::size_t>(index)]->dropped.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MergedPacketSource::inputLatePackets(int index) const
+{
+    return inputs[static_cast<std::size_t>(index)]->late;
+}
@@ -0,0 +1,129 @@
+#ifndef MERGEDPACKETSOURCE_H
+#define MERGEDPACKETSOURCE_H
+
+#include "PacketSource.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// 同时读取多个数据源 (网络接口和/或抓包文件), 按时间戳合并成一条数据流。
+// 每个输入由自己的线程读取并复制到预先分配的缓冲区, 分析线程用最小堆做k路归并。
+// 单个输入内允许 kReorderWindowNs 以内的乱序: 只有时间戳不晚于所有输入的水位线
+// (已读到的最大时间戳减去窗口) 的包才会交出; 实时输入空闲时水位线按系统时间推进。
+// 超出窗口的迟到包不再等待, 直接交出并计数
+class MergedPacketSource final : public PacketSource
+{
+public:
+    static constexpr int kMaxInputs = 16;
+    static constexpr std::uint64_t kReorderWindowNs = 100000000ULL;
+    // 每个输入预先分配的缓冲区: 普通的包放进 kBuffersPerInput 个 kBufferBytes 的缓冲区,
+    // 更长的 (巨帧、网卡合并后的TCP段) 放进 kLargeBuffersPerInput 个 kSnapLen 的缓冲区,
+    // 超过 kSnapLen 的只保留前 kSnapLen 字节。缓冲区个数就是读线程队列加归并堆能缓存的包数
+    static constexpr std::size_t kBuffersPerInput = 5120;
+    static constexpr std::uint32_t kBufferBytes = 2048;
+    static constexpr std::size_t kLargeBuffersPerInput = 64;
+    static constexpr std::uint32_t kSnapLen = 65536;
+
+    // 输入在构造时开始读取, 数量不超过 kMaxInputs
+    explicit MergedPacketSource(std::vector<std::unique_ptr<PacketSource>> inputs);
+    ~MergedPacketSource() override;
+
+    MergedPacketSource(const MergedPacketSource &) = delete;
+    MergedPacketSource &operator=(const MergedPacketSource &) = delete;
+
+    bool next(RawPacket &packet) override;
+    bool isLive() const override { return live; }
+    int progress() const override;
+    double backlog() const override;
+    QString description() const override;
+    QString errorString() const override;
+
+    int inputCount() const override { return static_cast<int>(inputs.size()); }
+    QString inputName(int index) const override;
+    std::uint64_t inputDrops(int index) const override;
+    std::uint64_t inputLatePackets(int index) const override;
+
+private:
+    // 读线程复制出来的数据包, raw.data 指向 data。构造时按缓冲区个数一次分配,
+    // 之后在空闲链表、读线程队列、堆和 current 之间流转
+    struct Held
+    {
+        RawPacket raw;
+        std::uint64_t seq = 0; // 同一输入内的读取顺序, 时间戳相同时保持原顺序
+        std::uint8_t *data = nullptr; // 指向所属输入的 buffers 或 largeBuffers
+        bool large = false;
+        Held *next = nullptr; // 空闲链表或队列中的下一个
+    };
+
+    struct Later
+    {
+        bool operator()(const Held *a, const Held *b) const
+        {
+            if (a->raw.tsNs != b->raw.tsNs) {
+                return a->raw.tsNs > b->raw.tsNs;
+            }
+            if (a->raw.source != b->raw.source) {
+                return a->raw.source > b->raw.source;
+            }
+            return a->seq > b->seq;
+        }
+    };
+
+    struct Input
+    {
+        std::unique_ptr<PacketSource> source;
+        std::thread reader;
+        bool live = false;
+        std::unique_ptr<std::uint8_t[]> buffers;
+        std::unique_ptr<std::uint8_t[]> largeBuffers;
+        std::unique_ptr<Held[]> slots; // 先是普通缓冲区的, 后面 kLargeBuffersPerInput 个是大缓冲区的
+        // 以下由 mutex 保护
+        Held *freeList = nullptr;
+        Held *freeLarge = nullptr;
+        Held *queueHead = nullptr; // 读线程交出、还没有进堆的包, 先进先出
+        Held *queueTail = nullptr;
+        bool waiting = false; // 离线输入的读线程在等待空闲的缓冲区
+        bool finished = false;
+        QString error; // 读线程结束时从源取出
+        // 以下只由分析线程访问
+        std::uint64_t maxTsNs = 0;
+        bool seenPacket = false;
+        std::uint64_t late = 0;
+        // 读线程写, 分析线程读; 只有读线程从源读取数据和查询状态
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<int> progress{0};
+        std::atomic<double> backlog{-1.0};
+    };
+
+    void readLoop(Input &input, std::uint8_t index);
+    // 把各输入队列中的包全部移进堆
+    void pullQueued();
+    // 可以安全交出的最大时间戳; 还有离线输入没有读到数据时返回false
+    bool watermark(std::uint64_t &ns) const;
+    bool allDrained() const;
+    // 每个输入预先分配的字节数
+    static std::uint64_t poolBytes();
+    // 取一个能放下 length 字节的空闲缓冲区, 没有时返回nullptr; 调用时持有 mutex
+    static Held *takeFree(Input &input, std::uint32_t length);
+    // 把上一次交出的包的缓冲区还给所属输入
+    void releaseCurrent();
+
+    std::vector<std::unique_ptr<Input>> inputs;
+    bool live = false;
+    std::atomic<bool> stopping{false};
+
+    mutable std::mutex mutex;
+    std::condition_variable dataReady;
+    std::condition_variable spaceFree;
+
+    std::priority_queue<Held *, std::vector<Held *>, Later> heap;
+    Held *current = nullptr; // 上一次 next() 交出的包, 数据在下一次调用前有效
+    std::uint64_t emittedNs = 0;
+};
+
+#endif // MERGEDPACKETSOURCE_H
@@ -0,0 +1,877 @@
+#include "OutputSink.h"
+#include "AddressFormatter.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <chrono>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <syslog.h>
+#include <unistd.h>
+#endif
+
+std::size_t OutputBatch::count(quint8 records) const
+{
+    std::size_t n = 0;
+    if (records & OutputPackets) {
+        n += static_cast<std::size_t>(packets.size());
+    }
+    if (records & OutputFlows) {
+        n += static_cast<std::size_t>(flows.size());
+    }
+    if (records & OutputAlerts) {
+        n += static_cast<std::size_t>(alerts.size());
+    }
+    return n;
+}
+
+namespace {
+
+// 单条二进制记录的长度字段只有16位, 流量类型超长时截断
+constexpr int kMaxBinaryText = 60000;
+// 套接字断开后至少隔这么久才重连, 期间的记录直接丢弃
+constexpr auto kReconnectInterval = std::chrono::seconds(1);
+
+const char *alertKindKey(AlertKind kind)
+{
+    switch (kind) {
+    case AlertKind::VerticalScan: return "vertical_scan";
+    case AlertKind::HorizontalScan: return "horizontal_scan";
+    case AlertKind::SynFlood: return "syn_flood";
+    case AlertKind::HalfOpen: return "half_open";
+    }
+    return "unknown";
+}
+
+const char *flowEndKey(FlowEndReason reason)
+{
+    switch (reason) {
+    case FlowEndReason::Idle: return "idle";
+    case FlowEndReason::Active: return "active";
+    case FlowEndReason::CaptureEnd: return "capture_end";
+    }
+    return "unknown";
+}
+
+// 把批次编码成一种格式。地址文本经过 AddressFormatter 的缓存, 每个写线程各用一个
+class RecordEncoder
+{
+public:
+    RecordEncoder(OutputFormat format, quint8 records)
+        : format(format)
+        , records(records)
+    {
+    }
+
+    void encode(const OutputBatch &batch, std::string &out)
+    {
+        switch (format) {
+        case OutputFormat::Csv:
+            encodeWith(batch, out, &RecordEncoder::packetCsv, &RecordEncoder::flowCsv, &RecordEncoder::alertCsv);
+            break;
+        case OutputFormat::Ndjson:
+            encodeWith(batch, out, &RecordEncoder::packetJson, &RecordEncoder::flowJson, &RecordEncoder::alertJson);
+            break;
+        case OutputFormat::Binary:
+            encodeWith(batch, out, &RecordEncoder::packetBinary, &RecordEncoder::flowBinary,
+                       &RecordEncoder::alertBinary);
+            break;
+        }
+    }
+
+private:
+    using PacketEncoder = void (RecordEncoder::*)(const ResultRow &, std::string &);
+    using FlowEncoder = void (RecordEncoder::*)(const FlowSummary &, std::string &);
+    using AlertEncoder = void (RecordEncoder::*)(const SecurityAlert &, std::string &);
+
+    void encodeWith(const OutputBatch &batch, std::string &out, PacketEncoder packet, FlowEncoder flow,
+                    AlertEncoder alert)
+    {
+        if (records & OutputPackets) {
+            for (const ResultRow &row : batch.packets) {
+                (this->*packet)(row, out);
+            }
+        }
+        if (records & OutputFlows) {
+            for (const FlowSummary &summary : batch.flows) {
+                (this->*flow)(summary, out);
+            }
+        }
+        if (records & OutputAlerts) {
+            for (const SecurityAlert &entry : batch.alerts) {
+                (this->*alert)(entry, out);
+            }
+        }
+    }
+
+    const std::string &address(const IpAddress &a)
+    {
+        scratch = formatter.format(a).toStdString();
+        return scratch;
+    }
+
+    static void number(std::string &out, quint64 value) { out += std::to_string(value); }
+
+    static void csvText(std::string &out, const QByteArray &text)
+    {
+        if (text.indexOf(',') < 0 && text.indexOf('"') < 0 && text.indexOf('\n') < 0 && text.indexOf('\r') < 0) {
+            out.append(text.constData(), static_cast<std::size_t>(text.size()));
+            return;
+        }
+        out += '"';
+        for (char c : text) {
+            if (c == '"') {
+                out += '"';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+
+    static void jsonText(std::string &out, const QByteArray &text)
+    {
+        static const char hex[] = "0123456789abcdef";
+        out += '"';
+        for (char c : text) {
+            const auto u = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (u < 0x20) {
+                out += "\\u00";
+                out += hex[u >> 4];
+                out += hex[u & 0xf];
+            } else {
+                out += c;
+            }
+        }
+        out += '"';
+    }
+
+    static void quoted(std::string &out, const std::string &text)
+    {
+        out += '"';
+        out += text;
+        out += '"';
+    }
+
+    static void jsonField(std::string &out, const char *key)
+    {
+        out += ",\"";
+        out += key;
+        out += "\":";
+    }
+
+    void packetCsv(const ResultRow &row, std::string &out)
+    {
+        out += "packet,";
+        number(out, row.tsNs);
+        out += ',';
+        number(out, row.source);
+        out += ',';
+        out += address(row.srcIp);
+        out += ',';
+        number(out, row.srcPort);
+        out += ',';
+        out += address(row.dstIp);
+        out += ',';
+        number(out, row.dstPort);
+        out += ',';
+        out += protocolName(row.l4Proto, row.app).toStdString();
+        out += row.checksumBad ? ",1," : ",0,";
+        csvText(out, row.trafficType.toUtf8());
+        out += '\n';
+    }
+
+    void packetJson(const ResultRow &row, std::string &out)
+    {
+        out += "{\"type\":\"packet\"";
+        jsonField(out, "ts_ns");
+        number(out, row.tsNs);
+        jsonField(out, "source");
+        number(out, row.source);
+        jsonField(out, "src");
+        quoted(out, address(row.srcIp));
+        jsonField(out, "src_port");
+        number(out, row.srcPort);
+        jsonField(out, "dst");
+        quoted(out, address(row.dstIp));
+        jsonField(out, "dst_port");
+        number(out, row.dstPort);
+        jsonField(out, "proto");
+        jsonText(out, protocolName(row.l4Proto, row.app).toUtf8());
+        jsonField(out, "checksum_bad");
+        out += row.checksumBad ? "true" : "false";
+        jsonField(out, "info");
+        jsonText(out, row.trafficType.toUtf8());
+        geoJson(out, "src", row.srcGeo);
+        geoJson(out, "dst", row.dstGeo);
+        out += "}\n";
+    }
+
+    void geoJson(std::string &out, const char *side, const GeoInfo &geo)
+    {
+        if (geo.asn != 0) {
+            jsonField(out, (std::string(side) + "_asn").c_str());
+            number(out, geo.asn);
+        }
+        if (geo.country[0] != 0) {
+            jsonField(out, (std::string(side) + "_country").c_str());
+            jsonText(out, QByteArray(geo.country, 2));
+        }
+    }
+
+    void flowCsv(const FlowSummary &flow, std::string &out)
+    {
+        out += "flow,";
+        number(out, flow.firstNs);
+        out += ',';
+        number(out, flow.lastNs);
+        out += ',';
+        out += address(flow.client);
+        out += ',';
+        number(out, flow.clientPort);
+        out += ',';
+        out += address(flow.server);
+        out += ',';
+        number(out, flow.serverPort);
+        out += ',';
+        out += protocolName(flow.l4Proto, flow.app).toStdString();
+        out += ',';
+        number(out, flow.packets);
+        out += ',';
+        number(out, flow.bytes);
+        out += ',';
+        out += flowEndKey(flow.reason);
+        out += '\n';
+    }
+
+    void flowJson(const FlowSummary &flow, std::string &out)
+    {
+        out += "{\"type\":\"flow\"";
+        jsonField(out, "first_ns");
+        number(out, flow.firstNs);
+        jsonField(out, "last_ns");
+        number(out, flow.lastNs);
+        jsonField(out, "client");
+        quoted(out, address(flow.client));
+        jsonField(out, "client_port");
+        number(out, flow.clientPort);
+        jsonField(out, "server");
+        quoted(out, address(flow.server));
+        jsonField(out, "server_port");
+        number(out, flow.serverPort);
+        jsonField(out, "proto");
+        jsonText(out, protocolName(flow.l4Proto, flow.app).toUtf8());
+        jsonField(out, "packets");
+        number(out, flow.packets);
+        jsonField(out, "bytes");
+        number(out, flow.bytes);
+        jsonField(out, "end");
+        jsonText(out, flowEndKey(flow.reason));
+        out += "}\n";
+    }
+
+    void alertCsv(const SecurityAlert &alert, std::string &out)
+    {
+        out += "alert,";
+        number(out, alert.tsNs);
+        out += ',';
+        out += alertKindKey(alert.kind);
+        out += ',';
+        out += address(alert.subject);
+        out += ',';
+        number(out, alert.distinctPorts);
+        out += ',';
+        number(out, alert.distinctHosts);
+        out += ',';
+        number(out, alert.syns);
+        out += ',';
+        number(out, alert.halfOpen);
+        out += '\n';
+    }
+
+    void alertJson(const SecurityAlert &alert, std::string &out)
+    {
+        out += "{\"type\":\"alert\"";
+        jsonField(out, "ts_ns");
+        number(out, alert.tsNs);
+        jsonField(out, "kind");
+        jsonText(out, alertKindKey(alert.kind));
+        jsonField(out, "subject");
+        quoted(out, address(alert.subject));
+        jsonField(out, "ports");
+        number(out, alert.distinctPorts);
+        jsonField(out, "hosts");
+        number(out, alert.distinctHosts);
+        jsonField(out, "syns");
+        number(out, alert.syns);
+        jsonField(out, "half_open");
+        number(out, alert.halfOpen);
+        out += "}\n";
+    }
+
+    template<typename T>
+    static void put(std::string &out, T value)
+    {
+        for (std::size_t i = 0; i < sizeof(T); ++i) {
+            out += static_cast<char>(static_cast<std::uint64_t>(value) >> (8 * i));
+        }
+    }
+
+    static void putAddress(std::string &out, const IpAddress &a)
+    {
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out += static_cast<char>(a.hi >> shift);
+        }
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out += static_cast<char>(a.lo >> shift);
+        }
+    }
+
+    // 先写种类和占位的长度, 记录写完后由 finishBinary 填上
+    static std::size_t beginBinary(std::string &out, quint8 kind)
+    {
+        const std::size_t start = out.size();
+        put<quint8>(out, kind);
+        put<quint8>(out, 0);
+        put<quint16>(out, 0);
+        return start;
+    }
+
+    static void finishBinary(std::string &out, std::size_t start)
+    {
+        const std::size_t len = out.size() - start;
+        out[start + 2] = static_cast<char>(len);
+        out[start + 3] = static_cast<char>(len >> 8);
+    }
+
+    void packetBinary(const ResultRow &row, std::string &out)
+    {
+        const std::size_t start = beginBinary(out, 1);
+        put<quint64>(out, row.tsNs);
+        putAddress(out, row.srcIp);
+        putAddress(out, row.dstIp);
+        put<quint16>(out, row.srcPort);
+        put<quint16>(out, row.dstPort);
+        put<quint8>(out, row.l4Proto);
+        put<quint8>(out, static_cast<quint8>(row.app));
+        put<quint8>(out, row.checksumBad ? 1 : 0);
+        put<quint8>(out, row.source);
+        put<quint32>(out, row.srcGeo.asn);
+        put<quint32>(out, row.dstGeo.asn);
+        out.append(row.srcGeo.country, 2);
+        out.append(row.dstGeo.country, 2);
+        const QByteArray text = row.trafficType.toUtf8().left(kMaxBinaryText);
+        put<quint16>(out, static_cast<quint16>(text.size()));
+        out.append(text.constData(), static_cast<std::size_t>(text.size()));
+        finishBinary(out, start);
+    }
+
+    void flowBinary(const FlowSummary &flow, std::string &out)
+    {
+        const std::size_t start = beginBinary(out, 2);
+        put<quint64>(out, flow.firstNs);
+        put<quint64>(out, flow.lastNs);
+        putAddress(out, flow.client);
+        putAddress(out, flow.server);
+        put<quint16>(out, flow.clientPort);
+        put<quint16>(out, flow.serverPort);
+        put<quint8>(out, flow.l4Proto);
+        put<quint8>(out, static_cast<quint8>(flow.app));
+        put<quint8>(out, static_cast<quint8>(flow.reason));
+        put<quint8>(out, 0);
+        put<quint64>(out, flow.packets);
+        put<quint64>(out, flow.bytes);
+        finishBinary(out, start);
+    }
+
+    void alertBinary(const SecurityAlert &alert, std::string &out)
+    {
+        const std::size_t start = beginBinary(out, 3);
+        put<quint64>(out, alert.tsNs);
+        put<quint8>(out, static_cast<quint8>(alert.kind));
+        put<quint8>(out, 0);
+        put<quint16>(out, 0);
+        putAddress(out, alert.subject);
+        put<quint32>(out, alert.distinctPorts);
+        put<quint32>(out, alert.distinctHosts);
+        put<quint32>(out, alert.syns);
+        put<quint32>(out, alert.halfOpen);
+        finishBinary(out, start);
+    }
+
+    OutputFormat format;
+    quint8 records;
+    AddressFormatter formatter;
+    std::string scratch;
+};
+
+// 导出目录下每次分析新建一个文件
+class FileSink final : public OutputSink
+{
+public:
+    explicit FileSink(const OutputSinkOptions &options)
+        : OutputSink(options)
+    {
+    }
+    ~FileSink() override { close(); }
+
+protected:
+    bool openTarget(QString &error) override
+    {
+        if (!QDir().mkpath(sinkOptions.path) || !QFileInfo(sinkOptions.path).isWritable()) {
+            error = QString("导出目录不可写: %1").arg(sinkOptions.path);
+            return false;
+        }
+        static const char *const suffixes[] = {"csv", "ndjson", "bin"};
+        file.setFileName(QString("%1/traffic_%2.%3")
+                             .arg(sinkOptions.path, QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"),
+                                  suffixes[static_cast<int>(sinkOptions.format)]));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = QString("无法创建导出文件 %1: %2").arg(file.fileName(), file.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    bool writeData(const std::string &data, QString &error) override
+    {
+        if (file.write(data.data(), static_cast<qint64>(data.size())) != static_cast<qint64>(data.size())
+            || !file.flush()) {
+            error = QString("写入导出文件失败: %1").arg(file.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    void closeTarget() override { file.close(); }
+
+private:
+    QFile file;
+};
+
+class StdoutSink final : public OutputSink
+{
+public:
+    explicit StdoutSink(const OutputSinkOptions &options)
+        : OutputSink(options)
+    {
+    }
+    ~StdoutSink() override { close(); }
+
+protected:
+    bool openTarget(QString &error) override
+    {
+        Q_UNUSED(error)
+        return true;
+    }
+
+    bool writeData(const std::string &data, QString &error) override
+    {
+        if (std::fwrite(data.data(), 1, data.size(), stdout) != data.size() || std::fflush(stdout) != 0) {
+            error = "写入标准输出失败";
+            std::clearerr(stdout);
+            return false;
+        }
+        return true;
+    }
+};
+
+#ifndef _WIN32
+
+// 流式UNIX套接字。对端不在或断开时丢弃记录, 每隔一段时间重连一次
+class UnixSocketSink final : public OutputSink
+{
+public:
+    explicit UnixSocketSink(const OutputSinkOptions &options)
+        : OutputSink(options)
+    {
+    }
+    ~UnixSocketSink() override { close(); }
+
+protected:
+    bool openTarget(QString &error) override
+    {
+        const QByteArray name = QFile::encodeName(sinkOptions.path);
+        if (name.isEmpty() || static_cast<std::size_t>(name.size()) >= sizeof(sockaddr_un::sun_path)) {
+            error = QString("UNIX套接字路径无效: %1").arg(sinkOptions.path);
+            return false;
+        }
+        // 对端可以晚于分析启动, 连不上不算失败
+        QString ignored;
+        connectSocket(ignored);
+        return true;
+    }
+
+    bool writeData(const std::string &data, QString &error) override
+    {
+        if (fd < 0 && !connectSocket(error)) {
+            return false;
+        }
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        std::size_t sent = 0;
+        while (sent < data.size()) {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, flags);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                error = QString("发送到 %1 失败: %2").arg(sinkOptions.path, QString::fromLocal8Bit(std::strerror(errno)));
+                disconnect();
+                return false;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    void closeTarget() override { disconnect(); }
+
+private:
+    bool connectSocket(QString &error)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (attempted && now - lastAttempt < kReconnectInterval) {
+            error = QString("未连接到 %1").arg(sinkOptions.path);
+            return false;
+        }
+        attempted = true;
+        lastAttempt = now;
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            error = QString("无法创建UNIX套接字: %1").arg(QString::fromLocal8Bit(std::strerror(errno)));
+            return false;
+        }
+#ifdef SO_NOSIGPIPE
+        const int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        const QByteArray name = QFile::encodeName(sinkOptions.path);
+        std::memcpy(addr.sun_path, name.constData(), static_cast<std::size_t>(name.size()));
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            error = QString("无法连接到 %1: %2").arg(sinkOptions.path, QString::fromLocal8Bit(std::strerror(errno)));
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    void disconnect()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    int fd = -1;
+    bool attempted = false;
+    std::chrono::steady_clock::time_point lastAttempt;
+};
+
+// 每条记录一条日志; 只输出告警时用警告级别
+class SyslogSink final : public OutputSink
+{
+public:
+    explicit SyslogSink(const OutputSinkOptions &options)
+        : OutputSink(options)
+    {
+    }
+    ~SyslogSink() override { close(); }
+
+protected:
+    bool openTarget(QString &error) override
+    {
+        Q_UNUSED(error)
+        ::openlog("NetworkAnalyzer", LOG_PID | LOG_NDELAY, LOG_USER);
+        return true;
+    }
+
+    bool writeData(const std::string &data, QString &error) override
+    {
+        Q_UNUSED(error)
+        const int priority = sinkOptions.records == OutputAlerts ? LOG_WARNING : LOG_INFO;
+        std::size_t begin = 0;
+        while (begin < data.size()) {
+            std::size_t end = data.find('\n', begin);
+            if (end == std::string::npos) {
+                end = data.size();
+            }
+            ::syslog(priority, "%.*s", static_cast<int>(end - begin), data.data() + begin);
+            begin = end + 1;
+        }
+        return true;
+    }
+
+    void closeTarget() override { ::closelog(); }
+};
+
+#else
+
+// UNIX套接字和系统日志在这个平台上不可用, 打开时报错
+class UnsupportedSink final : public OutputSink
+{
+public:
+    explicit UnsupportedSink(const OutputSinkOptions &options)
+        : OutputSink(options)
+    {
+    }
+    ~UnsupportedSink() override { close(); }
+
+protected:
+    bool openTarget(QString &error) override
+    {
+        error = QString("当前平台不支持输出到%1").arg(name());
+        return false;
+    }
+
+    bool writeData(const std::string &data, QString &error) override
+    {
+        Q_UNUSED(data)
+        Q_UNUSED(error)
+        return false;
+    }
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<OutputSink> OutputSink::create(const OutputSinkOptions &options)
+{
+    switch (options.target) {
+    case OutputTarget::File: return std::make_unique<FileSink>(options);
+    case OutputTarget::Stdout: return std::make_unique<StdoutSink>(options);
+#ifndef _WIN32
+    case OutputTarget::UnixSocket: return std::make_unique<UnixSocketSink>(options);
+    case OutputTarget::Syslog: {
+        OutputSinkOptions text = options;
+        if (text.format == OutputFormat::Binary) {
+            text.format = OutputFormat::Ndjson;
+        }
+        return std::make_unique<SyslogSink>(text);
+    }
+#else
+    case OutputTarget::UnixSocket:
+    case OutputTarget::Syslog:
+        return std::make_unique<UnsupportedSink>(options);
+#endif
+    }
+    return nullptr;
+}
+
+OutputSink::OutputSink(const OutputSinkOptions &options)
+    : sinkOptions(options)
+{
+}
+
+// 写线程调用虚函数, 派生类的析构函数必须先 close()
+OutputSink::~OutputSink() = default;
+
+bool OutputSink::open(QString *errorOut)
+{
+    close();
+    QString openError;
+    if (!openTarget(openError)) {
+        if (errorOut != nullptr) {
+            *errorOut = openError;
+        }
+        return false;
+    }
+    stopping = false;
+    error.clear();
+    worker = std::thread(&OutputSink::writeLoop, this);
+    return true;
+}
+
+void OutputSink::close()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_one();
+    worker.join();
+    closeTarget();
+}
+
+void OutputSink::submit(const std::shared_ptr<const OutputBatch> &batch)
+{
+    const std::size_t records = batch->count(sinkOptions.records);
+    if (records == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::size_t limit = sinkOptions.queueRecords;
+        if (sinkOptions.dropPolicy == OutputDropPolicy::DropOldest) {
+            while (!queue.empty() && queuedRecords + records > limit) {
+                dropped.fetch_add(queue.front().second, std::memory_order_relaxed);
+                queuedRecords -= queue.front().second;
+                queue.pop_front();
+            }
+        }
+        // 队列为空时总是接收, 超过上限的单个批次 (例如分析结束时导出的所有剩余流) 不会因此整批丢弃
+        if (!queue.empty() && queuedRecords + records > limit) {
+            dropped.fetch_add(records, std::memory_order_relaxed);
+            return;
+        }
+        queue.emplace_back(batch, records);
+        queuedRecords += records;
+    }
+    queued.notify_one();
+}
+
+OutputSink::Stats OutputSink::stats() const
+{
+    Stats stats;
+    stats.written = written.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.backlog = queuedRecords;
+    return stats;
+}
+
+QString OutputSink::errorString() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+QString OutputSink::name() const
+{
+    switch (sinkOptions.target) {
+    case OutputTarget::File: return QString("文件 %1").arg(sinkOptions.path);
+    case OutputTarget::Stdout: return QString("标准输出");
+    case OutputTarget::UnixSocket: return QString("UNIX套接字 %1").arg(sinkOptions.path);
+    case OutputTarget::Syslog: return QString("系统日志");
+    }
+    return QString();
+}
+
+void OutputSink::writeLoop()
+{
+    RecordEncoder encoder(sinkOptions.format, sinkOptions.records);
+    std::deque<std::pair<std::shared_ptr<const OutputBatch>, std::size_t>> pending;
+    std::string data;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return; // 停止时先写完排队的批次
+            }
+            pending.swap(queue);
+            queuedRecords = 0;
+        }
+
+        // 排队的批次合成一块写出, 慢的目的地每次写得更多, 系统调用次数不随记录数增长
+        data.clear();
+        std::size_t records = 0;
+        for (const auto &entry : pending) {
+            encoder.encode(*entry.first, data);
+            records += entry.second;
+        }
+        pending.clear();
+
+        QString writeError;
+        const bool ok = writeData(data, writeError);
+        (ok ? written : dropped).fetch_add(records, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        error = ok ? QString() : writeError;
+    }
+}
+
+OutputFanout::~OutputFanout()
+{
+    close();
+}
+
+bool OutputFanout::open(const QVector<OutputSinkOptions> &options, QString *error)
+{
+    close();
+    sinks.clear();
+    records = 0;
+    for (const OutputSinkOptions &sinkOptions : options) {
+        std::unique_ptr<OutputSink> sink = OutputSink::create(sinkOptions);
+        if (!sink || !sink->open(error)) {
+            close();
+            sinks.clear();
+            return false;
+        }
+        records |= sink->options().records;
+        sinks.push_back(std::move(sink));
+    }
+    return true;
+}
+
+void OutputFanout::close()
+{
+    for (const std::unique_ptr<OutputSink> &sink : sinks) {
+        sink->close();
+    }
+}
+
+void OutputFanout::publish(const QVector<ResultRow> &packets, const QVector<FlowSummary> &flows,
+                           const QVector<SecurityAlert> &alerts)
+{
+    auto batch = std::make_shared<OutputBatch>();
+    if (wants(OutputPackets)) {
+        batch->packets = packets;
+    }
+    if (wants(OutputFlows)) {
+        batch->flows = flows;
+    }
+    if (wants(OutputAlerts)) {
+        batch->alerts = alerts;
+    }
+    if (batch->count(records) == 0) {
+        return;
+    }
+    const std::shared_ptr<const OutputBatch> shared = std::move(batch);
+    for (const std::unique_ptr<OutputSink> &sink : sinks) {
+        sink->submit(shared);
+    }
+}
+
+OutputSink::Stats OutputFanout::stats() const
+{
+    OutputSink::Stats total;
+    for (const std::unique_ptr<OutputSink> &sink : sinks) {
+        const OutputSink::Stats stats = sink->stats();
+        total.written += stats.written;
+        total.dropped += stats.dropped;
+        total.backlog += stats.backlog;
+    }
+    return total;
+}
+
+QString OutputFanout::errorString() const
+{
+    QStringList errors;
+    for (const std::unique_ptr<OutputSink> &sink : sinks) {
+        const QString error = sink->errorString();
+        if (!error.isEmpty()) {
+            errors.append(sink->name() + ": " + error);
+        }
+    }
+    return errors.join("; ");
+}
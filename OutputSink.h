@@ -0,0 +1,123 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include "AnalysisTypes.h"
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 分析线程一次交出的记录, 由各输出端共享, 交出后不再修改
+struct OutputBatch
+{
+    QVector<ResultRow> packets;
+    QVector<FlowSummary> flows;
+    QVector<SecurityAlert> alerts;
+
+    // records 为 OutputRecord 的组合
+    std::size_t count(quint8 records) const;
+};
+
+// 一个输出端: 把记录编码成一种格式写到一个目的地。分析线程交出的批次进入它自己的有界队列,
+// 写线程每次取出排队的所有批次, 编码成一块数据一次写出; 队列满时按丢弃策略丢掉整批并计数,
+// 队列为空时超过上限的批次也照样接收。
+//
+// 文本格式每条记录一行, 第一个字段是记录种类:
+//   CSV    packet,时间(ns),数据源,源地址,源端口,目的地址,目的端口,协议,校验和错误,流量类型
+//          flow,开始(ns),结束(ns),客户端,客户端端口,服务端,服务端端口,协议,包数,字节数,结束原因
+//          alert,时间(ns),类型,对象地址,端口数,主机数,SYN数,未完成握手数
+//   NDJSON 同样的字段, 数据包另有地址库中的ASN和国家; 键名见 OutputSink.cpp
+// 二进制格式每条记录以 u8 种类 (1 数据包, 2 流, 3 告警)、u8 保留、u16 整条记录的长度开头,
+// 整数为小端, 地址为16字节网络序 (IPv4为映射形式), 数据包记录末尾是 u16 长度加UTF-8的流量类型
+class OutputSink
+{
+public:
+    struct Stats
+    {
+        std::uint64_t written = 0;
+        std::uint64_t dropped = 0; // 队列满或写入失败而丢弃的记录
+        std::uint64_t backlog = 0; // 排队等待写出的记录
+    };
+
+    // 按目的地创建; 系统日志不支持二进制格式, 改用NDJSON
+    static std::unique_ptr<OutputSink> create(const OutputSinkOptions &options);
+    virtual ~OutputSink();
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator=(const OutputSink &) = delete;
+
+    // 打开目的地并启动写线程
+    bool open(QString *error = nullptr);
+    // 写完排队的批次后结束写线程
+    void close();
+
+    // 只由分析线程调用, 不会等待写出
+    void submit(const std::shared_ptr<const OutputBatch> &batch);
+    Stats stats() const;
+    // 最近一次写入失败的原因, 之后写成功时清空
+    QString errorString() const;
+    QString name() const;
+    const OutputSinkOptions &options() const { return sinkOptions; }
+
+protected:
+    explicit OutputSink(const OutputSinkOptions &options);
+
+    virtual bool openTarget(QString &error) = 0;
+    // 只由写线程调用; 失败时返回 false 并给出原因, 这一块中的记录计为丢弃
+    virtual bool writeData(const std::string &data, QString &error) = 0;
+    virtual void closeTarget() {}
+
+    OutputSinkOptions sinkOptions;
+
+private:
+    void writeLoop();
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable queued;
+    std::deque<std::pair<std::shared_ptr<const OutputBatch>, std::size_t>> queue; // (批次, 其中要写的记录数)
+    std::size_t queuedRecords = 0;
+    bool stopping = false;
+    QString error;
+
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> dropped{0};
+};
+
+// 把分析线程的记录分发给各输出端, 各输出端共享同一批数据。只由分析线程调用
+class OutputFanout
+{
+public:
+    OutputFanout() = default;
+    ~OutputFanout();
+
+    OutputFanout(const OutputFanout &) = delete;
+    OutputFanout &operator=(const OutputFanout &) = delete;
+
+    // 任何一个输出端打不开时关闭已经打开的, 返回 false
+    bool open(const QVector<OutputSinkOptions> &sinks, QString *error = nullptr);
+    void close();
+    bool isOpen() const { return !sinks.empty(); }
+
+    // 有输出端需要这种记录
+    bool wants(OutputRecord record) const { return (records & record) != 0; }
+    void publish(const QVector<ResultRow> &packets, const QVector<FlowSummary> &flows,
+                 const QVector<SecurityAlert> &alerts);
+
+    // 各输出端的合计
+    OutputSink::Stats stats() const;
+    // 出错的输出端及原因, 多个时用分号隔开; 都正常时为空
+    QString errorString() const;
+
+private:
+    std::vector<std::unique_ptr<OutputSink>> sinks;
+    quint8 records = 0;
+};
+
+#endif // OUTPUTSINK_H
@@ -0,0 +1,229 @@
+#include "PacketDecoder.h"
+
+using PacketDecoder::readBe16;
+using PacketDecoder::readBe32;
+
+namespace {
+
+constexpr std::uint16_t kEtherTypeIpv4 = 0x0800;
+constexpr std::uint16_t kEtherTypeIpv6 = 0x86dd;
+constexpr std::uint16_t kEtherTypeVlan = 0x8100;
+constexpr std::uint16_t kEtherTypeQinQ = 0x88a8;
+
+bool decodeTransport(const std::uint8_t *p, std::size_t len, DecodedPacket &out)
+{
+    out.l4 = p;
+    out.l4Len = len;
+
+    if (out.l4Proto == ProtoTcp) {
+        if (len < 20) {
+            return false;
+        }
+        const std::size_t headerLen = static_cast<std::size_t>(p[12] >> 4) * 4;
+        if (headerLen < 20 || headerLen > len) {
+            return false;
+        }
+        out.srcPort = readBe16(p);
+        out.dstPort = readBe16(p + 2);
+        out.tcpSeq = readBe32(p + 4);
+        out.tcpFlags = p[13];
+        out.payload = p + headerLen;
+        out.payloadLen = len - headerLen;
+    } else if (out.l4Proto == ProtoUdp) {
+        if (len < 8) {
+            return false;
+        }
+        out.srcPort = readBe16(p);
+        out.dstPort = readBe16(p + 2);
+        out.payload = p + 8;
+        out.payloadLen = len - 8;
+    } else {
+        out.payload = p;
+        out.payloadLen = len;
+    }
+    return true;
+}
+
+// 首片的可分片部分可能短于完整的传输层头部 (例如只带TCP头部前8字节的微小分片)。
+// 分片本身仍然有效, 照样交给重组, 传输层留到重组后的完整数据报上解码
+bool keepShortFirstFragment(DecodedPacket &out)
+{
+    if (!out.isFragment) {
+        return false;
+    }
+    out.l4 = nullptr;
+    out.l4Len = 0;
+    return true;
+}
+
+bool decodeIpv4(const std::uint8_t *p, std::size_t len, DecodedPacket &out)
+{
+    if (len < 20) {
+        return false;
+    }
+    const std::size_t headerLen = static_cast<std::size_t>(p[0] & 0x0f) * 4;
+    std::size_t totalLen = readBe16(p + 2);
+    if (headerLen < 20 || headerLen > len) {
+        return false;
+    }
+    // TSO捕获的包总长度可能为0, 以实际捕获长度为准
+    if (totalLen < headerLen || totalLen > len) {
+        totalLen = len;
+        out.l3Truncated = true;
+    }
+
+    out.ipVersion = 4;
+    out.l4Proto = p[9];
+    out.srcAddr = p + 12;
+    out.dstAddr = p + 16;
+    out.l3 = p;
+    out.l3Len = totalLen;
+
+    const std::uint16_t fragField = readBe16(p + 6);
+    out.isFragment = (fragField & 0x3fff) != 0; // MF标志或非零偏移
+    if (out.isFragment) {
+        out.fragId = readBe16(p + 4);
+        out.fragOffset = static_cast<std::uint32_t>(fragField & 0x1fff) * 8;
+        out.moreFragments = (fragField & 0x2000) != 0;
+        out.fragNextHeader = out.l4Proto;
+        out.fragData = p + headerLen;
+        out.fragDataLen = totalLen - headerLen;
+    }
+    if ((fragField & 0x1fff) != 0) {
+        // 非首片没有传输层头部
+        out.payload = p + headerLen;
+        out.payloadLen = totalLen - headerLen;
+        return true;
+    }
+    return decodeTransport(p + headerLen, totalLen - headerLen, out) || keepShortFirstFragment(out);
+}
+
+bool decodeIpv6(const std::uint8_t *p, std::size_t len, DecodedPacket &out)
+{
+    if (len < 40) {
+        return false;
+    }
+    std::size_t totalLen = 40 + static_cast<std::size_t>(readBe16(p + 4));
+    if (totalLen > len) {
+        totalLen = len;
+        out.l3Truncated = true;
+    }
+
+    out.ipVersion = 6;
+    out.srcAddr = p + 8;
+    out.dstAddr = p + 24;
+    out.l3 = p;
+    out.l3Len = totalLen;
+
+    // 跳过扩展头部
+    std::uint8_t next = p[6];
+    std::size_t offset = 40;
+    for (int i = 0; i < 8; ++i) {
+        if (next == 0 || next == 43 || next == 60) { // 逐跳选项、路由、目的选项
+            if (offset + 8 > totalLen) {
+                return false;
+            }
+            const std::uint8_t following = p[offset];
+            offset += (static_cast<std::size_t>(p[offset + 1]) + 1) * 8;
+            next = following;
+        } else if (next == 44) { // 分片头
+            if (offset + 8 > totalLen) {
+                return false;
+            }
+            out.isFragment = true;
+            const std::uint16_t fragOffset = readBe16(p + offset + 2) & 0xfff8;
+            out.fragId = readBe32(p + offset + 4);
+            out.fragOffset = fragOffset;
+            out.moreFragments = (p[offset + 3] & 0x01) != 0;
+            out.fragNextHeader = p[offset];
+            next = p[offset];
+            offset += 8;
+            out.fragData = p + offset;
+            out.fragDataLen = totalLen - offset;
+            if (fragOffset != 0) {
+                out.l4Proto = next;
+                out.payload = p + offset;
+                out.payloadLen = totalLen - offset;
+                return true;
+            }
+        } else {
+            break;
+        }
+    }
+    if (offset > totalLen) {
+        return false;
+    }
+    out.l4Proto = next;
+    return decodeTransport(p + offset, totalLen - offset, out) || keepShortFirstFragment(out);
+}
+
+} // namespace
+
+bool PacketDecoder::decodeIp(const std::uint8_t *l3, std::size_t len, DecodedPacket &out)
+{
+    if (len < 1) {
+        return false;
+    }
+    switch (l3[0] >> 4) {
+    case 4:
+        return decodeIpv4(l3, len, out);
+    case 6:
+        return decodeIpv6(l3, len, out);
+    default:
+        return false;
+    }
+}
+
+bool PacketDecoder::decode(const RawPacket &raw, DecodedPacket &out)
+{
+    out = DecodedPacket();
+    out.tsNs = raw.tsNs;
+    out.wireLen = raw.origLen;
+    out.source = raw.source;
+
+    const std::uint8_t *p = raw.data;
+    std::size_t len = raw.capLen;
+    std::uint16_t etherType = 0;
+
+    switch (raw.linkType) {
+    case LinkEthernet:
+        if (len < 14) {
+            return false;
+        }
+        etherType = readBe16(p + 12);
+        p += 14;
+        len -= 14;
+        while ((etherType == kEtherTypeVlan || etherType == kEtherTypeQinQ) && len >= 4) {
+            etherType = readBe16(p + 2);
+            p += 4;
+            len -= 4;
+        }
+        break;
+    case LinkLinuxSll:
+        if (len < 16) {
+            return false;
+        }
+        etherType = readBe16(p + 14);
+        p += 16;
+        len -= 16;
+        break;
+    case LinkNull:
+        // BSD loopback: 4字节主机序协议族, 直接看IP版本号
+        if (len < 4) {
+            return false;
+        }
+        return decodeIp(p + 4, len - 4, out);
+    case LinkRaw:
+        return decodeIp(p, len, out);
+    default:
+        return false;
+    }
+
+    if (etherType == kEtherTypeIpv4) {
+        return decodeIpv4(p, len, out);
+    }
+    if (etherType == kEtherTypeIpv6) {
+        return decodeIpv6(p, len, out);
+    }
+    return false;
+}
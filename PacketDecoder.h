@@ -0,0 +1,96 @@
+#ifndef PACKETDECODER_H
+#define PACKETDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// pcap链路层类型
+enum LinkType : std::uint32_t {
+    LinkNull = 0,
+    LinkEthernet = 1,
+    LinkRaw = 101,
+    LinkLinuxSll = 113
+};
+
+enum IpProtocol : std::uint8_t {
+    ProtoTcp = 6,
+    ProtoUdp = 17
+};
+
+// 实时抓包时由内核提供的附加信息
+enum RawPacketFlags : std::uint8_t {
+    PacketOutgoing = 0x01,        // 本机发出的包
+    PacketChecksumPartial = 0x02  // 传输层校验和由网卡计算, 捕获时尚未填写
+};
+
+// 从数据源读出的原始数据包, 数据指向源的缓冲区
+struct RawPacket
+{
+    const std::uint8_t *data = nullptr;
+    std::uint32_t capLen = 0;
+    std::uint32_t origLen = 0;
+    std::uint64_t tsNs = 0;
+    std::uint32_t linkType = LinkEthernet;
+    std::uint8_t flags = 0;
+    std::uint8_t source = 0; // 同时读取多个数据源时输入的下标
+};
+
+// 解码后的数据包视图, 所有指针都指向原始数据包, 不做拷贝
+struct DecodedPacket
+{
+    std::uint64_t tsNs = 0;
+    std::uint32_t wireLen = 0;
+    std::uint8_t source = 0; // 同 RawPacket::source
+
+    std::uint8_t ipVersion = 0;     // 0 表示非IP包
+    std::uint8_t l4Proto = 0;
+    const std::uint8_t *srcAddr = nullptr; // IPv4为4字节, IPv6为16字节
+    const std::uint8_t *dstAddr = nullptr;
+    const std::uint8_t *l3 = nullptr;
+    std::size_t l3Len = 0;
+    bool l3Truncated = false; // 捕获长度不足或总长度字段不可信
+    bool isFragment = false;
+
+    // 分片信息, 仅在 isFragment 为真时有效。fragData 指向可分片部分:
+    // IPv4头部之后或IPv6分片头之后的数据
+    std::uint32_t fragId = 0;
+    std::uint32_t fragOffset = 0;     // 字节
+    bool moreFragments = false;
+    std::uint8_t fragNextHeader = 0;  // IPv4协议号或分片头中的下一个头部
+    const std::uint8_t *fragData = nullptr;
+    std::size_t fragDataLen = 0;
+
+    const std::uint8_t *l4 = nullptr;
+    std::size_t l4Len = 0;
+    std::uint16_t srcPort = 0;
+    std::uint16_t dstPort = 0;
+    std::uint8_t tcpFlags = 0;
+    std::uint32_t tcpSeq = 0;
+
+    const std::uint8_t *payload = nullptr;
+    std::size_t payloadLen = 0;
+};
+
+namespace PacketDecoder {
+
+// 解析链路层到传输层头部, 不是IP包或者头部损坏时返回false。
+// 分片的首片装不下传输层头部时仍返回true, 端口为0, l4 为空, 传输层在重组后解码
+bool decode(const RawPacket &raw, DecodedPacket &out);
+
+// 以已经定位好的IP头为起点解码
+bool decodeIp(const std::uint8_t *l3, std::size_t len, DecodedPacket &out);
+
+inline std::uint16_t readBe16(const std::uint8_t *p)
+{
+    return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline std::uint32_t readBe32(const std::uint8_t *p)
+{
+    return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16)
+           | (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+}
+
+} // namespace PacketDecoder
+
+#endif // PACKETDECODER_H
@@ -0,0 +1,104 @@
+#include "PacketSampler.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 队列占用超过 kHighWater 时采样率翻倍; 连续 kCalmRounds 次低于 kLowWater 才减半,
+// 避免在两个采样率之间来回跳
+constexpr double kHighWater = 0.5;
+constexpr double kLowWater = 0.1;
+constexpr int kCalmRounds = 10;
+
+std::uint64_t splitmix(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::uint64_t load64(const std::uint8_t *p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// 地址按16字节处理, IPv4只有前4字节有效
+std::uint64_t addressHash(const std::uint8_t *addr, std::uint8_t ipVersion)
+{
+    if (ipVersion == 6) {
+        return splitmix(load64(addr) ^ splitmix(load64(addr + 8)));
+    }
+    std::uint32_t v4;
+    std::memcpy(&v4, addr, sizeof(v4));
+    return splitmix(v4);
+}
+
+} // namespace
+
+PacketSampler::PacketSampler(std::uint32_t rate, bool adaptive, bool perFlow, std::uint64_t seed)
+    : maxRate(std::min(std::max<std::uint32_t>(rate, 1), kMaxRate))
+    , current(adaptive ? 1 : maxRate)
+    , isAdaptive(adaptive)
+    , flowConsistent(perFlow)
+    , seed(seed)
+    , state(splitmix(seed) | 1)
+{
+    if (isAdaptive) {
+        while (maxRate & (maxRate - 1)) {
+            maxRate &= maxRate - 1; // 取不超过上限的2的幂
+        }
+    }
+}
+
+std::uint32_t PacketSampler::sample(const DecodedPacket &pkt)
+{
+    if (current <= 1) {
+        return 1;
+    }
+    const std::uint64_t h = flowConsistent ? flowHash(pkt) : nextRandom();
+    return (h >> 32) % current == 0 ? current : 0;
+}
+
+bool PacketSampler::adjust(double backlog)
+{
+    if (!isAdaptive || backlog < 0) {
+        return false;
+    }
+    if (backlog > kHighWater) {
+        calmRounds = 0;
+        if (current < maxRate) {
+            current = std::min(current * 2, maxRate);
+            return true;
+        }
+        return false;
+    }
+    if (backlog < kLowWater && current > 1 && ++calmRounds >= kCalmRounds) {
+        calmRounds = 0;
+        current /= 2;
+        return true;
+    }
+    return false;
+}
+
+std::uint64_t PacketSampler::flowHash(const DecodedPacket &pkt) const
+{
+    if (pkt.srcAddr == nullptr || pkt.dstAddr == nullptr) {
+        return splitmix(seed ^ pkt.wireLen);
+    }
+    // 两个方向的端点哈希相加, 与方向无关
+    const std::uint64_t a = splitmix(addressHash(pkt.srcAddr, pkt.ipVersion) ^ pkt.srcPort);
+    const std::uint64_t b = splitmix(addressHash(pkt.dstAddr, pkt.ipVersion) ^ pkt.dstPort);
+    return splitmix(seed ^ (a + b) ^ (static_cast<std::uint64_t>(pkt.l4Proto) << 56));
+}
+
+std::uint64_t PacketSampler::nextRandom()
+{
+    // xorshift64*
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
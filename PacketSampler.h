@@ -0,0 +1,43 @@
+#ifndef PACKETSAMPLER_H
+#define PACKETSAMPLER_H
+
+#include "PacketDecoder.h"
+#include <cstdint>
+
+// 过载时的数据包采样。按流采样对双向五元组做带种子的哈希, 同一条流的包要么全部保留
+// 要么全部丢弃; 按包采样用随机数逐包决定。保留的包代表 rate 个包, 计数乘以 rate 即为
+// 无偏估计 (Horvitz-Thompson)。自适应模式下采样率只取2的幂, 提高采样率时按流保留的
+// 集合是原集合的子集, 不会中途换成另一批流
+class PacketSampler
+{
+public:
+    static constexpr std::uint32_t kMaxRate = 1024;
+
+    // rate 为1表示不采样; 自适应模式下 rate 是上限, 从1开始按接收队列的占用调整
+    PacketSampler(std::uint32_t rate, bool adaptive, bool perFlow, std::uint64_t seed);
+
+    // 返回0表示丢弃, 否则返回该包代表的包数 (即当前采样率)
+    std::uint32_t sample(const DecodedPacket &pkt);
+
+    // 按数据源接收队列的占用比例 (0-1) 调整采样率, 约每100ms调用一次; 负数表示数据源
+    // 无法报告队列状态, 保持不变。返回采样率是否变化
+    bool adjust(double backlog);
+
+    std::uint32_t rate() const { return current; }
+    bool perFlow() const { return flowConsistent; }
+    bool adaptive() const { return isAdaptive; }
+
+private:
+    std::uint64_t flowHash(const DecodedPacket &pkt) const;
+    std::uint64_t nextRandom();
+
+    std::uint32_t maxRate;
+    std::uint32_t current;
+    bool isAdaptive;
+    bool flowConsistent;
+    std::uint64_t seed;
+    std::uint64_t state;
+    int calmRounds = 0;
+};
+
+#endif // PACKETSAMPLER_H
@@ -0,0 +1,56 @@
+#ifndef PACKETSOURCE_H
+#define PACKETSOURCE_H
+
+#include "PacketDecoder.h"
+#include <QString>
+#include <cstdint>
+
+struct PrefetchedPacket;
+
+// 数据包来源的统一接口, 由分析线程逐个拉取
+class PacketSource
+{
+public:
+    virtual ~PacketSource() = default;
+
+    // 取下一个数据包, 数据在下一次调用前有效。
+    // 离线源返回false表示结束, 实时源返回false只表示本次等待超时
+    virtual bool next(RawPacket &packet) = 0;
+
+    virtual bool isLive() const { return false; }
+
+    // 读取进度 0-100, 实时抓包等无法估计时返回 -1
+    virtual int progress() const { return -1; }
+
+    // 还没取走的数据占接收缓冲区的比例 (0-1), 用于判断是否过载; 无法报告时返回 -1
+    virtual double backlog() const { return -1.0; }
+
+    virtual QString description() const = 0;
+
+    // 离线源提前结束的原因 (读取或解压出错), 正常读完时为空
+    virtual QString errorString() const { return QString(); }
+
+    // 上一次 next() 交出的包已经由解码线程处理过时返回结果, 否则返回nullptr由分析线程自己解码
+    virtual const PrefetchedPacket *prefetched() const { return nullptr; }
+
+    // 合并读取多个数据源时的输入个数, RawPacket::source 是输入的下标
+    virtual int inputCount() const { return 1; }
+    virtual QString inputName(int index) const
+    {
+        Q_UNUSED(index)
+        return description();
+    }
+    // 读线程的缓冲区用完时丢弃的包, 以及超出重排窗口后才到达的包
+    virtual std::uint64_t inputDrops(int index) const
+    {
+        Q_UNUSED(index)
+        return 0;
+    }
+    virtual std::uint64_t inputLatePackets(int index) const
+    {
+        Q_UNUSED(index)
+        return 0;
+    }
+};
+
+#endif // PACKETSOURCE_H
@@ -0,0 +1,169 @@
+#include "ParallelPcapSource.h"
+#include "MemoryBudget.h"
+#include "PcapFileSource.h"
+#include <algorithm>
+
+ParallelPcapSource::ParallelPcapSource(std::unique_ptr<PcapFileSource> source, int threads, bool validateChecksums)
+    : file(std::move(source))
+    , validateChecksums(validateChecksums)
+    , name(file->description())
+{
+    threads = std::max(threads, 1);
+    // 每个解码线程两块, 一块在解码、一块已完成等待取用
+    maxInFlight = static_cast<std::size_t>(threads) * 2 + 2;
+    indexer = std::thread(&ParallelPcapSource::indexLoop, this);
+    for (int i = 0; i < threads; ++i) {
+        decoders.emplace_back(&ParallelPcapSource::decodeLoop, this);
+    }
+}
+
+ParallelPcapSource::~ParallelPcapSource()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    spaceFree.notify_all();
+    indexer.join();
+    for (std::thread &decoder : decoders) {
+        decoder.join();
+    }
+
+    MemoryBudget &budget = MemoryBudget::global();
+    for (const std::unique_ptr<Chunk> &chunk : chunks) {
+        budget.release(MemoryBudget::Packets, chunk->bytes);
+        budget.addObjects(MemoryBudget::Packets, -static_cast<std::int64_t>(chunk->raw.size()));
+    }
+    if (consuming) {
+        budget.release(MemoryBudget::Packets, consuming->bytes);
+        budget.addObjects(MemoryBudget::Packets, -static_cast<std::int64_t>(consuming->raw.size()));
+    }
+}
+
+void ParallelPcapSource::indexLoop()
+{
+    MemoryBudget &budget = MemoryBudget::global();
+    RawPacket raw;
+    bool more = true;
+    while (more) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->raw.reserve(kChunkPackets);
+        while (chunk->raw.size() < kChunkPackets && (more = file->next(raw))) {
+            chunk->raw.push_back(raw);
+        }
+        chunk->progress = more ? file->progress() : 100;
+        if (chunk->raw.empty()) {
+            break;
+        }
+        // 只记账索引和解码结果, 包数据留在文件映射中
+        chunk->bytes = chunk->raw.capacity() * (sizeof(RawPacket) + sizeof(PrefetchedPacket));
+        budget.charge(MemoryBudget::Packets, chunk->bytes);
+        budget.addObjects(MemoryBudget::Packets, static_cast<std::int64_t>(chunk->raw.size()));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        spaceFree.wait(lock, [this]() { return stopping || chunks.size() < maxInFlight; });
+        if (stopping) {
+            budget.release(MemoryBudget::Packets, chunk->bytes);
+            budget.addObjects(MemoryBudget::Packets, -static_cast<std::int64_t>(chunk->raw.size()));
+            return;
+        }
+        todo.push_back(chunk.get());
+        chunks.push_back(std::move(chunk));
+        lock.unlock();
+        workAvailable.notify_one();
+    }
+
+    // 文件只由索引线程读取, 出错原因在这里取出交给分析线程
+    const QString failure = file->errorString();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = failure;
+        indexDone = true;
+    }
+    chunkReady.notify_one();
+}
+
+void ParallelPcapSource::decodeLoop()
+{
+    for (;;) {
+        Chunk *chunk = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this]() { return stopping || !todo.empty(); });
+            if (stopping) {
+                return;
+            }
+            chunk = todo.front();
+            todo.pop_front();
+        }
+        decodeChunk(*chunk);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            chunk->ready = true;
+        }
+        chunkReady.notify_one();
+    }
+}
+
+void ParallelPcapSource::decodeChunk(Chunk &chunk) const
+{
+    chunk.decoded.resize(chunk.raw.size());
+    for (std::size_t i = 0; i < chunk.raw.size(); ++i) {
+        const RawPacket &raw = chunk.raw[i];
+        PrefetchedPacket &out = chunk.decoded[i];
+        out.decoded = PacketDecoder::decode(raw, out.pkt);
+        if (!out.decoded) {
+            continue;
+        }
+        // 与分析线程中的顺序相同; 分片重组换成完整数据报后, 分析线程会重新计算这两项
+        if (validateChecksums) {
+            out.checksum = Checksum::validate(out.pkt, raw.flags);
+        }
+        out.isHttp = out.pkt.l4Proto == ProtoTcp && out.pkt.payloadLen > 0
+                     && HttpScanner::scan(out.pkt.payload, out.pkt.payloadLen, out.http);
+    }
+}
+
+bool ParallelPcapSource::next(RawPacket &packet)
+{
+    current = nullptr;
+    while (!consuming || position >= consuming->raw.size()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (consuming) {
+            MemoryBudget::global().release(MemoryBudget::Packets, consuming->bytes);
+            MemoryBudget::global().addObjects(MemoryBudget::Packets,
+                                              -static_cast<std::int64_t>(consuming->raw.size()));
+            consuming.reset();
+            spaceFree.notify_one();
+        }
+        chunkReady.wait(lock, [this]() { return (!chunks.empty() && chunks.front()->ready) || (chunks.empty() && indexDone); });
+        if (chunks.empty()) {
+            return false;
+        }
+        consuming = std::move(chunks.front());
+        chunks.pop_front();
+        position = 0;
+        consumedProgress = consuming->progress;
+    }
+    packet = consuming->raw[position];
+    current = &consuming->decoded[position];
+    ++position;
+    return true;
+}
+
+int ParallelPcapSource::progress() const
+{
+    return consumedProgress;
+}
+
+QString ParallelPcapSource::description() const
+{
+    return name;
+}
+
+QString ParallelPcapSource::errorString() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
@@ -0,0 +1,91 @@
+#ifndef PARALLELPCAPSOURCE_H
+#define PARALLELPCAPSOURCE_H
+
+#include "Checksum.h"
+#include "HttpScanner.h"
+#include "PacketSource.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class PcapFileSource;
+
+// 解码线程预先算好的结果, 指针都指向文件映射, 在源的生命周期内有效
+struct PrefetchedPacket
+{
+    bool decoded = false;      // PacketDecoder::decode 的返回值
+    DecodedPacket pkt;
+    Checksum::Result checksum; // 只在开启校验和验证时计算
+    bool isHttp = false;
+    HttpMetadata http;
+};
+
+// 用多个线程解码同一个大抓包文件。索引线程顺序走一遍记录头 (只读头部, 不碰数据),
+// 每 kChunkPackets 个记录切成一块; 线程池并行解码各块, 并做校验和验证和HTTP头部扫描;
+// 分析线程按文件顺序逐块取用, 所以流表、分片重组、扫描检测等有状态的部分仍然看到
+// 原始顺序, 跨块的流不需要额外拼接。
+// 同时在途的块数有上限, 分析线程跟不上时索引线程等待
+class ParallelPcapSource final : public PacketSource
+{
+public:
+    static constexpr std::size_t kChunkPackets = 8192;
+
+    // threads 为解码线程数, 不含索引线程
+    ParallelPcapSource(std::unique_ptr<PcapFileSource> file, int threads, bool validateChecksums);
+    ~ParallelPcapSource() override;
+
+    ParallelPcapSource(const ParallelPcapSource &) = delete;
+    ParallelPcapSource &operator=(const ParallelPcapSource &) = delete;
+
+    bool next(RawPacket &packet) override;
+    int progress() const override;
+    QString description() const override;
+    QString errorString() const override;
+    const PrefetchedPacket *prefetched() const override { return current; }
+
+    int threadCount() const { return static_cast<int>(decoders.size()); }
+
+private:
+    struct Chunk
+    {
+        std::vector<RawPacket> raw;
+        std::vector<PrefetchedPacket> decoded;
+        int progress = 0;        // 块末尾对应的读取进度
+        bool ready = false;      // 已经解码完成
+        std::uint64_t bytes = 0; // 计入内存预算的字节数
+    };
+
+    void indexLoop();
+    void decodeLoop();
+    void decodeChunk(Chunk &chunk) const;
+
+    std::unique_ptr<PcapFileSource> file; // 只由索引线程读取
+    const bool validateChecksums;
+    QString name;
+
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable; // 解码线程等待
+    std::condition_variable chunkReady;    // 分析线程等待
+    std::condition_variable spaceFree;     // 索引线程等待
+    std::deque<std::unique_ptr<Chunk>> chunks; // 按文件顺序, 包括还在解码的块
+    std::deque<Chunk *> todo;                  // 等待解码的块
+    std::size_t maxInFlight = 0;
+    bool indexDone = false;
+    QString error; // 索引线程读取文件出错 (截断、解压失败) 时的原因
+    bool stopping = false;
+
+    std::thread indexer;
+    std::vector<std::thread> decoders;
+
+    // 以下只由分析线程访问
+    std::unique_ptr<Chunk> consuming;
+    std::size_t position = 0;
+    const PrefetchedPacket *current = nullptr;
+    int consumedProgress = 0;
+};
+
+#endif // PARALLELPCAPSOURCE_H
@@ -0,0 +1,350 @@
+#include "PcapFileSource.h"
+#include "ReadAheadFile.h"
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint32_t kPcapMagicUs = 0xa1b2c3d4;
+constexpr std::uint32_t kPcapMagicNs = 0xa1b23c4d;
+constexpr std::uint32_t kPcapngShb = 0x0a0d0d0a;
+constexpr std::uint32_t kPcapngByteOrder = 0x1a2b3c4d;
+constexpr std::uint32_t kPcapngIdb = 0x00000001;
+constexpr std::uint32_t kPcapngSpb = 0x00000003;
+constexpr std::uint32_t kPcapngEpb = 0x00000006;
+
+std::uint32_t swap32(std::uint32_t v)
+{
+    return ((v & 0xff) << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) | (v >> 24);
+}
+
+std::uint32_t loadNative32(const std::uint8_t *p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+PcapFileSource::~PcapFileSource()
+{
+    close();
+}
+
+bool PcapFileSource::open(const QString &path, QString *error)
+{
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QString("无法打开文件: %1").arg(file.errorString());
+        }
+        return false;
+    }
+    size = static_cast<std::size_t>(file.size());
+
+    // 压缩的文件交给解压线程, 之后的解析都从解压出的数据流中读取
+    const QByteArray head = file.peek(4);
+    compression = DecompressionStream::detect(reinterpret_cast<const std::uint8_t *>(head.constData()),
+                                              static_cast<std::size_t>(head.size()));
+    if (compression != DecompressionStream::Codec::None) {
+        file.close();
+        auto inflater = std::make_unique<DecompressionStream>();
+        if (!inflater->open(path, compression, error)) {
+            close();
+            return false;
+        }
+        stream = std::move(inflater);
+    } else {
+        mode = requestedMode;
+        if (mode == FileReadMode::Mmap) {
+            base = size > 0 ? file.map(0, file.size()) : nullptr;
+            if (base == nullptr && size > 0) {
+                // 映射失败 (地址空间不足、特殊文件系统) 时改为逐块读取
+                mode = FileReadMode::Buffered;
+            }
+        }
+        if (mode != FileReadMode::Mmap) {
+            file.close();
+            auto reader = std::make_unique<ReadAheadFile>();
+            if (!reader->open(path, mode == FileReadMode::IoUring, error)) {
+                close();
+                return false;
+            }
+            if (!reader->isAsync()) {
+                mode = FileReadMode::Buffered;
+            }
+            stream = std::move(reader);
+        }
+    }
+    const std::uint8_t *header = fetch(24);
+    if (header == nullptr) {
+        if (error) {
+            if (stream && !stream->errorString().isEmpty()) {
+                *error = compression != DecompressionStream::Codec::None
+                             ? QString("无法解压文件: %1").arg(stream->errorString())
+                             : stream->errorString();
+            } else {
+                *error = QString("文件为空或不完整");
+            }
+        }
+        close();
+        return false;
+    }
+
+    const std::uint32_t magic = loadNative32(header);
+    if (magic == kPcapngShb) {
+        return openPcapng(error);
+    }
+    return openPcap(error);
+}
+
+void PcapFileSource::close()
+{
+    stream.reset();
+    compression = DecompressionStream::Codec::None;
+    mode = FileReadMode::Mmap;
+    if (base != nullptr) {
+        file.unmap(const_cast<std::uint8_t *>(base));
+        base = nullptr;
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    size = 0;
+    offset = 0;
+    swapped = false;
+    pcapng = false;
+    interfaces.clear();
+}
+
+bool PcapFileSource::openPcap(QString *error)
+{
+    const std::uint8_t *header = fetch(24);
+    const std::uint32_t magic = loadNative32(header);
+    if (magic == kPcapMagicUs || magic == kPcapMagicNs) {
+        swapped = false;
+    } else if (swap32(magic) == kPcapMagicUs || swap32(magic) == kPcapMagicNs) {
+        swapped = true;
+    } else {
+        if (error) {
+            *error = "不是有效的pcap/pcapng文件";
+        }
+        close();
+        return false;
+    }
+    const std::uint32_t normalized = swapped ? swap32(magic) : magic;
+    fractionToNs = normalized == kPcapMagicNs ? 1 : 1000;
+    linkType = read32(header + 20) & 0x0fffffff; // 高位是FCS信息
+    skip(24);
+    return true;
+}
+
+bool PcapFileSource::openPcapng(QString *error)
+{
+    pcapng = true;
+    const std::uint8_t *header = fetch(28);
+    if (header == nullptr) {
+        if (error) {
+            *error = "pcapng文件头不完整";
+        }
+        close();
+        return false;
+    }
+    const std::uint32_t byteOrder = loadNative32(header + 8);
+    if (byteOrder == kPcapngByteOrder) {
+        swapped = false;
+    } else if (swap32(byteOrder) == kPcapngByteOrder) {
+        swapped = true;
+    } else {
+        if (error) {
+            *error = "pcapng字节序标记无效";
+        }
+        close();
+        return false;
+    }
+    return true;
+}
+
+std::uint16_t PcapFileSource::read16(const std::uint8_t *p) const
+{
+    std::uint16_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return swapped ? static_cast<std::uint16_t>((v >> 8) | (v << 8)) : v;
+}
+
+std::uint32_t PcapFileSource::read32(const std::uint8_t *p) const
+{
+    const std::uint32_t v = loadNative32(p);
+    return swapped ? swap32(v) : v;
+}
+
+const std::uint8_t *PcapFileSource::fetch(std::size_t len)
+{
+    if (stream) {
+        return stream->peek(len);
+    }
+    if (base == nullptr || len > size - offset) {
+        return nullptr;
+    }
+    return base + offset;
+}
+
+void PcapFileSource::skip(std::size_t len)
+{
+    if (stream) {
+        stream->consume(len);
+    }
+    offset += len;
+}
+
+bool PcapFileSource::next(RawPacket &packet)
+{
+    if (base == nullptr && !stream) {
+        return false;
+    }
+    return pcapng ? nextPcapng(packet) : nextPcap(packet);
+}
+
+bool PcapFileSource::nextPcap(RawPacket &packet)
+{
+    const std::uint8_t *rec = fetch(16);
+    if (rec == nullptr) {
+        return false;
+    }
+    const std::uint32_t tsSec = read32(rec);
+    const std::uint32_t tsFrac = read32(rec + 4);
+    const std::uint32_t capLen = read32(rec + 8);
+    const std::uint32_t origLen = read32(rec + 12);
+    rec = fetch(16 + static_cast<std::size_t>(capLen));
+    if (rec == nullptr) {
+        return false; // 文件末尾的记录被截断
+    }
+
+    packet.data = rec + 16;
+    packet.capLen = capLen;
+    packet.origLen = origLen;
+    packet.tsNs = static_cast<std::uint64_t>(tsSec) * 1000000000ULL + tsFrac * fractionToNs;
+    packet.linkType = linkType;
+    skip(16 + static_cast<std::size_t>(capLen));
+    return true;
+}
+
+bool PcapFileSource::parseInterfaceBlock(const std::uint8_t *body, std::size_t len)
+{
+    if (len < 8) {
+        return false;
+    }
+    Interface iface;
+    iface.linkType = read16(body);
+
+    // 查找 if_tsresol 选项, 默认微秒
+    std::size_t pos = 8;
+    while (pos + 4 <= len) {
+        const std::uint16_t code = read16(body + pos);
+        const std::uint16_t optLen = read16(body + pos + 2);
+        if (code == 0) {
+            break;
+        }
+        if (code == 9 && optLen >= 1 && pos + 4 + optLen <= len) {
+            const std::uint8_t resol = body[pos + 4];
+            const unsigned exponent = resol & 0x7f;
+            iface.tsMultiplier = 1;
+            iface.tsDivisor = 1;
+            if (resol & 0x80) {
+                // 2^-n 秒
+                iface.tsMultiplier = 1000000000ULL;
+                iface.tsDivisor = exponent < 64 ? (1ULL << exponent) : 1;
+            } else if (exponent <= 9) {
+                for (unsigned i = exponent; i < 9; ++i) {
+                    iface.tsMultiplier *= 10;
+                }
+            } else {
+                for (unsigned i = 9; i < exponent && i < 19; ++i) {
+                    iface.tsDivisor *= 10;
+                }
+            }
+        }
+        pos += 4 + ((optLen + 3u) & ~3u);
+    }
+    interfaces.push_back(iface);
+    return true;
+}
+
+bool PcapFileSource::nextPcapng(RawPacket &packet)
+{
+    for (;;) {
+        const std::uint8_t *block = fetch(12);
+        if (block == nullptr) {
+            return false;
+        }
+        const std::uint32_t type = read32(block); // 节头块的类型值是回文, 与字节序无关
+        if (type == kPcapngShb) {
+            // 每个节可以有不同的字节序
+            const std::uint32_t byteOrder = loadNative32(block + 8);
+            swapped = byteOrder != kPcapngByteOrder;
+            interfaces.clear();
+        }
+        const std::uint32_t blockLen = read32(block + 4);
+        block = blockLen >= 12 ? fetch(blockLen) : nullptr;
+        if (block == nullptr) {
+            return false;
+        }
+        const std::uint8_t *body = block + 8;
+        const std::size_t bodyLen = blockLen - 12;
+        skip(blockLen);
+
+        if (type == kPcapngIdb) {
+            parseInterfaceBlock(body, bodyLen);
+        } else if (type == kPcapngEpb && bodyLen >= 20) {
+            const std::uint32_t ifaceId = read32(body);
+            if (ifaceId >= interfaces.size()) {
+                continue;
+            }
+            const Interface &iface = interfaces[ifaceId];
+            const std::uint64_t ts = (static_cast<std::uint64_t>(read32(body + 4)) << 32) | read32(body + 8);
+            const std::uint32_t capLen = read32(body + 12);
+            if (capLen > bodyLen - 20) {
+                continue;
+            }
+            packet.data = body + 20;
+            packet.capLen = capLen;
+            packet.origLen = read32(body + 16);
+            packet.tsNs = ts / iface.tsDivisor * iface.tsMultiplier
+                          + ts % iface.tsDivisor * iface.tsMultiplier / iface.tsDivisor;
+            packet.linkType = iface.linkType;
+            return true;
+        } else if (type == kPcapngSpb && bodyLen >= 4 && !interfaces.empty()) {
+            const std::uint32_t origLen = read32(body);
+            packet.data = body + 4;
+            packet.capLen = std::min<std::uint32_t>(origLen, static_cast<std::uint32_t>(bodyLen - 4));
+            packet.origLen = origLen;
+            packet.tsNs = 0; // 简单包块不带时间戳
+            packet.linkType = interfaces.front().linkType;
+            return true;
+        }
+    }
+}
+
+int PcapFileSource::progress() const
+{
+    if (stream) {
+        return stream->progress();
+    }
+    if (size == 0) {
+        return 0;
+    }
+    return static_cast<int>(static_cast<double>(offset) * 100.0 / static_cast<double>(size));
+}
+
+QString PcapFileSource::description() const
+{
+    return QFileInfo(file.fileName()).fileName();
+}
+
+QString PcapFileSource::errorString() const
+{
+    return stream ? stream->errorString() : QString();
+}
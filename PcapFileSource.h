@@ -0,0 +1,76 @@
+#ifndef PCAPFILESOURCE_H
+#define PCAPFILESOURCE_H
+
+#include "AnalysisTypes.h"
+#include "DecompressionStream.h"
+#include "PacketSource.h"
+#include <QFile>
+#include <memory>
+#include <vector>
+
+// 读取离线抓包文件, 支持 pcap (微秒/纳秒) 和 pcapng。默认整个文件映射到内存;
+// 也可以选择io_uring预读或普通的逐块读取。gzip/zstd/lz4压缩的文件总是边解压边读取。
+// 不映射时数据只在下一次 next() 之前有效
+class PcapFileSource final : public PacketSource
+{
+public:
+    PcapFileSource() = default;
+    ~PcapFileSource() override;
+
+    // 在 open() 之前设置, 压缩文件忽略此设置
+    void setReadMode(FileReadMode mode) { requestedMode = mode; }
+    bool open(const QString &path, QString *error = nullptr);
+    void close();
+
+    bool next(RawPacket &packet) override;
+    int progress() const override;
+    std::size_t fileSize() const { return size; }
+    // 未压缩的文件整个映射在内存中, 交出的数据在源的生命周期内都有效
+    bool isMapped() const { return base != nullptr; }
+    DecompressionStream::Codec codec() const { return compression; }
+    // 实际使用的读取方式: 映射失败或内核不支持io_uring时退回普通读取
+    FileReadMode readMode() const { return mode; }
+    QString description() const override;
+    QString errorString() const override;
+
+private:
+    struct Interface
+    {
+        std::uint32_t linkType = LinkEthernet;
+        std::uint64_t tsMultiplier = 1000; // 时间戳单位换算到纳秒
+        std::uint64_t tsDivisor = 1;
+    };
+
+    bool openPcap(QString *error);
+    bool openPcapng(QString *error);
+    bool nextPcap(RawPacket &packet);
+    bool nextPcapng(RawPacket &packet);
+    bool parseInterfaceBlock(const std::uint8_t *body, std::size_t len);
+
+    // 当前位置起 len 个连续字节, 不足时返回nullptr; skip() 越过已经读完的部分
+    const std::uint8_t *fetch(std::size_t len);
+    void skip(std::size_t len);
+
+    std::uint16_t read16(const std::uint8_t *p) const;
+    std::uint32_t read32(const std::uint8_t *p) const;
+
+    QFile file;
+    const std::uint8_t *base = nullptr;
+    std::size_t size = 0;
+    std::size_t offset = 0;
+    DecompressionStream::Codec compression = DecompressionStream::Codec::None;
+    std::unique_ptr<ByteStream> stream;
+    FileReadMode requestedMode = FileReadMode::Mmap;
+    FileReadMode mode = FileReadMode::Mmap;
+    bool swapped = false;
+    bool pcapng = false;
+
+    // pcap
+    std::uint32_t linkType = LinkEthernet;
+    std::uint64_t fractionToNs = 1000;
+
+    // pcapng
+    std::vector<Interface> interfaces;
+};
+
+#endif // PCAPFILESOURCE_H
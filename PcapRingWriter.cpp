@@ -0,0 +1,630 @@
+#include "PcapRingWriter.h"
+#include "IoUring.h"
+#include "MemoryBudget.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// O_DIRECT 要求的缓冲区地址、长度和文件偏移的对齐单位
+constexpr std::size_t kAlignment = 4096;
+constexpr std::size_t kPcapHeaderBytes = 24;
+constexpr std::size_t kRecordHeaderBytes = 16;
+constexpr std::uint32_t kPcapMagicNs = 0xa1b23c4d;
+
+struct WriteRequest
+{
+    std::uint8_t *data;
+    std::size_t len;
+    std::uint64_t offset;
+};
+
+std::size_t alignUp(std::size_t len)
+{
+    return (len + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+#ifdef __linux__
+
+// pwrite 返回0时重试的次数, 仍然写不进去就放弃
+constexpr int kMaxWriteStalls = 3;
+
+// 只有ENOSPC提示磁盘空间不足, 其他错误用系统的描述
+QString writeFailure(int code)
+{
+    return QString("写入录制文件失败: %1").arg(code == ENOSPC ? QString("磁盘空间不足") : QString(std::strerror(code)));
+}
+
+// 写线程当前打开的录制文件。尽量用O_DIRECT绕过页缓存, 文件系统不支持时退回普通写入;
+// 末尾不足对齐单位的部分补零写出, 关闭前再截断到实际长度
+class OutputFile
+{
+public:
+    OutputFile()
+    {
+#ifdef TA_IO_URING
+        ring.init(static_cast<unsigned>(PcapRingWriter::kBuffers));
+#endif
+    }
+    ~OutputFile()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    bool open(const QString &path, QString &error)
+    {
+        const QByteArray name = QFile::encodeName(path);
+        const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        fd = -1;
+        if (directSupported) {
+            fd = ::open(name.constData(), flags | O_DIRECT, 0644);
+            if (fd < 0 && errno == EINVAL) {
+                directSupported = false; // tmpfs等文件系统不支持O_DIRECT
+            }
+        }
+        direct = fd >= 0;
+        if (fd < 0) {
+            fd = ::open(name.constData(), flags, 0644);
+        }
+        if (fd < 0) {
+            error = QString("无法创建录制文件 %1: %2").arg(path, std::strerror(errno));
+            return false;
+        }
+        writtenEnd = 0;
+        return true;
+    }
+
+    // 同一文件的一批写入, 偏移和长度在O_DIRECT时已对齐
+    bool write(std::vector<WriteRequest> &requests, QString &error)
+    {
+        for (WriteRequest &request : requests) {
+            if (direct) {
+                const std::size_t padded = alignUp(request.len);
+                std::memset(request.data + request.len, 0, padded - request.len);
+                request.len = padded;
+            }
+            writtenEnd = std::max<std::uint64_t>(writtenEnd, request.offset + request.len);
+        }
+#ifdef TA_IO_URING
+        if (ring.isReady() && requests.size() <= ring.entries()) {
+            if (!writeBatch(requests)) {
+                ring.shutdown(); // 系统调用失败, 这一批和以后都改用普通写入
+            } else {
+                for (std::size_t i = 0; i < requests.size(); ++i) {
+                    const int res = results[i];
+                    if (res == static_cast<int>(requests[i].len)) {
+                        continue;
+                    }
+                    if (res >= 0) {
+                        // 只写了一部分, 剩下的用普通写入补上, 真正的错误由 pwrite 报告
+                        const auto done = static_cast<std::size_t>(res);
+                        const WriteRequest rest{requests[i].data + done, requests[i].len - done,
+                                                requests[i].offset + done};
+                        if (!writeAt(rest, error)) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    // 旧内核不支持 IORING_OP_WRITE 时返回EINVAL, 改用普通写入确认一次
+                    if (res == -EINVAL && writeAt(requests[i], error)) {
+                        ring.shutdown();
+                        continue;
+                    }
+                    error = writeFailure(-res);
+                    return false;
+                }
+                return true;
+            }
+        }
+#endif
+        for (const WriteRequest &request : requests) {
+            if (!writeAt(request, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool finish(std::uint64_t size, QString &error)
+    {
+        bool ok = true;
+        if (writtenEnd != size && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            error = QString("截断录制文件失败: %1").arg(std::strerror(errno));
+            ok = false;
+        }
+        ::close(fd);
+        fd = -1;
+        return ok;
+    }
+
+    QString modeName() const
+    {
+        QString name;
+#ifdef TA_IO_URING
+        if (ring.isReady()) {
+            name = "io_uring";
+        }
+#endif
+        if (direct) {
+            name += name.isEmpty() ? "O_DIRECT" : " + O_DIRECT";
+        }
+        return name.isEmpty() ? QString("普通写入") : name;
+    }
+
+private:
+#ifdef TA_IO_URING
+    // 整批一次提交并等待全部完成, 各请求的结果放在 results
+    bool writeBatch(const std::vector<WriteRequest> &requests)
+    {
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            io_uring_sqe *sqe = ring.prepare();
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(requests[i].data);
+            sqe->len = static_cast<std::uint32_t>(requests[i].len);
+            sqe->off = requests[i].offset;
+            sqe->user_data = i;
+        }
+        results.assign(requests.size(), 0);
+        std::size_t completed = 0;
+        while (completed < requests.size()) {
+            if (!ring.submit(static_cast<unsigned>(requests.size() - completed))) {
+                return false;
+            }
+            std::uint64_t index = 0;
+            int res = 0;
+            while (ring.reap(index, res)) {
+                results[index] = res;
+                ++completed;
+            }
+        }
+        return true;
+    }
+#endif
+
+    bool writeAt(const WriteRequest &request, QString &error)
+    {
+        std::size_t done = 0;
+        int stalls = 0;
+        while (done < request.len) {
+            const ssize_t n = ::pwrite(fd, request.data + done, request.len - done,
+                                       static_cast<off_t>(request.offset + done));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                error = writeFailure(errno);
+                return false;
+            }
+            // 短写时接着写剩下的部分; 磁盘满时下一次调用会返回ENOSPC
+            if (n == 0) {
+                if (++stalls > kMaxWriteStalls) {
+                    error = "写入录制文件失败: 写入没有进展";
+                    return false;
+                }
+                continue;
+            }
+            stalls = 0;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    int fd = -1;
+    bool direct = false;
+    bool directSupported = true;
+    std::uint64_t writtenEnd = 0;
+#ifdef TA_IO_URING
+    IoUring ring;
+    std::vector<int> results;
+#endif
+};
+
+#else
+
+// 其他平台按顺序逐块写入
+class OutputFile
+{
+public:
+    bool open(const QString &path, QString &error)
+    {
+        file.setFileName(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = QString("无法创建录制文件 %1: %2").arg(path, file.errorString());
+            return false;
+        }
+        return true;
+    }
+
+    bool write(std::vector<WriteRequest> &requests, QString &error)
+    {
+        for (const WriteRequest &request : requests) {
+            if (!file.seek(static_cast<qint64>(request.offset))
+                || file.write(reinterpret_cast<const char *>(request.data), static_cast<qint64>(request.len))
+                       != static_cast<qint64>(request.len)) {
+                error = QString("写入录制文件失败: %1").arg(file.errorString());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool finish(std::uint64_t size, QString &error)
+    {
+        Q_UNUSED(size)
+        Q_UNUSED(error)
+        file.close();
+        return true;
+    }
+
+    QString modeName() const { return "普通写入"; }
+
+private:
+    QFile file;
+};
+
+#endif
+
+} // namespace
+
+PcapRingWriter::~PcapRingWriter()
+{
+    close();
+}
+
+bool PcapRingWriter::open(const RecordOptions &recordOptions, QString *errorOut)
+{
+    close();
+    if (!QDir().mkpath(recordOptions.directory) || !QFileInfo(recordOptions.directory).isWritable()) {
+        if (errorOut != nullptr) {
+            *errorOut = QString("录制目录不可写: %1").arg(recordOptions.directory);
+        }
+        return false;
+    }
+    options = recordOptions;
+    sessionPrefix = "capture_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+
+    buffers.clear();
+    freeBuffers.clear();
+    for (int i = 0; i < kBuffers; ++i) {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->storage.resize(kBufferBytes + kAlignment);
+        const auto address = reinterpret_cast<std::uintptr_t>(buffer->storage.data());
+        buffer->data = buffer->storage.data() + (kAlignment - address % kAlignment) % kAlignment;
+        freeBuffers.push_back(buffer.get());
+        buffers.push_back(std::move(buffer));
+    }
+    MemoryBudget::global().charge(MemoryBudget::Packets, kBuffers * (kBufferBytes + kAlignment));
+    MemoryBudget::global().addSlabs(MemoryBudget::Packets, kBuffers);
+
+    current = nullptr;
+    lastSubmit = std::chrono::steady_clock::now();
+    fileSeq = 0;
+    fileBytes = 0;
+    packets = 0;
+    dropped = 0;
+    failed = false;
+    writtenBytes = 0;
+    backlogBytes = 0;
+    maxLatencyUs = 0;
+    lostPackets = 0;
+    fileCount = 0;
+    stopping = false;
+    error.clear();
+    backend.clear();
+    worker = std::thread(&PcapRingWriter::writeLoop, this);
+    return true;
+}
+
+void PcapRingWriter::close()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+    if (current != nullptr && current->len > 0) {
+        submit(current);
+    }
+    current = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    filledReady.notify_one();
+    worker.join();
+
+    MemoryBudget::global().release(MemoryBudget::Packets, buffers.size() * (kBufferBytes + kAlignment));
+    MemoryBudget::global().addSlabs(MemoryBudget::Packets, -static_cast<std::int64_t>(buffers.size()));
+    buffers.clear();
+    freeBuffers.clear();
+    filledBuffers.clear();
+}
+
+QString PcapRingWriter::filePath(std::uint64_t file) const
+{
+    return QString("%1/%2_%3.pcap").arg(options.directory, sessionPrefix).arg(file, 5, 10, QChar('0'));
+}
+
+void PcapRingWriter::submit(Buffer *buffer)
+{
+    lastSubmit = std::chrono::steady_clock::now();
+    // 入队后缓冲区就归写线程所有, 先记下积压
+    backlogBytes.fetch_add(buffer->len, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        filledBuffers.push_back(buffer);
+    }
+    filledReady.notify_one();
+}
+
+void PcapRingWriter::append(const void *data, std::size_t len, Buffer *&spare)
+{
+    const auto *bytes = static_cast<const std::uint8_t *>(data);
+    while (len > 0) {
+        if (current->len == kBufferBytes) {
+            // 写满的缓冲区交给写线程, 记录的剩余部分接着写进下一块
+            Buffer *next = spare;
+            spare = nullptr;
+            next->file = current->file;
+            next->offset = current->offset + kBufferBytes;
+            submit(current);
+            current = next;
+        }
+        const std::size_t n = std::min(len, kBufferBytes - current->len);
+        std::memcpy(current->data + current->len, bytes, n);
+        current->len += n;
+        bytes += n;
+        len -= n;
+    }
+}
+
+void PcapRingWriter::flushPending()
+{
+    if (current == nullptr || current->len == current->rewritten || failed.load(std::memory_order_relaxed)
+        || std::chrono::steady_clock::now() - lastSubmit < kPendingInterval) {
+        return;
+    }
+    Buffer *next = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeBuffers.empty()) {
+            return; // 写线程还忙, 下次再交
+        }
+        next = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+    // O_DIRECT 的文件偏移必须对齐: 新缓冲区从最后一个对齐位置开始, 先复制回未对齐的尾部,
+    // 这部分随下一块重写一遍
+    const std::size_t aligned = current->len / kAlignment * kAlignment;
+    const std::size_t tail = current->len - aligned;
+    std::memcpy(next->data, current->data + aligned, tail);
+    next->len = tail;
+    next->rewritten = tail;
+    next->file = current->file;
+    next->offset = current->offset + aligned;
+    submit(current);
+    current = next;
+}
+
+void PcapRingWriter::write(const RawPacket &packet)
+{
+    if (!isOpen() || failed.load(std::memory_order_relaxed)) {
+        ++dropped;
+        return;
+    }
+    const std::size_t record = kRecordHeaderBytes + packet.capLen;
+    const bool rotate = fileSeq == 0 || packet.linkType != fileLinkType
+                        || (fileBytes > kPcapHeaderBytes && fileBytes + record > options.maxFileBytes)
+                        || (options.maxFileNs > 0 && packet.tsNs >= fileStartNs + options.maxFileNs);
+    // 新文件从新的缓冲区开始; 记录一个缓冲区放不下时最多跨到下一块
+    const std::size_t needed = record + (rotate ? kPcapHeaderBytes : 0);
+    const std::size_t room = rotate ? 0 : kBufferBytes - current->len;
+    if (needed > kBufferBytes) {
+        ++dropped;
+        return;
+    }
+    Buffer *spare = nullptr;
+    if (needed > room) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeBuffers.empty()) {
+            ++dropped; // 写线程跟不上, 丢弃而不是等待
+            return;
+        }
+        spare = freeBuffers.back();
+        freeBuffers.pop_back();
+    }
+
+    if (rotate) {
+        if (current != nullptr) {
+            submit(current);
+        }
+        current = spare;
+        spare = nullptr;
+        ++fileSeq;
+        current->file = fileSeq;
+        current->offset = 0;
+        fileBytes = kPcapHeaderBytes;
+        fileStartNs = packet.tsNs;
+        fileLinkType = packet.linkType;
+        // 文件头按本机字节序写出, 读取方按魔数判断字节序
+        std::uint8_t header[kPcapHeaderBytes];
+        const std::uint32_t magic = kPcapMagicNs;
+        const std::uint16_t version[2] = {2, 4};
+        const std::uint32_t zone[2] = {0, 0};
+        const std::uint32_t snapLen = 262144;
+        std::memcpy(header, &magic, 4);
+        std::memcpy(header + 4, version, 4);
+        std::memcpy(header + 8, zone, 8);
+        std::memcpy(header + 16, &snapLen, 4);
+        std::memcpy(header + 20, &fileLinkType, 4);
+        append(header, sizeof(header), spare);
+    }
+
+    const std::uint32_t recordHeader[4] = {static_cast<std::uint32_t>(packet.tsNs / 1000000000),
+                                           static_cast<std::uint32_t>(packet.tsNs % 1000000000), packet.capLen,
+                                           packet.origLen};
+    append(recordHeader, sizeof(recordHeader), spare);
+    append(packet.data, packet.capLen, spare);
+    fileBytes += record;
+    ++current->packets;
+    ++packets;
+    if (spare != nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.push_back(spare);
+    }
+}
+
+void PcapRingWriter::writeLoop()
+{
+    OutputFile output;
+    std::uint64_t openFile = 0;
+    std::uint64_t openBytes = 0;
+    std::deque<std::pair<QString, std::uint64_t>> finishedFiles; // 按时间顺序, 用于磁盘预算
+    std::uint64_t finishedBytes = 0;
+    bool ok = true;
+    QString failure;
+    std::vector<Buffer *> batch;
+    std::vector<WriteRequest> requests;
+
+    auto finishFile = [&]() {
+        if (openFile == 0) {
+            return;
+        }
+        if (!output.finish(openBytes, failure)) {
+            ok = false;
+        }
+        finishedFiles.emplace_back(filePath(openFile), openBytes);
+        finishedBytes += openBytes;
+        openFile = 0;
+        openBytes = 0;
+    };
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            filledReady.wait(lock, [this]() { return stopping || !filledBuffers.empty(); });
+            if (filledBuffers.empty()) {
+                break;
+            }
+            batch.assign(filledBuffers.begin(), filledBuffers.end());
+            filledBuffers.clear();
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        std::size_t written = 0;
+        while (ok && written < batch.size()) {
+            if (batch[written]->file != openFile) {
+                finishFile();
+                if (!ok || !output.open(filePath(batch[written]->file), failure)) {
+                    ok = false;
+                    break;
+                }
+                openFile = batch[written]->file;
+                std::lock_guard<std::mutex> lock(mutex);
+                backend = output.modeName();
+            }
+            // 同一文件的连续缓冲区一次提交; 重写上一块尾部的缓冲区要等上一块写完, 单独提交
+            requests.clear();
+            std::size_t end = written;
+            for (; end < batch.size() && batch[end]->file == openFile && (end == written || batch[end]->rewritten == 0);
+                 ++end) {
+                requests.push_back({batch[end]->data, batch[end]->len, batch[end]->offset});
+            }
+            if (!output.write(requests, failure)) {
+                ok = false;
+                break;
+            }
+            for (; written < end; ++written) {
+                openBytes = std::max(openBytes, batch[written]->offset + batch[written]->len);
+                writtenBytes.fetch_add(batch[written]->len - batch[written]->rewritten, std::memory_order_relaxed);
+            }
+        }
+        const auto latency = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+        std::uint64_t previous = maxLatencyUs.load(std::memory_order_relaxed);
+        while (latency > previous && !maxLatencyUs.compare_exchange_weak(previous, latency)) {
+        }
+
+        // 超出磁盘预算时从最早的文件删起, 正在写的文件保留
+        while (finishedBytes + openBytes > options.maxTotalBytes && !finishedFiles.empty()) {
+            QFile::remove(finishedFiles.front().first);
+            finishedBytes -= finishedFiles.front().second;
+            finishedFiles.pop_front();
+        }
+        fileCount.store(static_cast<std::uint32_t>(finishedFiles.size() + (openFile != 0 ? 1 : 0)),
+                        std::memory_order_relaxed);
+
+        std::uint64_t batchBytes = 0;
+        std::uint64_t lost = 0;
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            batchBytes += batch[i]->len;
+            if (i >= written) {
+                lost += batch[i]->packets;
+            }
+        }
+        lostPackets.fetch_add(lost, std::memory_order_relaxed);
+        backlogBytes.fetch_sub(batchBytes, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Buffer *buffer : batch) {
+                buffer->len = 0;
+                buffer->packets = 0;
+                buffer->rewritten = 0;
+                freeBuffers.push_back(buffer);
+            }
+            if (!ok && error.isEmpty()) {
+                error = failure;
+            }
+        }
+        if (!ok) {
+            failed.store(true, std::memory_order_relaxed);
+        }
+    }
+    if (ok) {
+        finishFile();
+        if (!ok) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = failure;
+        }
+    }
+}
+
+PcapRingWriter::Stats PcapRingWriter::takeStats()
+{
+    Stats stats;
+    const std::uint64_t lost = lostPackets.load(std::memory_order_relaxed);
+    stats.packets = packets - std::min(packets, lost);
+    stats.dropped = dropped + lost;
+    stats.bytes = writtenBytes.load(std::memory_order_relaxed);
+    stats.backlogBytes = backlogBytes.load(std::memory_order_relaxed);
+    stats.maxLatencyUs = maxLatencyUs.exchange(0, std::memory_order_relaxed);
+    stats.files = fileCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+QString PcapRingWriter::errorString() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+QString PcapRingWriter::backendName() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return backend;
+}
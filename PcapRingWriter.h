@@ -0,0 +1,114 @@
+#ifndef PCAPRINGWRITER_H
+#define PCAPRINGWRITER_H
+
+#include "AnalysisTypes.h"
+#include "PacketDecoder.h"
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 边分析边把原始数据包录制成一组轮转的pcap文件 (纳秒时间戳)。单个文件按大小和数据包时间
+// 切换, 链路类型变化时也换新文件; 所有文件的总大小超出磁盘预算时删除最早的文件。
+// 分析线程只把记录复制进大块对齐缓冲区, 记录可以跨缓冲区, 所以除每个文件的最后一块外
+// 缓冲区都是满的, 文件偏移天然对齐。写满的缓冲区由写线程成批提交: Linux上文件以O_DIRECT
+// 打开并通过io_uring一次提交整批写入, 不支持时退回普通的逐块写入。
+// 没有空闲缓冲区时丢弃并计数, 磁盘变慢不会让分析线程等待。
+// 实时抓包流量小时缓冲区迟迟写不满, 定期把未写满的缓冲区也交出去, 下一块从对齐位置接着写
+class PcapRingWriter
+{
+public:
+    struct Stats
+    {
+        std::uint64_t packets = 0;
+        std::uint64_t bytes = 0;        // 已写入磁盘的字节数
+        std::uint64_t dropped = 0;      // 缓冲区用完或写入出错而没有录制的包
+        std::uint64_t backlogBytes = 0; // 已交给写线程还没写完的字节数
+        std::uint64_t maxLatencyUs = 0; // 上次取统计以来单批写入的最长耗时
+        std::uint32_t files = 0;        // 磁盘上保留的文件数
+    };
+
+    static constexpr std::size_t kBufferBytes = 1024 * 1024;
+    static constexpr int kBuffers = 16;
+    // 未写满的缓冲区最多停留这么久就交给写线程
+    static constexpr auto kPendingInterval = std::chrono::seconds(1);
+
+    PcapRingWriter() = default;
+    ~PcapRingWriter();
+
+    PcapRingWriter(const PcapRingWriter &) = delete;
+    PcapRingWriter &operator=(const PcapRingWriter &) = delete;
+
+    bool open(const RecordOptions &options, QString *error = nullptr);
+    // 交出未写满的缓冲区并等待写线程写完
+    void close();
+    bool isOpen() const { return worker.joinable(); }
+
+    // 只由分析线程调用, 不会等待磁盘
+    void write(const RawPacket &packet);
+    // 只由分析线程定期调用 (实时抓包): 上次交出缓冲区超过 kPendingInterval 后交出未写满的缓冲区
+    void flushPending();
+
+    // 只由分析线程调用; maxLatencyUs 读取后清零
+    Stats takeStats();
+    // 写入出错后录制停止, 返回原因; 正常时为空
+    QString errorString() const;
+    // 实际使用的写入方式, 在写线程打开第一个文件后确定
+    QString backendName() const;
+
+private:
+    struct Buffer
+    {
+        std::vector<std::uint8_t> storage;
+        std::uint8_t *data = nullptr; // storage 中按 kAlignment 对齐的起点
+        std::size_t len = 0;
+        std::uint64_t file = 0;   // 文件序号, 从1开始
+        std::uint64_t offset = 0; // 在文件中的偏移
+        std::uint64_t packets = 0;
+        std::size_t rewritten = 0; // 开头重写的上一块未对齐的尾部, 不重复计入写入字节数
+    };
+
+    void writeLoop();
+    void submit(Buffer *buffer);
+    void append(const void *data, std::size_t len, Buffer *&spare);
+    QString filePath(std::uint64_t file) const;
+
+    RecordOptions options;
+    QString sessionPrefix;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::thread worker;
+
+    mutable std::mutex mutex;
+    std::condition_variable filledReady;
+    std::deque<Buffer *> filledBuffers;
+    std::vector<Buffer *> freeBuffers;
+    bool stopping = false;
+    QString error;
+    QString backend;
+
+    // 写线程更新, 分析线程读取
+    std::atomic<bool> failed{false};
+    std::atomic<std::uint64_t> writtenBytes{0};
+    std::atomic<std::uint64_t> backlogBytes{0};
+    std::atomic<std::uint64_t> maxLatencyUs{0};
+    std::atomic<std::uint64_t> lostPackets{0}; // 出错后没能写出的缓冲区中的包
+    std::atomic<std::uint32_t> fileCount{0};
+
+    // 以下只由分析线程访问
+    Buffer *current = nullptr;
+    std::chrono::steady_clock::time_point lastSubmit;
+    std::uint64_t fileSeq = 0;
+    std::uint64_t fileBytes = 0;
+    std::uint64_t fileStartNs = 0;
+    std::uint32_t fileLinkType = 0;
+    std::uint64_t packets = 0;
+    std::uint64_t dropped = 0;
+};
+
+#endif // PCAPRINGWRITER_H
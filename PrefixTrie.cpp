@@ -0,0 +1,123 @@
+#include "PrefixTrie.h"
+#include <algorithm>
+#include <iterator>
+
+namespace PrefixTrie {
+
+Builder::Builder()
+    : directValue(1u << kDirectBits, 0)
+    , directChild(1u << kDirectBits, -1)
+{
+}
+
+void Builder::insert(std::uint64_t hi, std::uint64_t lo, int length, std::uint32_t value)
+{
+    const std::uint32_t top = static_cast<std::uint32_t>(hi >> (64 - kDirectBits));
+    if (length <= kDirectBits) {
+        const std::uint32_t span = 1u << (kDirectBits - length);
+        const std::uint32_t start = top & ~(span - 1);
+        for (std::uint32_t i = start; i < start + span; ++i) {
+            if (directChild[i] >= 0) {
+                fill(directChild[i], value);
+            } else {
+                directValue[i] = value;
+            }
+        }
+        return;
+    }
+
+    if (directChild[top] < 0) {
+        directChild[top] = newNode(directValue[top]);
+    }
+    int node = directChild[top];
+    for (int pos = kDirectBits;; pos += kStride) {
+        const unsigned idx = chunkAt(hi, lo, pos);
+        const int remaining = length - pos;
+        if (remaining <= kStride) {
+            // 前缀在本层展开成连续的 2^(6-remaining) 个位置
+            const unsigned span = 1u << (kStride - remaining);
+            const unsigned start = idx & ~(span - 1);
+            for (unsigned i = start; i < start + span; ++i) {
+                if (nodes[node].child[i] >= 0) {
+                    fill(nodes[node].child[i], value);
+                } else {
+                    nodes[node].value[i] = value;
+                }
+            }
+            return;
+        }
+        if (nodes[node].child[idx] < 0) {
+            const int child = newNode(nodes[node].value[idx]);
+            nodes[node].child[idx] = child;
+        }
+        node = nodes[node].child[idx];
+    }
+}
+
+void Builder::serialize(Table &out) const
+{
+    std::vector<int> order;
+    out.direct.assign(directValue.size(), 0);
+    for (std::size_t i = 0; i < directValue.size(); ++i) {
+        if (directChild[i] >= 0) {
+            out.direct[i] = kNodeFlag | static_cast<std::uint32_t>(order.size());
+            order.push_back(directChild[i]);
+        } else {
+            out.direct[i] = directValue[i];
+        }
+    }
+
+    out.nodes.clear();
+    out.leaves.clear();
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        const BuildNode &build = nodes[order[k]];
+        Node node{};
+        node.childBase = static_cast<std::uint32_t>(order.size());
+        node.leafBase = static_cast<std::uint32_t>(out.leaves.size());
+        bool first = true;
+        std::uint32_t previous = 0;
+        for (unsigned i = 0; i < 64; ++i) {
+            const std::uint64_t bit = 1ULL << i;
+            if (build.child[i] >= 0) {
+                node.vector |= bit;
+                order.push_back(build.child[i]);
+            } else if (first || build.value[i] != previous) {
+                node.leafvec |= bit;
+                out.leaves.push_back(build.value[i]);
+                previous = build.value[i];
+                first = false;
+            }
+        }
+        out.nodes.push_back(node);
+    }
+    if (out.leaves.empty()) {
+        out.leaves.push_back(0); // 保证段非空, 便于映射后校验
+    }
+}
+
+int Builder::newNode(std::uint32_t value)
+{
+    BuildNode node;
+    std::fill(std::begin(node.value), std::end(node.value), value);
+    std::fill(std::begin(node.child), std::end(node.child), -1);
+    nodes.push_back(node);
+    return static_cast<int>(nodes.size() - 1);
+}
+
+void Builder::fill(int root, std::uint32_t value)
+{
+    std::vector<int> stack{root};
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+        for (int i = 0; i < 64; ++i) {
+            if (nodes[node].child[i] >= 0) {
+                stack.push_back(nodes[node].child[i]);
+            } else {
+                nodes[node].value[i] = value;
+            }
+        }
+    }
+}
+
+} // namespace PrefixTrie
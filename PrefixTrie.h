@@ -0,0 +1,146 @@
+#ifndef PREFIXTRIE_H
+#define PREFIXTRIE_H
+
+#include "IpAddress.h"
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 最长前缀匹配用的poptrie: 键的高16位直接索引, 之后每层6位。
+// 地址库镜像把这些数组写进文件后直接映射使用, 网段分组在内存中构建同样的结构。
+// 查询结果是插入时给出的值, 0 表示没有匹配的前缀
+namespace PrefixTrie {
+
+constexpr std::uint32_t kNodeFlag = 0x80000000u; // 直接索引表项指向节点而不是叶子
+constexpr int kDirectBits = 16;
+constexpr int kStride = 6;
+
+// vector 标记哪些位置有子节点, leafvec 标记叶子取值变化的位置,
+// 子节点和叶子分别连续存放, 用popcount算偏移。补齐到32字节, 一条缓存行放两个
+struct Node
+{
+    std::uint64_t vector;
+    std::uint64_t leafvec;
+    std::uint32_t leafBase;
+    std::uint32_t childBase;
+    std::uint64_t reserved;
+};
+static_assert(sizeof(Node) == 32, "PrefixTrie::Node must stay 32 bytes");
+
+inline int popcount64(std::uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(v));
+#else
+    int n = 0;
+    for (; v != 0; v &= v - 1) {
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// 键从高位开始, 取第 pos 位起的 kStride 位。从16位开始每次6位, 不会跨越 hi/lo 边界,
+// 超出128位的部分补零
+inline unsigned chunkAt(std::uint64_t hi, std::uint64_t lo, int pos)
+{
+    if (pos < 64) {
+        return static_cast<unsigned>(hi >> (64 - kStride - pos)) & 63u;
+    }
+    if (pos + kStride <= 128) {
+        return static_cast<unsigned>(lo >> (128 - kStride - pos)) & 63u;
+    }
+    return static_cast<unsigned>(lo << (pos + kStride - 128)) & 63u;
+}
+
+// IPv4和IPv6分开建树: IPv4地址放在键的最高32位, 前缀长度按32位计, 避免共同的96位映射前缀
+struct Key
+{
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+    int length = 0;
+    bool v4 = false;
+};
+
+// prefixLen 为128位长度 (IPv4前缀已加96)
+inline Key keyOf(const IpAddress &address, int prefixLen = 128)
+{
+    Key key;
+    if (address.isV4() && prefixLen >= 96) {
+        key.hi = static_cast<std::uint64_t>(address.v4()) << 32;
+        key.length = prefixLen - 96;
+        key.v4 = true;
+    } else {
+        key.hi = address.hi;
+        key.lo = address.lo;
+        key.length = prefixLen;
+    }
+    return key;
+}
+
+inline std::uint32_t find(const std::uint32_t *direct, const Node *nodes, const std::uint32_t *leaves,
+                          std::uint64_t hi, std::uint64_t lo)
+{
+    const std::uint32_t entry = direct[hi >> (64 - kDirectBits)];
+    if ((entry & kNodeFlag) == 0) {
+        return entry;
+    }
+    const Node *node = nodes + (entry & ~kNodeFlag);
+    for (int pos = kDirectBits; pos < 128; pos += kStride) {
+        const std::uint64_t bit = 1ULL << chunkAt(hi, lo, pos);
+        if (node->vector & bit) {
+            node = nodes + node->childBase + popcount64(node->vector & (bit - 1));
+            continue;
+        }
+        return leaves[node->leafBase + popcount64(node->leafvec & (bit | (bit - 1))) - 1];
+    }
+    return 0;
+}
+
+// 压缩后的一棵树, 三个数组的布局和地址库镜像中的段相同
+struct Table
+{
+    std::vector<std::uint32_t> direct;
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> leaves;
+
+    std::uint32_t find(std::uint64_t hi, std::uint64_t lo) const
+    {
+        return PrefixTrie::find(direct.data(), nodes.data(), leaves.data(), hi, lo);
+    }
+};
+
+// 构建期使用的未压缩多分支树, 每个节点64个位置
+class Builder
+{
+public:
+    Builder();
+
+    // 前缀必须按长度从短到长插入, 这样较长的前缀总是覆盖较短的
+    void insert(std::uint64_t hi, std::uint64_t lo, int length, std::uint32_t value);
+
+    // 按广度优先输出poptrie: 同一节点的子节点连续存放, 相邻相同的叶子合并
+    void serialize(Table &out) const;
+
+private:
+    struct BuildNode
+    {
+        std::uint32_t value[64];
+        int child[64];
+    };
+
+    int newNode(std::uint32_t value);
+    void fill(int root, std::uint32_t value);
+
+    std::vector<std::uint32_t> directValue;
+    std::vector<int> directChild;
+    std::vector<BuildNode> nodes;
+};
+
+} // namespace PrefixTrie
+
+#endif // PREFIXTRIE_H
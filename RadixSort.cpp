@@ -0,0 +1,127 @@
+#include "RadixSort.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <thread>
+
+namespace RadixSort {
+
+int defaultThreads()
+{
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::min(std::max(cores, 1), 16);
+}
+
+void parallelFor(std::size_t count, int parts,
+                 const std::function<void(int part, std::size_t begin, std::size_t end)> &fn)
+{
+    parts = std::max(parts, 1);
+    auto bound = [count, parts](int part) {
+        return count / static_cast<std::size_t>(parts) * static_cast<std::size_t>(part)
+               + std::min(count % static_cast<std::size_t>(parts), static_cast<std::size_t>(part));
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(parts - 1));
+    for (int part = 1; part < parts; ++part) {
+        workers.emplace_back(fn, part, bound(part), bound(part + 1));
+    }
+    fn(0, bound(0), bound(1));
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+namespace {
+
+using Counts = std::array<std::size_t, 256>;
+
+// 按 (keys >> shift) 的最低字节把 (keys, rows) 稳定地分配到 (outKeys, outRows)
+void distribute(const std::vector<std::uint64_t> &keys, const std::vector<std::uint32_t> &rows,
+                std::vector<std::uint64_t> &outKeys, std::vector<std::uint32_t> &outRows, int shift, int threads,
+                std::vector<Counts> &counts)
+{
+    parallelFor(keys.size(), threads, [&](int part, std::size_t begin, std::size_t end) {
+        Counts &c = counts[part];
+        c.fill(0);
+        for (std::size_t i = begin; i < end; ++i) {
+            ++c[(keys[i] >> shift) & 0xff];
+        }
+    });
+
+    // 同一字节值内按段的先后排列, 各段内部又保持原来的顺序
+    std::size_t offset = 0;
+    for (int digit = 0; digit < 256; ++digit) {
+        for (Counts &c : counts) {
+            const std::size_t n = c[digit];
+            c[digit] = offset;
+            offset += n;
+        }
+    }
+
+    parallelFor(keys.size(), threads, [&](int part, std::size_t begin, std::size_t end) {
+        Counts &next = counts[part];
+        for (std::size_t i = begin; i < end; ++i) {
+            const std::size_t pos = next[(keys[i] >> shift) & 0xff]++;
+            outKeys[pos] = keys[i];
+            outRows[pos] = rows[i];
+        }
+    });
+}
+
+} // namespace
+
+bool sort(const std::vector<Key> &keys, std::uint32_t rowCount, int threads, std::vector<std::uint32_t> &order,
+          const std::function<bool()> &cancelled)
+{
+    order.resize(rowCount);
+    std::iota(order.begin(), order.end(), 0u);
+    if (keys.empty() || rowCount < 2) {
+        return true;
+    }
+    if (rowCount < kParallelMinRows) {
+        threads = 1;
+    }
+    threads = std::max(threads, 1);
+
+    std::vector<std::uint64_t> current(rowCount);
+    std::vector<std::uint64_t> nextKeys(rowCount);
+    std::vector<std::uint32_t> nextRows(rowCount);
+    std::vector<Counts> counts(static_cast<std::size_t>(threads));
+    std::vector<std::uint64_t> differing(static_cast<std::size_t>(threads));
+
+    for (auto key = keys.rbegin(); key != keys.rend(); ++key) {
+        if (cancelled && cancelled()) {
+            return false;
+        }
+        // 降序取反, 相同的值仍然保持原来的顺序
+        const std::uint64_t flip = key->descending ? ~std::uint64_t(0) : 0;
+        const std::uint64_t first = key->values[order[0]] ^ flip;
+        parallelFor(rowCount, threads, [&](int part, std::size_t begin, std::size_t end) {
+            std::uint64_t diff = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                current[i] = key->values[order[i]] ^ flip;
+                diff |= current[i] ^ first;
+            }
+            differing[part] = diff;
+        });
+        std::uint64_t diff = 0;
+        for (std::uint64_t d : differing) {
+            diff |= d;
+        }
+
+        for (int shift = 0; shift < 64; shift += 8) {
+            if (((diff >> shift) & 0xff) == 0) {
+                continue;
+            }
+            if (cancelled && cancelled()) {
+                return false;
+            }
+            distribute(current, order, nextKeys, nextRows, shift, threads, counts);
+            current.swap(nextKeys);
+            order.swap(nextRows);
+        }
+    }
+    return true;
+}
+
+} // namespace RadixSort
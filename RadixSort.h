@@ -0,0 +1,38 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 多线程LSD基数排序, 只求出行号的排列, 不移动行数据。
+// 多个键从最次要的一个开始逐键排序, 每个键按字节从低到高各做一趟稳定的分配; 所有行在某个字节上
+// 都相同时跳过这一趟, 端口、IPv4映射地址的高位等都不需要排。每一趟把行分成若干段由各线程
+// 分别计数, 再按 (字节值, 段) 的顺序算出各段的写入位置, 因此结果与单线程相同, 仍然稳定
+namespace RadixSort {
+
+struct Key
+{
+    std::vector<std::uint64_t> values; // 下标为行号
+    bool descending = false;
+};
+
+// 行数少于这个值时单线程排序, 线程的启动开销比排序本身还大
+constexpr std::size_t kParallelMinRows = 1 << 16;
+
+int defaultThreads();
+
+// 把 [0, count) 均分成 parts 段, 并行执行 fn(段号, 起点, 终点), 调用线程执行第0段并等待全部完成。
+// count 和 parts 相同时分段也相同
+void parallelFor(std::size_t count, int parts,
+                 const std::function<void(int part, std::size_t begin, std::size_t end)> &fn);
+
+// keys 按优先级从高到低, 每个键有 rowCount 个值。结果 order[i] 为排在第 i 位的行号,
+// 所有键都相同的行保持行号顺序。cancelled 返回真时放弃排序并返回 false
+bool sort(const std::vector<Key> &keys, std::uint32_t rowCount, int threads, std::vector<std::uint32_t> &order,
+          const std::function<bool()> &cancelled = {});
+
+} // namespace RadixSort
+
+#endif // RADIXSORT_H
@@ -0,0 +1,256 @@
+#include "ReadAheadFile.h"
+#include "MemoryBudget.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 单条记录的上限, 超过时按文件损坏处理
+constexpr std::size_t kMaxPeek = 64 * 1024 * 1024;
+// 解析器手里一块, 其余 kDepth 块同时在读
+constexpr int kChunks = ReadAheadFile::kDepth + 1;
+
+} // namespace
+
+ReadAheadFile::~ReadAheadFile()
+{
+    close();
+}
+
+bool ReadAheadFile::open(const QString &path, bool asyncReads, QString *errorOut)
+{
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorOut != nullptr) {
+            *errorOut = QString("无法打开文件: %1").arg(file.errorString());
+        }
+        return false;
+    }
+    fileSize = static_cast<std::uint64_t>(file.size());
+
+    // 缓冲区一次分配好, 计入内存预算
+    for (int i = 0; i < kChunks; ++i) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->storage.resize(kHeadroom + kChunkBytes);
+        chunk->index = i;
+        idle.push_back(chunk.get());
+        chunks.push_back(std::move(chunk));
+    }
+    MemoryBudget::global().charge(MemoryBudget::Packets, kChunks * (kHeadroom + kChunkBytes));
+    MemoryBudget::global().addSlabs(MemoryBudget::Packets, kChunks);
+
+#ifdef TA_IO_URING
+    if (asyncReads && ring.init(kChunks)) {
+        async = true;
+        iovecs.resize(chunks.size());
+        for (const auto &chunk : chunks) {
+            iovecs[chunk->index].iov_base = chunk->data();
+            iovecs[chunk->index].iov_len = kChunkBytes;
+        }
+        // 注册失败 (锁定内存上限太低) 时用普通的 READV, 仍然是异步的
+        registered = ring.registerBuffers(iovecs.data(), static_cast<unsigned>(iovecs.size()));
+    }
+#else
+    Q_UNUSED(asyncReads);
+#endif
+    refill();
+    return error.isEmpty();
+}
+
+void ReadAheadFile::close()
+{
+#ifdef TA_IO_URING
+    // 等在途的读取结束再释放缓冲区
+    while (ring.inFlight() > 0 && ring.submit(1)) {
+        std::uint64_t userData = 0;
+        int result = 0;
+        while (ring.reap(userData, result)) {
+        }
+    }
+    ring.shutdown();
+    registered = false;
+    iovecs.clear();
+#endif
+    if (!chunks.empty()) {
+        MemoryBudget::global().release(MemoryBudget::Packets, chunks.size() * (kHeadroom + kChunkBytes));
+        MemoryBudget::global().addSlabs(MemoryBudget::Packets, -static_cast<std::int64_t>(chunks.size()));
+    }
+    if (file.isOpen()) {
+        file.close();
+    }
+    chunks.clear();
+    reading.clear();
+    idle.clear();
+    oversized.clear();
+    current = nullptr;
+    pos = end = nullptr;
+    fileSize = nextOffset = deliveredBytes = 0;
+    async = false;
+    error.clear();
+}
+
+void ReadAheadFile::refill()
+{
+    bool queued = false;
+    while (!idle.empty() && nextOffset < fileSize && error.isEmpty()) {
+        Chunk *chunk = idle.back();
+        chunk->offset = nextOffset;
+        chunk->len = static_cast<std::size_t>(std::min<std::uint64_t>(kChunkBytes, fileSize - nextOffset));
+        chunk->done = false;
+        chunk->result = 0;
+#ifdef TA_IO_URING
+        if (async) {
+            io_uring_sqe *sqe = ring.prepare();
+            if (sqe == nullptr) {
+                break;
+            }
+            sqe->fd = file.handle();
+            sqe->off = chunk->offset;
+            sqe->user_data = static_cast<std::uint64_t>(chunk->index);
+            if (registered) {
+                sqe->opcode = IORING_OP_READ_FIXED;
+                sqe->addr = reinterpret_cast<std::uint64_t>(chunk->data());
+                sqe->len = static_cast<std::uint32_t>(chunk->len);
+                sqe->buf_index = static_cast<std::uint16_t>(chunk->index);
+            } else {
+                iovecs[chunk->index].iov_len = chunk->len;
+                sqe->opcode = IORING_OP_READV;
+                sqe->addr = reinterpret_cast<std::uint64_t>(&iovecs[chunk->index]);
+                sqe->len = 1;
+            }
+            queued = true;
+        }
+#endif
+        // 同步模式下只排好顺序, 轮到这一块时才读
+        idle.pop_back();
+        reading.push_back(chunk);
+        nextOffset += chunk->len;
+    }
+#ifdef TA_IO_URING
+    if (queued && !ring.submit()) {
+        // 提交失败时已经排好的块改为同步读取
+        async = false;
+    }
+#else
+    Q_UNUSED(queued);
+#endif
+}
+
+bool ReadAheadFile::readRemainder(Chunk &chunk, std::size_t done)
+{
+    // 同步读取, 或补齐异步读取中途返回的部分
+    while (done < chunk.len) {
+        if (!file.seek(static_cast<qint64>(chunk.offset + done))) {
+            error = QString("读取文件失败: %1").arg(file.errorString());
+            return false;
+        }
+        const qint64 n = file.read(reinterpret_cast<char *>(chunk.data()) + done, static_cast<qint64>(chunk.len - done));
+        if (n < 0) {
+            error = QString("读取文件失败: %1").arg(file.errorString());
+            return false;
+        }
+        if (n == 0) {
+            // 文件在读取过程中被截短
+            chunk.len = done;
+            fileSize = chunk.offset + done;
+            break;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+ReadAheadFile::Chunk *ReadAheadFile::takeNext()
+{
+    if (reading.empty() || !error.isEmpty()) {
+        return nullptr;
+    }
+    Chunk *chunk = reading.front();
+    reading.pop_front();
+    std::size_t done = 0;
+#ifdef TA_IO_URING
+    if (async || ring.inFlight() > 0) {
+        // 完成顺序不一定是提交顺序, 先完成的块记下结果, 直到队首这一块完成
+        while (!chunk->done) {
+            std::uint64_t userData = 0;
+            int result = 0;
+            if (ring.reap(userData, result)) {
+                Chunk *finished = chunks[static_cast<std::size_t>(userData)].get();
+                finished->done = true;
+                finished->result = result;
+            } else if (!ring.submit(1)) {
+                break;
+            }
+        }
+        if (chunk->done) {
+            if (chunk->result < 0) {
+                error = QString("读取文件失败: %1").arg(QString::fromLocal8Bit(std::strerror(-chunk->result)));
+                return nullptr;
+            }
+            done = static_cast<std::size_t>(chunk->result);
+        }
+    }
+#endif
+    if (!readRemainder(*chunk, done)) {
+        return nullptr;
+    }
+    deliveredBytes += chunk->len;
+    return chunk;
+}
+
+const std::uint8_t *ReadAheadFile::peek(std::size_t len)
+{
+    if (static_cast<std::size_t>(end - pos) >= len) {
+        return pos;
+    }
+    if (len > kMaxPeek || chunks.empty()) {
+        return nullptr;
+    }
+    while (static_cast<std::size_t>(end - pos) < len) {
+        Chunk *next = takeNext();
+        if (next == nullptr) {
+            return nullptr;
+        }
+        const std::size_t remaining = static_cast<std::size_t>(end - pos);
+        if (remaining <= kHeadroom) {
+            // 把上一块剩下的尾部放到新块前面的预留空间里
+            std::uint8_t *start = next->data() - remaining;
+            if (remaining > 0) {
+                std::memmove(start, pos, remaining);
+            }
+            oversized.clear();
+            if (current != nullptr) {
+                idle.push_back(current);
+            }
+            current = next;
+            pos = start;
+            end = next->data() + next->len;
+        } else {
+            // 预留空间放不下, 拼到单独的缓冲区里
+            std::vector<std::uint8_t> joined;
+            joined.reserve(remaining + next->len);
+            joined.insert(joined.end(), pos, end);
+            joined.insert(joined.end(), next->data(), next->data() + next->len);
+            if (current != nullptr) {
+                idle.push_back(current);
+            }
+            idle.push_back(next);
+            current = nullptr;
+            oversized.swap(joined);
+            pos = oversized.data();
+            end = pos + oversized.size();
+        }
+        // 空出的块立即开始读取后面的数据
+        refill();
+    }
+    return pos;
+}
+
+int ReadAheadFile::progress() const
+{
+    if (fileSize == 0) {
+        return 100;
+    }
+    return static_cast<int>(static_cast<double>(deliveredBytes) * 100.0 / static_cast<double>(fileSize));
+}
@@ -0,0 +1,79 @@
+#ifndef READAHEADFILE_H
+#define READAHEADFILE_H
+
+#include "ByteStream.h"
+#include "IoUring.h"
+#include <QFile>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// 不用内存映射、按大块顺序读取抓包文件。异步模式下通过io_uring始终保持 kDepth 个读取在途,
+// 缓冲区事先注册给内核 (IORING_OP_READ_FIXED), 分析线程处理一块时后面几块已经在读;
+// 网络文件系统和冷缓存上不会像内存映射那样在缺页时逐页停顿。
+// 读完的块按文件顺序交出, 跨块的记录和 DecompressionStream 一样拼到块前面的预留空间。
+// 同步模式 (或内核不支持io_uring时) 在需要下一块时才读, 作为对照
+class ReadAheadFile final : public ByteStream
+{
+public:
+    static constexpr std::size_t kChunkBytes = 4 * 1024 * 1024;
+    static constexpr int kDepth = 4;
+
+    ReadAheadFile() = default;
+    ~ReadAheadFile() override;
+
+    ReadAheadFile(const ReadAheadFile &) = delete;
+    ReadAheadFile &operator=(const ReadAheadFile &) = delete;
+
+    // asyncReads 为false或io_uring不可用时同步读取
+    bool open(const QString &path, bool asyncReads, QString *error = nullptr);
+    void close();
+    bool isAsync() const { return async; }
+
+    const std::uint8_t *peek(std::size_t len) override;
+    void consume(std::size_t len) override { pos += len; }
+    int progress() const override;
+    QString errorString() const override { return error; }
+
+private:
+    struct Chunk
+    {
+        std::vector<std::uint8_t> storage; // 前 kHeadroom 字节留给上一块的尾部
+        std::size_t len = 0;
+        std::uint64_t offset = 0;
+        int index = 0;
+        bool done = false;
+        int result = 0;
+        std::uint8_t *data() { return storage.data() + kHeadroom; }
+    };
+
+    static constexpr std::size_t kHeadroom = 256 * 1024;
+
+    // 为空闲的块发起后续读取
+    void refill();
+    // 按文件顺序取下一块, 必要时等待读取完成; 文件结束或出错时返回nullptr
+    Chunk *takeNext();
+    bool readRemainder(Chunk &chunk, std::size_t done);
+
+    QFile file;
+    std::uint64_t fileSize = 0;
+    std::uint64_t nextOffset = 0;     // 下一次读取的文件偏移
+    std::uint64_t deliveredBytes = 0; // 已交给解析器的字节数
+    bool async = false;
+#ifdef TA_IO_URING
+    IoUring ring;
+    bool registered = false;
+    std::vector<iovec> iovecs;
+#endif
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::deque<Chunk *> reading; // 已发起读取的块, 按文件顺序
+    std::vector<Chunk *> idle;
+    QString error;
+
+    Chunk *current = nullptr;
+    std::vector<std::uint8_t> oversized; // 超过预留空间的记录在这里拼接
+    const std::uint8_t *pos = nullptr;
+    const std::uint8_t *end = nullptr;
+};
+
+#endif // READAHEADFILE_H
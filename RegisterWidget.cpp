@@ -1,4 +1,5 @@
 #include "RegisterWidget.h"
+#include "AppStyle.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFormLayout>
@@ -9,7 +10,7 @@
 RegisterWidget::RegisterWidget(QWidget *parent)
     : QWidget(parent)
 {
-    setStyleSheet("QWidget { background-color: #f0f0f0; }");
+    setStyleSheet(AppStyle::pageStyleSheet());
     
     auto *mainLayout = new QVBoxLayout(this);
     mainLayout->setAlignment(Qt::AlignCenter);
@@ -17,32 +18,32 @@ RegisterWidget::RegisterWidget(QWidget *parent)
     // 标题
     auto *titleLabel = new QLabel("用户注册");
     titleLabel->setAlignment(Qt::AlignCenter);
-    titleLabel->setStyleSheet("font-size: 24px; font-weight: bold; color: #2c3e50; margin: 20px;");
+    titleLabel->setObjectName("pageTitle");
     
     // 注册框
     auto *registerBox = new QGroupBox("注册新用户");
     registerBox->setFixedSize(400, 300);
-    registerBox->setStyleSheet("QGroupBox { font-size: 14px; font-weight: bold; padding: 10px; }");
+    registerBox->setObjectName("formBox");
     
     auto *formLayout = new QFormLayout(registerBox);
     
     usernameEdit = new QLineEdit();
     usernameEdit->setPlaceholderText("请输入用户名");
-    usernameEdit->setStyleSheet("padding: 8px; border: 1px solid #ccc; border-radius: 4px;");
+    usernameEdit->setObjectName("formEdit");
     
     passwordEdit = new QLineEdit();
     passwordEdit->setEchoMode(QLineEdit::Password);
     passwordEdit->setPlaceholderText("请输入密码");
-    passwordEdit->setStyleSheet("padding: 8px; border: 1px solid #ccc; border-radius: 4px;");
+    passwordEdit->setObjectName("formEdit");
     
     confirmPasswordEdit = new QLineEdit();
     confirmPasswordEdit->setEchoMode(QLineEdit::Password);
     confirmPasswordEdit->setPlaceholderText("请确认密码");
-    confirmPasswordEdit->setStyleSheet("padding: 8px; border: 1px solid #ccc; border-radius: 4px;");
+    confirmPasswordEdit->setObjectName("formEdit");
     
     emailEdit = new QLineEdit();
     emailEdit->setPlaceholderText("请输入邮箱");
-    emailEdit->setStyleSheet("padding: 8px; border: 1px solid #ccc; border-radius: 4px;");
+    emailEdit->setObjectName("formEdit");
     
     formLayout->addRow("用户名:", usernameEdit);
     formLayout->addRow("密码:", passwordEdit);
@@ -53,10 +54,10 @@ RegisterWidget::RegisterWidget(QWidget *parent)
     auto *buttonLayout = new QHBoxLayout();
     
     registerBtn = new QPushButton("注册");
-    registerBtn->setStyleSheet("QPushButton { background-color: #27ae60; color: white; padding: 8px 20px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #219a52; }");
+    registerBtn->setObjectName("confirmBtn");
     
     backBtn = new QPushButton("返回登录");
-    backBtn->setStyleSheet("QPushButton { background-color: #95a5a6; color: white; padding: 8px 20px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #7f8c8d; }");
+    backBtn->setObjectName("secondaryBtn");
     
     buttonLayout->addWidget(registerBtn);
     buttonLayout->addWidget(backBtn);
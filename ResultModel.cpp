@@ -0,0 +1,527 @@
+#include "ResultModel.h"
+#include "HostNameCache.h"
+#include "MemoryBudget.h"
+#include "RadixSort.h"
+#include <QBrush>
+#include <QColor>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QGuiApplication>
+#include <QPointer>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <numeric>
+
+ResultModel::ResultModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , indexer(new SearchIndex(this))
+    , resortTimer(new QTimer(this))
+{
+    // 有排序时新到的行先接在末尾, 攒一会儿再整体重排, 避免每批结果都重排一次
+    resortTimer->setSingleShot(true);
+    resortTimer->setInterval(1000);
+    connect(resortTimer, &QTimer::timeout, this, &ResultModel::startSort);
+}
+
+ResultModel::~ResultModel()
+{
+    MemoryBudget::global().release(MemoryBudget::Results, chargedBytes);
+    MemoryBudget::global().addObjects(MemoryBudget::Results, -rows.size());
+}
+
+int ResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int ResultModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount + pluginColumnNames.size();
+}
+
+QString ResultModel::addressText(const IpAddress &address) const
+{
+    const QString &text = formatter.format(address);
+    if (hostNames != nullptr && !hostNames->isEmpty()) {
+        const QString name = hostNames->lookup(address);
+        if (!name.isEmpty()) {
+            return QString("%1 (%2)").arg(name, text);
+        }
+    }
+    return text;
+}
+
+namespace {
+
+// ASN/国家列显示对端的信息: 目的地址在库中时取目的地址, 否则取源地址
+const GeoInfo &remoteGeo(const ResultRow &row)
+{
+    return row.dstGeo.isValid() ? row.dstGeo : row.srcGeo;
+}
+
+QString asnText(const GeoInfo &geo)
+{
+    return geo.asn != 0 ? QString("AS%1").arg(geo.asn) : QString();
+}
+
+} // namespace
+
+QVariant ResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return QVariant();
+    }
+    const ResultRow &row = rowAt(index.row());
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case ColTime:
+            return QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(row.tsNs / 1000000))
+                .toString("yyyy-MM-dd hh:mm:ss");
+        case ColSource: return sourceNames.value(row.source);
+        case ColSrcIp: return addressText(row.srcIp);
+        case ColSrcPort: return row.srcPort;
+        case ColDstIp: return addressText(row.dstIp);
+        case ColDstPort: return row.dstPort;
+        case ColProtocol:
+            if (row.dissector != 0 && !dissectorProtocols.value(row.dissector - 1).isEmpty()) {
+                return dissectorProtocols[row.dissector - 1];
+            }
+            return protocolName(row.l4Proto, row.app);
+        case ColAsn: return asnText(remoteGeo(row));
+        case ColCountry: return remoteGeo(row).countryCode();
+        case ColTrafficType: return row.trafficType;
+        default: return row.pluginColumns.value(index.column() - ColumnCount);
+        }
+    } else if (role == Qt::BackgroundRole && row.checksumBad) {
+        return QBrush(QColor("#f8d7da"));
+    } else if (role == Qt::ToolTipRole) {
+        if (row.checksumBad) {
+            return QString("校验和错误");
+        }
+        if (index.column() == ColTrafficType) {
+            return row.trafficType;
+        }
+        if (index.column() >= ColumnCount) {
+            return row.pluginColumns.value(index.column() - ColumnCount);
+        }
+        if (index.column() == ColSrcIp || index.column() == ColDstIp) {
+            const quint16 group = index.column() == ColSrcIp ? row.srcGroup : row.dstGroup;
+            if (group != 0 && group < groupNames.size()) {
+                return QString("网段分组: %1").arg(groupNames[group]);
+            }
+        }
+        if ((index.column() == ColAsn || index.column() == ColCountry)
+            && (row.srcGeo.isValid() || row.dstGeo.isValid())) {
+            return QString("源: %1 %2\n目标: %3 %4")
+                .arg(asnText(row.srcGeo), row.srcGeo.countryCode(),
+                     asnText(row.dstGeo), row.dstGeo.countryCode());
+        }
+    }
+    return QVariant();
+}
+
+QVariant ResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    static const QStringList headers = {"时间", "数据源", "源IP", "源端口", "目标IP", "目标端口", "协议", "ASN", "国家", "流量类型"};
+    if (section >= ColumnCount) {
+        return pluginColumnNames.value(section - ColumnCount);
+    }
+    return headers.value(section);
+}
+
+void ResultModel::appendRows(const QVector<ResultRow> &newRows)
+{
+    if (newRows.isEmpty()) {
+        return;
+    }
+    // 引擎在接收结果行时已经按预算筛过, 这里只记账
+    quint64 bytes = 0;
+    for (const ResultRow &row : newRows) {
+        bytes += memoryCost(row);
+    }
+    MemoryBudget::global().charge(MemoryBudget::Results, bytes);
+    MemoryBudget::global().addObjects(MemoryBudget::Results, newRows.size());
+    chargedBytes += bytes;
+
+    indexer->append(newRows);
+    beginInsertRows(QModelIndex(), rows.size(), rows.size() + newRows.size() - 1);
+    const int first = rows.size();
+    rows += newRows;
+    if (!order.empty()) {
+        for (int row = first; row < rows.size(); ++row) {
+            order.push_back(static_cast<quint32>(row));
+        }
+    }
+    endInsertRows();
+
+    if (!sortColumns.isEmpty() && !resortTimer->isActive()) {
+        resortTimer->start();
+    }
+}
+
+void ResultModel::clear()
+{
+    beginResetModel();
+    MemoryBudget::global().release(MemoryBudget::Results, chargedBytes);
+    MemoryBudget::global().addObjects(MemoryBudget::Results, -rows.size());
+    chargedBytes = 0;
+    rows.clear();
+    order.clear();
+    formatter.clear();
+    indexer->clear();
+    // 进行中的排序作废, 排序列保留给之后的行
+    resortTimer->stop();
+    latestSort->store(++sortGeneration);
+    sortPending = false;
+    endResetModel();
+}
+
+namespace {
+
+// 一次排序需要的键: 整数列直接取字段, 地址拆成高低两个64位键;
+// 流量类型列和插件的自定义列先在界面线程取出文字, 到排序线程里换成名次
+struct SortJob
+{
+    std::vector<RadixSort::Key> keys;
+    std::vector<std::pair<std::size_t, std::vector<QString>>> texts; // (键下标, 各存储行的文字)
+};
+
+void addSortKey(const QVector<ResultRow> &rows, const ResultModel::SortKey &sortKey, int threads, SortJob &job)
+{
+    const ResultRow *data = rows.constData();
+    const std::size_t count = static_cast<std::size_t>(rows.size());
+    const bool descending = sortKey.order == Qt::DescendingOrder;
+    auto addKey = [&](quint64 (*value)(const ResultRow &)) {
+        RadixSort::Key key;
+        key.descending = descending;
+        key.values.resize(count);
+        RadixSort::parallelFor(count, threads, [&](int, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                key.values[i] = value(data[i]);
+            }
+        });
+        job.keys.push_back(std::move(key));
+    };
+    auto addTextKey = [&](auto text) {
+        std::vector<QString> texts(count);
+        RadixSort::parallelFor(count, threads, [&](int, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                texts[i] = text(data[i]);
+            }
+        });
+        job.texts.emplace_back(job.keys.size(), std::move(texts));
+        RadixSort::Key key;
+        key.descending = descending;
+        job.keys.push_back(std::move(key));
+    };
+
+    switch (sortKey.column) {
+    case ResultModel::ColTime: addKey([](const ResultRow &r) -> quint64 { return r.tsNs; }); break;
+    case ResultModel::ColSource: addKey([](const ResultRow &r) -> quint64 { return r.source; }); break;
+    case ResultModel::ColSrcIp:
+        addKey([](const ResultRow &r) -> quint64 { return r.srcIp.hi; });
+        addKey([](const ResultRow &r) -> quint64 { return r.srcIp.lo; });
+        break;
+    case ResultModel::ColSrcPort: addKey([](const ResultRow &r) -> quint64 { return r.srcPort; }); break;
+    case ResultModel::ColDstIp:
+        addKey([](const ResultRow &r) -> quint64 { return r.dstIp.hi; });
+        addKey([](const ResultRow &r) -> quint64 { return r.dstIp.lo; });
+        break;
+    case ResultModel::ColDstPort: addKey([](const ResultRow &r) -> quint64 { return r.dstPort; }); break;
+    case ResultModel::ColProtocol:
+        addKey([](const ResultRow &r) -> quint64 {
+            return (static_cast<quint64>(r.dissector) << 16) | (static_cast<quint64>(r.app) << 8) | r.l4Proto;
+        });
+        break;
+    case ResultModel::ColAsn: addKey([](const ResultRow &r) -> quint64 { return remoteGeo(r).asn; }); break;
+    case ResultModel::ColCountry:
+        addKey([](const ResultRow &r) -> quint64 {
+            const GeoInfo &geo = remoteGeo(r);
+            return (static_cast<quint64>(static_cast<uchar>(geo.country[0])) << 8) | static_cast<uchar>(geo.country[1]);
+        });
+        break;
+    case ResultModel::ColTrafficType:
+        addTextKey([](const ResultRow &r) { return r.trafficType; });
+        break;
+    default: {
+        // 插件的自定义列
+        const int column = sortKey.column - ResultModel::ColumnCount;
+        addTextKey([column](const ResultRow &r) { return r.pluginColumns.value(column); });
+        break;
+    }
+    }
+}
+
+// 文字换成名次, 相同的文字名次相同
+void rankTexts(SortJob &job, quint32 count)
+{
+    for (auto &entry : job.texts) {
+        const std::vector<QString> &texts = entry.second;
+        std::vector<quint32> byText(count);
+        std::iota(byText.begin(), byText.end(), 0u);
+        std::sort(byText.begin(), byText.end(), [&texts](quint32 a, quint32 b) { return texts[a] < texts[b]; });
+        std::vector<quint64> &values = job.keys[entry.first].values;
+        values.resize(count);
+        quint64 rank = 0;
+        for (quint32 i = 0; i < count; ++i) {
+            if (i > 0 && texts[byText[i]] != texts[byText[i - 1]]) {
+                ++rank;
+            }
+            values[byText[i]] = rank;
+        }
+    }
+    job.texts.clear();
+}
+
+} // namespace
+
+void ResultModel::sortBy(const QVector<SortKey> &keys)
+{
+    sortColumns = keys;
+    resortTimer->stop();
+    // 旧的排序作废, 不等它完成; 它结束后再按新的排序列排
+    latestSort->store(++sortGeneration);
+    startSort();
+}
+
+void ResultModel::startSort()
+{
+    if (sortRunning) {
+        sortPending = true;
+        return;
+    }
+    if (sortColumns.isEmpty() || rows.size() < 2) {
+        if (!order.empty()) {
+            installOrder({}, {});
+        }
+        return;
+    }
+
+    // 取键只是顺序读一遍行, 在界面线程分段并行进行; 排序本身在后台线程
+    const quint32 count = static_cast<quint32>(rows.size());
+    const int threads = count < RadixSort::kParallelMinRows ? 1 : RadixSort::defaultThreads();
+    auto job = std::make_shared<SortJob>();
+    for (const SortKey &key : sortColumns) {
+        addSortKey(rows, key, threads, *job);
+    }
+
+    const quint64 current = ++sortGeneration;
+    latestSort->store(current);
+    sortRunning = true;
+    QPointer<ResultModel> self(this);
+    std::shared_ptr<std::atomic<quint64>> latest = latestSort;
+    QThread *sorter = QThread::create([self, job, count, current, latest]() mutable {
+        auto cancelled = [&latest, current]() { return latest->load() != current; };
+        auto sorted = std::make_shared<std::vector<quint32>>();
+        auto position = std::make_shared<std::vector<quint32>>();
+        rankTexts(*job, count);
+        if (RadixSort::sort(job->keys, count, RadixSort::defaultThreads(), *sorted, cancelled)) {
+            position->resize(count);
+            for (quint32 i = 0; i < count; ++i) {
+                (*position)[(*sorted)[i]] = i;
+            }
+        }
+        job.reset();
+        QMetaObject::invokeMethod(qApp, [self, current, sorted, position]() {
+            if (self) {
+                self->finishSort(current, std::move(*sorted), *position);
+            }
+        }, Qt::QueuedConnection);
+    });
+    connect(sorter, &QThread::finished, sorter, &QObject::deleteLater);
+    sorter->start();
+}
+
+void ResultModel::finishSort(quint64 generation, std::vector<quint32> sorted, const std::vector<quint32> &position)
+{
+    sortRunning = false;
+    if (generation == sortGeneration) {
+        installOrder(std::move(sorted), position);
+    }
+    if (sortPending) {
+        sortPending = false;
+        startSort();
+    }
+}
+
+void ResultModel::installOrder(std::vector<quint32> sorted, const std::vector<quint32> &position)
+{
+    const quint32 covered = static_cast<quint32>(sorted.size());
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // 选中和当前行跟着行走: 旧的显示行号经存储行号换成新的显示行号
+    const QModelIndexList before = persistentIndexList();
+    QModelIndexList after;
+    after.reserve(before.size());
+    for (const QModelIndex &old : before) {
+        const quint32 storage = static_cast<quint32>(storageRow(old.row()));
+        const int row = static_cast<int>(storage < covered ? position[storage] : storage);
+        after.append(index(row, old.column()));
+    }
+
+    if (sorted.empty()) {
+        order.clear();
+    } else {
+        order = std::move(sorted);
+        order.reserve(rows.size());
+        for (quint32 row = covered; row < static_cast<quint32>(rows.size()); ++row) {
+            order.push_back(row);
+        }
+    }
+
+    changePersistentIndexList(before, after);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void ResultModel::setHostNames(HostNameCache *names)
+{
+    hostNames = names;
+    if (hostNames != nullptr) {
+        connect(hostNames, &HostNameCache::namesChanged, this, [this]() {
+            if (!rows.isEmpty()) {
+                emit dataChanged(index(0, ColSrcIp), index(rows.size() - 1, ColDstIp), {Qt::DisplayRole});
+            }
+        });
+    }
+}
+
+void ResultModel::setGroupNames(const QStringList &names)
+{
+    groupNames = names;
+}
+
+void ResultModel::setSourceNames(const QStringList &names)
+{
+    sourceNames = names;
+    if (!rows.isEmpty()) {
+        emit dataChanged(index(0, ColSource), index(rows.size() - 1, ColSource), {Qt::DisplayRole});
+    }
+}
+
+void ResultModel::setDissectors(const QStringList &protocols, const QStringList &columns)
+{
+    dissectorProtocols = protocols;
+    if (columns != pluginColumnNames) {
+        // 行中的插件编号和自定义列按加载时的插件保存, 换用插件前应先清空结果表, 否则旧行的这些列会对不上
+        if (!pluginColumnNames.isEmpty()) {
+            beginRemoveColumns(QModelIndex(), ColumnCount, ColumnCount + pluginColumnNames.size() - 1);
+            pluginColumnNames.clear();
+            endRemoveColumns();
+        }
+        if (!columns.isEmpty()) {
+            beginInsertColumns(QModelIndex(), ColumnCount, ColumnCount + columns.size() - 1);
+            pluginColumnNames = columns;
+            endInsertColumns();
+        }
+    }
+    if (!rows.isEmpty()) {
+        emit dataChanged(index(0, ColProtocol), index(rows.size() - 1, ColProtocol), {Qt::DisplayRole});
+    }
+}
+
+ResultFilterProxy::ResultFilterProxy(QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , refreshTimer(new QTimer(this))
+{
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(100);
+    connect(refreshTimer, &QTimer::timeout, this, &ResultFilterProxy::invalidateFilter);
+}
+
+void ResultFilterProxy::setSourceModel(QAbstractItemModel *model)
+{
+    QSortFilterProxyModel::setSourceModel(model);
+    const ResultModel *results = resultModel();
+    connect(results->searchIndex(), &SearchIndex::matchesFound, this, &ResultFilterProxy::onMatchesFound);
+    // 清空结果时索引也清空了, 进行中的查询作废, 之后的行都直接判断
+    connect(results, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+        searchGeneration = 0;
+        searchBoundary = 0;
+        searchMatches.clear();
+    });
+}
+
+const ResultModel *ResultFilterProxy::resultModel() const
+{
+    return static_cast<const ResultModel *>(sourceModel());
+}
+
+ResultModel *ResultFilterProxy::resultModel()
+{
+    return static_cast<ResultModel *>(sourceModel());
+}
+
+void ResultFilterProxy::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0) {
+        resultModel()->sortBy({});
+        return;
+    }
+    QVector<ResultModel::SortKey> keys;
+    if (QGuiApplication::keyboardModifiers() & Qt::ShiftModifier) {
+        keys = resultModel()->sortKeys();
+    }
+    auto existing = std::find_if(keys.begin(), keys.end(),
+                                 [column](const ResultModel::SortKey &key) { return key.column == column; });
+    if (existing != keys.end()) {
+        existing->order = order;
+    } else {
+        keys.append({column, order});
+    }
+    resultModel()->sortBy(keys);
+}
+
+void ResultFilterProxy::setSearch(const SearchQuery &query)
+{
+    SearchIndex *index = resultModel()->searchIndex();
+    refreshTimer->stop();
+    search = query;
+    searching = !query.isEmpty();
+    if (searching) {
+        searchBoundary = resultModel()->rowCount();
+        searchMatches.assign(searchBoundary, false);
+        searchGeneration = index->search(query, searchBoundary);
+    } else {
+        index->cancel();
+        searchGeneration = 0;
+        searchBoundary = 0;
+        searchMatches.clear();
+    }
+    invalidateFilter();
+}
+
+void ResultFilterProxy::onMatchesFound(quint64 generation, const QVector<int> &rows, bool finished)
+{
+    if (generation != searchGeneration) {
+        return;
+    }
+    for (int row : rows) {
+        if (row < static_cast<int>(searchMatches.size())) {
+            searchMatches[row] = true;
+        }
+    }
+    if (finished) {
+        refreshTimer->stop();
+        invalidateFilter();
+    } else if (!refreshTimer->isActive()) {
+        refreshTimer->start();
+    }
+}
+
+bool ResultFilterProxy::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    Q_UNUSED(sourceParent)
+    if (!searching) {
+        return true;
+    }
+    const int storage = resultModel()->storageRow(sourceRow);
+    if (storage < searchBoundary) {
+        return searchMatches[storage];
+    }
+    return search.matches(resultModel()->rowAt(sourceRow));
+}
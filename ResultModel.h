@@ -0,0 +1,134 @@
+#ifndef RESULTMODEL_H
+#define RESULTMODEL_H
+
+#include "AddressFormatter.h"
+#include "AnalysisTypes.h"
+#include "SearchIndex.h"
+#include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class HostNameCache;
+class QTimer;
+
+// 结果表模型: 行数据保持整数形式, data() 只为视图请求的可见单元格格式化文本。
+// 行按到达顺序存放 (存储行号), 排序只维护显示行号到存储行号的排列, 不移动行数据
+class ResultModel final : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColTime,
+        ColSource,
+        ColSrcIp,
+        ColSrcPort,
+        ColDstIp,
+        ColDstPort,
+        ColProtocol,
+        ColAsn,
+        ColCountry,
+        ColTrafficType,
+        ColumnCount
+    };
+
+    struct SortKey
+    {
+        int column = ColTime;
+        Qt::SortOrder order = Qt::AscendingOrder;
+    };
+
+    explicit ResultModel(QObject *parent = nullptr);
+    ~ResultModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void appendRows(const QVector<ResultRow> &newRows);
+    void clear();
+    // row 为显示行号
+    const ResultRow &rowAt(int row) const { return rows[storageRow(row)]; }
+    int storageRow(int row) const { return order.empty() ? row : static_cast<int>(order[row]); }
+    // 随行追加和清空同步维护的搜索索引, 行号为存储行号
+    SearchIndex *searchIndex() const { return indexer; }
+
+    // 按多列排序, 第一列为主键, 各列都相同的行保持到达顺序; 空表示按到达顺序显示。
+    // 排序在后台线程进行, 完成后整体换成新的顺序。排序期间和之后追加的行先接在末尾,
+    // 稍后连同已有的行一起重新排序
+    void sortBy(const QVector<SortKey> &keys);
+    const QVector<SortKey> &sortKeys() const { return sortColumns; }
+
+    // 设置后IP列优先显示主机名; 名称表变化时刷新IP列
+    void setHostNames(HostNameCache *names);
+    // 网段分组名称, 下标对应行中的分组编号, 用于地址列的提示
+    void setGroupNames(const QStringList &names);
+    // 数据源名称, 下标对应行中的输入编号
+    void setSourceNames(const QStringList &names);
+    // 协议解析插件的协议名 (下标为插件编号) 和自定义列; 自定义列接在固定列之后。
+    // 开始分析清空结果表后设置, 与引擎这次使用的插件一致
+    void setDissectors(const QStringList &protocols, const QStringList &columns);
+
+private:
+    QString addressText(const IpAddress &address) const;
+    void startSort();
+    void finishSort(quint64 generation, std::vector<quint32> sorted, const std::vector<quint32> &position);
+    // sorted 覆盖存储行 [0, sorted.size()), position 为它的逆排列; 之后的行按到达顺序接在末尾
+    void installOrder(std::vector<quint32> sorted, const std::vector<quint32> &position);
+
+    QVector<ResultRow> rows;
+    quint64 chargedBytes = 0; // 已计入全局内存预算的字节数
+    mutable AddressFormatter formatter;
+    HostNameCache *hostNames = nullptr;
+    QStringList groupNames;
+    QStringList sourceNames;
+    QStringList dissectorProtocols;
+    QStringList pluginColumnNames;
+    SearchIndex *indexer = nullptr;
+
+    QVector<SortKey> sortColumns;
+    std::vector<quint32> order; // 显示行号 -> 存储行号, 空表示按存储顺序
+    quint64 sortGeneration = 0;
+    // 后台排序线程据此判断是否作废, 模型析构后线程仍可能持有
+    std::shared_ptr<std::atomic<quint64>> latestSort = std::make_shared<std::atomic<quint64>>(0);
+    bool sortRunning = false;
+    bool sortPending = false; // 排序期间又需要排序, 完成后再排一次
+    QTimer *resortTimer = nullptr;
+};
+
+// 只负责过滤; 排序转给 ResultModel, 代理保持源模型的行顺序
+class ResultFilterProxy final : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit ResultFilterProxy(QObject *parent = nullptr);
+
+    // 源模型必须是 ResultModel
+    void setSourceModel(QAbstractItemModel *model) override;
+    // 按搜索条件过滤, 空条件显示全部。已有的行交给后台索引查询, 结果分批到达时陆续显示;
+    // 查询开始之后追加的行直接按条件判断
+    void setSearch(const SearchQuery &query);
+    // 点击表头按该列排序; 按住 Shift 点击时把该列加为次要排序列, 已在排序列中时只改变方向
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    const ResultModel *resultModel() const;
+    ResultModel *resultModel();
+    void onMatchesFound(quint64 generation, const QVector<int> &rows, bool finished);
+
+    SearchQuery search;
+    bool searching = false;
+    quint64 searchGeneration = 0;
+    int searchBoundary = 0;           // 存储行号在这之前的行看 searchMatches, 之后追加的行直接判断
+    std::vector<bool> searchMatches;  // 下标为存储行号
+    QTimer *refreshTimer = nullptr;   // 合并分批到达的结果, 避免每批都重新过滤整个表
+};
+
+#endif // RESULTMODEL_H
@@ -0,0 +1,54 @@
+#include "RowDelegate.h"
+#include <QPainter>
+
+namespace {
+// 与 QStyledItemDelegate 在常见样式下的文本边距一致
+constexpr int kTextMargin = 3;
+}
+
+RowDelegate::RowDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void RowDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    // 交替行底色已经由视图画好, 这里只画选中或模型指定的背景
+    const bool selected = option.state & QStyle::State_Selected;
+    const QPalette::ColorGroup group = !(option.state & QStyle::State_Enabled) ? QPalette::Disabled
+        : (option.state & QStyle::State_Active) ? QPalette::Active
+                                               : QPalette::Inactive;
+    if (selected) {
+        painter->fillRect(option.rect, option.palette.brush(group, QPalette::Highlight));
+    } else {
+        const QVariant background = index.data(Qt::BackgroundRole);
+        if (background.isValid()) {
+            painter->fillRect(option.rect, qvariant_cast<QBrush>(background));
+        }
+    }
+
+    const QString text = index.data(Qt::DisplayRole).toString();
+    if (text.isEmpty()) {
+        return;
+    }
+    QColor color = option.palette.color(group, selected ? QPalette::HighlightedText : QPalette::Text);
+    if (!selected) {
+        const QVariant foreground = index.data(Qt::ForegroundRole);
+        if (foreground.isValid()) {
+            color = qvariant_cast<QBrush>(foreground).color();
+        }
+    }
+    const QVariant alignmentValue = index.data(Qt::TextAlignmentRole);
+    Qt::Alignment alignment = alignmentValue.isValid() ? Qt::Alignment(alignmentValue.toInt()) : Qt::AlignLeft;
+    if (!(alignment & Qt::AlignVertical_Mask)) {
+        alignment |= Qt::AlignVCenter;
+    }
+
+    const QRect textRect = option.rect.adjusted(kTextMargin, 0, -kTextMargin, 0);
+    const QString shown = option.fontMetrics.elidedText(text, Qt::ElideRight, textRect.width());
+    painter->save();
+    painter->setFont(option.font);
+    painter->setPen(color);
+    painter->drawText(textRect, int(alignment | Qt::TextSingleLine), shown);
+    painter->restore();
+}
@@ -0,0 +1,19 @@
+#ifndef ROWDELEGATE_H
+#define ROWDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+// 高频刷新的表格使用的委托: 直接用画笔填充背景和绘制省略后的文本, 不经过样式的 CE_ItemViewItem,
+// 每个单元格只向模型请求显示文本、背景、前景和对齐四个角色。
+// 不支持图标、复选框和编辑, 用于结果表和流记录这类只读的纯文本表格
+class RowDelegate final : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit RowDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
+
+#endif // ROWDELEGATE_H
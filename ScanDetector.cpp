@@ -0,0 +1,341 @@
+#include "ScanDetector.h"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint8_t kTcpSyn = 0x02;
+constexpr std::uint8_t kTcpAck = 0x10;
+
+// CLOCK指针一次最多走这么多格, 全表都被引用时直接淘汰最后看到的条目
+constexpr int kMaxClockSweep = 64;
+
+std::uint64_t mix64(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::uint32_t roundUpPow2(std::size_t n)
+{
+    std::uint32_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace
+
+void ScanEntry::resetWindow(std::uint64_t nowNs)
+{
+    windowStartNs = nowNs;
+    alerted = 0;
+    syns = 0;
+    completed = 0;
+    std::memset(portBits, 0, sizeof(portBits));
+    std::memset(hosts, 0, sizeof(hosts));
+}
+
+void ScanEntry::addPort(std::uint16_t port)
+{
+    const std::uint64_t bit = mix64(port) & (kPortBitmapWords * 64 - 1);
+    portBits[bit >> 6] |= 1ULL << (bit & 63);
+}
+
+void ScanEntry::addHost(const IpAddress &host)
+{
+    const std::uint64_t h = mix64(host.hi ^ mix64(host.lo));
+    const int index = static_cast<int>(h >> 58); // 高6位选寄存器
+    std::uint64_t w = (h << 6) | (1ULL << 5);    // 保证至多数到58位
+    std::uint8_t rank = 1;
+    while ((w & (1ULL << 63)) == 0) {
+        w <<= 1;
+        ++rank;
+    }
+    hosts[index] = std::max(hosts[index], rank);
+}
+
+std::uint32_t ScanEntry::distinctPorts() const
+{
+    // 线性计数: n ≈ -m ln(空位比例)
+    constexpr double m = kPortBitmapWords * 64;
+    std::size_t set = 0;
+    for (std::uint64_t word : portBits) {
+        set += std::bitset<64>(word).count();
+    }
+    const double zeros = m - static_cast<double>(set);
+    if (zeros <= 0.0) {
+        return static_cast<std::uint32_t>(m * std::log(m));
+    }
+    return static_cast<std::uint32_t>(std::lround(-m * std::log(zeros / m)));
+}
+
+std::uint32_t ScanEntry::distinctHosts() const
+{
+    constexpr double m = kHllRegisters;
+    constexpr double alpha = 0.709;
+    double sum = 0.0;
+    int zeros = 0;
+    for (std::uint8_t reg : hosts) {
+        sum += std::ldexp(1.0, -reg);
+        if (reg == 0) {
+            ++zeros;
+        }
+    }
+    double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(m / zeros); // 小基数时退化为线性计数
+    }
+    return static_cast<std::uint32_t>(std::lround(estimate));
+}
+
+ScanStateTable::ScanStateTable(std::size_t capacity)
+    : entries(std::max<std::size_t>(capacity, 1))
+    , buckets(roundUpPow2(entries.size() * 2), ScanEntry::kNil)
+    , bucketMask(static_cast<std::uint32_t>(buckets.size() - 1))
+{
+}
+
+std::uint32_t ScanStateTable::bucketOf(const IpAddress &address) const
+{
+    return static_cast<std::uint32_t>(IpAddressHash()(address)) & bucketMask;
+}
+
+ScanEntry &ScanStateTable::acquire(const IpAddress &address, bool &created)
+{
+    const std::uint32_t bucket = bucketOf(address);
+    for (std::uint32_t slot = buckets[bucket]; slot != ScanEntry::kNil; slot = entries[slot].next) {
+        ScanEntry &entry = entries[slot];
+        if (entry.address == address) {
+            entry.referenced = true;
+            created = false;
+            markChanged(slot);
+            return entry;
+        }
+    }
+
+    const std::uint32_t slot = allocate();
+    ScanEntry &entry = entries[slot];
+    entry.address = address;
+    entry.used = true;
+    entry.referenced = true;
+    entry.next = buckets[bucket];
+    buckets[bucket] = slot;
+    created = true;
+    markChanged(slot);
+    return entry;
+}
+
+void ScanStateTable::markChanged(std::uint32_t slot)
+{
+    if (tracking && changedFlags[slot] == 0) {
+        changedFlags[slot] = 1;
+        changedSlots.push_back(slot);
+    }
+}
+
+std::uint32_t ScanStateTable::allocate()
+{
+    if (used < entries.size()) {
+        return used++;
+    }
+
+    // CLOCK: 清掉沿途的引用位, 遇到第一个未被引用的条目就淘汰
+    std::uint32_t victim = hand;
+    for (int step = 0; step < kMaxClockSweep; ++step) {
+        victim = hand;
+        hand = (hand + 1) % static_cast<std::uint32_t>(entries.size());
+        if (!entries[victim].referenced) {
+            break;
+        }
+        entries[victim].referenced = false;
+        markChanged(victim);
+    }
+    unlink(victim);
+    ++evicted;
+    return victim;
+}
+
+void ScanStateTable::unlink(std::uint32_t slot)
+{
+    std::uint32_t *link = &buckets[bucketOf(entries[slot].address)];
+    while (*link != slot) {
+        link = &entries[*link].next;
+    }
+    *link = entries[slot].next;
+    entries[slot].next = ScanEntry::kNil;
+    entries[slot].used = false;
+}
+
+void ScanStateTable::clear()
+{
+    for (ScanEntry &entry : entries) {
+        entry.used = false;
+        entry.next = ScanEntry::kNil;
+    }
+    std::fill(buckets.begin(), buckets.end(), ScanEntry::kNil);
+    used = 0;
+    hand = 0;
+    evicted = 0;
+    std::fill(changedFlags.begin(), changedFlags.end(), 0);
+    changedSlots.clear();
+}
+
+void ScanStateTable::setChangeTracking(bool enabled)
+{
+    tracking = enabled;
+    changedFlags.assign(enabled ? entries.size() : 0, 0);
+    changedSlots.clear();
+}
+
+void ScanStateTable::takeChanges(bool all, std::vector<std::uint32_t> &slots, std::vector<ScanEntry> &images)
+{
+    slots.clear();
+    images.clear();
+    if (all) {
+        for (std::uint32_t slot = 0; slot < used; ++slot) {
+            slots.push_back(slot);
+            images.push_back(entries[slot]);
+        }
+    } else {
+        slots.swap(changedSlots);
+        for (std::uint32_t slot : slots) {
+            images.push_back(entries[slot]);
+        }
+    }
+    std::fill(changedFlags.begin(), changedFlags.end(), 0);
+    changedSlots.clear();
+}
+
+ScanTableState ScanStateTable::state() const
+{
+    ScanTableState current;
+    current.capacity = static_cast<std::uint32_t>(entries.size());
+    current.used = used;
+    current.hand = hand;
+    current.evicted = evicted;
+    return current;
+}
+
+bool ScanStateTable::restore(const ScanTableState &saved, const std::vector<ScanEntry> &savedEntries)
+{
+    clear();
+    if (saved.capacity != entries.size() || savedEntries.size() != entries.size() || saved.used > saved.capacity
+        || saved.hand >= saved.capacity) {
+        return false;
+    }
+    // 槽位原样放回, 哈希链按地址重新串起来
+    for (std::uint32_t slot = 0; slot < saved.used; ++slot) {
+        ScanEntry &entry = entries[slot];
+        entry = savedEntries[slot];
+        entry.used = true;
+        const std::uint32_t bucket = bucketOf(entry.address);
+        entry.next = buckets[bucket];
+        buckets[bucket] = slot;
+    }
+    used = saved.used;
+    hand = saved.hand;
+    evicted = saved.evicted;
+    return true;
+}
+
+ScanDetector::ScanDetector(const ScanThresholds &thresholds, std::size_t sourceCapacity, std::size_t targetCapacity)
+    : limits(thresholds)
+    , sources(sourceCapacity)
+    , targets(targetCapacity)
+{
+}
+
+void ScanDetector::clear()
+{
+    sources.clear();
+    targets.clear();
+}
+
+ScanEntry &ScanDetector::entryFor(ScanStateTable &table, const IpAddress &address, std::uint64_t nowNs)
+{
+    bool created = false;
+    ScanEntry &entry = table.acquire(address, created);
+    if (created || nowNs - entry.windowStartNs >= limits.windowNs || nowNs < entry.windowStartNs) {
+        entry.resetWindow(nowNs);
+    }
+    return entry;
+}
+
+void ScanDetector::raise(ScanEntry &entry, AlertKind kind, std::uint64_t nowNs, QVector<SecurityAlert> &alerts)
+{
+    const std::uint8_t bit = static_cast<std::uint8_t>(1u << static_cast<unsigned>(kind));
+    if (entry.alerted & bit) {
+        return; // 同一窗口内每种告警只报一次
+    }
+    entry.alerted |= bit;
+
+    SecurityAlert alert;
+    alert.tsNs = nowNs;
+    alert.kind = kind;
+    alert.subject = entry.address;
+    alert.distinctPorts = entry.distinctPorts();
+    alert.distinctHosts = entry.distinctHosts();
+    alert.syns = entry.syns;
+    alert.halfOpen = entry.syns > entry.completed ? entry.syns - entry.completed : 0;
+    alerts.append(alert);
+}
+
+void ScanDetector::inspect(const DecodedPacket &pkt, FlowRecord &flow, bool fromInitiator,
+                           QVector<SecurityAlert> &alerts)
+{
+    if (pkt.l4Proto != ProtoTcp) {
+        return;
+    }
+    const bool syn = (pkt.tcpFlags & kTcpSyn) != 0;
+    const bool ack = (pkt.tcpFlags & kTcpAck) != 0;
+    const std::uint64_t now = pkt.tsNs;
+
+    if (syn && !ack) {
+        flow.handshake = TcpHandshake::SynSent;
+        const IpAddress src = IpAddress::fromBytes(pkt.srcAddr, pkt.ipVersion);
+        const IpAddress dst = IpAddress::fromBytes(pkt.dstAddr, pkt.ipVersion);
+
+        ScanEntry &source = entryFor(sources, src, now);
+        ++source.syns;
+        source.addPort(pkt.dstPort);
+        source.addHost(dst);
+        // 估计基数要扫一遍寄存器, 探测数还不够任何阈值时跳过
+        if (source.syns >= std::min(limits.verticalPorts, limits.horizontalHosts)) {
+            const std::uint32_t ports = source.distinctPorts();
+            const std::uint32_t hosts = source.distinctHosts();
+            if (ports >= limits.verticalPorts && hosts <= limits.verticalMaxHosts) {
+                raise(source, AlertKind::VerticalScan, now, alerts);
+            }
+            if (hosts >= limits.horizontalHosts && ports <= limits.horizontalMaxPorts) {
+                raise(source, AlertKind::HorizontalScan, now, alerts);
+            }
+        }
+
+        ScanEntry &target = entryFor(targets, dst, now);
+        ++target.syns;
+        target.addHost(src);
+        const std::uint32_t halfOpen = target.syns > target.completed ? target.syns - target.completed : 0;
+        if (target.syns >= limits.floodSyns
+            && target.completed < target.syns * limits.floodMaxCompletion) {
+            raise(target, AlertKind::SynFlood, now, alerts);
+        }
+        if (halfOpen >= limits.halfOpen) {
+            raise(target, AlertKind::HalfOpen, now, alerts);
+        }
+        return;
+    }
+
+    if (syn && ack && !fromInitiator && flow.handshake == TcpHandshake::SynSent) {
+        flow.handshake = TcpHandshake::SynAckSeen;
+    } else if (ack && !syn && fromInitiator && flow.handshake == TcpHandshake::SynAckSeen) {
+        flow.handshake = TcpHandshake::Established;
+        ScanEntry &target = entryFor(targets, IpAddress::fromBytes(pkt.dstAddr, pkt.ipVersion), now);
+        ++target.completed;
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef SCANDETECTOR_H
+#define SCANDETECTOR_H
+
+#include "AnalysisTypes.h"
+#include "FlowTable.h"
+#include <cstdint>
+#include <vector>
+
+// 每个地址在一个检测窗口内的状态, 大小固定
+struct ScanEntry
+{
+    static constexpr std::uint32_t kNil = 0xffffffffu;
+    static constexpr int kPortBitmapWords = 16; // 1024位线性计数
+    static constexpr int kHllRegisters = 64;
+
+    IpAddress address;
+    std::uint32_t next = kNil; // 哈希链
+    bool used = false;
+    bool referenced = false;   // CLOCK引用位
+    std::uint8_t alerted = 0;  // 本窗口已报过的告警类型
+    std::uint64_t windowStartNs = 0;
+    std::uint32_t syns = 0;
+    std::uint32_t completed = 0;
+    std::uint64_t portBits[kPortBitmapWords];
+    std::uint8_t hosts[kHllRegisters]; // HyperLogLog寄存器
+
+    void resetWindow(std::uint64_t nowNs);
+    void addPort(std::uint16_t port);
+    void addHost(const IpAddress &host);
+    std::uint32_t distinctPorts() const;
+    std::uint32_t distinctHosts() const;
+};
+
+// 状态表在检查点中的游标, 条目内容另外保存
+struct ScanTableState
+{
+    std::uint32_t capacity = 0;
+    std::uint32_t used = 0;
+    std::uint32_t hand = 0;
+    std::uint32_t pad = 0;
+    std::uint64_t evicted = 0;
+};
+
+// 容量固定的地址状态表: 数组存放条目, 定长链式哈希做索引, 满了以后用CLOCK淘汰。
+// 大量伪造源地址时只会加快淘汰, 不会增长内存
+class ScanStateTable
+{
+public:
+    explicit ScanStateTable(std::size_t capacity);
+
+    // 找不到时分配新条目 (必要时淘汰旧条目), created 返回是否为新条目
+    ScanEntry &acquire(const IpAddress &address, bool &created);
+    std::uint64_t evictions() const { return evicted; }
+    void clear();
+
+    // 检查点: 开启后记录上一次 takeChanges 以来改动过的槽位
+    void setChangeTracking(bool enabled);
+    // all 为true时取出全部已用的槽位, 否则只取改动过的; slots 与 images 一一对应
+    void takeChanges(bool all, std::vector<std::uint32_t> &slots, std::vector<ScanEntry> &images);
+    ScanTableState state() const;
+    // entries 为按槽位排列的全部条目, 哈希链按其中的地址重建; 容量与检查点不同时返回false
+    bool restore(const ScanTableState &saved, const std::vector<ScanEntry> &savedEntries);
+
+private:
+    std::uint32_t bucketOf(const IpAddress &address) const;
+    std::uint32_t allocate();
+    void unlink(std::uint32_t slot);
+    void markChanged(std::uint32_t slot);
+
+    std::vector<ScanEntry> entries;
+    std::vector<std::uint32_t> buckets;
+    std::uint32_t bucketMask = 0;
+    std::uint32_t used = 0;
+    std::uint32_t hand = 0;
+    std::uint64_t evicted = 0;
+    bool tracking = false;
+    std::vector<std::uint8_t> changedFlags;
+    std::vector<std::uint32_t> changedSlots;
+};
+
+// 检测阈值, 计数都按一个检测窗口计算
+struct ScanThresholds
+{
+    std::uint64_t windowNs = 10ull * 1000000000ull;
+    std::uint32_t verticalPorts = 100;   // 同一源的不同目的端口数
+    std::uint32_t verticalMaxHosts = 4;
+    std::uint32_t horizontalHosts = 64;  // 同一源的不同目的主机数
+    std::uint32_t horizontalMaxPorts = 4;
+    std::uint32_t floodSyns = 1000;      // 同一目标窗口内的SYN数
+    double floodMaxCompletion = 0.2;     // 握手完成比例低于此值才算泛洪
+    std::uint32_t halfOpen = 256;        // 同一目标未完成握手数
+};
+
+// 端口扫描和SYN泛洪检测, 每个包只做常数次表操作。
+// 扫描按源地址统计探测SYN, 泛洪按目标地址统计SYN与完成的握手
+class ScanDetector
+{
+public:
+    explicit ScanDetector(const ScanThresholds &thresholds = ScanThresholds(),
+                          std::size_t sourceCapacity = 16384, std::size_t targetCapacity = 4096);
+
+    // 推进流上的握手状态并更新统计, 触发的告警追加到 alerts
+    void inspect(const DecodedPacket &pkt, FlowRecord &flow, bool fromInitiator,
+                 QVector<SecurityAlert> &alerts);
+    std::uint64_t evictions() const { return sources.evictions() + targets.evictions(); }
+    void clear();
+
+    // 检查点直接读写两张状态表
+    ScanStateTable &sourceTable() { return sources; }
+    ScanStateTable &targetTable() { return targets; }
+
+private:
+    ScanEntry &entryFor(ScanStateTable &table, const IpAddress &address, std::uint64_t nowNs);
+    void raise(ScanEntry &entry, AlertKind kind, std::uint64_t nowNs, QVector<SecurityAlert> &alerts);
+
+    ScanThresholds limits;
+    ScanStateTable sources;
+    ScanStateTable targets;
+};
+
+#endif // SCANDETECTOR_H
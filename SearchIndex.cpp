@@ -0,0 +1,416 @@
+#include "SearchIndex.h"
+#include "AddressFormatter.h"
+#include "MemoryBudget.h"
+#include "PrefixTrie.h"
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+// 尾部攒到这么多地址时排序并归并进有序数组
+constexpr size_t kMergeThreshold = 8192;
+// 确认和交出结果的分段大小
+constexpr int kChunkRows = 16384;
+
+quint16 protocolKey(quint8 l4Proto, AppProtocol app)
+{
+    return static_cast<quint16>((l4Proto << 8) | static_cast<quint8>(app));
+}
+
+quint32 trigramAt(const std::string &text, size_t pos)
+{
+    return (static_cast<quint32>(static_cast<unsigned char>(text[pos])) << 16)
+           | (static_cast<quint32>(static_cast<unsigned char>(text[pos + 1])) << 8)
+           | static_cast<unsigned char>(text[pos + 2]);
+}
+
+// 前缀覆盖的最大地址
+IpAddress lastInPrefix(const IpAddress &prefix, int length)
+{
+    IpAddress last = prefix;
+    if (length <= 0) {
+        last.hi = last.lo = ~0ULL;
+    } else if (length < 64) {
+        last.hi |= ~0ULL >> length;
+        last.lo = ~0ULL;
+    } else if (length < 128) {
+        last.lo |= ~0ULL >> (length - 64);
+    }
+    return last;
+}
+
+// "192.168." 或 "10.1" 这样不完整的IPv4, 按写出的段作为前缀
+bool parsePartialV4(const QString &token, SearchQuery::Prefix &prefix)
+{
+    QString text = token;
+    if (text.endsWith('.')) {
+        text.chop(1);
+    }
+    const QStringList parts = text.split('.');
+    if (parts.size() < 2 || parts.size() > 3) {
+        return false;
+    }
+    quint32 value = 0;
+    for (const QString &part : parts) {
+        bool ok = false;
+        const uint octet = part.toUInt(&ok);
+        if (!ok || octet > 255 || part.size() > 3) {
+            return false;
+        }
+        value = (value << 8) | octet;
+    }
+    value <<= 8 * (4 - parts.size());
+    prefix.length = 96 + 8 * parts.size();
+    prefix.prefix = IpAddress::fromV4(value).masked(prefix.length);
+    return true;
+}
+
+const QStringList &protocolNames()
+{
+    static const QStringList names = {
+        protocolName(6, AppProtocol::None), protocolName(17, AppProtocol::None),
+        protocolName(0, AppProtocol::Http), protocolName(0, AppProtocol::Https),
+        protocolName(0, AppProtocol::Ftp), protocolName(0, AppProtocol::Ssh),
+        protocolName(0, AppProtocol::Dns)};
+    return names;
+}
+
+// 索引一行的大致内存: 两个地址项、三个倒排项、文字和它的三元组
+quint64 indexCost(const ResultRow &row)
+{
+    const quint64 textBytes = static_cast<quint64>(row.trafficType.size()) * 2;
+    return 2 * (sizeof(IpAddress) + sizeof(quint64)) + 3 * sizeof(quint32) + sizeof(std::string)
+           + textBytes * (1 + sizeof(quint32));
+}
+
+} // namespace
+
+SearchQuery SearchQuery::parse(const QString &text)
+{
+    SearchQuery query;
+    const QString simplified = text.simplified();
+    if (simplified.isEmpty()) {
+        return query;
+    }
+    for (const QString &token : simplified.split(' ')) {
+        bool isNumber = false;
+        const uint port = token.toUInt(&isNumber);
+        Prefix prefix;
+        if (isNumber && port <= 65535) {
+            query.ports.push_back(static_cast<quint16>(port));
+        } else if (AddressFormatter::parseCidr(token, prefix.prefix, prefix.length)
+                   || parsePartialV4(token, prefix)) {
+            query.prefixes.push_back(prefix);
+        } else if (protocolNames().contains(token.toUpper())) {
+            query.protocols.push_back(token.toUpper());
+        } else {
+            query.texts.push_back(token.toLower());
+        }
+    }
+    return query;
+}
+
+bool SearchQuery::matches(const ResultRow &row) const
+{
+    for (const Prefix &p : prefixes) {
+        if (row.srcIp.masked(p.length) != p.prefix && row.dstIp.masked(p.length) != p.prefix) {
+            return false;
+        }
+    }
+    for (quint16 port : ports) {
+        if (row.srcPort != port && row.dstPort != port) {
+            return false;
+        }
+    }
+    if (!protocols.empty()) {
+        const QString name = protocolName(row.l4Proto, row.app);
+        for (const QString &protocol : protocols) {
+            if (name != protocol) {
+                return false;
+            }
+        }
+    }
+    for (const QString &needle : texts) {
+        if (!row.trafficType.contains(needle, Qt::CaseInsensitive)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SearchIndex::SearchIndex(QObject *parent)
+    : QObject(parent)
+{
+    worker = std::thread(&SearchIndex::workLoop, this);
+}
+
+SearchIndex::~SearchIndex()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks.clear();
+        ++latestGeneration;
+    }
+    changed.notify_all();
+    worker.join();
+    MemoryBudget::global().release(MemoryBudget::Results, chargedBytes);
+}
+
+void SearchIndex::append(const QVector<ResultRow> &rows)
+{
+    if (rows.isEmpty()) {
+        return;
+    }
+    Task task;
+    task.kind = Task::Append;
+    task.rows.reserve(rows.size());
+    quint64 bytes = 0;
+    for (const ResultRow &row : rows) {
+        // 文字转小写和切分三元组留给工作线程, 这里只复制 (QString 共享数据)
+        task.rows.push_back({row.srcIp, row.dstIp, row.srcPort, row.dstPort, protocolKey(row.l4Proto, row.app),
+                             row.trafficType});
+        bytes += indexCost(row);
+    }
+    MemoryBudget::global().charge(MemoryBudget::Results, bytes);
+    chargedBytes += bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    changed.notify_one();
+}
+
+void SearchIndex::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // 排队中的追加和查询都不必再做
+        tasks.clear();
+        Task task;
+        task.kind = Task::Clear;
+        tasks.push_back(std::move(task));
+        ++latestGeneration;
+    }
+    changed.notify_one();
+    MemoryBudget::global().release(MemoryBudget::Results, chargedBytes);
+    chargedBytes = 0;
+}
+
+quint64 SearchIndex::search(const SearchQuery &query, int rowCount)
+{
+    quint64 generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                                   [](const Task &task) { return task.kind == Task::Search; }),
+                    tasks.end());
+        generation = ++latestGeneration;
+        Task task;
+        task.kind = Task::Search;
+        task.query = query;
+        task.rowCount = rowCount;
+        task.generation = generation;
+        tasks.push_back(std::move(task));
+    }
+    changed.notify_one();
+    return generation;
+}
+
+void SearchIndex::cancel()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                               [](const Task &task) { return task.kind == Task::Search; }),
+                tasks.end());
+    ++latestGeneration;
+}
+
+void SearchIndex::workLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (stopping) {
+            return;
+        }
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        switch (task.kind) {
+        case Task::Append: addRows(task.rows); break;
+        case Task::Clear: resetIndex(); break;
+        case Task::Search: runSearch(task); break;
+        }
+        lock.lock();
+    }
+}
+
+void SearchIndex::addRows(const std::vector<IndexedRow> &rows)
+{
+    for (const IndexedRow &row : rows) {
+        const quint32 id = rowTotal++;
+        recentAddresses.push_back({row.srcIp, id});
+        recentAddresses.push_back({row.dstIp, id});
+
+        std::vector<quint32> &src = portPostings[row.srcPort];
+        src.push_back(id);
+        if (row.dstPort != row.srcPort) {
+            portPostings[row.dstPort].push_back(id);
+        }
+        protocolPostings[row.protocol].push_back(id);
+
+        texts.push_back(row.text.toLower().toStdString());
+        const std::string &text = texts.back();
+        for (size_t i = 0; i + 3 <= text.size(); ++i) {
+            std::vector<quint32> &postings = trigramPostings[trigramAt(text, i)];
+            if (postings.empty() || postings.back() != id) {
+                postings.push_back(id);
+            }
+        }
+    }
+
+    if (recentAddresses.size() >= kMergeThreshold) {
+        std::sort(recentAddresses.begin(), recentAddresses.end());
+        const auto middle = sortedAddresses.insert(sortedAddresses.end(), recentAddresses.begin(),
+                                                   recentAddresses.end());
+        std::inplace_merge(sortedAddresses.begin(), middle, sortedAddresses.end());
+        recentAddresses.clear();
+    }
+}
+
+void SearchIndex::resetIndex()
+{
+    rowTotal = 0;
+    std::vector<AddressEntry>().swap(sortedAddresses);
+    std::vector<AddressEntry>().swap(recentAddresses);
+    std::unordered_map<quint16, std::vector<quint32>>().swap(portPostings);
+    std::unordered_map<quint16, std::vector<quint32>>().swap(protocolPostings);
+    std::unordered_map<quint32, std::vector<quint32>>().swap(trigramPostings);
+    std::vector<std::string>().swap(texts);
+}
+
+void SearchIndex::andPostings(const std::vector<quint32> &postings, int rowCount, Bits &bits)
+{
+    Bits term(bits.size(), 0);
+    for (quint32 row : postings) {
+        if (row >= static_cast<quint32>(rowCount)) {
+            break; // 倒排表按行号递增
+        }
+        term[row >> 6] |= 1ULL << (row & 63);
+    }
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] &= term[i];
+    }
+}
+
+bool SearchIndex::matchPrefix(const SearchQuery::Prefix &prefix, int rowCount, Bits &bits, quint64 generation) const
+{
+    Bits term(bits.size(), 0);
+    auto mark = [&](const AddressEntry &entry) {
+        if (entry.row < static_cast<quint32>(rowCount)) {
+            term[entry.row >> 6] |= 1ULL << (entry.row & 63);
+        }
+    };
+    const AddressEntry first{prefix.prefix, 0};
+    const AddressEntry last{lastInPrefix(prefix.prefix, prefix.length), ~0u};
+    auto it = std::lower_bound(sortedAddresses.begin(), sortedAddresses.end(), first);
+    for (size_t n = 0; it != sortedAddresses.end() && !(last < *it); ++it, ++n) {
+        // 很宽的前缀会覆盖大部分地址, 中途检查是否已经作废
+        if ((n & 0xffff) == 0xffff && cancelled(generation)) {
+            return false;
+        }
+        mark(*it);
+    }
+    for (const AddressEntry &entry : recentAddresses) {
+        if (entry.address.masked(prefix.length) == prefix.prefix) {
+            mark(entry);
+        }
+    }
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] &= term[i];
+    }
+    return true;
+}
+
+void SearchIndex::runSearch(const Task &task)
+{
+    const SearchQuery &query = task.query;
+    const quint64 generation = task.generation;
+    const int rowCount = std::min(task.rowCount, static_cast<int>(rowTotal));
+
+    // 先用各项的索引求出候选行
+    Bits bits((rowCount + 63) / 64, ~0ULL);
+    if (rowCount % 64 != 0) {
+        bits.back() = (1ULL << (rowCount % 64)) - 1;
+    }
+    static const std::vector<quint32> kNoRows;
+    auto postingsOf = [](const auto &map, auto key) -> const std::vector<quint32> & {
+        const auto found = map.find(key);
+        return found != map.end() ? found->second : kNoRows;
+    };
+    for (const SearchQuery::Prefix &prefix : query.prefixes) {
+        if (!matchPrefix(prefix, rowCount, bits, generation)) {
+            return;
+        }
+    }
+    for (quint16 port : query.ports) {
+        andPostings(postingsOf(portPostings, port), rowCount, bits);
+    }
+    for (const QString &protocol : query.protocols) {
+        // 同一个协议名可能对应多个键, 例如不同传输层上的 DNS
+        Bits term(bits.size(), 0);
+        for (const auto &entry : protocolPostings) {
+            if (protocolName(static_cast<quint8>(entry.first >> 8), static_cast<AppProtocol>(entry.first & 0xff))
+                == protocol) {
+                Bits one(bits.size(), ~0ULL);
+                andPostings(entry.second, rowCount, one);
+                for (size_t i = 0; i < term.size(); ++i) {
+                    term[i] |= one[i];
+                }
+            }
+        }
+        for (size_t i = 0; i < bits.size(); ++i) {
+            bits[i] &= term[i];
+        }
+    }
+    std::vector<std::string> needles;
+    for (const QString &text : query.texts) {
+        needles.push_back(text.toStdString());
+        const std::string &needle = needles.back();
+        for (size_t i = 0; i + 3 <= needle.size(); ++i) {
+            andPostings(postingsOf(trigramPostings, trigramAt(needle, i)), rowCount, bits);
+        }
+        if (cancelled(generation)) {
+            return;
+        }
+    }
+
+    // 按行号分段确认子串并交出结果
+    for (int begin = 0; begin < rowCount || begin == 0; begin += kChunkRows) {
+        if (cancelled(generation)) {
+            return;
+        }
+        const int end = std::min(begin + kChunkRows, rowCount);
+        QVector<int> matches;
+        for (int word = begin / 64; word < (end + 63) / 64; ++word) {
+            for (quint64 w = bits[word]; w != 0; w &= w - 1) {
+                const int row = word * 64 + PrefixTrie::popcount64((w & (~w + 1)) - 1);
+                const std::string &text = texts[row];
+                const bool ok = std::all_of(needles.begin(), needles.end(), [&](const std::string &needle) {
+                    return text.find(needle) != std::string::npos;
+                });
+                if (ok) {
+                    matches.append(row);
+                }
+            }
+        }
+        const bool finished = end >= rowCount;
+        if (!matches.isEmpty() || finished) {
+            emit matchesFound(generation, matches, finished);
+        }
+        if (finished) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include "AnalysisTypes.h"
+#include <QObject>
+#include <QVector>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 结果表的搜索条件, 空格分隔的各项同时满足:
+//   IP地址或网段 (10.0.0.0/8、2001:db8::/32); 不完整的IPv4 (192.168.) 按已写出的段作为前缀
+//   纯数字为源或目的端口
+//   协议名 (TCP、UDP、HTTP 等), 与协议列的显示一致, 不区分大小写
+//   其它文字在流量类型列中查找 (HTTP主机名、TLS SNI 等), 不区分大小写
+struct SearchQuery
+{
+    struct Prefix
+    {
+        IpAddress prefix;
+        int length = 0; // 128位长度
+    };
+
+    std::vector<Prefix> prefixes;
+    std::vector<quint16> ports;
+    std::vector<QString> protocols; // 大写, 与 protocolName 比较
+    std::vector<QString> texts;     // 小写
+
+    static SearchQuery parse(const QString &text);
+    bool isEmpty() const { return prefixes.empty() && ports.empty() && protocols.empty() && texts.empty(); }
+    // 不经过索引直接判断一行, 用于查询开始之后追加的行
+    bool matches(const ResultRow &row) const;
+};
+
+// 结果表的搜索索引, 随结果行追加增量维护, 查询在后台线程进行。
+// 地址按 (地址, 行号) 排好序, 新行先放在未排序的尾部, 攒够一批后排序并归并进去;
+// 端口和协议是按行号递增的倒排表; 流量类型文字按UTF-8字节三元组建倒排表, 查询时先用三元组求交
+// 得到候选行, 再逐行确认子串。
+// 索引只由工作线程访问, 追加、清空和查询按提交顺序排队执行; 新的查询或清空使进行中的查询作废,
+// 查询按行号分段确认, 每段的结果通过 matchesFound 交回界面线程
+class SearchIndex final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(QObject *parent = nullptr);
+    ~SearchIndex() override;
+
+    SearchIndex(const SearchIndex &) = delete;
+    SearchIndex &operator=(const SearchIndex &) = delete;
+
+    // 行号接着已追加的行
+    void append(const QVector<ResultRow> &rows);
+    void clear();
+    // 在前 rowCount 行中查询, 返回这次查询的编号; 之前还没完成的查询作废
+    quint64 search(const SearchQuery &query, int rowCount);
+    void cancel();
+
+signals:
+    // 按行号递增分段交出; finished 为真时这次查询结束
+    void matchesFound(quint64 generation, const QVector<int> &rows, bool finished);
+
+private:
+    struct IndexedRow
+    {
+        IpAddress srcIp;
+        IpAddress dstIp;
+        quint16 srcPort = 0;
+        quint16 dstPort = 0;
+        quint16 protocol = 0; // (l4Proto << 8) | app
+        QString text;
+    };
+
+    struct AddressEntry
+    {
+        IpAddress address;
+        quint32 row = 0;
+
+        bool operator<(const AddressEntry &o) const
+        {
+            return address < o.address || (address == o.address && row < o.row);
+        }
+    };
+
+    struct Task
+    {
+        enum Kind { Append, Clear, Search } kind = Append;
+        std::vector<IndexedRow> rows;
+        SearchQuery query;
+        int rowCount = 0;
+        quint64 generation = 0;
+    };
+
+    using Bits = std::vector<quint64>;
+
+    void workLoop();
+    void addRows(const std::vector<IndexedRow> &rows);
+    void resetIndex();
+    void runSearch(const Task &task);
+    bool cancelled(quint64 generation) const { return latestGeneration.load() != generation; }
+    bool matchPrefix(const SearchQuery::Prefix &prefix, int rowCount, Bits &bits, quint64 generation) const;
+    static void andPostings(const std::vector<quint32> &postings, int rowCount, Bits &bits);
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Task> tasks;
+    bool stopping = false;
+    std::atomic<quint64> latestGeneration{0};
+    quint64 chargedBytes = 0; // 已计入全局内存预算的字节数, 只由界面线程访问
+
+    // 以下只由工作线程访问
+    quint32 rowTotal = 0;
+    std::vector<AddressEntry> sortedAddresses;
+    std::vector<AddressEntry> recentAddresses;
+    std::unordered_map<quint16, std::vector<quint32>> portPostings;
+    std::unordered_map<quint16, std::vector<quint32>> protocolPostings;
+    std::unordered_map<quint32, std::vector<quint32>> trigramPostings;
+    std::vector<std::string> texts;
+};
+
+#endif // SEARCHINDEX_H
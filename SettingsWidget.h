@@ -16,9 +16,11 @@
 #include <QSlider>
 #include <QPushButton>
 #include <QTabWidget>
+#include <QTableWidget>
 #include <QSettings>
 #include <QColorDialog>
 #include <QFontDialog>
+#include "AnalysisTypes.h"
 
 class SettingsWidget : public QWidget
 {
@@ -44,11 +46,31 @@ public:
     bool isProxyEnabled() const;
     QString getProxyHost() const;
     int getProxyPort() const;
+    QString getHostsFile() const;
+    QString getGeoDatabasePath() const;
+    QVector<SubnetGroup> getSubnetGroups() const;
     QString getLogLevel() const;
     bool isAutoExportEnabled() const;
     QString getExportPath() const;
     bool isDebugModeEnabled() const;
-    int getBufferSize() const;
+    int getMemoryBudgetMb() const;
+    int getFragmentMemoryMb() const;
+    SamplingMode getSamplingMode() const;
+    int getSamplingRate() const;
+    bool isSamplingPerFlow() const;
+    int getDecodeThreads() const;
+    FileReadMode getFileReadMode() const;
+    // 为空时不加载协议解析插件
+    QString getPluginDirectory() const;
+    bool isRecordingEnabled() const;
+    // 未开启录制时 directory 为空
+    RecordOptions getRecordOptions() const;
+    // 未开启检查点时 path 为空
+    CheckpointOptions getCheckpointOptions() const;
+    // 直接读已保存的检查点设置, 不需要先创建设置页; 启动时用来提前读取检查点
+    static CheckpointOptions savedCheckpointOptions();
+    // 自动导出对应导出目录下的文件, 其余为标准输出、UNIX套接字和系统日志; 都没开启时为空
+    QVector<OutputSinkOptions> getOutputSinks() const;
 
 public slots:
     // --- Public Setters to programmatically update UI and settings ---
@@ -67,11 +89,21 @@ public slots:
     void setProxyEnabled(bool enabled);
     void setProxyHost(const QString &host);
     void setProxyPort(int port);
+    void setHostsFile(const QString &path);
+    void setGeoDatabasePath(const QString &path);
+    void setSubnetGroups(const QVector<SubnetGroup> &groups);
     void setLogLevel(const QString &level);
     void setAutoExport(bool enabled);
     void setExportPath(const QString &path);
     void setDebugMode(bool enabled);
-    void setBufferSize(int size);
+    void setMemoryBudgetMb(int megabytes);
+    void setFragmentMemoryMb(int megabytes);
+    void setSampling(SamplingMode mode, int rate, bool perFlow);
+    void setDecodeThreads(int threads);
+    void setFileReadMode(FileReadMode mode);
+    void setPluginDirectory(const QString &path);
+    void setRecording(bool enabled, const RecordOptions &options);
+    void setCheckpoint(bool enabled, int intervalSeconds);
 
     // --- Import/Export functionality ---
     void importSettings();
@@ -94,6 +126,12 @@ private slots:
     void onAutoExportToggled(bool enabled);
     void onExportPathChanged();
     void onBrowseExportPath();
+    void onBrowseRecordDirectory();
+    void onBrowsePluginDirectory();
+    void onBrowseHostsFile();
+    void onImportGeoCsv();
+    void onAddSubnetGroup();
+    void onRemoveSubnetGroup();
     void onCustomColorClicked();
     void onFontSettingsClicked();
     void onResetToDefaults();
@@ -141,14 +179,46 @@ private:
     QLineEdit *proxyHostEdit;
     QSpinBox *proxyPortSpin;
     QCheckBox *proxyEnabledCheckBox;
+    QLineEdit *hostsFileEdit;
+    QPushButton *browseHostsBtn;
+    QLineEdit *geoDatabaseEdit;
+    QPushButton *importGeoBtn;
+    QTableWidget *subnetGroupTable;
+    QPushButton *addSubnetGroupBtn;
+    QPushButton *removeSubnetGroupBtn;
 
     // Advanced Settings
     QComboBox *logLevelCombo;
     QCheckBox *autoExportCheckBox;
     QLineEdit *exportPathEdit;
     QPushButton *browseExportBtn;
+    QComboBox *exportFormatCombo;
+    QCheckBox *outputPacketsCheckBox;
+    QCheckBox *outputFlowsCheckBox;
+    QCheckBox *outputAlertsCheckBox;
+    QCheckBox *outputStdoutCheckBox;
+    QCheckBox *outputSocketCheckBox;
+    QLineEdit *outputSocketEdit;
+    QCheckBox *outputSyslogCheckBox;
     QCheckBox *debugModeCheckBox;
-    QSpinBox *bufferSizeSpin;
+    QSpinBox *memoryBudgetSpin;
+    QSpinBox *fragmentMemorySpin;
+    QComboBox *samplingModeCombo;
+    QSpinBox *samplingRateSpin;
+    QComboBox *samplingUnitCombo;
+    QSpinBox *decodeThreadsSpin;
+    QComboBox *fileReadModeCombo;
+    QLineEdit *pluginDirectoryEdit;
+    QPushButton *browsePluginBtn;
+    QCheckBox *recordCheckBox;
+    QLineEdit *recordDirectoryEdit;
+    QPushButton *browseRecordBtn;
+    QCheckBox *recordFilteredCheckBox;
+    QSpinBox *recordFileSizeSpin;
+    QSpinBox *recordFileSecondsSpin;
+    QSpinBox *recordTotalSpin;
+    QCheckBox *checkpointCheckBox;
+    QSpinBox *checkpointIntervalSpin;
 
     // Buttons
     QPushButton *resetBtn;
@@ -163,6 +233,8 @@ private:
     QColor customThemeColor;
     QFont appFont;
     QString defaultStyleSheet;
+    QColor customStyleColor; // customStyleSheet 对应的主色, 颜色不变时不重新生成
+    QString customStyleSheet;
 };
 
 #endif // SETTINGSWIDGET_H
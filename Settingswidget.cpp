@@ -1,4 +1,6 @@
 #include "SettingsWidget.h"
+#include "GeoDatabaseBuilder.h"
+#include "SubnetGroupMap.h"
 #include <QApplication>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -9,6 +11,9 @@
 #include <QRegularExpression>
 #include <QFileInfo>
 #include <QStyle>
+#include <QHeaderView>
+#include <QPointer>
+#include <QThread>
 
 SettingsWidget::SettingsWidget(QWidget *parent)
     : QWidget(parent)
@@ -277,6 +282,7 @@ void SettingsWidget::setupNetworkTab()
     timeoutSpin->setValue(30);
     timeoutSpin->setSuffix(" 秒");
     monitorLayout->addWidget(timeoutSpin, 2, 1);
+    timeoutSpin->setToolTip("流空闲超过该时间即结束并导出到流记录, 按数据包时间计算");
 
     // 代理设置组
     auto *proxyGroup = new QGroupBox("代理设置");
@@ -303,8 +309,53 @@ void SettingsWidget::setupNetworkTab()
         proxyPortSpin->setEnabled(enabled);
     });
 
+    // 地址信息组
+    auto *namesGroup = new QGroupBox("地址信息");
+    auto *namesLayout = new QGridLayout(namesGroup);
+
+    namesLayout->addWidget(new QLabel("主机名文件:"), 0, 0);
+    hostsFileEdit = new QLineEdit();
+    hostsFileEdit->setPlaceholderText("hosts格式, 每行 \"地址 名称\", 留空则只显示IP");
+    namesLayout->addWidget(hostsFileEdit, 0, 1);
+
+    browseHostsBtn = new QPushButton("浏览");
+    namesLayout->addWidget(browseHostsBtn, 0, 2);
+    connect(browseHostsBtn, &QPushButton::clicked, this, &SettingsWidget::onBrowseHostsFile);
+
+    namesLayout->addWidget(new QLabel("ASN/地理库:"), 1, 0);
+    geoDatabaseEdit = new QLineEdit();
+    geoDatabaseEdit->setPlaceholderText("由CSV导入生成的 .ipdb 文件, 留空则不显示ASN和国家");
+    namesLayout->addWidget(geoDatabaseEdit, 1, 1);
+
+    importGeoBtn = new QPushButton("导入CSV...");
+    importGeoBtn->setToolTip("每行 \"网段,ASN,国家\" 或 \"起始地址,结束地址,ASN,国家\"");
+    namesLayout->addWidget(importGeoBtn, 1, 2);
+    connect(importGeoBtn, &QPushButton::clicked, this, &SettingsWidget::onImportGeoCsv);
+
+    // 网段分组组
+    auto *subnetGroup = new QGroupBox("网段分组");
+    auto *subnetLayout = new QGridLayout(subnetGroup);
+
+    subnetGroupTable = new QTableWidget(0, 2);
+    subnetGroupTable->setHorizontalHeaderLabels({"名称", "网段 (逗号分隔)"});
+    subnetGroupTable->horizontalHeader()->setStretchLastSection(true);
+    subnetGroupTable->verticalHeader()->setVisible(false);
+    subnetGroupTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    subnetGroupTable->setToolTip("例如 DMZ: 10.1.0.0/16, 2001:db8:1::/48; 网段重叠时按最长前缀归类");
+    subnetLayout->addWidget(subnetGroupTable, 0, 0, 3, 1);
+
+    addSubnetGroupBtn = new QPushButton("添加");
+    subnetLayout->addWidget(addSubnetGroupBtn, 0, 1);
+    connect(addSubnetGroupBtn, &QPushButton::clicked, this, &SettingsWidget::onAddSubnetGroup);
+
+    removeSubnetGroupBtn = new QPushButton("删除");
+    subnetLayout->addWidget(removeSubnetGroupBtn, 1, 1);
+    connect(removeSubnetGroupBtn, &QPushButton::clicked, this, &SettingsWidget::onRemoveSubnetGroup);
+
     layout->addWidget(monitorGroup);
     layout->addWidget(proxyGroup);
+    layout->addWidget(namesGroup);
+    layout->addWidget(subnetGroup);
     layout->addStretch();
 
     tabWidget->addTab(networkTab, "网络");
@@ -332,6 +383,8 @@ void SettingsWidget::setupAdvancedTab()
     auto *exportLayout = new QGridLayout(exportGroup);
 
     autoExportCheckBox = new QCheckBox("自动导出分析结果");
+    autoExportCheckBox->setToolTip("分析时把记录连续写入导出目录下的新文件。每个输出目的地有自己的队列, "
+                                   "写入跟不上时丢弃记录并计数, 不会拖慢分析");
     exportLayout->addWidget(autoExportCheckBox, 0, 0, 1, 3);
     connect(autoExportCheckBox, &QCheckBox::toggled, this, &SettingsWidget::onAutoExportToggled);
 
@@ -347,6 +400,44 @@ void SettingsWidget::setupAdvancedTab()
     exportLayout->addWidget(browseExportBtn, 1, 2);
     connect(browseExportBtn, &QPushButton::clicked, this, &SettingsWidget::onBrowseExportPath);
 
+    exportLayout->addWidget(new QLabel("导出格式:"), 2, 0);
+    exportFormatCombo = new QComboBox();
+    exportFormatCombo->addItems({"CSV", "NDJSON", "二进制"}); // 顺序与 OutputFormat 一致
+    exportFormatCombo->setEnabled(false);
+    exportLayout->addWidget(exportFormatCombo, 2, 1);
+
+    exportLayout->addWidget(new QLabel("输出内容:"), 3, 0);
+    auto *recordsLayout = new QHBoxLayout();
+    outputPacketsCheckBox = new QCheckBox("数据包");
+    outputPacketsCheckBox->setToolTip("每个数据包一条记录, 不受结果表行数和内存预算的限制");
+    outputFlowsCheckBox = new QCheckBox("流记录");
+    outputAlertsCheckBox = new QCheckBox("安全告警");
+    for (QCheckBox *box : {outputPacketsCheckBox, outputFlowsCheckBox, outputAlertsCheckBox}) {
+        box->setChecked(true);
+        recordsLayout->addWidget(box);
+    }
+    recordsLayout->addStretch();
+    exportLayout->addLayout(recordsLayout, 3, 1, 1, 2);
+
+    outputStdoutCheckBox = new QCheckBox("同时以NDJSON输出到标准输出");
+    exportLayout->addWidget(outputStdoutCheckBox, 4, 0, 1, 3);
+
+    outputSocketCheckBox = new QCheckBox("发送到UNIX套接字:");
+    outputSocketCheckBox->setToolTip("以NDJSON发送, 对端不在或断开时丢弃记录, 每秒重连一次");
+    exportLayout->addWidget(outputSocketCheckBox, 5, 0);
+    outputSocketEdit = new QLineEdit();
+    outputSocketEdit->setPlaceholderText("/run/traffic-analyzer.sock");
+    outputSocketEdit->setEnabled(false);
+    exportLayout->addWidget(outputSocketEdit, 5, 1, 1, 2);
+    connect(outputSocketCheckBox, &QCheckBox::toggled, outputSocketEdit, &QLineEdit::setEnabled);
+
+    outputSyslogCheckBox = new QCheckBox("安全告警写入系统日志 (syslog)");
+    exportLayout->addWidget(outputSyslogCheckBox, 6, 0, 1, 3);
+#ifdef _WIN32
+    outputSocketCheckBox->setEnabled(false);
+    outputSyslogCheckBox->setEnabled(false);
+#endif
+
     // 高级选项组
     auto *advancedGroup = new QGroupBox("高级选项");
     auto *advancedLayout = new QGridLayout(advancedGroup);
@@ -354,12 +445,149 @@ void SettingsWidget::setupAdvancedTab()
     debugModeCheckBox = new QCheckBox("启用调试模式");
     advancedLayout->addWidget(debugModeCheckBox, 0, 0);
 
-    advancedLayout->addWidget(new QLabel("缓冲区大小 (KB):"), 1, 0);
-    bufferSizeSpin = new QSpinBox();
-    bufferSizeSpin->setRange(64, 4096);
-    bufferSizeSpin->setValue(512);
-    bufferSizeSpin->setSuffix(" KB");
-    advancedLayout->addWidget(bufferSizeSpin, 1, 1);
+    advancedLayout->addWidget(new QLabel("内存预算 (MB):"), 1, 0);
+    memoryBudgetSpin = new QSpinBox();
+    memoryBudgetSpin->setRange(64, 65536);
+    memoryBudgetSpin->setValue(512);
+    memoryBudgetSpin->setSuffix(" MB");
+    memoryBudgetSpin->setToolTip("流表、分片重组缓存和结果行共用的内存上限, 用完后新的流不再跟踪、结果行丢弃并计数");
+    advancedLayout->addWidget(memoryBudgetSpin, 1, 1);
+
+    advancedLayout->addWidget(new QLabel("分片重组内存 (MB):"), 2, 0);
+    fragmentMemorySpin = new QSpinBox();
+    fragmentMemorySpin->setRange(0, 1024);
+    fragmentMemorySpin->setValue(64);
+    fragmentMemorySpin->setSuffix(" MB");
+    fragmentMemorySpin->setSpecialValueText("不重组");
+    fragmentMemorySpin->setToolTip("IPv4/IPv6分片重组缓存的上限, 超出时丢弃最早的未完成数据报");
+    advancedLayout->addWidget(fragmentMemorySpin, 2, 1);
+
+    advancedLayout->addWidget(new QLabel("过载采样:"), 3, 0);
+    samplingModeCombo = new QComboBox();
+    samplingModeCombo->addItem("关闭", static_cast<int>(SamplingMode::Off));
+    samplingModeCombo->addItem("固定 1/N", static_cast<int>(SamplingMode::Fixed));
+    samplingModeCombo->addItem("自适应", static_cast<int>(SamplingMode::Adaptive));
+    samplingModeCombo->setToolTip("自适应模式按抓包接收队列的占用在不采样和 1/N 之间调整; 采样时统计和图表都是估计值");
+    advancedLayout->addWidget(samplingModeCombo, 3, 1);
+
+    advancedLayout->addWidget(new QLabel("采样率 1/N:"), 4, 0);
+    samplingRateSpin = new QSpinBox();
+    samplingRateSpin->setRange(2, 1024);
+    samplingRateSpin->setValue(16);
+    samplingRateSpin->setToolTip("固定模式的采样率, 自适应模式的上限 (取不超过它的2的幂)");
+    advancedLayout->addWidget(samplingRateSpin, 4, 1);
+
+    advancedLayout->addWidget(new QLabel("采样单位:"), 5, 0);
+    samplingUnitCombo = new QComboBox();
+    samplingUnitCombo->addItems({"按流", "按包"});
+    samplingUnitCombo->setToolTip("按流采样保留完整的流, 流记录和TLS识别不受影响; 按包采样的计数误差更小");
+    advancedLayout->addWidget(samplingUnitCombo, 5, 1);
+    auto updateSamplingControls = [this]() {
+        const bool enabled = getSamplingMode() != SamplingMode::Off;
+        samplingRateSpin->setEnabled(enabled);
+        samplingUnitCombo->setEnabled(enabled);
+    };
+    connect(samplingModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, updateSamplingControls);
+    updateSamplingControls();
+
+    advancedLayout->addWidget(new QLabel("解码线程:"), 6, 0);
+    decodeThreadsSpin = new QSpinBox();
+    decodeThreadsSpin->setRange(0, 64);
+    decodeThreadsSpin->setSpecialValueText("自动");
+    decodeThreadsSpin->setValue(0);
+    decodeThreadsSpin->setToolTip("分析单个大于64MB的抓包文件时并行解码的线程数, 1 表示不并行");
+    advancedLayout->addWidget(decodeThreadsSpin, 6, 1);
+
+    advancedLayout->addWidget(new QLabel("文件读取方式:"), 7, 0);
+    fileReadModeCombo = new QComboBox();
+    fileReadModeCombo->addItem("内存映射", static_cast<int>(FileReadMode::Mmap));
+    fileReadModeCombo->addItem("io_uring预读", static_cast<int>(FileReadMode::IoUring));
+    fileReadModeCombo->addItem("普通读取", static_cast<int>(FileReadMode::Buffered));
+    fileReadModeCombo->setToolTip("未压缩的抓包文件的读取方式。io_uring预读同时发起多个大块读取, "
+                                  "适合网络存储和冷缓存; 只有内存映射支持并行解码");
+    advancedLayout->addWidget(fileReadModeCombo, 7, 1);
+
+    advancedLayout->addWidget(new QLabel("协议解析插件目录:"), 8, 0);
+    pluginDirectoryEdit = new QLineEdit();
+    pluginDirectoryEdit->setText(QCoreApplication::applicationDirPath() + "/plugins");
+    pluginDirectoryEdit->setToolTip("目录下导出 ta_dissector_init 的动态库在启动时加载, 接口见 DissectorPlugin.h; "
+                                    "留空则不加载插件, 更换目录后下一次开始分析时生效");
+    browsePluginBtn = new QPushButton("浏览");
+    connect(browsePluginBtn, &QPushButton::clicked, this, &SettingsWidget::onBrowsePluginDirectory);
+    auto *pluginLayout = new QHBoxLayout();
+    pluginLayout->addWidget(pluginDirectoryEdit);
+    pluginLayout->addWidget(browsePluginBtn);
+    advancedLayout->addLayout(pluginLayout, 8, 1);
+
+    // 数据包录制组
+    auto *recordGroup = new QGroupBox("数据包录制");
+    auto *recordLayout = new QGridLayout(recordGroup);
+
+    recordCheckBox = new QCheckBox("分析时把原始数据包录制成pcap文件");
+    recordLayout->addWidget(recordCheckBox, 0, 0, 1, 3);
+
+    recordLayout->addWidget(new QLabel("录制目录:"), 1, 0);
+    recordDirectoryEdit = new QLineEdit();
+    recordDirectoryEdit->setText(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/captures");
+    recordLayout->addWidget(recordDirectoryEdit, 1, 1);
+    browseRecordBtn = new QPushButton("浏览");
+    recordLayout->addWidget(browseRecordBtn, 1, 2);
+    connect(browseRecordBtn, &QPushButton::clicked, this, &SettingsWidget::onBrowseRecordDirectory);
+
+    recordFilteredCheckBox = new QCheckBox("只录制符合协议过滤的包");
+    recordFilteredCheckBox->setToolTip("IP分片在重组前看不出协议, 总是录制");
+    recordLayout->addWidget(recordFilteredCheckBox, 2, 0, 1, 3);
+
+    recordLayout->addWidget(new QLabel("单个文件上限 (MB):"), 3, 0);
+    recordFileSizeSpin = new QSpinBox();
+    recordFileSizeSpin->setRange(1, 16384);
+    recordFileSizeSpin->setValue(256);
+    recordFileSizeSpin->setSuffix(" MB");
+    recordLayout->addWidget(recordFileSizeSpin, 3, 1);
+
+    recordLayout->addWidget(new QLabel("单个文件时长 (秒):"), 4, 0);
+    recordFileSecondsSpin = new QSpinBox();
+    recordFileSecondsSpin->setRange(0, 86400);
+    recordFileSecondsSpin->setValue(0);
+    recordFileSecondsSpin->setSpecialValueText("不限");
+    recordFileSecondsSpin->setToolTip("按数据包时间计算, 到时换新文件");
+    recordLayout->addWidget(recordFileSecondsSpin, 4, 1);
+
+    recordLayout->addWidget(new QLabel("磁盘预算 (MB):"), 5, 0);
+    recordTotalSpin = new QSpinBox();
+    recordTotalSpin->setRange(16, 1048576);
+    recordTotalSpin->setValue(4096);
+    recordTotalSpin->setSuffix(" MB");
+    recordTotalSpin->setToolTip("本次录制所有文件的总大小上限, 超出时删除最早的文件");
+    recordLayout->addWidget(recordTotalSpin, 5, 1);
+
+    auto updateRecordControls = [this](bool enabled) {
+        for (QWidget *widget : std::initializer_list<QWidget *>{recordDirectoryEdit, browseRecordBtn, recordFilteredCheckBox,
+                                                               recordFileSizeSpin, recordFileSecondsSpin, recordTotalSpin}) {
+            widget->setEnabled(enabled);
+        }
+    };
+    connect(recordCheckBox, &QCheckBox::toggled, this, updateRecordControls);
+    updateRecordControls(false);
+
+    // 检查点组
+    auto *checkpointGroup = new QGroupBox("检查点");
+    auto *checkpointLayout = new QGridLayout(checkpointGroup);
+
+    checkpointCheckBox = new QCheckBox("定期保存分析状态, 重启后恢复");
+    checkpointCheckBox->setToolTip("保存计数、流表、扫描检测状态和吞吐量历史, 不保存结果表。"
+                                   "对同一个数据源重新开始分析时从保存的位置继续");
+    checkpointLayout->addWidget(checkpointCheckBox, 0, 0, 1, 2);
+
+    checkpointLayout->addWidget(new QLabel("保存间隔 (秒):"), 1, 0);
+    checkpointIntervalSpin = new QSpinBox();
+    checkpointIntervalSpin->setRange(10, 3600);
+    checkpointIntervalSpin->setValue(60);
+    checkpointIntervalSpin->setSuffix(" 秒");
+    checkpointIntervalSpin->setToolTip("两次保存之间只写变化的部分, 增量积累多了再写一次完整状态");
+    checkpointLayout->addWidget(checkpointIntervalSpin, 1, 1);
+    connect(checkpointCheckBox, &QCheckBox::toggled, checkpointIntervalSpin, &QSpinBox::setEnabled);
+    checkpointIntervalSpin->setEnabled(false);
 
     // 导入/导出设置组
     auto *importExportGroup = new QGroupBox("导入/导出设置");
@@ -378,6 +606,8 @@ void SettingsWidget::setupAdvancedTab()
     layout->addWidget(logGroup);
     layout->addWidget(exportGroup);
     layout->addWidget(advancedGroup);
+    layout->addWidget(recordGroup);
+    layout->addWidget(checkpointGroup);
     layout->addWidget(importExportGroup);
     layout->addStretch();
 
@@ -408,14 +638,48 @@ void SettingsWidget::loadSettings()
     proxyEnabledCheckBox->setChecked(settings->value("proxyEnabled", false).toBool());
     proxyHostEdit->setText(settings->value("proxyHost", "").toString());
     proxyPortSpin->setValue(settings->value("proxyPort", 8080).toInt());
+    hostsFileEdit->setText(settings->value("hostsFile", "").toString());
+    geoDatabaseEdit->setText(settings->value("geoDatabase", "").toString());
+    QVector<SubnetGroup> groups;
+    const int groupCount = settings->beginReadArray("subnetGroups");
+    for (int i = 0; i < groupCount; ++i) {
+        settings->setArrayIndex(i);
+        groups.append({settings->value("name").toString(), settings->value("prefixes").toStringList()});
+    }
+    settings->endArray();
+    setSubnetGroups(groups);
 
     // 加载高级设置
     logLevelCombo->setCurrentText(settings->value("logLevel", "信息").toString());
     autoExportCheckBox->setChecked(settings->value("autoExport", false).toBool());
     exportPathEdit->setText(settings->value("exportPath",
         QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)).toString());
+    exportFormatCombo->setCurrentIndex(settings->value("exportFormat", static_cast<int>(OutputFormat::Csv)).toInt());
+    const int outputRecords = settings->value("outputRecords", OutputPackets | OutputFlows | OutputAlerts).toInt();
+    outputPacketsCheckBox->setChecked(outputRecords & OutputPackets);
+    outputFlowsCheckBox->setChecked(outputRecords & OutputFlows);
+    outputAlertsCheckBox->setChecked(outputRecords & OutputAlerts);
+    outputStdoutCheckBox->setChecked(settings->value("outputStdout", false).toBool());
+    outputSocketCheckBox->setChecked(settings->value("outputSocket", false).toBool());
+    outputSocketEdit->setText(settings->value("outputSocketPath", "").toString());
+    outputSyslogCheckBox->setChecked(settings->value("outputSyslog", false).toBool());
     debugModeCheckBox->setChecked(settings->value("debugMode", false).toBool());
-    bufferSizeSpin->setValue(settings->value("bufferSize", 512).toInt());
+    memoryBudgetSpin->setValue(settings->value("memoryBudgetMb", 512).toInt());
+    fragmentMemorySpin->setValue(settings->value("fragmentMemoryMb", 64).toInt());
+    setSampling(static_cast<SamplingMode>(settings->value("samplingMode", 0).toInt()),
+                settings->value("samplingRate", 16).toInt(), settings->value("samplingPerFlow", true).toBool());
+    decodeThreadsSpin->setValue(settings->value("decodeThreads", 0).toInt());
+    setFileReadMode(static_cast<FileReadMode>(settings->value("fileReadMode", 0).toInt()));
+    pluginDirectoryEdit->setText(settings->value("pluginDirectory", QCoreApplication::applicationDirPath() + "/plugins").toString());
+    RecordOptions record;
+    record.directory = settings->value("recordDirectory",
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/captures").toString();
+    record.filteredOnly = settings->value("recordFilteredOnly", false).toBool();
+    record.maxFileBytes = settings->value("recordFileMb", 256).toULongLong() * 1024 * 1024;
+    record.maxFileNs = settings->value("recordFileSeconds", 0).toULongLong() * 1000000000;
+    record.maxTotalBytes = settings->value("recordTotalMb", 4096).toULongLong() * 1024 * 1024;
+    setRecording(settings->value("recordEnabled", false).toBool(), record);
+    setCheckpoint(settings->value("checkpointEnabled", false).toBool(), settings->value("checkpointInterval", 60).toInt());
 
     // 应用加载的设置到UI
     applyTheme(themeCombo->currentText());
@@ -447,13 +711,48 @@ void SettingsWidget::saveSettings()
     settings->setValue("proxyEnabled", proxyEnabledCheckBox->isChecked());
     settings->setValue("proxyHost", proxyHostEdit->text());
     settings->setValue("proxyPort", proxyPortSpin->value());
+    settings->setValue("hostsFile", hostsFileEdit->text());
+    settings->setValue("geoDatabase", geoDatabaseEdit->text());
+    const QVector<SubnetGroup> groups = getSubnetGroups();
+    settings->remove("subnetGroups");
+    settings->beginWriteArray("subnetGroups", groups.size());
+    for (int i = 0; i < groups.size(); ++i) {
+        settings->setArrayIndex(i);
+        settings->setValue("name", groups[i].name);
+        settings->setValue("prefixes", groups[i].prefixes);
+    }
+    settings->endArray();
 
     // 保存高级设置
     settings->setValue("logLevel", logLevelCombo->currentText());
     settings->setValue("autoExport", autoExportCheckBox->isChecked());
     settings->setValue("exportPath", exportPathEdit->text());
+    settings->setValue("exportFormat", exportFormatCombo->currentIndex());
+    settings->setValue("outputRecords", (outputPacketsCheckBox->isChecked() ? OutputPackets : 0)
+                                            | (outputFlowsCheckBox->isChecked() ? OutputFlows : 0)
+                                            | (outputAlertsCheckBox->isChecked() ? OutputAlerts : 0));
+    settings->setValue("outputStdout", outputStdoutCheckBox->isChecked());
+    settings->setValue("outputSocket", outputSocketCheckBox->isChecked());
+    settings->setValue("outputSocketPath", outputSocketEdit->text());
+    settings->setValue("outputSyslog", outputSyslogCheckBox->isChecked());
     settings->setValue("debugMode", debugModeCheckBox->isChecked());
-    settings->setValue("bufferSize", bufferSizeSpin->value());
+    settings->remove("bufferSize"); // 旧版本的缓冲区大小, 已由内存预算取代
+    settings->setValue("memoryBudgetMb", memoryBudgetSpin->value());
+    settings->setValue("fragmentMemoryMb", fragmentMemorySpin->value());
+    settings->setValue("samplingMode", static_cast<int>(getSamplingMode()));
+    settings->setValue("samplingRate", samplingRateSpin->value());
+    settings->setValue("samplingPerFlow", isSamplingPerFlow());
+    settings->setValue("decodeThreads", decodeThreadsSpin->value());
+    settings->setValue("fileReadMode", static_cast<int>(getFileReadMode()));
+    settings->setValue("pluginDirectory", pluginDirectoryEdit->text());
+    settings->setValue("recordEnabled", recordCheckBox->isChecked());
+    settings->setValue("recordDirectory", recordDirectoryEdit->text());
+    settings->setValue("recordFilteredOnly", recordFilteredCheckBox->isChecked());
+    settings->setValue("recordFileMb", recordFileSizeSpin->value());
+    settings->setValue("recordFileSeconds", recordFileSecondsSpin->value());
+    settings->setValue("recordTotalMb", recordTotalSpin->value());
+    settings->setValue("checkpointEnabled", checkpointCheckBox->isChecked());
+    settings->setValue("checkpointInterval", checkpointIntervalSpin->value());
 
     settings->sync();
 }
@@ -486,6 +785,7 @@ void SettingsWidget::onAutoExportToggled(bool enabled)
 {
     exportPathEdit->setEnabled(enabled);
     browseExportBtn->setEnabled(enabled);
+    exportFormatCombo->setEnabled(enabled);
 }
 
 void SettingsWidget::onExportPathChanged() { /* Path validation logic can be added here */ }
@@ -498,6 +798,84 @@ void SettingsWidget::onBrowseExportPath()
     }
 }
 
+void SettingsWidget::onBrowseRecordDirectory()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, "选择录制目录", recordDirectoryEdit->text());
+    if (!dir.isEmpty()) {
+        recordDirectoryEdit->setText(dir);
+    }
+}
+
+void SettingsWidget::onBrowsePluginDirectory()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, "选择插件目录", pluginDirectoryEdit->text());
+    if (!dir.isEmpty()) {
+        pluginDirectoryEdit->setText(dir);
+    }
+}
+
+void SettingsWidget::onBrowseHostsFile()
+{
+    QString file = QFileDialog::getOpenFileName(this, "选择主机名文件", hostsFileEdit->text());
+    if (!file.isEmpty()) {
+        hostsFileEdit->setText(file);
+    }
+}
+
+void SettingsWidget::onImportGeoCsv()
+{
+    const QString csvPath = QFileDialog::getOpenFileName(this, "选择ASN/地理CSV", QString(), "CSV Files (*.csv);;All Files (*)");
+    if (csvPath.isEmpty()) {
+        return;
+    }
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    const QString imagePath = QDir(dir).filePath("geo.ipdb");
+
+    // 大文件编译需要几秒, 放到后台线程, 完成后回到界面线程更新
+    importGeoBtn->setEnabled(false);
+    importGeoBtn->setText("正在导入...");
+    QPointer<SettingsWidget> self(this);
+    QThread *worker = QThread::create([self, csvPath, imagePath]() {
+        QString error;
+        int prefixes = 0;
+        const bool ok = GeoDatabaseBuilder::compileCsv(csvPath, imagePath, &error, &prefixes);
+        QMetaObject::invokeMethod(qApp, [self, ok, error, prefixes, imagePath]() {
+            if (!self) {
+                return;
+            }
+            self->importGeoBtn->setEnabled(true);
+            self->importGeoBtn->setText("导入CSV...");
+            if (!ok) {
+                QMessageBox::warning(self, "导入失败", error);
+                return;
+            }
+            self->geoDatabaseEdit->setText(imagePath);
+            QMessageBox::information(self, "完成", QString("已导入 %1 个网段, 应用设置后生效").arg(prefixes));
+        }, Qt::QueuedConnection);
+    });
+    connect(worker, &QThread::finished, worker, &QObject::deleteLater);
+    worker->start();
+}
+
+void SettingsWidget::onAddSubnetGroup()
+{
+    const int row = subnetGroupTable->rowCount();
+    subnetGroupTable->insertRow(row);
+    subnetGroupTable->setItem(row, 0, new QTableWidgetItem(QString("分组%1").arg(row + 1)));
+    subnetGroupTable->setItem(row, 1, new QTableWidgetItem());
+    subnetGroupTable->setCurrentCell(row, 1);
+    subnetGroupTable->editItem(subnetGroupTable->item(row, 1));
+}
+
+void SettingsWidget::onRemoveSubnetGroup()
+{
+    const int row = subnetGroupTable->currentRow();
+    if (row >= 0) {
+        subnetGroupTable->removeRow(row);
+    }
+}
+
 void SettingsWidget::onCustomColorClicked()
 {
     QColor color = QColorDialog::getColor(customThemeColor, this, "选择自定义颜色");
@@ -547,10 +925,11 @@ void SettingsWidget::onCancelSettings()
 
 void SettingsWidget::applyTheme(const QString &themeName)
 {
+    // 样式表相同时不重新设置: setStyleSheet 会重新解析并重新套用整棵控件树的样式
     if (themeName == "自定义") {
         applyCustomTheme(customThemeColor);
     } else if (themeName == "深色主题") {
-        QString darkStyle = R"(
+        static const QString darkStyle = R"(
             QWidget { background-color: #2c3e50; color: #ecf0f1; font-family: 'Microsoft YaHei', Arial, sans-serif; }
             QGroupBox { border: 2px solid #34495e; }
             QGroupBox::title { color: #1abc9c; }
@@ -566,19 +945,15 @@ void SettingsWidget::applyTheme(const QString &themeName)
             QPushButton#applyBtn { background-color: #2ecc71; }
             QPushButton#cancelBtn, QPushButton#backBtn { background-color: #95a5a6; }
         )";
-        setStyleSheet(darkStyle);
-    } else { // 浅色主题 or 自动跟随系统
+        if (styleSheet() != darkStyle) {
+            setStyleSheet(darkStyle);
+        }
+    } else if (styleSheet() != defaultStyleSheet) { // 浅色主题 or 自动跟随系统
+        // 按钮自己的样式表不受这里影响, 不需要重新设置
         setStyleSheet(defaultStyleSheet);
-        // Re-apply specific styles that might have been lost
-        backBtn->setStyleSheet("QPushButton { background-color: #6c757d; margin: 10px 0; }");
-        resetBtn->setStyleSheet("QPushButton { background-color: #ffc107; color: #212529; }");
-        applyBtn->setStyleSheet("QPushButton { background-color: #28a745; }");
-        cancelBtn->setStyleSheet("QPushButton { background-color: #6c757d; }");
     }
-    // Ensure font and styles are correctly applied after stylesheet change
+    // setStyleSheet 已经重新套用了样式, 这里只需恢复字体
     setFont(appFont);
-    style()->unpolish(this);
-    style()->polish(this);
 }
 
 void SettingsWidget::updateLanguageUI()
@@ -600,6 +975,13 @@ void SettingsWidget::updateLanguageUI()
 
 void SettingsWidget::applyCustomTheme(const QColor &primaryColor)
 {
+    if (primaryColor == customStyleColor && !customStyleSheet.isEmpty()) {
+        if (styleSheet() != customStyleSheet) {
+            setStyleSheet(customStyleSheet);
+        }
+        return;
+    }
+
     // Generate a color scheme based on the primary color
     QColor lightColor = primaryColor.lighter(150);
     QColor darkColor = primaryColor.darker(150);
@@ -682,7 +1064,9 @@ void SettingsWidget::applyCustomTheme(const QColor &primaryColor)
     .arg(hoverColor.name())        // %5 - hover color
     .arg(pressedColor.name());     // %6 - pressed color
 
-    setStyleSheet(customThemeStyle);
+    customStyleColor = primaryColor;
+    customStyleSheet = customThemeStyle;
+    setStyleSheet(customStyleSheet);
 }
 
 void SettingsWidget::updateCustomColorButton(const QColor &color)
@@ -725,11 +1109,124 @@ int SettingsWidget::getTimeout() const { return timeoutSpin->value(); }
 bool SettingsWidget::isProxyEnabled() const { return proxyEnabledCheckBox->isChecked(); }
 QString SettingsWidget::getProxyHost() const { return proxyHostEdit->text(); }
 int SettingsWidget::getProxyPort() const { return proxyPortSpin->value(); }
+QString SettingsWidget::getHostsFile() const { return hostsFileEdit->text(); }
+QString SettingsWidget::getGeoDatabasePath() const { return geoDatabaseEdit->text(); }
+
+QVector<SubnetGroup> SettingsWidget::getSubnetGroups() const
+{
+    QVector<SubnetGroup> groups;
+    for (int row = 0; row < subnetGroupTable->rowCount(); ++row) {
+        const QTableWidgetItem *name = subnetGroupTable->item(row, 0);
+        const QTableWidgetItem *prefixes = subnetGroupTable->item(row, 1);
+        SubnetGroup group;
+        group.name = name ? name->text().trimmed() : QString();
+        for (const QString &prefix : (prefixes ? prefixes->text() : QString()).split(',')) {
+            if (!prefix.trimmed().isEmpty()) {
+                group.prefixes << prefix.trimmed();
+            }
+        }
+        if (!group.name.isEmpty() || !group.prefixes.isEmpty()) {
+            groups.append(group);
+        }
+    }
+    return groups;
+}
 QString SettingsWidget::getLogLevel() const { return logLevelCombo->currentText(); }
 bool SettingsWidget::isAutoExportEnabled() const { return autoExportCheckBox->isChecked(); }
 QString SettingsWidget::getExportPath() const { return exportPathEdit->text(); }
 bool SettingsWidget::isDebugModeEnabled() const { return debugModeCheckBox->isChecked(); }
-int SettingsWidget::getBufferSize() const { return bufferSizeSpin->value(); }
+int SettingsWidget::getMemoryBudgetMb() const { return memoryBudgetSpin->value(); }
+int SettingsWidget::getFragmentMemoryMb() const { return fragmentMemorySpin->value(); }
+SamplingMode SettingsWidget::getSamplingMode() const { return static_cast<SamplingMode>(samplingModeCombo->currentData().toInt()); }
+int SettingsWidget::getSamplingRate() const { return samplingRateSpin->value(); }
+bool SettingsWidget::isSamplingPerFlow() const { return samplingUnitCombo->currentIndex() == 0; }
+int SettingsWidget::getDecodeThreads() const { return decodeThreadsSpin->value(); }
+FileReadMode SettingsWidget::getFileReadMode() const { return static_cast<FileReadMode>(fileReadModeCombo->currentData().toInt()); }
+QString SettingsWidget::getPluginDirectory() const { return pluginDirectoryEdit->text().trimmed(); }
+bool SettingsWidget::isRecordingEnabled() const { return recordCheckBox->isChecked(); }
+
+RecordOptions SettingsWidget::getRecordOptions() const
+{
+    RecordOptions options;
+    if (isRecordingEnabled()) {
+        options.directory = recordDirectoryEdit->text().trimmed();
+    }
+    options.filteredOnly = recordFilteredCheckBox->isChecked();
+    options.maxFileBytes = static_cast<quint64>(recordFileSizeSpin->value()) * 1024 * 1024;
+    options.maxFileNs = static_cast<quint64>(recordFileSecondsSpin->value()) * 1000000000;
+    options.maxTotalBytes = static_cast<quint64>(recordTotalSpin->value()) * 1024 * 1024;
+    return options;
+}
+
+namespace {
+
+QString checkpointPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/analysis.ckpt";
+}
+
+} // namespace
+
+CheckpointOptions SettingsWidget::getCheckpointOptions() const
+{
+    CheckpointOptions options;
+    if (checkpointCheckBox->isChecked()) {
+        options.path = checkpointPath();
+    }
+    options.intervalSeconds = static_cast<quint32>(checkpointIntervalSpin->value());
+    return options;
+}
+
+CheckpointOptions SettingsWidget::savedCheckpointOptions()
+{
+    // 键和默认值与 loadSettings 一致
+    QSettings saved("NetworkAnalyzer", "Settings");
+    CheckpointOptions options;
+    if (saved.value("checkpointEnabled", false).toBool()) {
+        options.path = checkpointPath();
+    }
+    options.intervalSeconds = static_cast<quint32>(saved.value("checkpointInterval", 60).toInt());
+    return options;
+}
+
+QVector<OutputSinkOptions> SettingsWidget::getOutputSinks() const
+{
+    QVector<OutputSinkOptions> sinks;
+    OutputSinkOptions sink;
+    sink.records = (outputPacketsCheckBox->isChecked() ? OutputPackets : 0)
+                   | (outputFlowsCheckBox->isChecked() ? OutputFlows : 0)
+                   | (outputAlertsCheckBox->isChecked() ? OutputAlerts : 0);
+    if (sink.records != 0) {
+        // 文件保留较早的连续数据; 管道和套接字看的是实时数据, 积压时丢弃最旧的
+        if (isAutoExportEnabled()) {
+            sink.target = OutputTarget::File;
+            sink.format = static_cast<OutputFormat>(exportFormatCombo->currentIndex());
+            sink.path = getExportPath();
+            sink.dropPolicy = OutputDropPolicy::DropNewest;
+            sinks.append(sink);
+        }
+        sink.format = OutputFormat::Ndjson;
+        sink.dropPolicy = OutputDropPolicy::DropOldest;
+        if (outputStdoutCheckBox->isChecked()) {
+            sink.target = OutputTarget::Stdout;
+            sink.path.clear();
+            sinks.append(sink);
+        }
+        if (outputSocketCheckBox->isChecked() && !outputSocketEdit->text().trimmed().isEmpty()) {
+            sink.target = OutputTarget::UnixSocket;
+            sink.path = outputSocketEdit->text().trimmed();
+            sinks.append(sink);
+        }
+    }
+    if (outputSyslogCheckBox->isChecked()) {
+        OutputSinkOptions alerts;
+        alerts.target = OutputTarget::Syslog;
+        alerts.records = OutputAlerts;
+        alerts.dropPolicy = OutputDropPolicy::DropOldest;
+        sinks.append(alerts);
+    }
+    return sinks;
+}
 
 // --- Setter functions for programmatically updating settings ---
 
@@ -761,11 +1258,61 @@ void SettingsWidget::setTimeout(int timeout) { timeoutSpin->setValue(timeout); }
 void SettingsWidget::setProxyEnabled(bool enabled) { proxyEnabledCheckBox->setChecked(enabled); }
 void SettingsWidget::setProxyHost(const QString &host) { proxyHostEdit->setText(host); }
 void SettingsWidget::setProxyPort(int port) { proxyPortSpin->setValue(port); }
+void SettingsWidget::setHostsFile(const QString &path) { hostsFileEdit->setText(path); }
+void SettingsWidget::setGeoDatabasePath(const QString &path) { geoDatabaseEdit->setText(path); }
+
+void SettingsWidget::setSubnetGroups(const QVector<SubnetGroup> &groups)
+{
+    subnetGroupTable->setRowCount(0);
+    for (const SubnetGroup &group : groups) {
+        const int row = subnetGroupTable->rowCount();
+        subnetGroupTable->insertRow(row);
+        subnetGroupTable->setItem(row, 0, new QTableWidgetItem(group.name));
+        subnetGroupTable->setItem(row, 1, new QTableWidgetItem(group.prefixes.join(", ")));
+    }
+}
 void SettingsWidget::setLogLevel(const QString &level) { logLevelCombo->setCurrentText(level); }
 void SettingsWidget::setAutoExport(bool enabled) { autoExportCheckBox->setChecked(enabled); }
 void SettingsWidget::setExportPath(const QString &path) { exportPathEdit->setText(path); }
 void SettingsWidget::setDebugMode(bool enabled) { debugModeCheckBox->setChecked(enabled); }
-void SettingsWidget::setBufferSize(int size) { bufferSizeSpin->setValue(size); }
+void SettingsWidget::setMemoryBudgetMb(int megabytes) { memoryBudgetSpin->setValue(megabytes); }
+void SettingsWidget::setFragmentMemoryMb(int megabytes) { fragmentMemorySpin->setValue(megabytes); }
+
+void SettingsWidget::setSampling(SamplingMode mode, int rate, bool perFlow)
+{
+    const int index = samplingModeCombo->findData(static_cast<int>(mode));
+    samplingModeCombo->setCurrentIndex(index >= 0 ? index : 0);
+    samplingRateSpin->setValue(rate);
+    samplingUnitCombo->setCurrentIndex(perFlow ? 0 : 1);
+}
+
+void SettingsWidget::setDecodeThreads(int threads) { decodeThreadsSpin->setValue(threads); }
+
+void SettingsWidget::setFileReadMode(FileReadMode mode)
+{
+    const int index = fileReadModeCombo->findData(static_cast<int>(mode));
+    fileReadModeCombo->setCurrentIndex(index >= 0 ? index : 0);
+}
+
+void SettingsWidget::setPluginDirectory(const QString &path) { pluginDirectoryEdit->setText(path); }
+
+void SettingsWidget::setRecording(bool enabled, const RecordOptions &options)
+{
+    recordCheckBox->setChecked(enabled);
+    if (!options.directory.isEmpty()) {
+        recordDirectoryEdit->setText(options.directory);
+    }
+    recordFilteredCheckBox->setChecked(options.filteredOnly);
+    recordFileSizeSpin->setValue(static_cast<int>(options.maxFileBytes / (1024 * 1024)));
+    recordFileSecondsSpin->setValue(static_cast<int>(options.maxFileNs / 1000000000));
+    recordTotalSpin->setValue(static_cast<int>(options.maxTotalBytes / (1024 * 1024)));
+}
+
+void SettingsWidget::setCheckpoint(bool enabled, int intervalSeconds)
+{
+    checkpointCheckBox->setChecked(enabled);
+    checkpointIntervalSpin->setValue(intervalSeconds);
+}
 
 // --- Utility Functions ---
 bool SettingsWidget::validateSettings()
@@ -788,6 +1335,48 @@ bool SettingsWidget::validateSettings()
         }
     }
 
+    const bool anyOutput = isAutoExportEnabled() || outputStdoutCheckBox->isChecked() || outputSocketCheckBox->isChecked();
+    if (anyOutput && !outputPacketsCheckBox->isChecked() && !outputFlowsCheckBox->isChecked()
+        && !outputAlertsCheckBox->isChecked()) {
+        QMessageBox::warning(this, "设置错误", "开启导出或输出时至少要选择一种输出内容。");
+        return false;
+    }
+    if (outputSocketCheckBox->isChecked() && outputSocketEdit->text().trimmed().isEmpty()) {
+        QMessageBox::warning(this, "设置错误", "发送到UNIX套接字时必须填写套接字路径。");
+        return false;
+    }
+
+    // 录制目录不存在时在开始录制时创建
+    if (isRecordingEnabled()) {
+        if (recordDirectoryEdit->text().trimmed().isEmpty()) {
+            QMessageBox::warning(this, "设置错误", "开启录制时必须填写录制目录。");
+            return false;
+        }
+        if (recordTotalSpin->value() < recordFileSizeSpin->value()) {
+            QMessageBox::warning(this, "设置错误", "录制的磁盘预算不能小于单个文件上限。");
+            return false;
+        }
+    }
+
+    const QVector<SubnetGroup> groups = getSubnetGroups();
+    for (const SubnetGroup &group : groups) {
+        if (group.name.isEmpty()) {
+            QMessageBox::warning(this, "设置错误", "网段分组必须填写名称。");
+            return false;
+        }
+    }
+    if (getFragmentMemoryMb() > getMemoryBudgetMb()) {
+        QMessageBox::warning(this, "设置错误", "分片重组内存不能超过内存预算。");
+        return false;
+    }
+
+    QStringList groupErrors;
+    SubnetGroupMap::compile(groups, &groupErrors);
+    if (!groupErrors.isEmpty()) {
+        QMessageBox::warning(this, "设置错误", "网段分组有误:\n" + groupErrors.join('\n'));
+        return false;
+    }
+
     QString dataSource = getDefaultDataSource();
     if (!dataSource.isEmpty()) {
         QRegularExpression ipRegex("^((25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\\.){3}(25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)$");
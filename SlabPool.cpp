@@ -0,0 +1,81 @@
+#include "SlabPool.h"
+#include <algorithm>
+
+SlabPool::SlabPool(std::size_t objectSize, MemoryBudget::Category category, MemoryBudget &budget)
+    : objectBytes((std::max(objectSize, sizeof(FreeNode)) + kAlignment - 1) & ~(kAlignment - 1))
+    , slabBytes(std::max(kSlabBytes, objectBytes))
+    , category(category)
+    , budget(budget)
+{
+}
+
+SlabPool::~SlabPool()
+{
+    for (void *slab : slabs) {
+        ::operator delete(slab);
+    }
+    budget.release(category, slabs.size() * slabBytes);
+    budget.addSlabs(category, -static_cast<std::int64_t>(slabs.size()));
+    budget.addObjects(category, -static_cast<std::int64_t>(liveObjects));
+}
+
+bool SlabPool::reserve()
+{
+    if (freeList != nullptr) {
+        return true;
+    }
+    if (!budget.tryCharge(category, slabBytes)) {
+        return false;
+    }
+    addSlab();
+    return true;
+}
+
+void *SlabPool::allocate()
+{
+    if (freeList == nullptr) {
+        budget.charge(category, slabBytes);
+        addSlab();
+    }
+    FreeNode *node = freeList;
+    freeList = node->next;
+    ++liveObjects;
+    budget.addObjects(category, 1);
+    return node;
+}
+
+void SlabPool::deallocate(void *p)
+{
+    auto *node = static_cast<FreeNode *>(p);
+    node->next = freeList;
+    freeList = node;
+    --liveObjects;
+    budget.addObjects(category, -1);
+}
+
+void *SlabPool::allocateLarge(std::size_t bytes)
+{
+    budget.charge(category, bytes);
+    return ::operator new(bytes);
+}
+
+void SlabPool::deallocateLarge(void *p, std::size_t bytes)
+{
+    budget.release(category, bytes);
+    ::operator delete(p);
+}
+
+void SlabPool::addSlab()
+{
+    // 调用方已经记过账
+    auto *slab = static_cast<unsigned char *>(::operator new(slabBytes));
+    slabs.push_back(slab);
+    budget.addSlabs(category, 1);
+    // 倒序挂链, 分配时按地址递增取用
+    for (std::size_t offset = slabBytes / objectBytes * objectBytes; offset > 0;) {
+        offset -= objectBytes;
+        auto *node = reinterpret_cast<FreeNode *>(slab + offset);
+        node->next = freeList;
+        freeList = node;
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef SLABPOOL_H
+#define SLABPOOL_H
+
+#include "MemoryBudget.h"
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// 固定大小对象的slab池: 每次向系统申请一整块 (默认64KB) 再切成等长的对象,
+// 释放的对象挂回空闲链表, 热路径上不再调用 malloc。每种对象 (流记录等) 用自己的池,
+// 对象大小就是它的尺寸等级。池不加锁, 只能由创建它的线程使用; slab在池销毁时才归还
+class SlabPool
+{
+public:
+    static constexpr std::size_t kSlabBytes = 64 * 1024;
+    static constexpr std::size_t kAlignment = alignof(std::max_align_t);
+
+    SlabPool(std::size_t objectSize, MemoryBudget::Category category,
+             MemoryBudget &budget = MemoryBudget::global());
+    ~SlabPool();
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    // 保证下一次 allocate 不需要新的slab; 预算不足时返回false并计一次失败。
+    // 需要遵守预算的调用方在分配前先调用它
+    bool reserve();
+    // 总是成功: 没有空闲对象时按需申请slab, 此时不检查预算
+    void *allocate();
+    void deallocate(void *p);
+    // 放不进池的请求直接走 operator new, 只记账
+    void *allocateLarge(std::size_t bytes);
+    void deallocateLarge(void *p, std::size_t bytes);
+
+    std::size_t objectSize() const { return objectBytes; }
+    std::size_t inUse() const { return liveObjects; }
+
+private:
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    void addSlab();
+
+    std::size_t objectBytes;
+    std::size_t slabBytes;
+    MemoryBudget::Category category;
+    MemoryBudget &budget;
+    std::vector<void *> slabs;
+    FreeNode *freeList = nullptr;
+    std::size_t liveObjects = 0;
+};
+
+// 让标准容器的节点从 SlabPool 分配。单个对象且放得进池的请求走池,
+// 其余 (例如哈希表的桶数组) 走 operator new, 同样计入预算
+template<typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(SlabPool *pool) noexcept
+        : pool(pool)
+    {
+    }
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U> &other) noexcept
+        : pool(other.pool)
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        if (fromPool(n)) {
+            return static_cast<T *>(pool->allocate());
+        }
+        return static_cast<T *>(pool->allocateLarge(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        if (fromPool(n)) {
+            pool->deallocate(p);
+            return;
+        }
+        pool->deallocateLarge(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U> &other) const noexcept
+    {
+        return pool == other.pool;
+    }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U> &other) const noexcept
+    {
+        return pool != other.pool;
+    }
+
+private:
+    template<typename U>
+    friend class PoolAllocator;
+
+    bool fromPool(std::size_t n) const
+    {
+        return n == 1 && sizeof(T) <= pool->objectSize() && alignof(T) <= SlabPool::kAlignment;
+    }
+
+    SlabPool *pool;
+};
+
+#endif // SLABPOOL_H
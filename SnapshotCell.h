@@ -0,0 +1,138 @@
+#ifndef SNAPSHOTCELL_H
+#define SNAPSHOTCELL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// 发布不可变快照: 写方整体替换, 读方不加锁读取, 被替换的快照按纪元回收。
+// 读方每次 acquire 时登记当时的纪元, 拿到的快照在下一次 acquire 或读方析构之前有效;
+// 写方替换后推进纪元, 旧快照等所有登记过的读方都越过它退役时的纪元才释放。
+// 读方的常规路径只有两次原子读, 写方之间用互斥量串行, 回收也由写方完成
+template<typename T>
+class SnapshotCell
+{
+public:
+    static constexpr int kMaxReaders = 8;
+
+    class Reader
+    {
+    public:
+        // 读方数量超过 kMaxReaders 时登记失败, 之后每次 acquire 都在写方的互斥量下复制一份快照,
+        // 仍然正确, 只是不再无锁
+        explicit Reader(SnapshotCell &cell)
+            : cell(cell)
+        {
+            for (int i = 0; i < kMaxReaders; ++i) {
+                bool expected = false;
+                if (cell.slotTaken[i].compare_exchange_strong(expected, true)) {
+                    slot = i;
+                    break;
+                }
+            }
+        }
+
+        ~Reader()
+        {
+            if (slot >= 0) {
+                cell.readerEpochs[slot].store(0);
+                cell.slotTaken[slot].store(false);
+            }
+        }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        // 取当前快照, 同时放弃之前取到的
+        const T &acquire()
+        {
+            if (slot < 0) {
+                std::lock_guard<std::mutex> lock(cell.writeMutex);
+                own = std::make_unique<const T>(*cell.current.load());
+                seen = cell.epoch.load();
+                held = own.get();
+                return *held;
+            }
+            seen = cell.epoch.load();
+            cell.readerEpochs[slot].store(seen);
+            held = cell.current.load();
+            return *held;
+        }
+
+        // 上一次 acquire 之后有新的快照发布
+        bool stale() const { return cell.epoch.load(std::memory_order_acquire) != seen; }
+        const T &get() const { return *held; }
+
+    private:
+        SnapshotCell &cell;
+        int slot = -1;
+        std::uint64_t seen = 0;
+        const T *held = nullptr;
+        std::unique_ptr<const T> own; // 没有登记上时自己持有的副本
+    };
+
+    explicit SnapshotCell(std::unique_ptr<const T> initial = std::make_unique<const T>())
+        : current(initial.release())
+    {
+        for (int i = 0; i < kMaxReaders; ++i) {
+            readerEpochs[i].store(0);
+            slotTaken[i].store(false);
+        }
+    }
+
+    // 析构时不能再有读方
+    ~SnapshotCell()
+    {
+        for (const auto &entry : retired) {
+            delete entry.second;
+        }
+        delete current.load();
+    }
+
+    SnapshotCell(const SnapshotCell &) = delete;
+    SnapshotCell &operator=(const SnapshotCell &) = delete;
+
+    void publish(std::unique_ptr<const T> next)
+    {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        const T *previous = current.exchange(next.release());
+        // 在这之后登记的读方一定看到新快照
+        const std::uint64_t retiredAt = epoch.fetch_add(1) + 1;
+        retired.emplace_back(retiredAt, previous);
+        reclaim();
+    }
+
+private:
+    // 只释放所有读方都已经越过的快照; 没有取过快照的读方纪元为0, 不阻止回收
+    void reclaim()
+    {
+        std::uint64_t oldest = ~std::uint64_t(0);
+        for (int i = 0; i < kMaxReaders; ++i) {
+            const std::uint64_t readerEpoch = readerEpochs[i].load();
+            if (readerEpoch != 0 && readerEpoch < oldest) {
+                oldest = readerEpoch;
+            }
+        }
+        std::size_t kept = 0;
+        for (const auto &entry : retired) {
+            if (entry.first <= oldest) {
+                delete entry.second;
+            } else {
+                retired[kept++] = entry;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    std::atomic<const T *> current;
+    std::atomic<std::uint64_t> epoch{1};
+    std::atomic<std::uint64_t> readerEpochs[kMaxReaders];
+    std::atomic<bool> slotTaken[kMaxReaders];
+    std::mutex writeMutex;
+    std::vector<std::pair<std::uint64_t, const T *>> retired; // (退役时的纪元, 快照)
+};
+
+#endif // SNAPSHOTCELL_H
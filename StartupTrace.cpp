@@ -0,0 +1,33 @@
+#include "StartupTrace.h"
+#include <QElapsedTimer>
+#include <cstdio>
+
+namespace {
+bool enabled = false;
+QElapsedTimer timer;
+qint64 lastNs = 0;
+}
+
+void StartupTrace::enable()
+{
+    enabled = true;
+    timer.start();
+    lastNs = 0;
+}
+
+bool StartupTrace::isEnabled()
+{
+    return enabled;
+}
+
+void StartupTrace::mark(const char *phase)
+{
+    if (!enabled) {
+        return;
+    }
+    const qint64 nowNs = timer.nsecsElapsed();
+    std::fprintf(stderr, "[startup] %8.1f ms  (+%7.1f ms)  %s\n",
+                 nowNs / 1e6, (nowNs - lastNs) / 1e6, phase);
+    std::fflush(stderr);
+    lastNs = nowNs;
+}
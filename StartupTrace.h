@@ -0,0 +1,16 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+// 启动耗时记录。以 --startup-trace 启动时, 各初始化阶段完成时把距 main() 开始的时间和与上一阶段的间隔
+// 打印到标准错误; 没有开启时 mark 只读一个标志
+namespace StartupTrace {
+
+// 在 main() 最开始调用, 计时从这里开始
+void enable();
+bool isEnabled();
+// 只在界面线程调用
+void mark(const char *phase);
+
+} // namespace StartupTrace
+
+#endif // STARTUPTRACE_H
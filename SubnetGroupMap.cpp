@@ -0,0 +1,86 @@
+#include "SubnetGroupMap.h"
+#include "AddressFormatter.h"
+#include <QHash>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+struct GroupPrefix
+{
+    IpAddress address;
+    int length = 0; // 128位长度
+    std::uint32_t group = 0;
+};
+
+} // namespace
+
+std::shared_ptr<const SubnetGroupMap> SubnetGroupMap::compile(const QVector<SubnetGroup> &groups,
+                                                              QStringList *errors)
+{
+    auto report = [errors](const QString &message) {
+        if (errors != nullptr) {
+            errors->append(message);
+        }
+    };
+
+    std::shared_ptr<SubnetGroupMap> map(new SubnetGroupMap());
+    map->groupNames << QStringLiteral("未分组");
+
+    std::vector<GroupPrefix> prefixes;
+    QHash<QString, std::uint32_t> owners; // 同一网段只能属于一个分组, 先定义的优先
+    for (const SubnetGroup &group : groups) {
+        const QString name = group.name.trimmed();
+        if (name.isEmpty()) {
+            continue;
+        }
+        if (map->groupNames.size() > kMaxGroups) {
+            report(QString("分组数量超过 %1 个, 忽略 \"%2\" 及之后的分组").arg(kMaxGroups).arg(name));
+            break;
+        }
+        const std::uint32_t index = static_cast<std::uint32_t>(map->groupNames.size());
+        map->groupNames << name;
+
+        for (const QString &text : group.prefixes) {
+            if (text.trimmed().isEmpty()) {
+                continue;
+            }
+            GroupPrefix prefix;
+            prefix.group = index;
+            if (!AddressFormatter::parseCidr(text, prefix.address, prefix.length)) {
+                report(QString("分组 \"%1\" 中的网段无效: %2").arg(name, text.trimmed()));
+                continue;
+            }
+            const QString canonical = QString("%1/%2").arg(AddressFormatter::toText(prefix.address)).arg(prefix.length);
+            const auto owner = owners.constFind(canonical);
+            if (owner != owners.constEnd()) {
+                if (owner.value() == index) {
+                    report(QString("分组 \"%1\" 中的网段 %2 重复").arg(name, text.trimmed()));
+                } else {
+                    report(QString("分组 \"%1\" 中的网段 %2 已属于分组 \"%3\"")
+                               .arg(name, text.trimmed(), map->groupNames[static_cast<int>(owner.value())]));
+                }
+                continue;
+            }
+            owners.insert(canonical, index);
+            prefixes.push_back(prefix);
+        }
+    }
+    if (prefixes.empty()) {
+        return nullptr;
+    }
+
+    // 短前缀先插入, 重叠时更具体的网段覆盖较大的网段
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const GroupPrefix &a, const GroupPrefix &b) { return a.length < b.length; });
+    PrefixTrie::Builder v4Builder;
+    PrefixTrie::Builder v6Builder;
+    for (const GroupPrefix &prefix : prefixes) {
+        const PrefixTrie::Key key = PrefixTrie::keyOf(prefix.address, prefix.length);
+        (key.v4 ? v4Builder : v6Builder).insert(key.hi, key.lo, key.length, prefix.group);
+    }
+    v4Builder.serialize(map->v4);
+    v6Builder.serialize(map->v6);
+    map->prefixes = static_cast<int>(prefixes.size());
+    return map;
+}
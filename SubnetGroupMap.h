@@ -0,0 +1,39 @@
+#ifndef SUBNETGROUPMAP_H
+#define SUBNETGROUPMAP_H
+
+#include "AnalysisTypes.h"
+#include "PrefixTrie.h"
+#include <memory>
+
+// 编译后的网段分组: 地址按最长前缀匹配归入分组, 查询时间与网段数量无关。
+// 构建后只读, 可以被分析线程和界面线程同时使用
+class SubnetGroupMap
+{
+public:
+    // 分组之间的流量矩阵按分组数的平方增长, 限制分组数量
+    static constexpr int kMaxGroups = 256;
+
+    // 无法解析或重复的网段跳过并写入 errors; 没有任何有效网段时返回空指针
+    static std::shared_ptr<const SubnetGroupMap> compile(const QVector<SubnetGroup> &groups,
+                                                         QStringList *errors = nullptr);
+
+    quint16 lookup(const IpAddress &address) const
+    {
+        const PrefixTrie::Key key = PrefixTrie::keyOf(address);
+        return static_cast<quint16>(key.v4 ? v4.find(key.hi, key.lo) : v6.find(key.hi, key.lo));
+    }
+
+    // 下标即分组编号, 第0项是未分组
+    const QStringList &names() const { return groupNames; }
+    int prefixCount() const { return prefixes; }
+
+private:
+    SubnetGroupMap() = default;
+
+    QStringList groupNames;
+    PrefixTrie::Table v4;
+    PrefixTrie::Table v6;
+    int prefixes = 0;
+};
+
+#endif // SUBNETGROUPMAP_H
@@ -0,0 +1,389 @@
+#include "ThroughputChart.h"
+#include <QDateTime>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPolygonF>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr double kMinSpan = 10.0;
+constexpr int kMarginLeft = 72;
+constexpr int kMarginRight = 12;
+constexpr int kMarginTop = 28;
+constexpr int kMarginBottom = 24;
+constexpr int kGridDivisions = 4;
+
+const char *const kSeriesNames[ThroughputSeriesCount] = {
+    "总计", "TCP", "UDP", "HTTP", "HTTPS", "DNS", "SSH", "FTP"
+};
+
+const QColor &seriesColor(int series)
+{
+    static const QColor colors[ThroughputSeriesCount] = {
+        QColor("#2c3e50"), QColor("#3498db"), QColor("#27ae60"), QColor("#e67e22"),
+        QColor("#8e44ad"), QColor("#16a085"), QColor("#c0392b"), QColor("#d4ac0d")
+    };
+    return colors[series];
+}
+
+// 把坐标轴上限取整到 1/2/5 x 10^n
+double niceCeil(double value)
+{
+    if (value <= 0.0) {
+        return 1.0;
+    }
+    const double magnitude = std::pow(10.0, std::floor(std::log10(value)));
+    const double fraction = value / magnitude;
+    const double nice = fraction <= 1.0 ? 1.0 : fraction <= 2.0 ? 2.0 : fraction <= 5.0 ? 5.0 : 10.0;
+    return nice * magnitude;
+}
+}
+
+ThroughputChart::ThroughputChart(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(180);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setToolTip("滚轮缩放, 拖动平移, 双击回到最新数据; 点击图例显示或隐藏曲线");
+}
+
+void ThroughputChart::appendSamples(const QVector<ThroughputSample> &samples)
+{
+    if (samples.isEmpty()) {
+        return;
+    }
+    // 用户停在历史区间时, 窗口外的新数据不触发重绘
+    bool visibleChange = following;
+    for (const ThroughputSample &sample : samples) {
+        // 最新一秒所在的桶按实际覆盖时长折算速率, 新数据也会改变它
+        const qint64 touched = history.isEmpty() ? sample.second : std::min(sample.second, history.newest());
+        dirtySecond = dirtySecond < 0 ? touched : std::min(dirtySecond, touched);
+        history.append(sample);
+        maxSamplingRate = qMax(maxSamplingRate, sample.samplingRate);
+        if (sample.second + 1 > viewStart() && sample.second < viewEnd) {
+            visibleChange = true;
+        }
+    }
+    if (following) {
+        viewEnd = static_cast<double>(history.newest() + 1);
+    }
+    if (visibleChange) {
+        update();
+    }
+}
+
+void ThroughputChart::clear()
+{
+    history.clear();
+    maxSamplingRate = 1;
+    following = true;
+    viewEnd = 0.0;
+    cacheValid = false;
+    update();
+}
+
+void ThroughputChart::setHistory(const ThroughputHistory &restored)
+{
+    history = restored;
+    maxSamplingRate = 1;
+    following = true;
+    viewEnd = static_cast<double>(history.newest() + 1);
+    cacheValid = false;
+    update();
+}
+
+void ThroughputChart::setSpan(int seconds)
+{
+    span = std::clamp(static_cast<double>(seconds), kMinSpan, static_cast<double>(ThroughputHistory::kHorizonSeconds));
+    setViewEnd(following ? static_cast<double>(history.newest() + 1) : viewEnd);
+    update();
+}
+
+void ThroughputChart::setMetric(ThroughputHistory::Metric newMetric)
+{
+    metric = newMetric;
+    update();
+}
+
+void ThroughputChart::followLatest()
+{
+    following = true;
+    viewEnd = static_cast<double>(history.newest() + 1);
+    update();
+}
+
+QRect ThroughputChart::plotRect() const
+{
+    return rect().adjusted(kMarginLeft, kMarginTop, -kMarginRight, -kMarginBottom);
+}
+
+void ThroughputChart::setViewEnd(double end)
+{
+    if (history.isEmpty()) {
+        return;
+    }
+    const double latest = static_cast<double>(history.newest() + 1);
+    const double earliest = std::min(static_cast<double>(history.oldest()) + span, latest);
+    viewEnd = std::clamp(end, earliest, latest);
+    following = viewEnd >= latest;
+}
+
+void ThroughputChart::rebuildCurves()
+{
+    // 先按窗口长度挑一个点数约为像素数几倍的级别, 再由LTTB降到每像素一个点。
+    // 级别和分块只取决于窗口长度而不是位置, 平移时已有的块都能复用
+    const QRect plot = plotRect();
+    const int points = std::max(3, plot.width());
+    const qint64 spanSeconds = static_cast<qint64>(std::ceil(span));
+    CacheKey key;
+    key.level = history.pickLevel(0, spanSeconds, points * 4);
+    const qint64 bucket = history.levelWidth(key.level);
+    key.tileSeconds = std::max<qint64>(1, (spanSeconds / kGridDivisions + bucket - 1) / bucket) * bucket;
+    key.tilePoints = std::max(3, static_cast<int>(std::ceil(points * static_cast<double>(key.tileSeconds) / span)));
+    key.metric = metric;
+    key.hidden = hiddenSeries;
+    if (!cacheValid || !(key == cacheKey)) {
+        tiles.clear();
+    } else {
+        // 新数据所在的桶及之后的块, 以及滚出保留范围的旧数据所在的块重新计算
+        const qint64 staleFrom = dirtySecond < 0 ? std::numeric_limits<qint64>::max() : dirtySecond / bucket * bucket;
+        const qint64 staleTo = history.oldest() != cachedOldest ? std::max(history.oldest(), cachedOldest) + bucket
+                                                                : std::numeric_limits<qint64>::min();
+        tiles.erase(std::remove_if(tiles.begin(), tiles.end(),
+                                   [&](const Tile &tile) {
+                                       return (tile.index + 1) * key.tileSeconds > staleFrom
+                                              || tile.index * key.tileSeconds < staleTo;
+                                   }),
+                    tiles.end());
+    }
+    cacheKey = key;
+    cacheValid = true;
+    dirtySecond = -1;
+    cachedOldest = history.oldest();
+
+    const qint64 from = static_cast<qint64>(std::floor(viewStart()));
+    const qint64 to = static_cast<qint64>(std::ceil(viewEnd));
+    const qint64 firstTile = from / key.tileSeconds;
+    const qint64 lastTile = (std::max(from + 1, to) - 1) / key.tileSeconds;
+    // 只保留视窗附近的块, 来回平移时仍能命中
+    tiles.erase(std::remove_if(tiles.begin(), tiles.end(),
+                               [&](const Tile &tile) {
+                                   return tile.index < firstTile - kGridDivisions
+                                          || tile.index > lastTile + kGridDivisions;
+                               }),
+                tiles.end());
+
+    for (std::vector<QPointF> &curve : curves) {
+        curve.clear();
+    }
+    auto cached = tiles.begin();
+    for (qint64 index = firstTile; index <= lastTile; ++index) {
+        cached = std::lower_bound(cached, tiles.end(), index,
+                                  [](const Tile &tile, qint64 value) { return tile.index < value; });
+        if (cached == tiles.end() || cached->index != index) {
+            Tile tile;
+            tile.index = index;
+            for (int series = 0; series < ThroughputSeriesCount; ++series) {
+                if (hiddenSeries & (1u << series)) {
+                    continue;
+                }
+                history.extract(key.level, metric, series, index * key.tileSeconds, (index + 1) * key.tileSeconds,
+                                scratch);
+                ThroughputHistory::downsample(scratch, key.tilePoints, tile.curves[series]);
+            }
+            cached = tiles.insert(cached, std::move(tile));
+        }
+        for (int series = 0; series < ThroughputSeriesCount; ++series) {
+            curves[series].insert(curves[series].end(), cached->curves[series].begin(), cached->curves[series].end());
+        }
+    }
+
+    // 纵轴只按视窗内的点取上限
+    double peak = 0.0;
+    for (const std::vector<QPointF> &curve : curves) {
+        for (const QPointF &point : curve) {
+            if (point.x() >= viewStart() && point.x() <= viewEnd) {
+                peak = std::max(peak, point.y());
+            }
+        }
+    }
+    yMax = niceCeil(peak * (metric == ThroughputHistory::Bytes ? 8.0 : 1.0));
+}
+
+void ThroughputChart::rebuildBackground()
+{
+    const qreal ratio = devicePixelRatioF();
+    background = QPixmap(size() * ratio);
+    background.setDevicePixelRatio(ratio);
+    background.fill(Qt::white);
+
+    QPainter painter(&background);
+    const QRect plot = plotRect();
+    painter.setPen(QPen(QColor("#ecf0f1"), 1, Qt::DashLine));
+    for (int i = 1; i < kGridDivisions; ++i) {
+        const int y = plot.bottom() - plot.height() * i / kGridDivisions;
+        const int x = plot.left() + plot.width() * i / kGridDivisions;
+        painter.drawLine(plot.left(), y, plot.right(), y);
+        painter.drawLine(x, plot.top(), x, plot.bottom());
+    }
+    painter.setPen(QColor("#bdc3c7"));
+    painter.drawRect(plot);
+}
+
+QString ThroughputChart::formatRate(double value) const
+{
+    const QString unit = metric == ThroughputHistory::Bytes ? "bit/s" : "pps";
+    if (value >= 1e9) {
+        return QString("%1 G%2").arg(value / 1e9, 0, 'f', 1).arg(unit);
+    }
+    if (value >= 1e6) {
+        return QString("%1 M%2").arg(value / 1e6, 0, 'f', 1).arg(unit);
+    }
+    if (value >= 1e3) {
+        return QString("%1 K%2").arg(value / 1e3, 0, 'f', 1).arg(unit);
+    }
+    return QString("%1 %2").arg(value, 0, 'f', 0).arg(unit);
+}
+
+void ThroughputChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    if (background.isNull() || background.size() != size() * devicePixelRatioF()) {
+        rebuildBackground();
+    }
+
+    QPainter painter(this);
+    painter.drawPixmap(0, 0, background);
+    const QRect plot = plotRect();
+
+    // 图例
+    int legendX = plot.left();
+    const QFontMetrics metrics = fontMetrics();
+    for (int series = 0; series < ThroughputSeriesCount; ++series) {
+        const bool hidden = hiddenSeries & (1u << series);
+        const QString name = kSeriesNames[series];
+        const int width = 16 + metrics.horizontalAdvance(name);
+        legendRects[series] = QRect(legendX, 6, width, 16);
+        painter.fillRect(QRect(legendX, 9, 10, 10), hidden ? QColor("#d0d0d0") : seriesColor(series));
+        painter.setPen(hidden ? QColor("#bdc3c7") : QColor("#2c3e50"));
+        painter.drawText(QRect(legendX + 14, 6, width - 14, 16), Qt::AlignLeft | Qt::AlignVCenter, name);
+        legendX += width + 12;
+    }
+
+    if (history.isEmpty()) {
+        painter.setPen(QColor("#7f8c8d"));
+        painter.drawText(plot, Qt::AlignCenter, "暂无数据");
+        return;
+    }
+    if (maxSamplingRate > 1) {
+        painter.setPen(QColor("#e67e22"));
+        painter.drawText(QRect(plot.left(), 6, plot.width(), 16), Qt::AlignRight | Qt::AlignVCenter,
+                         QString("采样估计值 (最高 1/%1)").arg(maxSamplingRate));
+    }
+    rebuildCurves();
+
+    // 坐标轴标签
+    painter.setPen(QColor("#7f8c8d"));
+    for (int i = 0; i <= kGridDivisions; ++i) {
+        const int y = plot.bottom() - plot.height() * i / kGridDivisions;
+        painter.drawText(QRect(0, y - 8, plot.left() - 6, 16), Qt::AlignRight | Qt::AlignVCenter,
+                         formatRate(yMax * i / kGridDivisions));
+    }
+    const QString timeFormat = span > 6 * 3600 ? "MM-dd hh:mm" : "hh:mm:ss";
+    for (int i = 0; i <= kGridDivisions; ++i) {
+        const int x = plot.left() + plot.width() * i / kGridDivisions;
+        const double t = viewStart() + span * i / kGridDivisions;
+        const QString label = QDateTime::fromSecsSinceEpoch(static_cast<qint64>(t)).toString(timeFormat);
+        painter.drawText(QRect(x - 50, plot.bottom() + 4, 100, 16), Qt::AlignCenter, label);
+    }
+
+    // 曲线: 缓存里是数据坐标, 平移/缩放时只重做这一步映射
+    const double xScale = plot.width() / span;
+    const double yScale = plot.height() / yMax * (metric == ThroughputHistory::Bytes ? 8.0 : 1.0);
+    const double start = viewStart();
+    painter.setClipRect(plot);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QPolygonF polyline;
+    for (int series = ThroughputSeriesCount - 1; series >= 0; --series) {
+        const std::vector<QPointF> &curve = curves[series];
+        if (curve.empty()) {
+            continue;
+        }
+        polyline.resize(static_cast<int>(curve.size()));
+        for (std::size_t i = 0; i < curve.size(); ++i) {
+            polyline[static_cast<int>(i)] = QPointF(plot.left() + (curve[i].x() - start) * xScale,
+                                                   plot.bottom() - curve[i].y() * yScale);
+        }
+        painter.setPen(QPen(seriesColor(series), series == SeriesTotal ? 2.0 : 1.2));
+        painter.drawPolyline(polyline);
+    }
+}
+
+void ThroughputChart::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    background = QPixmap();
+}
+
+void ThroughputChart::wheelEvent(QWheelEvent *event)
+{
+    const double steps = event->angleDelta().y() / 120.0;
+    if (steps == 0.0 || history.isEmpty()) {
+        return;
+    }
+    const QRect plot = plotRect();
+    const double ratio = std::clamp((event->position().x() - plot.left()) / std::max(1, plot.width()), 0.0, 1.0);
+    const double anchor = viewStart() + span * ratio;
+    const double newSpan = std::clamp(span * std::pow(0.8, steps), kMinSpan,
+                                      static_cast<double>(ThroughputHistory::kHorizonSeconds));
+    // 以鼠标所在时刻为中心缩放
+    const double newStart = anchor - newSpan * ratio;
+    span = newSpan;
+    setViewEnd(newStart + newSpan);
+    update();
+    event->accept();
+}
+
+void ThroughputChart::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        return;
+    }
+    for (int series = 0; series < ThroughputSeriesCount; ++series) {
+        if (legendRects[series].contains(event->pos())) {
+            hiddenSeries ^= 1u << series;
+            update();
+            return;
+        }
+    }
+    dragging = true;
+    dragOriginX = event->pos().x();
+    dragViewEnd = viewEnd;
+    setCursor(Qt::ClosedHandCursor);
+}
+
+void ThroughputChart::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!dragging) {
+        return;
+    }
+    const int dx = event->pos().x() - dragOriginX;
+    setViewEnd(dragViewEnd - dx * span / std::max(1, plotRect().width()));
+    update();
+}
+
+void ThroughputChart::mouseReleaseEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event)
+    dragging = false;
+    unsetCursor();
+}
+
+void ThroughputChart::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event)
+    followLatest();
+}
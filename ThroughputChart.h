@@ -0,0 +1,94 @@
+#ifndef THROUGHPUTCHART_H
+#define THROUGHPUTCHART_H
+
+#include "ThroughputHistory.h"
+#include <QPixmap>
+#include <QRect>
+#include <QWidget>
+#include <vector>
+
+// 按协议分线的带宽/包速率图表。滚轮缩放, 拖动平移, 双击回到最新数据。
+// 曲线先按窗口选定分辨率级别, 再用LTTB降到绘图区宽度。降采样按对齐到桶宽的时间段分块做并缓存,
+// 平移时只计算新露出的时间段, 新数据只让它所在及之后的时间段失效
+class ThroughputChart final : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ThroughputChart(QWidget *parent = nullptr);
+
+    void appendSamples(const QVector<ThroughputSample> &samples);
+    void clear();
+    // 换成检查点中恢复的历史, 视窗回到最新数据
+    void setHistory(const ThroughputHistory &restored);
+    // 可见时间窗口, 单位秒
+    void setSpan(int seconds);
+    void setMetric(ThroughputHistory::Metric metric);
+    void followLatest();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    // 决定分块方式和块内容的参数, 任何一项变化时所有块作废
+    struct CacheKey
+    {
+        int level = 0;
+        qint64 tileSeconds = 0;
+        int tilePoints = 0;
+        int metric = 0;
+        quint32 hidden = 0;
+
+        bool operator==(const CacheKey &other) const
+        {
+            return level == other.level && tileSeconds == other.tileSeconds && tilePoints == other.tilePoints
+                   && metric == other.metric && hidden == other.hidden;
+        }
+    };
+
+    // [index * tileSeconds, (index + 1) * tileSeconds) 内各曲线的LTTB结果
+    struct Tile
+    {
+        qint64 index = 0;
+        std::vector<QPointF> curves[ThroughputSeriesCount];
+    };
+
+    QRect plotRect() const;
+    double viewStart() const { return viewEnd - span; }
+    void setViewEnd(double end);
+    void rebuildCurves();
+    void rebuildBackground();
+    QString formatRate(double value) const;
+
+    ThroughputHistory history;
+    ThroughputHistory::Metric metric = ThroughputHistory::Bytes;
+    double span = 60.0;
+    double viewEnd = 0.0; // 不含
+    bool following = true;
+    quint32 hiddenSeries = 0;
+    quint32 maxSamplingRate = 1; // 已收到的数据中最大的采样率, 大于1时标注为估计值
+
+    CacheKey cacheKey;
+    bool cacheValid = false;
+    std::vector<Tile> tiles; // 按 index 升序
+    qint64 dirtySecond = -1;  // 上次重建以来写入的最早一秒, -1 表示没有新数据
+    qint64 cachedOldest = 0;  // 重建时历史的起点, 旧数据滚出保留范围时首块失效
+    std::vector<QPointF> curves[ThroughputSeriesCount];
+    std::vector<QPointF> scratch;
+    double yMax = 1.0;
+
+    QPixmap background;
+    QRect legendRects[ThroughputSeriesCount];
+
+    bool dragging = false;
+    int dragOriginX = 0;
+    double dragViewEnd = 0.0;
+};
+
+#endif // THROUGHPUTCHART_H
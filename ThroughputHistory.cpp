@@ -0,0 +1,235 @@
+#include "ThroughputHistory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+constexpr qint64 kLevelWidths[] = {1, 10, 60};
+}
+
+ThroughputHistory::ThroughputHistory()
+{
+    for (qint64 width : kLevelWidths) {
+        Level level;
+        level.width = width;
+        level.capacity = kHorizonSeconds / width;
+        level.values.assign(static_cast<std::size_t>(MetricCount * ThroughputSeriesCount * level.capacity), 0.0f);
+        levels.push_back(std::move(level));
+    }
+}
+
+void ThroughputHistory::clear()
+{
+    for (Level &level : levels) {
+        std::fill(level.values.begin(), level.values.end(), 0.0f);
+        level.newestBucket = -1;
+    }
+    oldestSecond = 0;
+    newestSecond = -1;
+    ++dataRevision;
+}
+
+void ThroughputHistory::append(const ThroughputSample &sample)
+{
+    if (sample.second < 0 || (!isEmpty() && sample.second <= newestSecond - kHorizonSeconds)) {
+        return; // 超出保留范围的旧样本
+    }
+
+    for (Level &level : levels) {
+        const qint64 bucket = sample.second / level.width;
+        if (bucket > level.newestBucket) {
+            // 环形前进时把复用的槽位清零, 跳过的空档也就成了零速率
+            const qint64 first = std::max(level.newestBucket + 1, bucket - level.capacity + 1);
+            for (qint64 b = first; b <= bucket; ++b) {
+                for (int metric = 0; metric < MetricCount; ++metric) {
+                    for (int series = 0; series < ThroughputSeriesCount; ++series) {
+                        level.at(metric, series, b) = 0.0f;
+                    }
+                }
+            }
+            level.newestBucket = bucket;
+        } else if (bucket <= level.newestBucket - level.capacity) {
+            continue;
+        }
+        for (int series = 0; series < ThroughputSeriesCount; ++series) {
+            level.at(Bytes, series, bucket) += static_cast<float>(sample.bytes[series]);
+            level.at(Packets, series, bucket) += static_cast<float>(sample.packets[series]);
+        }
+    }
+
+    if (isEmpty()) {
+        oldestSecond = newestSecond = sample.second;
+    } else {
+        oldestSecond = std::min(oldestSecond, sample.second);
+        newestSecond = std::max(newestSecond, sample.second);
+    }
+    oldestSecond = std::max(oldestSecond, newestSecond - kHorizonSeconds + 1);
+    ++dataRevision;
+}
+
+namespace {
+
+template<typename T>
+void put(std::vector<std::uint8_t> &out, const T &value)
+{
+    const auto *p = reinterpret_cast<const std::uint8_t *>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+bool take(const std::uint8_t *&p, const std::uint8_t *end, T &value)
+{
+    if (static_cast<std::size_t>(end - p) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+} // namespace
+
+void ThroughputHistory::save(std::vector<std::uint8_t> &out) const
+{
+    put(out, static_cast<std::uint32_t>(levels.size()));
+    put(out, static_cast<std::uint32_t>(ThroughputSeriesCount));
+    put(out, oldestSecond);
+    put(out, newestSecond);
+    for (const Level &level : levels) {
+        put(out, level.width);
+        put(out, level.capacity);
+        put(out, level.newestBucket);
+        const auto *p = reinterpret_cast<const std::uint8_t *>(level.values.data());
+        out.insert(out.end(), p, p + level.values.size() * sizeof(float));
+    }
+}
+
+bool ThroughputHistory::restore(const std::uint8_t *data, std::size_t len)
+{
+    const std::uint8_t *p = data;
+    const std::uint8_t *end = data + len;
+    std::uint32_t levelCount = 0;
+    std::uint32_t seriesCount = 0;
+    qint64 oldest = 0;
+    qint64 newest = -1;
+    if (!take(p, end, levelCount) || !take(p, end, seriesCount) || !take(p, end, oldest) || !take(p, end, newest)
+        || levelCount != levels.size() || seriesCount != ThroughputSeriesCount) {
+        return false;
+    }
+    std::vector<qint64> newestBuckets(levels.size());
+    const std::uint8_t *start = p;
+    // 先整体校验再写入, 失败时保持原有内容
+    for (std::size_t pass = 0; pass < 2; ++pass) {
+        p = start;
+        for (std::size_t i = 0; i < levels.size(); ++i) {
+            Level &level = levels[i];
+            qint64 width = 0;
+            qint64 capacity = 0;
+            if (!take(p, end, width) || !take(p, end, capacity) || !take(p, end, newestBuckets[i])
+                || width != level.width || capacity != level.capacity) {
+                return false;
+            }
+            const std::size_t bytes = level.values.size() * sizeof(float);
+            if (static_cast<std::size_t>(end - p) < bytes) {
+                return false;
+            }
+            if (pass == 1) {
+                std::memcpy(level.values.data(), p, bytes);
+                level.newestBucket = newestBuckets[i];
+            }
+            p += bytes;
+        }
+    }
+    oldestSecond = oldest;
+    newestSecond = newest;
+    ++dataRevision;
+    return true;
+}
+
+int ThroughputHistory::pickLevel(qint64 fromSecond, qint64 toSecond, int maxPoints) const
+{
+    const qint64 span = std::max<qint64>(1, toSecond - fromSecond);
+    for (int i = 0; i < levelCount(); ++i) {
+        if (span / levels[i].width <= maxPoints) {
+            return i;
+        }
+    }
+    return levelCount() - 1;
+}
+
+void ThroughputHistory::extract(int level, Metric metric, int series, qint64 fromSecond, qint64 toSecond,
+                                std::vector<QPointF> &out) const
+{
+    out.clear();
+    if (isEmpty()) {
+        return;
+    }
+    const Level &lv = levels[level];
+    const qint64 from = std::max(fromSecond, oldestSecond);
+    const qint64 to = std::min(toSecond, newestSecond + 1);
+    if (from >= to) {
+        return;
+    }
+
+    const qint64 firstBucket = std::max(from / lv.width, lv.newestBucket - lv.capacity + 1);
+    const qint64 lastBucket = std::min((to - 1) / lv.width, lv.newestBucket);
+    out.reserve(static_cast<std::size_t>(std::max<qint64>(0, lastBucket - firstBucket + 1)));
+    for (qint64 b = firstBucket; b <= lastBucket; ++b) {
+        // 首尾的粗粒度桶可能只覆盖了一部分秒数, 按实际覆盖时长折算速率
+        const qint64 start = std::max(b * lv.width, oldestSecond);
+        const qint64 end = std::min(b * lv.width + lv.width, newestSecond + 1);
+        const double duration = static_cast<double>(std::max<qint64>(1, end - start));
+        out.emplace_back(static_cast<double>(b * lv.width) + lv.width / 2.0,
+                         lv.at(metric, series, b) / duration);
+    }
+}
+
+void ThroughputHistory::downsample(const std::vector<QPointF> &in, int threshold, std::vector<QPointF> &out)
+{
+    const std::size_t count = in.size();
+    if (threshold < 3 || count <= static_cast<std::size_t>(threshold)) {
+        out = in;
+        return;
+    }
+
+    out.clear();
+    out.reserve(static_cast<std::size_t>(threshold));
+    out.push_back(in.front());
+
+    const double every = static_cast<double>(count - 2) / (threshold - 2);
+    std::size_t a = 0;
+    for (int i = 0; i < threshold - 2; ++i) {
+        // 下一个桶的平均点作为三角形的第三个顶点
+        std::size_t avgStart = static_cast<std::size_t>(std::floor((i + 1) * every)) + 1;
+        std::size_t avgEnd = std::min(static_cast<std::size_t>(std::floor((i + 2) * every)) + 1, count);
+        avgStart = std::min(avgStart, count - 1);
+        avgEnd = std::max(avgEnd, avgStart + 1);
+        double avgX = 0.0;
+        double avgY = 0.0;
+        for (std::size_t j = avgStart; j < avgEnd; ++j) {
+            avgX += in[j].x();
+            avgY += in[j].y();
+        }
+        avgX /= static_cast<double>(avgEnd - avgStart);
+        avgY /= static_cast<double>(avgEnd - avgStart);
+
+        // 当前桶里与上一个选中点、下一桶平均点构成最大三角形的点
+        const std::size_t rangeStart = static_cast<std::size_t>(std::floor(i * every)) + 1;
+        const std::size_t rangeEnd = std::min(static_cast<std::size_t>(std::floor((i + 1) * every)) + 1, count - 1);
+        const double ax = in[a].x();
+        const double ay = in[a].y();
+        double maxArea = -1.0;
+        std::size_t next = rangeStart;
+        for (std::size_t j = rangeStart; j < rangeEnd; ++j) {
+            const double area = std::fabs((ax - avgX) * (in[j].y() - ay) - (ax - in[j].x()) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                next = j;
+            }
+        }
+        out.push_back(in[next]);
+        a = next;
+    }
+
+    out.push_back(in.back());
+}
@@ -0,0 +1,74 @@
+#ifndef THROUGHPUTHISTORY_H
+#define THROUGHPUTHISTORY_H
+
+#include "AnalysisTypes.h"
+#include <QPointF>
+#include <cstdint>
+#include <vector>
+
+// 多分辨率环形缓冲: 每一级都覆盖最近24小时, 分别按1秒、10秒、60秒聚合。
+// 缩得越远用越粗的一级, 交给LTTB的点数始终与屏幕宽度同一量级
+class ThroughputHistory
+{
+public:
+    enum Metric {
+        Bytes,
+        Packets,
+        MetricCount
+    };
+
+    static constexpr qint64 kHorizonSeconds = 24 * 3600;
+
+    ThroughputHistory();
+
+    void append(const ThroughputSample &sample);
+    void clear();
+
+    bool isEmpty() const { return newestSecond < oldestSecond; }
+    qint64 oldest() const { return oldestSecond; }
+    qint64 newest() const { return newestSecond; }
+    // 每次写入递增, 绘制缓存据此判断是否失效
+    quint64 revision() const { return dataRevision; }
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    qint64 levelWidth(int level) const { return levels[level].width; }
+    // 选出窗口内桶数不超过 maxPoints 的最细一级
+    int pickLevel(qint64 fromSecond, qint64 toSecond, int maxPoints) const;
+
+    // 取出 [fromSecond, toSecond) 内的每秒速率, x 为桶起始秒
+    void extract(int level, Metric metric, int series, qint64 fromSecond, qint64 toSecond,
+                 std::vector<QPointF> &out) const;
+
+    // 检查点用: 各级环形缓冲的原始内容依次追加到 out; restore 时级别划分不一致则返回false
+    void save(std::vector<std::uint8_t> &out) const;
+    bool restore(const std::uint8_t *data, std::size_t len);
+
+    // Largest-Triangle-Three-Buckets 降采样, 保留首尾点和视觉上的峰谷
+    static void downsample(const std::vector<QPointF> &in, int threshold, std::vector<QPointF> &out);
+
+private:
+    struct Level
+    {
+        qint64 width = 1;
+        qint64 capacity = 0;
+        qint64 newestBucket = -1;
+        // 按 [指标][曲线][槽位] 连续存放, 取单条曲线时顺序访问
+        std::vector<float> values;
+
+        float &at(int metric, int series, qint64 bucket)
+        {
+            return values[((metric * ThroughputSeriesCount + series) * capacity) + bucket % capacity];
+        }
+        float at(int metric, int series, qint64 bucket) const
+        {
+            return values[((metric * ThroughputSeriesCount + series) * capacity) + bucket % capacity];
+        }
+    };
+
+    std::vector<Level> levels;
+    qint64 oldestSecond = 0;
+    qint64 newestSecond = -1;
+    quint64 dataRevision = 0;
+};
+
+#endif // THROUGHPUTHISTORY_H
@@ -0,0 +1,257 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(std::uint64_t tickNs, std::uint32_t slotCount)
+    : tickNs(std::max<std::uint64_t>(tickNs, 1))
+    , heads(std::max<std::uint32_t>(slotCount, 1), kNone)
+{
+}
+
+void TimerWheel::schedule(std::uint32_t id, std::uint64_t deadlineNs)
+{
+    if (id >= timers.size()) {
+        timers.resize(static_cast<std::size_t>(id) + 1);
+    }
+    cancel(id);
+
+    // 已经过期的定时器放进当前槽, 下一次推进时触发
+    const std::uint64_t tick = std::max(deadlineNs / tickNs, currentTick);
+    const std::uint32_t slot = static_cast<std::uint32_t>(tick % heads.size());
+    Timer &timer = timers[id];
+    timer.deadlineNs = deadlineNs;
+    timer.slot = slot;
+    timer.prev = kNone;
+    timer.next = heads[slot];
+    if (timer.next != kNone) {
+        timers[timer.next].prev = id;
+    }
+    heads[slot] = id;
+    ++scheduled;
+}
+
+void TimerWheel::cancel(std::uint32_t id)
+{
+    if (!isScheduled(id)) {
+        return;
+    }
+    Timer &timer = timers[id];
+    if (timer.prev != kNone) {
+        timers[timer.prev].next = timer.next;
+    } else {
+        heads[timer.slot] = timer.next;
+    }
+    if (timer.next != kNone) {
+        timers[timer.next].prev = timer.prev;
+    }
+    timer.prev = timer.next = timer.slot = kNone;
+    --scheduled;
+}
+
+void TimerWheel::advance(std::uint64_t nowNs, std::vector<std::uint32_t> &expired)
+{
+    expired.clear();
+    const std::uint64_t nowTick = nowNs / tickNs;
+    if (!started) {
+        started = true;
+        currentTick = nowTick;
+    }
+    if (nowTick < currentTick || scheduled == 0) {
+        currentTick = std::max(currentTick, nowTick);
+        return;
+    }
+
+    const std::uint64_t steps = std::min<std::uint64_t>(nowTick - currentTick, heads.size() - 1);
+    for (std::uint64_t tick = nowTick - steps; tick <= nowTick; ++tick) {
+        const std::uint32_t slot = static_cast<std::uint32_t>(tick % heads.size());
+        // 同一个槽里还有转一圈以后才到期的定时器, 只摘下已经到期的
+        for (std::uint32_t id = heads[slot]; id != kNone;) {
+            const std::uint32_t next = timers[id].next;
+            if (timers[id].deadlineNs <= nowNs) {
+                cancel(id);
+                expired.push_back(id);
+            }
+            id = next;
+        }
+    }
+    currentTick = nowTick;
+}
+
+std::uint32_t TimerWheel::earliest() const
+{
+    std::uint32_t best = kNone;
+    for (std::size_t i = 0; i < heads.size(); ++i) {
+        const std::uint32_t slot = static_cast<std::uint32_t>((currentTick + i) % heads.size());
+        for (std::uint32_t id = heads[slot]; id != kNone; id = timers[id].next) {
+            if (best == kNone || timers[id].deadlineNs < timers[best].deadlineNs) {
+                best = id;
+            }
+        }
+        // 到期时间不超过一圈时, 按槽顺序找到的第一个非空槽就包含最早的定时器
+        if (best != kNone && timers[best].deadlineNs / tickNs < currentTick + heads.size()) {
+            break;
+        }
+    }
+    return best;
+}
+
+void TimerWheel::clear()
+{
+    std::fill(heads.begin(), heads.end(), kNone);
+    timers.clear();
+    currentTick = 0;
+    started = false;
+    scheduled = 0;
+}
+
+HierarchicalTimerWheel::HierarchicalTimerWheel(std::uint64_t tickNs)
+    : tickNs(std::max<std::uint64_t>(tickNs, 1))
+    , heads(kLevels * kSlots, kNone)
+{
+}
+
+void HierarchicalTimerWheel::schedule(std::uint32_t id, std::uint64_t deadlineNs)
+{
+    if (id >= timers.size()) {
+        timers.resize(static_cast<std::size_t>(id) + 1);
+    }
+    cancel(id);
+    timers[id].deadlineTick = deadlineNs / tickNs;
+    ++scheduled;
+    place(id);
+}
+
+void HierarchicalTimerWheel::cancel(std::uint32_t id)
+{
+    if (!isScheduled(id)) {
+        return;
+    }
+    if (timers[id].slot == kPending) {
+        timers[id].slot = kNone; // 交出时跳过
+    } else {
+        unlink(id);
+    }
+    --scheduled;
+}
+
+void HierarchicalTimerWheel::place(std::uint32_t id)
+{
+    Timer &timer = timers[id];
+    if (!started || timer.deadlineTick <= currentTick) {
+        timer.slot = kPending;
+        pending.push_back(id);
+        return;
+    }
+
+    // 到期格与当前格最高的不同位所在的层; 超出总跨度的先放在最高层, 下放时重新计算
+    std::uint64_t target = timer.deadlineTick;
+    const std::uint64_t span = 1ULL << (kSlotBits * kLevels);
+    if (target - currentTick >= span) {
+        target = currentTick + span - 1;
+    }
+    const std::uint64_t diff = target ^ currentTick;
+    int level = 0;
+    while (level + 1 < kLevels && (diff >> (kSlotBits * (level + 1))) != 0) {
+        ++level;
+    }
+    const std::uint32_t index = static_cast<std::uint32_t>((target >> (kSlotBits * level)) & (kSlots - 1));
+    link(id, static_cast<std::uint32_t>(level) * kSlots + index);
+}
+
+void HierarchicalTimerWheel::link(std::uint32_t id, std::uint32_t slot)
+{
+    Timer &timer = timers[id];
+    timer.slot = slot;
+    timer.prev = kNone;
+    timer.next = heads[slot];
+    if (timer.next != kNone) {
+        timers[timer.next].prev = id;
+    }
+    heads[slot] = id;
+}
+
+void HierarchicalTimerWheel::unlink(std::uint32_t id)
+{
+    Timer &timer = timers[id];
+    if (timer.prev != kNone) {
+        timers[timer.prev].next = timer.next;
+    } else {
+        heads[timer.slot] = timer.next;
+    }
+    if (timer.next != kNone) {
+        timers[timer.next].prev = timer.prev;
+    }
+    timer.prev = timer.next = timer.slot = kNone;
+}
+
+void HierarchicalTimerWheel::cascade(std::uint32_t slot)
+{
+    std::uint32_t id = heads[slot];
+    heads[slot] = kNone;
+    while (id != kNone) {
+        const std::uint32_t next = timers[id].next;
+        timers[id].prev = timers[id].next = timers[id].slot = kNone;
+        place(id);
+        id = next;
+    }
+}
+
+void HierarchicalTimerWheel::tick()
+{
+    ++currentTick;
+    // 先下放高层, 下放到低层的定时器可能在同一格里继续下放或到期
+    for (int level = kLevels - 1; level >= 1; --level) {
+        const int shift = kSlotBits * level;
+        if ((currentTick & ((1ULL << shift) - 1)) == 0) {
+            cascade(static_cast<std::uint32_t>(level) * kSlots
+                    + static_cast<std::uint32_t>((currentTick >> shift) & (kSlots - 1)));
+        }
+    }
+    cascade(static_cast<std::uint32_t>(currentTick & (kSlots - 1)));
+}
+
+bool HierarchicalTimerWheel::advance(std::uint64_t nowNs, std::vector<std::uint32_t> &expired,
+                                     std::size_t maxExpired, std::uint64_t maxTicks)
+{
+    expired.clear();
+    const std::uint64_t nowTick = nowNs / tickNs;
+    if (!started) {
+        started = true;
+        currentTick = nowTick;
+    }
+    if (scheduled == 0 && nowTick > currentTick) {
+        currentTick = nowTick; // 轮上没有定时器时直接跳过空转
+    }
+
+    std::uint64_t ticks = 0;
+    for (;;) {
+        while (pendingPos < pending.size() && expired.size() < maxExpired) {
+            const std::uint32_t id = pending[pendingPos++];
+            if (timers[id].slot == kPending) {
+                timers[id].slot = kNone;
+                --scheduled;
+                expired.push_back(id);
+            }
+        }
+        if (pendingPos == pending.size()) {
+            pending.clear();
+            pendingPos = 0;
+        }
+        if (expired.size() >= maxExpired || currentTick >= nowTick || ticks >= maxTicks) {
+            break;
+        }
+        tick();
+        ++ticks;
+    }
+    return !pending.empty() || currentTick < nowTick;
+}
+
+void HierarchicalTimerWheel::clear()
+{
+    std::fill(heads.begin(), heads.end(), kNone);
+    timers.clear();
+    pending.clear();
+    pendingPos = 0;
+    currentTick = 0;
+    started = false;
+    scheduled = 0;
+}
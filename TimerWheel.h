@@ -0,0 +1,101 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+// 哈希时间轮: 定时器按到期时间散列到固定数量的槽里, 用数组下标组成的双向链表串起来。
+// 时间由调用方推进 (通常是数据包时间), 推进时只检查经过的槽, 增删都是O(1)。
+// 定时器用调用方自己的编号标识, 一般就是条目在数组中的下标
+class TimerWheel
+{
+public:
+    static constexpr std::uint32_t kNone = 0xffffffffu;
+
+    TimerWheel(std::uint64_t tickNs, std::uint32_t slotCount);
+
+    // 已经在轮上的编号会先取消再重新安排
+    void schedule(std::uint32_t id, std::uint64_t deadlineNs);
+    void cancel(std::uint32_t id);
+    bool isScheduled(std::uint32_t id) const { return id < timers.size() && timers[id].slot != kNone; }
+    std::size_t size() const { return scheduled; }
+
+    // 把时间推进到 nowNs, 到期的编号写入 expired (先清空)。
+    // 时间倒退时不做任何事; 一次跳过超过一圈时每个槽只检查一遍
+    void advance(std::uint64_t nowNs, std::vector<std::uint32_t> &expired);
+
+    // 到期时间最早的编号, 轮为空时返回 kNone。需要扫描槽, 只用于内存不足时挑选淘汰对象
+    std::uint32_t earliest() const;
+
+    void clear();
+
+private:
+    struct Timer
+    {
+        std::uint64_t deadlineNs = 0;
+        std::uint32_t prev = kNone;
+        std::uint32_t next = kNone;
+        std::uint32_t slot = kNone;
+    };
+
+    std::uint64_t tickNs;
+    std::vector<std::uint32_t> heads;
+    std::vector<Timer> timers;
+    std::uint64_t currentTick = 0;
+    bool started = false;
+    std::size_t scheduled = 0;
+};
+
+// 分层时间轮: 每层64个槽, 下一层的一格等于上一层转一圈。远期定时器放在高层,
+// 时间走到对应边界时才逐层下放, 因此定时器数量和超时长短都不影响每次推进的开销。
+// 推进可以分批: 每次最多交出指定数量的到期编号, 剩下的留到下一次, 避免一次清理太多
+class HierarchicalTimerWheel
+{
+public:
+    static constexpr std::uint32_t kNone = 0xffffffffu;
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr std::uint32_t kSlots = 1u << kSlotBits;
+
+    explicit HierarchicalTimerWheel(std::uint64_t tickNs);
+
+    void schedule(std::uint32_t id, std::uint64_t deadlineNs);
+    void cancel(std::uint32_t id);
+    bool isScheduled(std::uint32_t id) const { return id < timers.size() && timers[id].slot != kNone; }
+    std::size_t size() const { return scheduled; }
+
+    // 推进到 nowNs, 到期的编号写入 expired (先清空), 最多 maxExpired 个, 最多走 maxTicks 格。
+    // 返回true表示还有没处理完的积压, 下一次调用会继续
+    bool advance(std::uint64_t nowNs, std::vector<std::uint32_t> &expired, std::size_t maxExpired,
+                 std::uint64_t maxTicks);
+
+    void clear();
+
+private:
+    static constexpr std::uint32_t kPending = 0xfffffffeu; // 已到期, 等待交出
+
+    struct Timer
+    {
+        std::uint64_t deadlineTick = 0;
+        std::uint32_t prev = kNone;
+        std::uint32_t next = kNone;
+        std::uint32_t slot = kNone; // 全局槽号 level * kSlots + index, 或 kPending
+    };
+
+    void place(std::uint32_t id);
+    void link(std::uint32_t id, std::uint32_t slot);
+    void unlink(std::uint32_t id);
+    void cascade(std::uint32_t slot);
+    void tick();
+
+    std::uint64_t tickNs;
+    std::vector<std::uint32_t> heads;
+    std::vector<Timer> timers;
+    std::vector<std::uint32_t> pending;
+    std::size_t pendingPos = 0;
+    std::uint64_t currentTick = 0; // 已经处理完的最后一格
+    bool started = false;
+    std::size_t scheduled = 0;
+};
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,344 @@
+#include "TlsClientHello.h"
+#include <QCryptographicHash>
+#include <QByteArray>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr std::uint8_t kContentHandshake = 0x16;
+constexpr std::uint8_t kHandshakeClientHello = 0x01;
+
+constexpr std::uint16_t kExtServerName = 0;
+constexpr std::uint16_t kExtSupportedGroups = 10;
+constexpr std::uint16_t kExtPointFormats = 11;
+constexpr std::uint16_t kExtSignatureAlgorithms = 13;
+constexpr std::uint16_t kExtAlpn = 16;
+constexpr std::uint16_t kExtSupportedVersions = 43;
+
+// 按边界检查读取的游标, 越界后所有读取都返回0且 ok() 为false
+class Reader
+{
+public:
+    Reader(const std::uint8_t *data, std::size_t len) : p(data), end(data + len) {}
+
+    bool ok() const { return valid; }
+    std::size_t remaining() const { return static_cast<std::size_t>(end - p); }
+
+    std::uint8_t u8()
+    {
+        if (!require(1)) {
+            return 0;
+        }
+        return *p++;
+    }
+
+    std::uint16_t u16()
+    {
+        if (!require(2)) {
+            return 0;
+        }
+        const auto v = static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+        p += 2;
+        return v;
+    }
+
+    std::uint32_t u24()
+    {
+        if (!require(3)) {
+            return 0;
+        }
+        const std::uint32_t v = (static_cast<std::uint32_t>(p[0]) << 16) | (p[1] << 8) | p[2];
+        p += 3;
+        return v;
+    }
+
+    // 截取长度为n的子区间并前移
+    Reader sub(std::size_t n)
+    {
+        if (!require(n)) {
+            return Reader(p, 0, false);
+        }
+        Reader r(p, n);
+        p += n;
+        return r;
+    }
+
+    const std::uint8_t *current() const { return p; }
+
+private:
+    Reader(const std::uint8_t *data, std::size_t len, bool isValid) : p(data), end(data + len), valid(isValid) {}
+
+    bool require(std::size_t n)
+    {
+        if (!valid || remaining() < n) {
+            valid = false;
+            return false;
+        }
+        return true;
+    }
+
+    const std::uint8_t *p;
+    const std::uint8_t *end;
+    bool valid = true;
+};
+
+// GREASE值 (RFC 8701) 形如 0x?a?a, 指纹计算时忽略
+bool isGrease(std::uint16_t v)
+{
+    return (v & 0x0f0f) == 0x0a0a && (v >> 8) == (v & 0xff);
+}
+
+void parseExtension(std::uint16_t type, Reader body, TlsClientHello &out)
+{
+    switch (type) {
+    case kExtServerName: {
+        Reader list = body.sub(body.u16());
+        while (list.ok() && list.remaining() >= 3) {
+            const std::uint8_t nameType = list.u8();
+            const std::uint16_t nameLen = list.u16();
+            Reader name = list.sub(nameLen);
+            if (name.ok() && nameType == 0 && out.sni.empty()) {
+                out.sni.assign(reinterpret_cast<const char *>(name.current()), nameLen);
+            }
+        }
+        break;
+    }
+    case kExtAlpn: {
+        Reader list = body.sub(body.u16());
+        while (list.ok() && list.remaining() >= 1) {
+            const std::uint8_t protoLen = list.u8();
+            Reader proto = list.sub(protoLen);
+            if (proto.ok()) {
+                out.alpn.emplace_back(reinterpret_cast<const char *>(proto.current()), protoLen);
+            }
+        }
+        break;
+    }
+    case kExtSupportedGroups: {
+        Reader list = body.sub(body.u16());
+        while (list.ok() && list.remaining() >= 2) {
+            out.groups.push_back(list.u16());
+        }
+        break;
+    }
+    case kExtPointFormats: {
+        Reader list = body.sub(body.u8());
+        while (list.ok() && list.remaining() >= 1) {
+            out.pointFormats.push_back(list.u8());
+        }
+        break;
+    }
+    case kExtSignatureAlgorithms: {
+        Reader list = body.sub(body.u16());
+        while (list.ok() && list.remaining() >= 2) {
+            out.signatureAlgorithms.push_back(list.u16());
+        }
+        break;
+    }
+    case kExtSupportedVersions: {
+        Reader list = body.sub(body.u8());
+        while (list.ok() && list.remaining() >= 2) {
+            const std::uint16_t v = list.u16();
+            if (!isGrease(v) && v > out.maxSupportedVersion) {
+                out.maxSupportedVersion = v;
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+template <typename T>
+std::string joinDecimal(const std::vector<T> &values, bool skipGrease)
+{
+    std::string s;
+    for (T v : values) {
+        if (skipGrease && isGrease(static_cast<std::uint16_t>(v))) {
+            continue;
+        }
+        if (!s.empty()) {
+            s += '-';
+        }
+        s += std::to_string(v);
+    }
+    return s;
+}
+
+std::string joinHex(const std::vector<std::uint16_t> &values)
+{
+    std::string s;
+    char buf[8];
+    for (std::uint16_t v : values) {
+        if (!s.empty()) {
+            s += ',';
+        }
+        std::snprintf(buf, sizeof(buf), "%04x", v);
+        s += buf;
+    }
+    return s;
+}
+
+std::string hashHex(const std::string &input, QCryptographicHash::Algorithm algorithm)
+{
+    const QByteArray digest = QCryptographicHash::hash(
+        QByteArray::fromRawData(input.data(), static_cast<int>(input.size())), algorithm);
+    return digest.toHex().toStdString();
+}
+
+// JA4中的截断SHA256, 空输入固定为12个0
+std::string ja4Hash(const std::string &input)
+{
+    if (input.empty()) {
+        return "000000000000";
+    }
+    return hashHex(input, QCryptographicHash::Sha256).substr(0, 12);
+}
+
+const char *ja4Version(std::uint16_t v)
+{
+    switch (v) {
+    case 0x0304: return "13";
+    case 0x0303: return "12";
+    case 0x0302: return "11";
+    case 0x0301: return "10";
+    case 0x0300: return "s3";
+    default: return "00";
+    }
+}
+
+} // namespace
+
+TlsParser::Result TlsParser::parseClientHello(const std::uint8_t *data, std::size_t len, TlsClientHello &out)
+{
+    // 记录头: 类型(1) 版本(2) 长度(2)
+    if (len < 1 || data[0] != kContentHandshake) {
+        return Result::NotTls;
+    }
+    if (len < 6) {
+        return Result::NeedMore;
+    }
+    if (data[1] != 0x03 || data[5] != kHandshakeClientHello) {
+        return Result::NotTls;
+    }
+    const std::size_t recordLen = (static_cast<std::size_t>(data[3]) << 8) | data[4];
+    if (recordLen < 4 || recordLen > kMaxRecordBytes - 5) {
+        return Result::NotTls;
+    }
+    if (len < 5 + recordLen) {
+        return Result::NeedMore;
+    }
+
+    Reader record(data + 5, recordLen);
+    record.u8(); // 握手类型
+    const std::uint32_t helloLen = record.u24();
+    if (helloLen > record.remaining()) {
+        return Result::NotTls; // 握手消息跨多个记录, 不支持
+    }
+    Reader hello = record.sub(helloLen);
+
+    out = TlsClientHello();
+    out.recordVersion = static_cast<std::uint16_t>((data[1] << 8) | data[2]);
+    out.clientVersion = hello.u16();
+    hello.sub(32);            // random
+    hello.sub(hello.u8());    // session id
+
+    Reader ciphers = hello.sub(hello.u16());
+    while (ciphers.ok() && ciphers.remaining() >= 2) {
+        out.ciphers.push_back(ciphers.u16());
+    }
+    hello.sub(hello.u8());    // compression methods
+    if (!hello.ok()) {
+        return Result::NotTls;
+    }
+
+    if (hello.remaining() >= 2) {
+        Reader extensions = hello.sub(hello.u16());
+        while (extensions.ok() && extensions.remaining() >= 4) {
+            const std::uint16_t type = extensions.u16();
+            Reader body = extensions.sub(extensions.u16());
+            if (!body.ok()) {
+                break;
+            }
+            out.extensions.push_back(type);
+            parseExtension(type, body, out);
+        }
+    }
+    if (out.maxSupportedVersion == 0) {
+        out.maxSupportedVersion = out.clientVersion;
+    }
+    computeFingerprints(out);
+    return Result::Complete;
+}
+
+void TlsParser::computeFingerprints(TlsClientHello &hello)
+{
+    // JA3: SSLVersion,Ciphers,Extensions,EllipticCurves,EllipticCurvePointFormats
+    hello.ja3 = std::to_string(hello.clientVersion) + ','
+                + joinDecimal(hello.ciphers, true) + ','
+                + joinDecimal(hello.extensions, true) + ','
+                + joinDecimal(hello.groups, true) + ','
+                + joinDecimal(hello.pointFormats, false);
+    hello.ja3Hash = hashHex(hello.ja3, QCryptographicHash::Md5);
+
+    // JA4: t<版本><d|i><密码套件数><扩展数><ALPN首尾字符>_<套件哈希>_<扩展哈希>
+    std::vector<std::uint16_t> ciphers;
+    for (std::uint16_t c : hello.ciphers) {
+        if (!isGrease(c)) {
+            ciphers.push_back(c);
+        }
+    }
+    std::vector<std::uint16_t> extensions;
+    std::size_t extensionCount = 0;
+    for (std::uint16_t e : hello.extensions) {
+        if (isGrease(e)) {
+            continue;
+        }
+        ++extensionCount;
+        if (e != kExtServerName && e != kExtAlpn) {
+            extensions.push_back(e);
+        }
+    }
+    std::vector<std::uint16_t> signatureAlgorithms;
+    for (std::uint16_t s : hello.signatureAlgorithms) {
+        if (!isGrease(s)) {
+            signatureAlgorithms.push_back(s);
+        }
+    }
+
+    std::string alpn = "00";
+    if (!hello.alpn.empty() && !hello.alpn.front().empty()) {
+        const std::string &first = hello.alpn.front();
+        alpn = std::string(1, first.front()) + first.back();
+    }
+
+    char prefix[16];
+    std::snprintf(prefix, sizeof(prefix), "t%s%c%02u%02u",
+                  ja4Version(hello.maxSupportedVersion),
+                  hello.sni.empty() ? 'i' : 'd',
+                  static_cast<unsigned>(std::min<std::size_t>(ciphers.size(), 99)),
+                  static_cast<unsigned>(std::min<std::size_t>(extensionCount, 99)));
+
+    std::sort(ciphers.begin(), ciphers.end());
+    std::sort(extensions.begin(), extensions.end());
+    std::string extensionInput = joinHex(extensions);
+    if (!signatureAlgorithms.empty()) {
+        extensionInput += '_' + joinHex(signatureAlgorithms);
+    }
+
+    hello.ja4 = std::string(prefix) + alpn + '_' + ja4Hash(joinHex(ciphers)) + '_' + ja4Hash(extensionInput);
+}
+
+const char *TlsParser::versionName(std::uint16_t version)
+{
+    switch (version) {
+    case 0x0304: return "TLS 1.3";
+    case 0x0303: return "TLS 1.2";
+    case 0x0302: return "TLS 1.1";
+    case 0x0301: return "TLS 1.0";
+    case 0x0300: return "SSL 3.0";
+    default: return "TLS";
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef TLSCLIENTHELLO_H
+#define TLSCLIENTHELLO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 从TLS ClientHello中提取的信息, 每个流只解析一次并缓存在流记录上
+struct TlsClientHello
+{
+    std::uint16_t recordVersion = 0;
+    std::uint16_t clientVersion = 0;
+    std::uint16_t maxSupportedVersion = 0; // supported_versions 扩展中的最高版本, 没有时同 clientVersion
+    std::string sni;
+    std::vector<std::string> alpn;
+    std::vector<std::uint16_t> ciphers;        // 保持报文中的顺序, 包含GREASE
+    std::vector<std::uint16_t> extensions;
+    std::vector<std::uint16_t> groups;
+    std::vector<std::uint8_t> pointFormats;
+    std::vector<std::uint16_t> signatureAlgorithms;
+
+    std::string ja3;     // JA3原始串
+    std::string ja3Hash; // JA3的MD5
+    std::string ja4;
+};
+
+namespace TlsParser {
+
+enum class Result {
+    Complete, // 解析成功
+    NeedMore, // 记录跨越多个TCP段, 需要更多数据
+    NotTls    // 不是TLS握手
+};
+
+// data 从客户端第一个TLS记录的开头开始
+Result parseClientHello(const std::uint8_t *data, std::size_t len, TlsClientHello &out);
+
+// 填充 ja3 / ja3Hash / ja4 字段
+void computeFingerprints(TlsClientHello &hello);
+
+// 0x0303 -> "TLS 1.2"
+const char *versionName(std::uint16_t version);
+
+// TLS记录最大长度, 跨段缓存不会超过这个值
+constexpr std::size_t kMaxRecordBytes = 5 + 16384;
+
+} // namespace TlsParser
+
+#endif // TLSCLIENTHELLO_H
@@ -1,63 +1,351 @@
 #include "TrafficAnalyzerWidget.h"
+#include "AddressFormatter.h"
+#include "AnalysisEngine.h"
+#include "AppStyle.h"
+#include "Checkpoint.h"
+#include "DissectorRegistry.h"
+#include "GeoDatabase.h"
+#include "FlowModel.h"
+#include "GroupTrafficModel.h"
+#include "MemoryBudget.h"
+#include "HostNameCache.h"
+#include "ResultModel.h"
+#include "RowDelegate.h"
+#include "StartupTrace.h"
+#include "SubnetGroupMap.h"
+#include "ThroughputChart.h"
+#include <QCoreApplication>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHeaderView>
+#include <QLocale>
+#include <QSortFilterProxyModel>
+#include <QSplitter>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QDateTime>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSignalBlocker>
+#include <QThread>
+
+namespace {
+// 结果表最多保留的行数, 超出后只更新统计
+// 行只保存整数字段, 文本在绘制可见行时才生成, 因此上限可以比逐项创建单元格时高得多
+constexpr int kMaxDisplayRows = 200000;
+// 告警面板保留的行数, 超出后丢弃最早的告警
+constexpr int kMaxAlertRows = 1000;
+constexpr int kAlertTabIndex = 2;
+}
 
 TrafficAnalyzerWidget::TrafficAnalyzerWidget(QWidget *parent)
     : QWidget(parent)
+    , engine(new AnalysisEngine(this))
+    , hostNames(new HostNameCache(this))
 {
     setupUI();
     addSampleData();
+
+    connect(engine, &AnalysisEngine::rowsReady, this, &TrafficAnalyzerWidget::onRowsReady);
+    connect(engine, &AnalysisEngine::statsUpdated, this, &TrafficAnalyzerWidget::onStatsUpdated);
+    connect(engine, &AnalysisEngine::throughputReady, throughputChart, &ThroughputChart::appendSamples);
+    connect(engine, &AnalysisEngine::alertsRaised, this, &TrafficAnalyzerWidget::onAlertsRaised);
+    connect(engine, &AnalysisEngine::groupTrafficUpdated, this, &TrafficAnalyzerWidget::onGroupTrafficUpdated);
+    connect(engine, &AnalysisEngine::flowsExpired, this, &TrafficAnalyzerWidget::onFlowsExpired);
+    connect(engine, &AnalysisEngine::progressChanged, this, &TrafficAnalyzerWidget::onProgressChanged);
+    connect(engine, &AnalysisEngine::logMessage, this, &TrafficAnalyzerWidget::appendLog);
+    connect(engine, &AnalysisEngine::analysisFinished, this, &TrafficAnalyzerWidget::onAnalysisFinished);
+    connect(hostNames, &HostNameCache::namesChanged, this, [this](int count) {
+        if (count > 0) {
+            appendLog(QString("已加载 %1 条主机名").arg(count));
+        }
+    });
+}
+
+void TrafficAnalyzerWidget::setHostsFile(const QString &path)
+{
+    hostNames->loadAsync(path);
+}
+
+void TrafficAnalyzerWidget::setGeoDatabase(const QString &path)
+{
+    // 之后的调用让还没完成的加载作废
+    const quint64 current = ++geoGeneration;
+    if (path.isEmpty()) {
+        if (!geoDatabasePath.isEmpty()) {
+            appendLog("已关闭ASN/地理库");
+        }
+        geoDatabasePath.clear();
+        engine->setGeoDatabase(nullptr);
+        return;
+    }
+
+    // 镜像是映射加载的, 即使同一路径被重新导入也要重新打开; 打开和校验放到后台, 不拖慢启动
+    QPointer<TrafficAnalyzerWidget> self(this);
+    QThread *loader = QThread::create([self, path, current]() {
+        auto error = std::make_shared<QString>();
+        std::shared_ptr<const GeoDatabase> database = GeoDatabase::open(path, error.get());
+        QMetaObject::invokeMethod(qApp, [self, path, current, database, error]() {
+            if (!self || current != self->geoGeneration) {
+                return;
+            }
+            if (!database) {
+                self->appendLog("加载ASN/地理库失败: " + *error);
+                return;
+            }
+            self->geoDatabasePath = path;
+            self->engine->setGeoDatabase(database);
+            self->appendLog(QString("已加载ASN/地理库: %1 (%2 个网段)").arg(path).arg(database->prefixCount()));
+            StartupTrace::mark("ASN/地理库已加载");
+        }, Qt::QueuedConnection);
+    });
+    connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+    loader->start(QThread::LowPriority);
+}
+
+void TrafficAnalyzerWidget::setPluginDirectory(const QString &path)
+{
+    // 加载插件会执行插件的初始化代码, 目录没变时不重复加载
+    if (path == pluginDirectory) {
+        return;
+    }
+    pluginDirectory = path;
+    const quint64 current = ++pluginGeneration;
+    if (path.isEmpty()) {
+        if (dissectors) {
+            appendLog("已关闭协议解析插件, 下一次开始分析时生效");
+        }
+        installDissectors(nullptr);
+        return;
+    }
+
+    QPointer<TrafficAnalyzerWidget> self(this);
+    QThread *loader = QThread::create([self, path, current]() {
+        auto errors = std::make_shared<QStringList>();
+        std::shared_ptr<const DissectorRegistry> registry = DissectorRegistry::load(path, errors.get());
+        QMetaObject::invokeMethod(qApp, [self, path, current, registry, errors]() {
+            if (!self || current != self->pluginGeneration) {
+                return;
+            }
+            for (const QString &error : *errors) {
+                self->appendLog("协议解析插件 " + error);
+            }
+            self->installDissectors(registry);
+            if (!registry) {
+                self->appendLog(QString("插件目录 %1 中没有可用的协议解析插件").arg(path));
+                return;
+            }
+            QStringList names;
+            for (int i = 0; i < registry->size(); ++i) {
+                names.append(registry->at(i).name);
+            }
+            self->appendLog(QString("已加载 %1 个协议解析插件: %2, 下一次开始分析时生效")
+                                .arg(registry->size()).arg(names.join(", ")));
+        }, Qt::QueuedConnection);
+    });
+    connect(loader, &QThread::finished, loader, &QObject::deleteLater);
+    loader->start(QThread::LowPriority);
+}
+
+void TrafficAnalyzerWidget::installDissectors(const std::shared_ptr<const DissectorRegistry> &registry)
+{
+    // 进行中的分析继续用开始时的插件, 引擎和结果表在下一次开始分析时一起换用
+    dissectors = registry;
+    QStringList protocols;
+    if (registry) {
+        protocols = registry->protocolNames();
+    }
+
+    // 协议过滤中换成新插件的协议名; 选中的插件协议不再存在时回到 "全部"
+    const QString selected = protocolCombo->currentText();
+    {
+        const QSignalBlocker blocker(protocolCombo);
+        for (const QString &name : pluginProtocols) {
+            const int index = protocolCombo->findText(name);
+            if (index >= 0) {
+                protocolCombo->removeItem(index);
+            }
+        }
+        pluginProtocols.clear();
+        for (const QString &name : protocols) {
+            if (!name.isEmpty() && protocolCombo->findText(name) < 0) {
+                protocolCombo->addItem(name);
+                pluginProtocols.append(name);
+            }
+        }
+        protocolCombo->setCurrentIndex(qMax(protocolCombo->findText(selected), 0));
+    }
+    if (protocolCombo->currentText() != selected) {
+        applyConfig();
+    }
+}
+
+void TrafficAnalyzerWidget::setSubnetGroups(const QVector<SubnetGroup> &groups)
+{
+    QStringList errors;
+    std::shared_ptr<const SubnetGroupMap> map = SubnetGroupMap::compile(groups, &errors);
+    for (const QString &error : errors) {
+        appendLog("网段分组: " + error);
+    }
+    engine->setSubnetGroups(map);
+    resultModel->setGroupNames(map ? map->names() : QStringList());
+    if (map) {
+        appendLog(QString("已加载 %1 个网段分组, 共 %2 个网段").arg(map->names().size() - 1).arg(map->prefixCount()));
+    }
+}
+
+void TrafficAnalyzerWidget::setFragmentMemoryLimit(quint64 bytes)
+{
+    engineConfig.fragmentMemoryLimit = bytes;
+}
+
+void TrafficAnalyzerWidget::setFlowIdleTimeout(int seconds)
+{
+    engineConfig.flowIdleTimeoutNs = static_cast<quint64>(qMax(seconds, 1)) * 1000000000;
+}
+
+void TrafficAnalyzerWidget::applyConfig()
+{
+    engineConfig.protocolFilter = protocolCombo->currentText();
+    engineConfig.validateChecksums = checksumCheckBox->isChecked();
+    engine->setConfig(engineConfig);
+}
+
+void TrafficAnalyzerWidget::setSampling(SamplingMode mode, quint32 rate, bool perFlow)
+{
+    samplingMode = mode;
+    samplingRate = rate;
+    samplingPerFlow = perFlow;
+}
+
+void TrafficAnalyzerWidget::setDecodeThreads(int threads)
+{
+    decodeThreads = threads;
+}
+
+void TrafficAnalyzerWidget::setFileReadMode(FileReadMode mode)
+{
+    fileReadMode = mode;
+}
+
+void TrafficAnalyzerWidget::setRecording(const RecordOptions &options)
+{
+    recordOptions = options;
+}
+
+void TrafficAnalyzerWidget::setCheckpoint(const CheckpointOptions &options)
+{
+    checkpointOptions = options;
+}
+
+void TrafficAnalyzerWidget::setOutputs(const QVector<OutputSinkOptions> &sinks)
+{
+    outputSinks = sinks;
+}
+
+void TrafficAnalyzerWidget::expectCheckpoint()
+{
+    checkpointExpected = true;
+}
+
+void TrafficAnalyzerWidget::installCheckpoint(bool loaded, const CheckpointState &state, const QString &error,
+                                              qint64 elapsedMs)
+{
+    if (!checkpointExpected) {
+        return;
+    }
+    checkpointExpected = false;
+    if (!loaded) {
+        appendLog("读取检查点失败: " + error);
+        return;
+    }
+    sourceEdit->setText(state.source);
+    throughputChart->setHistory(state.history);
+    onStatsUpdated(state.stats);
+    if (!state.groupTraffic.groups.isEmpty()) {
+        onGroupTrafficUpdated(state.groupTraffic);
+    }
+    resumeSource = state.source;
+    appendLog(QString("已恢复 %1 保存的分析状态: %2 个包, %3 条流 (%4 段, 用时 %5 ms), 开始分析时从这里继续")
+                  .arg(QDateTime::fromMSecsSinceEpoch(state.savedAtMs).toString("yyyy-MM-dd hh:mm:ss"))
+                  .arg(state.stats.total)
+                  .arg(state.flows.size())
+                  .arg(state.segments)
+                  .arg(elapsedMs));
+    StartupTrace::mark("检查点已恢复");
+}
+
+void TrafficAnalyzerWidget::setMemoryBudget(quint64 bytes)
+{
+    MemoryBudget::global().setLimit(bytes);
+}
+
+void TrafficAnalyzerWidget::setDebugMode(bool enabled)
+{
+    const int index = resultTabs->indexOf(memoryTable);
+    if (enabled && index < 0) {
+        resultTabs->addTab(memoryTable, "内存");
+        resultTabs->addTab(pluginTable, "插件");
+        refreshMemoryStats();
+    } else if (!enabled && index >= 0) {
+        resultTabs->removeTab(resultTabs->indexOf(pluginTable));
+        resultTabs->removeTab(index);
+    }
 }
 
 void TrafficAnalyzerWidget::setupUI()
 {
-    setStyleSheet("QWidget { background-color: #f5f5f5; }");
-    
+    // 页面本身不设样式表, 见 AppStyle.h
+    AppStyle::setPageBackground(this, QColor(0xf5, 0xf5, 0xf5));
+
     auto *mainLayout = new QVBoxLayout(this);
     
     // 标题
     auto *titleLabel = new QLabel("网络流量分析系统");
     titleLabel->setAlignment(Qt::AlignCenter);
-    titleLabel->setStyleSheet("font-size: 20px; font-weight: bold; color: #2c3e50; margin: 10px;");
+    titleLabel->setObjectName("analyzerTitle");
     
     // 控制面板
     auto *controlGroup = new QGroupBox("控制面板");
-    controlGroup->setStyleSheet("QGroupBox { font-weight: bold; }");
+    controlGroup->setObjectName("panel");
     auto *controlLayout = new QGridLayout(controlGroup);
     
     controlLayout->addWidget(new QLabel("数据源:"), 0, 0);
     sourceEdit = new QLineEdit();
-    sourceEdit->setPlaceholderText("输入IP地址、文件路径或网络接口");
-    sourceEdit->setStyleSheet("padding: 5px; border: 1px solid #ccc; border-radius: 3px;");
+    sourceEdit->setPlaceholderText("输入IP地址、文件路径或网络接口, 多个数据源用分号分隔");
+    sourceEdit->setObjectName("controlInput");
     controlLayout->addWidget(sourceEdit, 0, 1, 1, 2);
     
     controlLayout->addWidget(new QLabel("协议过滤:"), 1, 0);
     protocolCombo = new QComboBox();
     protocolCombo->addItems({"全部", "TCP", "UDP", "HTTP", "HTTPS", "FTP", "SSH", "DNS"});
-    protocolCombo->setStyleSheet("padding: 5px; border: 1px solid #ccc; border-radius: 3px;");
+    protocolCombo->setObjectName("controlInput");
     controlLayout->addWidget(protocolCombo, 1, 1);
+
+    checksumCheckBox = new QCheckBox("校验和验证");
+    checksumCheckBox->setToolTip("校验IPv4/TCP/UDP校验和并标记错误包, 自动识别网卡校验和卸载");
+    controlLayout->addWidget(checksumCheckBox, 1, 2);
+    // 分析进行中修改过滤条件或校验和开关时立即发布新配置
+    connect(protocolCombo, &QComboBox::currentTextChanged, this, &TrafficAnalyzerWidget::applyConfig);
+    connect(checksumCheckBox, &QCheckBox::toggled, this, &TrafficAnalyzerWidget::applyConfig);
     
     // 控制按钮
     auto *buttonLayout = new QHBoxLayout();
     
     startBtn = new QPushButton("开始分析");
-    startBtn->setStyleSheet("QPushButton { background-color: #27ae60; color: white; padding: 8px 15px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #219a52; }");
+    startBtn->setObjectName("startBtn");
     
     stopBtn = new QPushButton("停止分析");
     stopBtn->setEnabled(false);
-    stopBtn->setStyleSheet("QPushButton { background-color: #e74c3c; color: white; padding: 8px 15px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #c0392b; } QPushButton:disabled { background-color: #bdc3c7; }");
+    stopBtn->setObjectName("stopBtn");
     
     clearBtn = new QPushButton("清空结果");
-    clearBtn->setStyleSheet("QPushButton { background-color: #f39c12; color: white; padding: 8px 15px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #e67e22; }");
+    clearBtn->setObjectName("clearBtn");
     
     exportBtn = new QPushButton("导出结果");
-    exportBtn->setStyleSheet("QPushButton { background-color: #3498db; color: white; padding: 8px 15px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #2980b9; }");
+    exportBtn->setObjectName("exportBtn");
     
     buttonLayout->addWidget(startBtn);
     buttonLayout->addWidget(stopBtn);
@@ -70,14 +358,14 @@ void TrafficAnalyzerWidget::setupUI()
     // 状态信息
     auto *statusLayout = new QHBoxLayout();
     statusLabel = new QLabel("状态: 就绪");
-    statusLabel->setStyleSheet("color: #27ae60; font-weight: bold;");
+    statusLabel->setObjectName("statusLabel");
     
     progressBar = new QProgressBar();
     progressBar->setVisible(false);
-    progressBar->setStyleSheet("QProgressBar { border: 1px solid #ccc; border-radius: 3px; } QProgressBar::chunk { background-color: #3498db; }");
+    progressBar->setObjectName("analysisProgress");
     
     statsLabel = new QLabel("总计: 0 个包 | TCP: 0 | UDP: 0 | HTTP: 0");
-    statsLabel->setStyleSheet("color: #7f8c8d;");
+    AppStyle::styleHintLabel(statsLabel);
     
     statusLayout->addWidget(statusLabel);
     statusLayout->addWidget(progressBar);
@@ -86,32 +374,168 @@ void TrafficAnalyzerWidget::setupUI()
     
     // 结果表格
     auto *resultGroup = new QGroupBox("分析结果");
-    resultGroup->setStyleSheet("QGroupBox { font-weight: bold; }");
     auto *resultLayout = new QVBoxLayout(resultGroup);
     
-    resultTable = new QTableWidget();
-    resultTable->setColumnCount(7);
-    QStringList headers = {"时间", "源IP", "源端口", "目标IP", "目标端口", "协议", "流量类型"};
-    resultTable->setHorizontalHeaderLabels(headers);
+    auto *filterLayout = new QHBoxLayout();
+    filterLayout->addWidget(new QLabel("搜索:"));
+    searchEdit = new QLineEdit();
+    searchEdit->setPlaceholderText("IP或网段 (192.168.1. 或 2001:db8::/32)、端口、协议或域名, 多个条件用空格分隔");
+    searchEdit->setClearButtonEnabled(true);
+    searchEdit->setObjectName("filterEdit");
+    filterLayout->addWidget(searchEdit, 1);
+
+    resultModel = new ResultModel(this);
+    resultModel->setHostNames(hostNames);
+    resultProxy = new ResultFilterProxy(this);
+    resultProxy->setSourceModel(resultModel);
+
+    resultTable = new QTableView();
+    resultTable->setModel(resultProxy);
+    resultTable->setSortingEnabled(true);
+    resultTable->sortByColumn(ResultModel::ColTime, Qt::AscendingOrder);
+    resultTable->setColumnHidden(ResultModel::ColSource, true); // 只有一个数据源时不显示
     resultTable->horizontalHeader()->setStretchLastSection(true);
+    resultTable->verticalHeader()->setDefaultSectionSize(22);
     resultTable->setAlternatingRowColors(true);
     resultTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    resultTable->setStyleSheet("QTableWidget { gridline-color: #d0d0d0; } QHeaderView::section { background-color: #ecf0f1; font-weight: bold; }");
+    resultTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    resultTable->setItemDelegate(new RowDelegate(resultTable));
+    AppStyle::styleDataView(resultTable);
     
-    resultLayout->addWidget(resultTable);
+    auto *tablePage = new QWidget();
+    auto *tableLayout = new QVBoxLayout(tablePage);
+    tableLayout->setContentsMargins(0, 4, 0, 0);
+    tableLayout->addLayout(filterLayout);
+    tableLayout->addWidget(resultTable);
+
+    // 吞吐量图表
+    auto *chartPage = new QWidget();
+    auto *chartLayout = new QVBoxLayout(chartPage);
+    chartLayout->setContentsMargins(0, 4, 0, 0);
+    auto *chartControls = new QHBoxLayout();
+    chartControls->addWidget(new QLabel("时间范围:"));
+    chartSpanCombo = new QComboBox();
+    chartSpanCombo->addItem("最近1分钟", 60);
+    chartSpanCombo->addItem("最近10分钟", 600);
+    chartSpanCombo->addItem("最近1小时", 3600);
+    chartSpanCombo->addItem("最近6小时", 6 * 3600);
+    chartSpanCombo->addItem("最近24小时", 24 * 3600);
+    chartControls->addWidget(chartSpanCombo);
+    chartControls->addWidget(new QLabel("指标:"));
+    chartMetricCombo = new QComboBox();
+    chartMetricCombo->addItem("带宽 (bit/s)", ThroughputHistory::Bytes);
+    chartMetricCombo->addItem("包速率 (pps)", ThroughputHistory::Packets);
+    chartControls->addWidget(chartMetricCombo);
+    chartControls->addStretch();
+    throughputChart = new ThroughputChart();
+    chartLayout->addLayout(chartControls);
+    chartLayout->addWidget(throughputChart, 1);
+
+    resultTabs = new QTabWidget();
+    resultTabs->addTab(tablePage, "数据包");
+    resultTabs->addTab(chartPage, "流量图表");
+
+    // 安全告警
+    alertTable = new QTableWidget();
+    alertTable->setColumnCount(4);
+    alertTable->setHorizontalHeaderLabels({"时间", "类型", "地址", "详情"});
+    alertTable->horizontalHeader()->setStretchLastSection(true);
+    alertTable->setAlternatingRowColors(true);
+    alertTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    alertTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    AppStyle::styleDataView(alertTable);
+    resultTabs->addTab(alertTable, "安全告警");
+
+    // 网段分组流量: 上面按分组汇总, 下面是源/目的分组矩阵
+    groupSummaryModel = new GroupTrafficModel(GroupTrafficModel::Summary, this);
+    auto *groupSummaryProxy = new QSortFilterProxyModel(this);
+    groupSummaryProxy->setSourceModel(groupSummaryModel);
+    groupSummaryProxy->setSortRole(GroupTrafficModel::SortRole);
+    groupSummaryTable = new QTableView();
+    groupSummaryTable->setModel(groupSummaryProxy);
+    groupSummaryTable->setSortingEnabled(true);
+    groupSummaryTable->sortByColumn(GroupTrafficModel::ColSentBytes, Qt::DescendingOrder);
+    groupSummaryTable->verticalHeader()->setVisible(false);
+    groupSummaryTable->horizontalHeader()->setStretchLastSection(true);
+    groupSummaryTable->setAlternatingRowColors(true);
+    groupSummaryTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    groupMatrixModel = new GroupTrafficModel(GroupTrafficModel::Matrix, this);
+    groupMatrixTable = new QTableView();
+    groupMatrixTable->setModel(groupMatrixModel);
+    groupMatrixTable->setToolTip("行为源分组, 列为目的分组");
+
+    auto *groupSplitter = new QSplitter(Qt::Vertical);
+    groupSplitter->addWidget(groupSummaryTable);
+    groupSplitter->addWidget(groupMatrixTable);
+    for (QTableView *view : {groupSummaryTable, groupMatrixTable}) {
+        view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        AppStyle::styleDataView(view);
+    }
+    resultTabs->addTab(groupSplitter, "网段流量");
+
+    // 超时结束的流
+    flowModel = new FlowModel(this);
+    auto *flowProxy = new QSortFilterProxyModel(this);
+    flowProxy->setSourceModel(flowModel);
+    flowProxy->setSortRole(FlowModel::SortRole);
+    flowTable = new QTableView();
+    flowTable->setModel(flowProxy);
+    flowTable->setSortingEnabled(true);
+    flowTable->sortByColumn(FlowModel::ColStart, Qt::AscendingOrder);
+    flowTable->verticalHeader()->setVisible(false);
+    flowTable->horizontalHeader()->setStretchLastSection(true);
+    flowTable->setAlternatingRowColors(true);
+    flowTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    flowTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    flowTable->setItemDelegate(new RowDelegate(flowTable));
+    AppStyle::styleDataView(flowTable);
+    resultTabs->addTab(flowTable, "流记录");
+
+    // 每个数据源的计数
+    sourceTable = new QTableWidget(0, 5);
+    sourceTable->setHorizontalHeaderLabels({"数据源", "包数", "字节数", "丢弃", "乱序"});
+    sourceTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    sourceTable->verticalHeader()->setVisible(false);
+    sourceTable->setAlternatingRowColors(true);
+    sourceTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    sourceTable->setToolTip("丢弃: 读线程队列满或超出内存预算时丢掉的包\n乱序: 超出重排窗口才到达, 没能按时间顺序处理的包");
+    AppStyle::styleDataView(sourceTable);
+    resultTabs->addTab(sourceTable, "数据源");
+
+    // 内存分配统计, 只在调试模式下加入标签页
+    memoryTable = new QTableWidget(MemoryBudget::CategoryCount + 1, 5, this);
+    memoryTable->setHorizontalHeaderLabels({"已用", "峰值", "对象数", "slab数", "超出预算"});
+    memoryTable->setVerticalHeaderLabels({"数据包", "流表", "分片重组", "结果行", "合计"});
+    memoryTable->horizontalHeader()->setStretchLastSection(true);
+    memoryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    AppStyle::styleDataView(memoryTable);
+    memoryTable->hide();
+
+    // 协议解析插件各阶段的调用次数和耗时, 同样只在调试模式下加入
+    pluginTable = new QTableWidget(0, 7, this);
+    pluginTable->setHorizontalHeaderLabels({"插件", "阶段", "调用", "认领", "平均耗时", "累计耗时", "计数器"});
+    pluginTable->horizontalHeader()->setStretchLastSection(true);
+    pluginTable->verticalHeader()->setVisible(false);
+    pluginTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    pluginTable->setToolTip("端口: 按登记的端口调用\n启发式: 没有被认领的流按负载内容试探\n已认领的流: 插件认领整条流后的数据包");
+    AppStyle::styleDataView(pluginTable);
+    pluginTable->hide();
+    resultLayout->addWidget(resultTabs);
+    AppStyle::setPanelTitleBold(resultGroup, resultTabs);
     
     // 日志区域
     auto *logGroup = new QGroupBox("系统日志");
-    logGroup->setStyleSheet("QGroupBox { font-weight: bold; }");
     logGroup->setMaximumHeight(150);
     auto *logLayout = new QVBoxLayout(logGroup);
     
     logEdit = new QTextEdit();
     logEdit->setMaximumHeight(120);
-    logEdit->setStyleSheet("QTextEdit { background-color: #2c3e50; color: #ecf0f1; font-family: 'Courier New', monospace; }");
+    AppStyle::styleLogView(logEdit);
     logEdit->append("系统启动完成，等待开始分析...");
     
     logLayout->addWidget(logEdit);
+    AppStyle::setPanelTitleBold(logGroup, logEdit);
     
     // 添加到主布局
     mainLayout->addWidget(titleLabel);
@@ -119,31 +543,62 @@ void TrafficAnalyzerWidget::setupUI()
     mainLayout->addLayout(statusLayout);
     mainLayout->addWidget(resultGroup, 1);
     mainLayout->addWidget(logGroup);
+
+    // 样式表只设在不包含高频刷新视图的控件上
+    for (QWidget *styled : {static_cast<QWidget *>(titleLabel), static_cast<QWidget *>(controlGroup),
+                            static_cast<QWidget *>(statusLabel), static_cast<QWidget *>(progressBar),
+                            static_cast<QWidget *>(searchEdit)}) {
+        styled->setStyleSheet(AppStyle::pageStyleSheet());
+    }
     
     // 连接信号槽
     connect(startBtn, &QPushButton::clicked, this, &TrafficAnalyzerWidget::onStartAnalysis);
     connect(stopBtn, &QPushButton::clicked, this, &TrafficAnalyzerWidget::onStopAnalysis);
     connect(clearBtn, &QPushButton::clicked, this, &TrafficAnalyzerWidget::onClearResults);
     connect(exportBtn, &QPushButton::clicked, this, &TrafficAnalyzerWidget::onExportResults);
+    // 边输入边查询, 旧的查询由索引作废
+    connect(searchEdit, &QLineEdit::textChanged, this, &TrafficAnalyzerWidget::onSearchChanged);
+    connect(chartSpanCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        throughputChart->setSpan(chartSpanCombo->currentData().toInt());
+    });
+    connect(chartMetricCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this]() {
+        throughputChart->setMetric(static_cast<ThroughputHistory::Metric>(chartMetricCombo->currentData().toInt()));
+    });
 }
 
 void TrafficAnalyzerWidget::addSampleData() const {
     // 添加一些示例数据
-    resultTable->setRowCount(5);
-    
-    QString sampleData[5][7] = {
-        {"2024-01-15 10:30:45", "192.168.1.100", "8080", "10.0.0.1", "80", "HTTP", "Web浏览"},
-        {"2024-01-15 10:30:46", "192.168.1.101", "443", "74.125.224.72", "443", "HTTPS", "加密Web"},
-        {"2024-01-15 10:30:47", "192.168.1.102", "22", "10.0.0.2", "22", "SSH", "远程登录"},
-        {"2024-01-15 10:30:48", "192.168.1.103", "53", "8.8.8.8", "53", "DNS", "域名解析"},
-        {"2024-01-15 10:30:49", "192.168.1.104", "21", "192.168.1.200", "21", "FTP", "文件传输"}
+    struct Sample {
+        const char *time;
+        const char *srcIp;
+        quint16 srcPort;
+        const char *dstIp;
+        quint16 dstPort;
+        AppProtocol app;
+        const char *trafficType;
     };
-    
-    for (int i = 0; i < 5; i++) {
-        for (int j = 0; j < 7; j++) {
-            resultTable->setItem(i, j, new QTableWidgetItem(sampleData[i][j]));
-        }
+    const Sample samples[] = {
+        {"2024-01-15 10:30:45", "192.168.1.100", 8080, "10.0.0.1", 80, AppProtocol::Http, "GET 10.0.0.1/index.html"},
+        {"2024-01-15 10:30:46", "192.168.1.101", 443, "74.125.224.72", 443, AppProtocol::Https, "加密Web"},
+        {"2024-01-15 10:30:47", "192.168.1.102", 22, "10.0.0.2", 22, AppProtocol::Ssh, "远程登录"},
+        {"2024-01-15 10:30:48", "192.168.1.103", 53, "8.8.8.8", 53, AppProtocol::Dns, "域名解析"},
+        {"2024-01-15 10:30:49", "192.168.1.104", 21, "192.168.1.200", 21, AppProtocol::Ftp, "文件传输"}
+    };
+
+    QVector<ResultRow> rows;
+    for (const Sample &sample : samples) {
+        ResultRow row;
+        row.tsNs = static_cast<quint64>(QDateTime::fromString(sample.time, "yyyy-MM-dd hh:mm:ss").toMSecsSinceEpoch()) * 1000000;
+        AddressFormatter::parse(sample.srcIp, row.srcIp);
+        AddressFormatter::parse(sample.dstIp, row.dstIp);
+        row.srcPort = sample.srcPort;
+        row.dstPort = sample.dstPort;
+        row.l4Proto = sample.app == AppProtocol::Dns ? 17 : 6;
+        row.app = sample.app;
+        row.trafficType = sample.trafficType;
+        rows.append(row);
     }
+    resultModel->appendRows(rows);
     
     statsLabel->setText("总计: 5 个包 | TCP: 3 | UDP: 1 | HTTP: 1");
 }
@@ -154,11 +609,59 @@ void TrafficAnalyzerWidget::onStartAnalysis()
         QMessageBox::warning(this, "警告", "请输入数据源！");
         return;
     }
+
+    AnalysisOptions options;
+    engineConfig.protocolFilter = protocolCombo->currentText();
+    engineConfig.validateChecksums = checksumCheckBox->isChecked();
+    options.config = engineConfig;
+    options.samplingMode = samplingMode;
+    options.samplingRate = samplingRate;
+    options.samplingPerFlow = samplingPerFlow;
+    options.decodeThreads = decodeThreads;
+    options.fileReadMode = fileReadMode;
+    options.record = recordOptions;
+    options.checkpoint = checkpointOptions;
+    options.outputs = outputSinks;
+    // 数据源没变时接着检查点分析, 否则新的检查点覆盖旧的
+    const bool resume = !resumeSource.isEmpty() && resumeSource == sourceEdit->text();
+    options.checkpoint.resume = resume;
+
+    QString error;
+    engine->setDissectors(dissectors);
+    if (!engine->start(sourceEdit->text(), options, &error)) {
+        QMessageBox::warning(this, "错误", error);
+        appendLog("启动分析失败: " + error);
+        return;
+    }
+    // 结果表中的数据源列显示文件名或接口名
+    QStringList sourceNames;
+    for (const QString &part : sourceEdit->text().split(';')) {
+        if (!part.trimmed().isEmpty()) {
+            sourceNames.append(QFileInfo(part.trimmed()).fileName());
+        }
+    }
+    resultModel->setSourceNames(sourceNames);
+    resultTable->setColumnHidden(ResultModel::ColSource, sourceNames.size() < 2);
+    sourceTable->setRowCount(0);
+    resultModel->clear();
+    resultModel->setDissectors(dissectors ? dissectors->protocolNames() : QStringList(),
+                               dissectors ? dissectors->columnNames() : QStringList());
+    if (!resume) {
+        throughputChart->clear();
+        groupSummaryModel->clear();
+        groupMatrixModel->clear();
+    }
+    resumeSource.clear();
+    checkpointExpected = false;
+    alertTable->setRowCount(0);
+    resultTabs->setTabText(kAlertTabIndex, "安全告警");
+    flowModel->clear();
+    progressBar->setValue(0);
     
     startBtn->setEnabled(false);
     stopBtn->setEnabled(true);
     statusLabel->setText("状态: 正在分析...");
-    statusLabel->setStyleSheet("color: #f39c12; font-weight: bold;");
+    AppStyle::setStyleState(statusLabel, "running");
     progressBar->setVisible(true);
 
     const QString msg = QString("开始分析数据源: %1, 协议过滤: %2")
@@ -168,17 +671,27 @@ void TrafficAnalyzerWidget::onStartAnalysis()
 }
 
 void TrafficAnalyzerWidget::onStopAnalysis() const {
+    engine->stop();
     startBtn->setEnabled(true);
     stopBtn->setEnabled(false);
     statusLabel->setText("状态: 已停止");
-    statusLabel->setStyleSheet("color: #e74c3c; font-weight: bold;");
+    AppStyle::setStyleState(statusLabel, "stopped");
     progressBar->setVisible(false);
     
     logEdit->append(QDateTime::currentDateTime().toString("hh:mm:ss") + " - 分析已停止");
 }
 
-void TrafficAnalyzerWidget::onClearResults() const {
-    resultTable->setRowCount(0);
+void TrafficAnalyzerWidget::onClearResults() {
+    resumeSource.clear();
+    checkpointExpected = false;
+    resultModel->clear();
+    throughputChart->clear();
+    alertTable->setRowCount(0);
+    resultTabs->setTabText(kAlertTabIndex, "安全告警");
+    groupSummaryModel->clear();
+    groupMatrixModel->clear();
+    flowModel->clear();
+    sourceTable->setRowCount(0);
     statsLabel->setText("总计: 0 个包 | TCP: 0 | UDP: 0 | HTTP: 0");
     logEdit->append(QDateTime::currentDateTime().toString("hh:mm:ss") + " - 结果已清空");
 }
@@ -191,3 +704,254 @@ void TrafficAnalyzerWidget::onExportResults()
         logEdit->append(QDateTime::currentDateTime().toString("hh:mm:ss") + " - 结果已导出: " + fileName);
     }
 }
+
+void TrafficAnalyzerWidget::onRowsReady(const QVector<ResultRow> &rows) const
+{
+    const int start = resultModel->rowCount();
+    const int count = qMin(rows.size(), kMaxDisplayRows - start);
+    if (count <= 0) {
+        return;
+    }
+
+    resultModel->appendRows(count == rows.size() ? rows : rows.mid(0, count));
+
+    if (start + count == kMaxDisplayRows) {
+        appendLog(QString("结果表已达到 %1 行上限, 后续数据包只计入统计").arg(kMaxDisplayRows));
+    }
+}
+
+void TrafficAnalyzerWidget::onStatsUpdated(const TrafficStats &stats) const
+{
+    QString text;
+    if (stats.sampled || stats.samplingRate > 1) {
+        // 采样时各项是估计值, 附上95%置信区间
+        auto estimate = [](quint64 value, double error) {
+            return QString("≈%1 ±%2").arg(value).arg(qRound64(error));
+        };
+        text = QString("采样 1/%1 (估计值) | 总计: %2 个包 | TCP: %3 | UDP: %4 | HTTP: %5")
+                   .arg(stats.samplingRate).arg(stats.total)
+                   .arg(estimate(stats.tcp, stats.tcpError), estimate(stats.udp, stats.udpError),
+                        estimate(stats.http, stats.httpError));
+    } else {
+        text = QString("总计: %1 个包 | TCP: %2 | UDP: %3 | HTTP: %4")
+                   .arg(stats.total).arg(stats.tcp).arg(stats.udp).arg(stats.http);
+    }
+    if (stats.checksumsValidated) {
+        text += QString(" | 校验错误 IP: %1 TCP: %2 UDP: %3 | 卸载: %4")
+                    .arg(stats.badIpChecksums).arg(stats.badTcpChecksums)
+                    .arg(stats.badUdpChecksums).arg(stats.offloadedChecksums);
+    }
+    if (stats.fragmentsReassembled + stats.fragmentTimeouts + stats.fragmentDrops > 0) {
+        text += QString(" | 分片重组: %1 超时: %2 丢弃: %3")
+                    .arg(stats.fragmentsReassembled).arg(stats.fragmentTimeouts).arg(stats.fragmentDrops);
+    }
+    if (stats.untrackedPackets + stats.droppedRows > 0) {
+        text += QString(" | 超出内存预算 未跟踪: %1 丢弃行: %2").arg(stats.untrackedPackets).arg(stats.droppedRows);
+    }
+    if (stats.alerts > 0) {
+        text += QString(" | 告警: %1").arg(stats.alerts);
+    }
+    quint64 sourceDrops = 0;
+    quint64 latePackets = 0;
+    for (const SourceStats &source : stats.sources) {
+        sourceDrops += source.dropped;
+        latePackets += source.late;
+    }
+    if (sourceDrops + latePackets > 0) {
+        text += QString(" | 数据源丢弃: %1 乱序: %2").arg(sourceDrops).arg(latePackets);
+    }
+    if (stats.recording) {
+        const QLocale locale;
+        text += QString(" | 录制: %1 个包 %2, %3 个文件, 待写入 %4, 写入耗时 %5 ms")
+                    .arg(stats.recordedPackets)
+                    .arg(locale.formattedDataSize(static_cast<qint64>(stats.recordedBytes)))
+                    .arg(stats.recordFiles)
+                    .arg(locale.formattedDataSize(static_cast<qint64>(stats.recordBacklogBytes)))
+                    .arg(stats.recordLatencyUs / 1000.0, 0, 'f', 1);
+        if (stats.recordDrops > 0) {
+            text += QString(" 丢弃: %1").arg(stats.recordDrops);
+        }
+    }
+    if (stats.outputting) {
+        text += QString(" | 输出: %1 条, 待输出 %2").arg(stats.outputRecords).arg(stats.outputBacklog);
+        if (stats.outputDrops > 0) {
+            text += QString(" 丢弃: %1").arg(stats.outputDrops);
+        }
+    }
+    statsLabel->setText(text);
+    refreshSourceStats(stats.sources);
+    refreshMemoryStats();
+    refreshDissectorStats(stats.dissectors);
+}
+
+void TrafficAnalyzerWidget::refreshSourceStats(const QVector<SourceStats> &sources) const
+{
+    const QLocale locale;
+    sourceTable->setRowCount(sources.size());
+    for (int row = 0; row < sources.size(); ++row) {
+        const SourceStats &source = sources[row];
+        const QStringList cells = {source.name, QString::number(source.packets),
+                                   locale.formattedDataSize(static_cast<qint64>(source.bytes)),
+                                   QString::number(source.dropped), QString::number(source.late)};
+        for (int column = 0; column < cells.size(); ++column) {
+            auto *item = sourceTable->item(row, column);
+            if (item == nullptr) {
+                item = new QTableWidgetItem();
+                if (column > 0) {
+                    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                }
+                sourceTable->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    }
+}
+
+void TrafficAnalyzerWidget::refreshDissectorStats(const QVector<DissectorStats> &dissectors) const
+{
+    if (resultTabs->indexOf(pluginTable) < 0) {
+        return;
+    }
+    static const char *const stageNames[] = {"端口", "启发式", "已认领的流"};
+    constexpr int kStages = static_cast<int>(sizeof(stageNames) / sizeof(stageNames[0]));
+    pluginTable->setRowCount(dissectors.size() * kStages);
+    for (int i = 0; i < dissectors.size(); ++i) {
+        const DissectorStats &dissector = dissectors[i];
+        QStringList counters;
+        for (int c = 0; c < dissector.counters.size(); ++c) {
+            counters.append(QString("%1=%2").arg(dissector.counterNames.value(c)).arg(dissector.counters[c]));
+        }
+        for (int stage = 0; stage < kStages; ++stage) {
+            const DissectorStageStats &s = dissector.stages[stage];
+            const QStringList cells = {stage == 0 ? dissector.name : QString(), stageNames[stage],
+                                       QString::number(s.calls), QString::number(s.accepted),
+                                       s.calls > 0 ? QString("%1 ns").arg(s.ns / s.calls) : QString(),
+                                       QString("%1 ms").arg(s.ns / 1e6, 0, 'f', 1),
+                                       stage == 0 ? counters.join(", ") : QString()};
+            const int row = i * kStages + stage;
+            for (int column = 0; column < cells.size(); ++column) {
+                auto *item = pluginTable->item(row, column);
+                if (item == nullptr) {
+                    item = new QTableWidgetItem();
+                    if (column >= 2 && column <= 5) {
+                        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                    }
+                    pluginTable->setItem(row, column, item);
+                }
+                item->setText(cells[column]);
+            }
+        }
+    }
+}
+
+void TrafficAnalyzerWidget::refreshMemoryStats() const
+{
+    if (resultTabs->indexOf(memoryTable) < 0) {
+        return;
+    }
+    const MemoryBudget::Snapshot snapshot = MemoryBudget::global().snapshot();
+    const QLocale locale;
+    auto setRow = [&](int row, const MemoryBudget::CategoryStats &c) {
+        const QStringList cells = {locale.formattedDataSize(static_cast<qint64>(c.bytes)),
+                                   locale.formattedDataSize(static_cast<qint64>(c.peakBytes)),
+                                   QString::number(c.objects), QString::number(c.slabs),
+                                   QString::number(c.failures)};
+        for (int column = 0; column < cells.size(); ++column) {
+            auto *item = memoryTable->item(row, column);
+            if (item == nullptr) {
+                item = new QTableWidgetItem();
+                item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+                memoryTable->setItem(row, column, item);
+            }
+            item->setText(cells[column]);
+        }
+    };
+    MemoryBudget::CategoryStats total;
+    for (int i = 0; i < MemoryBudget::CategoryCount; ++i) {
+        const MemoryBudget::CategoryStats &c = snapshot.categories[i];
+        setRow(i, c);
+        total.objects += c.objects;
+        total.slabs += c.slabs;
+        total.failures += c.failures;
+    }
+    total.bytes = snapshot.used;
+    total.peakBytes = snapshot.peak;
+    setRow(MemoryBudget::CategoryCount, total);
+    memoryTable->setToolTip(QString("预算 %1, 已用 %2")
+                                .arg(locale.formattedDataSize(static_cast<qint64>(snapshot.limit)),
+                                     locale.formattedDataSize(static_cast<qint64>(snapshot.used))));
+}
+
+void TrafficAnalyzerWidget::onProgressChanged(int percent) const
+{
+    if (percent < 0) {
+        progressBar->setRange(0, 0); // 实时数据源没有进度, 显示忙碌状态
+    } else {
+        progressBar->setRange(0, 100);
+        progressBar->setValue(percent);
+    }
+}
+
+void TrafficAnalyzerWidget::onAnalysisFinished() const
+{
+    if (!stopBtn->isEnabled()) {
+        return; // 用户已经手动停止
+    }
+    startBtn->setEnabled(true);
+    stopBtn->setEnabled(false);
+    statusLabel->setText("状态: 分析完成");
+    AppStyle::setStyleState(statusLabel, "ready");
+    progressBar->setVisible(false);
+
+    appendLog("分析完成");
+}
+
+void TrafficAnalyzerWidget::appendLog(const QString &message) const
+{
+    logEdit->append(QDateTime::currentDateTime().toString("hh:mm:ss") + " - " + message);
+}
+
+void TrafficAnalyzerWidget::onSearchChanged(const QString &text) const
+{
+    resultProxy->setSearch(SearchQuery::parse(text));
+}
+
+void TrafficAnalyzerWidget::onAlertsRaised(const QVector<SecurityAlert> &alerts) const
+{
+    alertTable->setUpdatesEnabled(false);
+    for (const SecurityAlert &alert : alerts) {
+        const QString time = QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(alert.tsNs / 1000000))
+                                 .toString("yyyy-MM-dd hh:mm:ss");
+        const QString address = AddressFormatter::toText(alert.subject);
+        const QString detail = alertDetail(alert);
+
+        const int row = alertTable->rowCount();
+        alertTable->insertRow(row);
+        alertTable->setItem(row, 0, new QTableWidgetItem(time));
+        alertTable->setItem(row, 1, new QTableWidgetItem(alertKindName(alert.kind)));
+        alertTable->setItem(row, 2, new QTableWidgetItem(address));
+        alertTable->setItem(row, 3, new QTableWidgetItem(detail));
+
+        appendLog(QString("[告警] %1 %2: %3").arg(alertKindName(alert.kind), address, detail));
+    }
+    if (alertTable->rowCount() > kMaxAlertRows) {
+        const int excess = alertTable->rowCount() - kMaxAlertRows;
+        for (int i = 0; i < excess; ++i) {
+            alertTable->removeRow(0);
+        }
+    }
+    alertTable->setUpdatesEnabled(true);
+    alertTable->scrollToBottom();
+    resultTabs->setTabText(kAlertTabIndex, QString("安全告警 (%1)").arg(alertTable->rowCount()));
+}
+
+void TrafficAnalyzerWidget::onGroupTrafficUpdated(const GroupTrafficMatrix &matrix) const
+{
+    groupSummaryModel->setMatrix(matrix);
+    groupMatrixModel->setMatrix(matrix);
+}
+
+void TrafficAnalyzerWidget::onFlowsExpired(const QVector<FlowSummary> &flows) const
+{
+    flowModel->appendFlows(flows);
+}
@@ -7,8 +7,23 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QCheckBox>
+#include <QTableView>
 #include <QTableWidget>
 #include <QProgressBar>
+#include <QTabWidget>
+#include "AnalysisTypes.h"
+#include <memory>
+
+class AnalysisEngine;
+struct CheckpointState;
+class DissectorRegistry;
+class FlowModel;
+class GroupTrafficModel;
+class HostNameCache;
+class ResultModel;
+class ResultFilterProxy;
+class ThroughputChart;
 
 class TrafficAnalyzerWidget final : public QWidget
 {
@@ -17,23 +32,109 @@ class TrafficAnalyzerWidget final : public QWidget
 public:
     explicit TrafficAnalyzerWidget(QWidget *parent = nullptr);
 
+    // hosts格式的名称文件, 在后台加载后用于IP列显示主机名; 空路径关闭
+    void setHostsFile(const QString &path);
+    // 编译好的ASN/地理库镜像, 在后台打开, 分析进行中也可以替换; 空路径关闭
+    void setGeoDatabase(const QString &path);
+    // 协议解析插件目录, 在后台加载其中的插件, 下一次开始分析时生效; 目录没变时不重新加载, 空路径关闭
+    void setPluginDirectory(const QString &path);
+    // 命名网段分组, 编译后交给分析引擎统计分组间流量; 空列表关闭
+    void setSubnetGroups(const QVector<SubnetGroup> &groups);
+    // 分片重组的内存上限, 0 表示不重组; applyConfig 后生效
+    void setFragmentMemoryLimit(quint64 bytes);
+    // 流的空闲超时, 按数据包时间计算; applyConfig 后生效
+    void setFlowIdleTimeout(int seconds);
+    // 把过滤条件、超时和分片内存作为一个快照发布给分析引擎, 正在进行的分析也随之换用
+    void applyConfig();
+    // 过载时的采样方式, 下一次开始分析时生效
+    void setSampling(SamplingMode mode, quint32 rate, bool perFlow);
+    // 单个大文件的并行解码线程数, 0 为自动; 下一次开始分析时生效
+    void setDecodeThreads(int threads);
+    // 未压缩抓包文件的读取方式; 下一次开始分析时生效
+    void setFileReadMode(FileReadMode mode);
+    // 原始数据包录制, 目录为空时不录制; 下一次开始分析时生效
+    void setRecording(const RecordOptions &options);
+    // 分析状态检查点, 路径为空时不保存; 下一次开始分析时生效
+    void setCheckpoint(const CheckpointOptions &options);
+    // 连续输出的目的地, 为空时不输出; 下一次开始分析时生效
+    void setOutputs(const QVector<OutputSinkOptions> &sinks);
+    // 主窗口在后台读取检查点; 读完之前先调用 expectCheckpoint, 之后开始分析或清空结果时放弃恢复
+    void expectCheckpoint();
+    // 显示检查点保存时的统计和图表, 之后对同一数据源开始分析时从检查点继续
+    void installCheckpoint(bool loaded, const CheckpointState &state, const QString &error, qint64 elapsedMs);
+    // 全局内存预算, 立即生效
+    void setMemoryBudget(quint64 bytes);
+    // 调试模式下显示内存分配统计页和插件耗时页
+    void setDebugMode(bool enabled);
+
     private slots:
         void onStartAnalysis();
     void onStopAnalysis() const;
-    void onClearResults() const;
+    void onClearResults();
     void onExportResults();
+    void onRowsReady(const QVector<ResultRow> &rows) const;
+    void onStatsUpdated(const TrafficStats &stats) const;
+    void onProgressChanged(int percent) const;
+    void onAnalysisFinished() const;
+    void appendLog(const QString &message) const;
+    void onSearchChanged(const QString &text) const;
+    void onAlertsRaised(const QVector<SecurityAlert> &alerts) const;
+    void onGroupTrafficUpdated(const GroupTrafficMatrix &matrix) const;
+    void onFlowsExpired(const QVector<FlowSummary> &flows) const;
 
 private:
     void setupUI();
     void addSampleData() const;
+    void refreshMemoryStats() const;
+    void refreshSourceStats(const QVector<SourceStats> &sources) const;
+    void refreshDissectorStats(const QVector<DissectorStats> &dissectors) const;
+    void installDissectors(const std::shared_ptr<const DissectorRegistry> &registry);
+
+    AnalysisEngine *engine{};
+    HostNameCache *hostNames{};
+    QString geoDatabasePath;
+    quint64 geoGeneration = 0;     // 每次设置地理库加一, 过时的后台加载结果被丢弃
+    QString pluginDirectory;
+    quint64 pluginGeneration = 0;  // 同上, 对应插件目录
+    QStringList pluginProtocols;   // 插件加到协议过滤中的协议名
+    std::shared_ptr<const DissectorRegistry> dissectors; // 已加载的插件, 开始分析时交给引擎和结果表
+    bool checkpointExpected = false; // 等待中的检查点, 开始分析或清空结果时放弃
+    EngineConfig engineConfig; // 过滤条件和校验和开关发布时从控件读取
+    SamplingMode samplingMode = AnalysisOptions().samplingMode;
+    quint32 samplingRate = AnalysisOptions().samplingRate;
+    bool samplingPerFlow = AnalysisOptions().samplingPerFlow;
+    int decodeThreads = AnalysisOptions().decodeThreads;
+    FileReadMode fileReadMode = AnalysisOptions().fileReadMode;
+    RecordOptions recordOptions;
+    QVector<OutputSinkOptions> outputSinks;
+    CheckpointOptions checkpointOptions;
+    QString resumeSource; // 从检查点恢复的数据源, 清空结果或开始分析后失效
+    ResultModel *resultModel{};
+    ResultFilterProxy *resultProxy{};
 
     QLineEdit *sourceEdit{};
     QComboBox *protocolCombo{};
+    QCheckBox *checksumCheckBox{};
     QPushButton *startBtn{};
     QPushButton *stopBtn{};
     QPushButton *clearBtn{};
     QPushButton *exportBtn{};
-    QTableWidget *resultTable{};
+    QLineEdit *searchEdit{};
+    QTableView *resultTable{};
+    QTabWidget *resultTabs{};
+    QComboBox *chartSpanCombo{};
+    QComboBox *chartMetricCombo{};
+    ThroughputChart *throughputChart{};
+    QTableWidget *alertTable{};
+    GroupTrafficModel *groupSummaryModel{};
+    GroupTrafficModel *groupMatrixModel{};
+    QTableView *groupSummaryTable{};
+    QTableView *groupMatrixTable{};
+    FlowModel *flowModel{};
+    QTableView *flowTable{};
+    QTableWidget *sourceTable{};
+    QTableWidget *memoryTable{};
+    QTableWidget *pluginTable{};
     QTextEdit *logEdit{};
     QProgressBar *progressBar{};
     QLabel *statusLabel{};
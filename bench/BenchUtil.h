@@ -0,0 +1,84 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 各基准程序共用的计时和输出。每项跑若干次, 报告最小值和中位数; 第一次的结果也计入,
+// 冷启动的代价 (缺页、线程创建) 因此会体现在最大值里
+namespace Bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Result
+{
+    double minMs = 0;
+    double medianMs = 0;
+    double maxMs = 0;
+};
+
+template<typename Fn>
+Result run(int repeats, Fn &&fn)
+{
+    std::vector<double> times;
+    times.reserve(static_cast<std::size_t>(repeats));
+    for (int i = 0; i < repeats; ++i) {
+        const Clock::time_point start = Clock::now();
+        fn();
+        times.push_back(elapsedMs(start));
+    }
+    std::sort(times.begin(), times.end());
+    return Result{times.front(), times[times.size() / 2], times.back()};
+}
+
+inline void report(const char *name, const Result &result, double items = 0, const char *unit = nullptr)
+{
+    std::printf("%-36s min %9.2f ms  中位 %9.2f ms  max %9.2f ms", name, result.minMs, result.medianMs, result.maxMs);
+    if (items > 0 && unit != nullptr && result.medianMs > 0) {
+        std::printf("  %10.1f %s/s", items / (result.medianMs / 1000.0), unit);
+    }
+    std::printf("\n");
+}
+
+// 命令行中 "--name value" 形式的整数参数, 没有时返回 fallback
+inline long long option(int argc, char **argv, const char *name, long long fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return std::atoll(argv[i + 1]);
+        }
+    }
+    return fallback;
+}
+
+inline bool flag(int argc, char **argv, const char *name)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 防止编译器把只为计时而算的结果优化掉
+inline void keep(std::uint64_t value)
+{
+    static volatile std::uint64_t sink = 0;
+    sink = sink + value;
+}
+
+} // namespace Bench
+
+#endif // BENCHUTIL_H
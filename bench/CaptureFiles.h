@@ -0,0 +1,245 @@
+#ifndef CAPTUREFILES_H
+#define CAPTUREFILES_H
+
+#include "Checksum.h"
+#include "HttpScanner.h"
+#include "PacketDecoder.h"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+// 读取抓包文件的基准共用: 生成模拟的抓包文件、压缩, 以及与分析线程相近的逐包处理
+namespace Bench {
+
+namespace detail {
+
+inline void put16(std::string &s, std::uint16_t v)
+{
+    s.push_back(static_cast<char>(v >> 8));
+    s.push_back(static_cast<char>(v));
+}
+
+inline void put32(std::string &s, std::uint32_t v)
+{
+    put16(s, static_cast<std::uint16_t>(v >> 16));
+    put16(s, static_cast<std::uint16_t>(v));
+}
+
+inline void putLe32(std::string &s, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) {
+        s.push_back(static_cast<char>(v >> (8 * i)));
+    }
+}
+
+// 以太网 + IPv4 + TCP/UDP, 校验和不计算 (只影响校验结果, 不影响耗时)
+inline std::string makeFrame(std::mt19937_64 &rng, std::uint32_t seq)
+{
+    std::string payload;
+    const bool tcp = rng() % 10 < 7;
+    if (tcp) {
+        switch (rng() % 4) {
+        case 0:
+            payload = "GET /api/v1/items/" + std::to_string(rng() % 5000) + " HTTP/1.1\r\nHost: service"
+                      + std::to_string(rng() % 20) + ".example.com\r\nUser-Agent: Mozilla/5.0\r\n"
+                      + "Accept: */*\r\nConnection: keep-alive\r\n\r\n";
+            break;
+        case 1:
+            payload = "HTTP/1.1 200 OK\r\nServer: nginx\r\nContent-Type: application/json\r\nContent-Length: "
+                      + std::to_string(rng() % 4000) + "\r\n\r\n{\"items\":[";
+            while (payload.size() < 200 + rng() % 1200) {
+                payload += "{\"id\":" + std::to_string(rng() % 100000) + ",\"name\":\"item\"},";
+            }
+            break;
+        case 2:
+            payload.assign(rng() % 1400, '\0'); // 加密流量等不可压缩的负载
+            for (char &c : payload) {
+                c = static_cast<char>(rng());
+            }
+            break;
+        default:
+            break; // 纯ACK
+        }
+    } else {
+        payload.assign(40 + rng() % 200, '\0');
+        for (std::size_t i = 0; i < payload.size(); i += 8) {
+            payload[i] = static_cast<char>(rng());
+        }
+    }
+
+    std::string frame;
+    frame.append("\x00\x11\x22\x33\x44\x55\x66\x77\x88\x99\xaa\xbb\x08\x00", 14);
+    const std::size_t l4Len = (tcp ? 20 : 8) + payload.size();
+    frame.push_back(0x45);
+    frame.push_back(0);
+    put16(frame, static_cast<std::uint16_t>(20 + l4Len));
+    put16(frame, static_cast<std::uint16_t>(seq));
+    put16(frame, 0x4000);
+    frame.push_back(64);
+    frame.push_back(tcp ? 6 : 17);
+    put16(frame, 0);
+    put32(frame, 0x0a000000u | static_cast<std::uint32_t>(rng() % 256));
+    put32(frame, 0xc0a80000u | static_cast<std::uint32_t>(rng() % 64));
+    const std::uint16_t clientPort = static_cast<std::uint16_t>(30000 + rng() % 30000);
+    const std::uint16_t serverPort = tcp ? (rng() % 4 == 0 ? 443 : 80) : 53;
+    put16(frame, clientPort);
+    put16(frame, serverPort);
+    if (tcp) {
+        put32(frame, seq * 1460u);
+        put32(frame, 0);
+        frame.push_back(0x50);
+        frame.push_back(payload.empty() ? 0x10 : 0x18);
+        put16(frame, 65535);
+        put16(frame, 0);
+        put16(frame, 0);
+    } else {
+        put16(frame, static_cast<std::uint16_t>(l4Len));
+        put16(frame, 0);
+    }
+    frame += payload;
+    return frame;
+}
+
+} // namespace detail
+
+// 写一个约 bytes 字节的以太网pcap文件 (微秒时间戳), 返回包数
+inline std::uint64_t writeCapture(const std::string &path, std::uint64_t bytes, std::uint64_t seed = 1)
+{
+    std::FILE *out = std::fopen(path.c_str(), "wb");
+    if (out == nullptr) {
+        return 0;
+    }
+    std::string header;
+    detail::putLe32(header, 0xa1b2c3d4u);
+    header.append("\x02\x00\x04\x00", 4);
+    detail::putLe32(header, 0);
+    detail::putLe32(header, 0);
+    detail::putLe32(header, 65535);
+    detail::putLe32(header, 1);
+    std::fwrite(header.data(), 1, header.size(), out);
+
+    std::mt19937_64 rng(seed);
+    std::uint64_t written = header.size();
+    std::uint64_t packets = 0;
+    std::uint64_t usec = 0;
+    std::string record;
+    while (written < bytes) {
+        const std::string frame = detail::makeFrame(rng, static_cast<std::uint32_t>(packets));
+        usec += 1 + rng() % 200;
+        record.clear();
+        detail::putLe32(record, static_cast<std::uint32_t>(1700000000 + usec / 1000000));
+        detail::putLe32(record, static_cast<std::uint32_t>(usec % 1000000));
+        detail::putLe32(record, static_cast<std::uint32_t>(frame.size()));
+        detail::putLe32(record, static_cast<std::uint32_t>(frame.size()));
+        record += frame;
+        std::fwrite(record.data(), 1, record.size(), out);
+        written += record.size();
+        ++packets;
+    }
+    std::fclose(out);
+    return packets;
+}
+
+// 把 source 压缩成 target, 格式由 codec 决定 ("gzip"/"zstd"/"lz4"); 编译时没有该格式或失败时返回false
+inline bool compressFile(const std::string &source, const std::string &target, const std::string &codec)
+{
+    std::FILE *in = std::fopen(source.c_str(), "rb");
+    if (in == nullptr) {
+        return false;
+    }
+    std::vector<char> chunk(1 << 20);
+    bool ok = false;
+#ifdef HAVE_ZLIB
+    if (codec == "gzip") {
+        gzFile out = gzopen(target.c_str(), "wb6");
+        ok = out != nullptr;
+        std::size_t n = 0;
+        while (ok && (n = std::fread(chunk.data(), 1, chunk.size(), in)) > 0) {
+            ok = gzwrite(out, chunk.data(), static_cast<unsigned>(n)) == static_cast<int>(n);
+        }
+        if (out != nullptr) {
+            ok = gzclose(out) == Z_OK && ok;
+        }
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (codec == "zstd") {
+        std::FILE *out = std::fopen(target.c_str(), "wb");
+        ZSTD_CCtx *context = ZSTD_createCCtx();
+        std::vector<char> buffer(ZSTD_CStreamOutSize());
+        ok = out != nullptr && context != nullptr;
+        for (bool last = false; ok && !last;) {
+            const std::size_t n = std::fread(chunk.data(), 1, chunk.size(), in);
+            last = n < chunk.size();
+            ZSTD_inBuffer input{chunk.data(), n, 0};
+            for (bool done = false; ok && !done;) {
+                ZSTD_outBuffer output{buffer.data(), buffer.size(), 0};
+                const std::size_t left = ZSTD_compressStream2(context, &output, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+                ok = !ZSTD_isError(left) && std::fwrite(buffer.data(), 1, output.pos, out) == output.pos;
+                done = last ? left == 0 : input.pos == input.size;
+            }
+        }
+        ZSTD_freeCCtx(context);
+        if (out != nullptr) {
+            ok = std::fclose(out) == 0 && ok;
+        }
+    }
+#endif
+#ifdef HAVE_LZ4
+    if (codec == "lz4") {
+        std::FILE *out = std::fopen(target.c_str(), "wb");
+        LZ4F_cctx *context = nullptr;
+        ok = out != nullptr && !LZ4F_isError(LZ4F_createCompressionContext(&context, LZ4F_VERSION));
+        std::vector<char> buffer(LZ4F_compressBound(chunk.size(), nullptr) + 64);
+        std::size_t n = ok ? LZ4F_compressBegin(context, buffer.data(), buffer.size(), nullptr) : 0;
+        ok = ok && !LZ4F_isError(n) && std::fwrite(buffer.data(), 1, n, out) == n;
+        while (ok && (n = std::fread(chunk.data(), 1, chunk.size(), in)) > 0) {
+            n = LZ4F_compressUpdate(context, buffer.data(), buffer.size(), chunk.data(), n, nullptr);
+            ok = !LZ4F_isError(n) && std::fwrite(buffer.data(), 1, n, out) == n;
+        }
+        n = ok ? LZ4F_compressEnd(context, buffer.data(), buffer.size(), nullptr) : 0;
+        ok = ok && !LZ4F_isError(n) && std::fwrite(buffer.data(), 1, n, out) == n;
+        LZ4F_freeCompressionContext(context);
+        if (out != nullptr) {
+            ok = std::fclose(out) == 0 && ok;
+        }
+    }
+#endif
+    std::fclose(in);
+    if (!ok) {
+        std::remove(target.c_str());
+    }
+    return ok;
+}
+
+// 分析线程对每个包做的主要工作: 解码、校验和验证、HTTP头部扫描。返回值只用于防止被优化掉
+inline std::uint64_t analyze(const RawPacket &raw)
+{
+    DecodedPacket pkt;
+    if (!PacketDecoder::decode(raw, pkt)) {
+        return 1;
+    }
+    std::uint64_t digest = pkt.srcPort ^ (static_cast<std::uint64_t>(pkt.dstPort) << 16);
+    const Checksum::Result checksum = Checksum::validate(pkt, raw.flags);
+    digest += checksum.bad() ? 3 : 0;
+    HttpMetadata http;
+    if (pkt.l4Proto == ProtoTcp && pkt.payloadLen > 0 && HttpScanner::scan(pkt.payload, pkt.payloadLen, http)) {
+        digest += http.contentLength > 0 ? static_cast<std::uint64_t>(http.contentLength) : 7;
+    }
+    return digest;
+}
+
+} // namespace Bench
+
+#endif // CAPTUREFILES_H
@@ -0,0 +1,153 @@
+// 压缩抓包文件的基准: 比较边解压边分析 (PcapFileSource 读 .gz/.zst/.lz4) 与先解压成临时文件再分析。
+// 同时单独测解压和分析两段, 流水线的理想耗时是较慢的一段, 先解压再分析是两段之和再加写临时文件。
+//
+//   DecompressionBench [--mb N] [--repeat R] [--dir 目录]
+//
+// 在 --dir (默认系统临时目录) 下生成约 N MB 的pcap文件, 用编译时启用的每种格式各压缩一份,
+// 结束时删除。解压和分析能否重叠取决于空闲的CPU核数
+#include "BenchUtil.h"
+#include "CaptureFiles.h"
+#include "DecompressionStream.h"
+#include "PcapFileSource.h"
+#include <filesystem>
+#include <thread>
+
+namespace {
+
+struct Pass
+{
+    std::uint64_t packets = 0;
+    std::uint64_t digest = 0;
+};
+
+Pass analyzeFile(const std::string &path)
+{
+    Pass pass;
+    PcapFileSource source;
+    QString error;
+    if (!source.open(QString::fromStdString(path), &error)) {
+        std::printf("无法打开 %s: %s\n", path.c_str(), qPrintable(error));
+        std::exit(2);
+    }
+    RawPacket raw;
+    while (source.next(raw)) {
+        ++pass.packets;
+        pass.digest += Bench::analyze(raw);
+    }
+    if (!source.errorString().isEmpty()) {
+        std::printf("读取 %s 出错: %s\n", path.c_str(), qPrintable(source.errorString()));
+        std::exit(2);
+    }
+    return pass;
+}
+
+// 只解压不分析, 按已知的解压后大小取完所有数据; target 不为空时写到文件里
+void inflateFile(const std::string &path, DecompressionStream::Codec codec, std::uint64_t plainBytes,
+                 const std::string &target = std::string())
+{
+    DecompressionStream stream;
+    QString error;
+    if (!stream.open(QString::fromStdString(path), codec, &error)) {
+        std::printf("无法解压 %s: %s\n", path.c_str(), qPrintable(error));
+        std::exit(2);
+    }
+    std::FILE *out = target.empty() ? nullptr : std::fopen(target.c_str(), "wb");
+    std::uint64_t remaining = plainBytes;
+    while (remaining > 0) {
+        // 不超过预留空间, 跨缓冲区时不需要额外拼接
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, 64 * 1024));
+        const std::uint8_t *data = stream.peek(n);
+        if (data == nullptr) {
+            std::printf("解压 %s 提前结束: %s\n", path.c_str(), qPrintable(stream.errorString()));
+            std::exit(2);
+        }
+        if (out != nullptr) {
+            std::fwrite(data, 1, n, out);
+        } else {
+            Bench::keep(data[n - 1]);
+        }
+        stream.consume(n);
+        remaining -= n;
+    }
+    if (out != nullptr) {
+        std::fclose(out);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::uint64_t megabytes = static_cast<std::uint64_t>(Bench::option(argc, argv, "--mb", 256));
+    const int repeats = static_cast<int>(Bench::option(argc, argv, "--repeat", 3));
+    std::string dir = std::filesystem::temp_directory_path().string();
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--dir") == 0) {
+            dir = argv[i + 1];
+        }
+    }
+
+    const std::string plain = dir + "/decompression-bench.pcap";
+    const std::string temp = dir + "/decompression-bench-tmp.pcap";
+    const std::uint64_t packets = Bench::writeCapture(plain, megabytes * 1024 * 1024);
+    const std::uint64_t plainBytes = std::filesystem::file_size(plain);
+    std::printf("%llu 个包, %.1f MB, 可用CPU %u 个\n", static_cast<unsigned long long>(packets), plainBytes / 1e6,
+                std::thread::hardware_concurrency());
+
+    Pass reference;
+    const Bench::Result analyzeOnly = Bench::run(repeats, [&]() { reference = analyzeFile(plain); });
+    Bench::report("只分析 (未压缩, 内存映射)", analyzeOnly, static_cast<double>(packets), "包");
+
+    int failures = 0;
+    const struct
+    {
+        const char *name;
+        const char *suffix;
+        DecompressionStream::Codec codec;
+    } formats[] = {
+        {"gzip", ".gz", DecompressionStream::Codec::Gzip},
+        {"zstd", ".zst", DecompressionStream::Codec::Zstd},
+        {"lz4", ".lz4", DecompressionStream::Codec::Lz4},
+    };
+    for (const auto &format : formats) {
+        if (!DecompressionStream::isSupported(format.codec)) {
+            std::printf("\n%s: 编译时没有启用, 跳过\n", format.name);
+            continue;
+        }
+        const std::string compressed = plain + format.suffix;
+        if (!Bench::compressFile(plain, compressed, format.name)) {
+            std::printf("\n%s: 压缩失败, 跳过\n", format.name);
+            continue;
+        }
+        std::printf("\n%s, 压缩后 %.1f MB\n", format.name, std::filesystem::file_size(compressed) / 1e6);
+
+        const Bench::Result inflateOnly = Bench::run(repeats, [&]() {
+            inflateFile(compressed, format.codec, plainBytes);
+        });
+        Bench::report("只解压", inflateOnly, plainBytes / 1e6, "MB");
+
+        Pass pipelined;
+        const Bench::Result pipeline = Bench::run(repeats, [&]() { pipelined = analyzeFile(compressed); });
+        Bench::report("边解压边分析", pipeline, static_cast<double>(packets), "包");
+
+        Pass serial;
+        const Bench::Result twoStep = Bench::run(repeats, [&]() {
+            inflateFile(compressed, format.codec, plainBytes, temp);
+            serial = analyzeFile(temp);
+            std::remove(temp.c_str());
+        });
+        Bench::report("先解压到临时文件再分析", twoStep, static_cast<double>(packets), "包");
+
+        std::printf("  较慢的一段 %.0f ms, 两段之和 %.0f ms, 流水线 %.0f ms\n",
+                    std::max(inflateOnly.medianMs, analyzeOnly.medianMs),
+                    inflateOnly.medianMs + analyzeOnly.medianMs, pipeline.medianMs);
+        if (pipelined.packets != reference.packets || pipelined.digest != reference.digest
+            || serial.packets != reference.packets || serial.digest != reference.digest) {
+            std::printf("  结果与未压缩文件不一致!\n");
+            ++failures;
+        }
+        std::remove(compressed.c_str());
+    }
+    std::remove(plain.c_str());
+    return failures == 0 ? 0 : 1;
+}
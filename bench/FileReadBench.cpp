@@ -0,0 +1,145 @@
+// 未压缩抓包文件的读取方式基准: 内存映射、io_uring预读和普通读取, 分别在冷缓存和热缓存下读完整个文件
+// 并做与分析线程相近的逐包处理, 同时核对三种方式交出的数据包一致。
+//
+//   FileReadBench [--mb N] [--repeat R] [--file 路径] [--dir 目录]
+//
+// 不给 --file 时在 --dir (默认系统临时目录) 下生成约 N MB 的pcap文件, 结束时删除。
+// 冷缓存用 posix_fadvise(DONTNEED) 把文件逐出页缓存, 只对本机磁盘有效; 网络文件系统上
+// 客户端缓存可能仍然命中, 这时应在服务器上清缓存或直接用足够大的文件
+#include "BenchUtil.h"
+#include "CaptureFiles.h"
+#include "PcapFileSource.h"
+#include <filesystem>
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Pass
+{
+    std::uint64_t packets = 0;
+    std::uint64_t digest = 0;
+    FileReadMode mode = FileReadMode::Mmap;
+};
+
+Pass readFile(const std::string &path, FileReadMode mode)
+{
+    Pass pass;
+    PcapFileSource source;
+    source.setReadMode(mode);
+    QString error;
+    if (!source.open(QString::fromStdString(path), &error)) {
+        std::printf("无法打开 %s: %s\n", path.c_str(), qPrintable(error));
+        std::exit(2);
+    }
+    pass.mode = source.readMode();
+    RawPacket raw;
+    while (source.next(raw)) {
+        ++pass.packets;
+        pass.digest += Bench::analyze(raw);
+        for (std::uint32_t i = 0; i < raw.capLen; i += 64) {
+            pass.digest += raw.data[i]; // 映射时每一页都要真正读到
+        }
+    }
+    if (!source.errorString().isEmpty()) {
+        std::printf("读取 %s 出错: %s\n", path.c_str(), qPrintable(source.errorString()));
+        std::exit(2);
+    }
+    return pass;
+}
+
+// 把文件逐出页缓存, 不支持时返回false
+bool dropCache(const std::string &path)
+{
+#if defined(__unix__)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    ::fdatasync(fd);
+    const bool ok = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+const char *modeName(FileReadMode mode)
+{
+    switch (mode) {
+    case FileReadMode::Mmap: return "内存映射";
+    case FileReadMode::IoUring: return "io_uring预读";
+    case FileReadMode::Buffered: return "普通读取";
+    }
+    return "";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::uint64_t megabytes = static_cast<std::uint64_t>(Bench::option(argc, argv, "--mb", 512));
+    const int repeats = static_cast<int>(Bench::option(argc, argv, "--repeat", 3));
+    std::string dir = std::filesystem::temp_directory_path().string();
+    std::string path;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--dir") == 0) {
+            dir = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--file") == 0) {
+            path = argv[i + 1];
+        }
+    }
+    const bool generated = path.empty();
+    if (generated) {
+        path = dir + "/file-read-bench.pcap";
+        Bench::writeCapture(path, megabytes * 1024 * 1024);
+    }
+    const double fileMb = std::filesystem::file_size(path) / 1e6;
+    std::printf("%s, %.1f MB\n", path.c_str(), fileMb);
+
+    const bool canDrop = dropCache(path);
+    if (!canDrop) {
+        std::printf("无法清除页缓存, 只测热缓存\n");
+    }
+
+    const Pass reference = readFile(path, FileReadMode::Mmap);
+    int failures = 0;
+    for (FileReadMode mode : {FileReadMode::Mmap, FileReadMode::IoUring, FileReadMode::Buffered}) {
+        Pass pass;
+        std::printf("\n%s", modeName(mode));
+        if (canDrop) {
+            // 冷缓存每次先清缓存, 计时只包括读取和处理
+            std::vector<double> times;
+            for (int i = 0; i < repeats; ++i) {
+                dropCache(path);
+                const Bench::Clock::time_point start = Bench::Clock::now();
+                pass = readFile(path, mode);
+                times.push_back(Bench::elapsedMs(start));
+            }
+            std::sort(times.begin(), times.end());
+            if (pass.mode != mode) {
+                std::printf(" (实际使用%s)", modeName(pass.mode));
+            }
+            std::printf("\n");
+            Bench::report("  冷缓存", Bench::Result{times.front(), times[times.size() / 2], times.back()}, fileMb,
+                          "MB");
+        } else {
+            std::printf("\n");
+        }
+        readFile(path, mode); // 预热
+        const Bench::Result warm = Bench::run(repeats, [&]() { pass = readFile(path, mode); });
+        Bench::report("  热缓存", warm, fileMb, "MB");
+        if (pass.packets != reference.packets || pass.digest != reference.digest) {
+            std::printf("  交出的数据包与内存映射不一致!\n");
+            ++failures;
+        }
+    }
+    if (generated) {
+        std::remove(path.c_str());
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+// HTTP头部扫描的基准: 在模拟的TCP负载上比较 HttpScanner::scan (运行时选中的SIMD或标量实现)
+// 与逐行拷贝成字符串再解析的朴素做法, 并核对两者提取的字段一致。
+//
+//   HttpScannerBench [--payloads N] [--repeat R]
+//
+// 负载中约四成是浏览器式的请求, 三成是响应, 其余是TLS记录和随机二进制数据
+#include "BenchUtil.h"
+#include "HttpScanner.h"
+#include <cctype>
+#include <random>
+#include <string>
+
+namespace {
+
+// 朴素的扫描: 截取前8KB拷贝成字符串, 按 "\r\n" 拆成行, 头部名转成小写后比较
+struct NaiveResult
+{
+    bool isRequest = false;
+    std::string method;
+    std::string uri;
+    std::string host;
+    int statusCode = 0;
+    long long contentLength = -1;
+};
+
+std::string trimmed(const std::string &s)
+{
+    const std::size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    const std::size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool naiveScan(const std::uint8_t *data, std::size_t len, NaiveResult &out)
+{
+    out = NaiveResult();
+    if (len < 14) {
+        return false;
+    }
+    const std::string text(reinterpret_cast<const char *>(data), std::min<std::size_t>(len, 8192));
+    std::vector<std::string> lines;
+    std::size_t pos = 0;
+    for (;;) {
+        const std::size_t next = text.find('\n', pos);
+        if (next == std::string::npos) {
+            lines.push_back(text.substr(pos)); // 被截断的最后一行
+            break;
+        }
+        lines.push_back(text.substr(pos, next - pos));
+        pos = next + 1;
+    }
+    if (lines.size() < 2) {
+        return false; // 起始行必须完整
+    }
+
+    const std::string start = trimmed(lines[0]);
+    if (start.compare(0, 7, "HTTP/1.") == 0) {
+        if (start.size() < 12 || start[8] != ' ') {
+            return false;
+        }
+        for (std::size_t i = 9; i < 12; ++i) {
+            if (!std::isdigit(static_cast<unsigned char>(start[i]))) {
+                return false;
+            }
+        }
+        out.statusCode = std::stoi(start.substr(9, 3));
+    } else {
+        static const char *const methods[] = {"GET", "POST", "PUT", "DELETE", "HEAD",
+                                              "OPTIONS", "PATCH", "CONNECT", "TRACE"};
+        const std::size_t sp1 = start.find(' ');
+        const std::size_t sp2 = start.rfind(' ');
+        if (sp1 == std::string::npos || sp2 == sp1 || start.compare(sp2 + 1, 7, "HTTP/1.") != 0) {
+            return false;
+        }
+        const std::string method = start.substr(0, sp1);
+        if (std::find(std::begin(methods), std::end(methods), method) == std::end(methods)) {
+            return false;
+        }
+        out.isRequest = true;
+        out.method = method;
+        out.uri = start.substr(sp1 + 1, sp2 - sp1 - 1);
+    }
+
+    for (std::size_t i = 1; i < lines.size(); ++i) {
+        const std::string &line = lines[i];
+        if (line.empty() || line == "\r") {
+            break;
+        }
+        const std::size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, colon);
+        for (char &c : name) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        const std::string value = trimmed(line.substr(colon + 1));
+        if (out.isRequest && out.host.empty() && name == "host") {
+            out.host = value;
+        } else if (out.contentLength < 0 && name == "content-length") {
+            if (!value.empty() && value.size() < 19
+                && value.find_first_not_of("0123456789") == std::string::npos) {
+                out.contentLength = std::stoll(value);
+            }
+        }
+    }
+    return true;
+}
+
+bool sameFields(const HttpMetadata &a, const NaiveResult &b)
+{
+    return a.isRequest == b.isRequest && a.method == b.method && a.uri == b.uri && a.host == b.host
+           && a.statusCode == b.statusCode && a.contentLength == b.contentLength;
+}
+
+const char *const kUserAgents[] = {
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36",
+    "Mozilla/5.0 (X11; Linux x86_64; rv:121.0) Gecko/20100101 Firefox/121.0",
+    "curl/8.4.0",
+};
+
+std::string makeRequest(std::mt19937_64 &rng)
+{
+    static const char *const methods[] = {"GET", "GET", "GET", "POST", "HEAD"};
+    std::string uri = "/static/js/app." + std::to_string(rng() % 100000) + ".js";
+    if (rng() % 2 == 0) {
+        uri += "?v=" + std::to_string(rng()) + "&ts=12:30:00"; // URI中的冒号
+    }
+    std::string s = std::string(methods[rng() % 5]) + " " + uri + " HTTP/1.1\r\n";
+    s += "User-Agent: " + std::string(kUserAgents[rng() % 3]) + "\r\n";
+    s += "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n";
+    s += "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n";
+    s += "Accept-Encoding: gzip, deflate, br\r\n";
+    s += "Referer: https://www.example.com/index.html\r\n";
+    s += "Cookie: session=" + std::to_string(rng()) + "; theme=dark; lang=zh\r\n";
+    s += "Host: www" + std::to_string(rng() % 50) + ".example.com:8080\r\n";
+    if (rng() % 3 == 0) {
+        s += "Content-Length: " + std::to_string(rng() % 100000) + "\r\n";
+    }
+    s += "Connection: keep-alive\r\n\r\n";
+    return s;
+}
+
+std::string makeResponse(std::mt19937_64 &rng)
+{
+    static const char *const statuses[] = {"200 OK", "304 Not Modified", "404 Not Found", "502 Bad Gateway"};
+    std::string s = "HTTP/1.1 " + std::string(statuses[rng() % 4]) + "\r\n";
+    s += "Server: nginx/1.24.0\r\n";
+    s += "Date: Mon, 01 Jan 2024 12:00:00 GMT\r\n";
+    s += "Content-Type: text/html; charset=utf-8\r\n";
+    s += "Cache-Control: max-age=3600\r\n";
+    s += "ETag: \"" + std::to_string(rng()) + "\"\r\n";
+    s += "content-length: " + std::to_string(rng() % 1000000) + "\r\n\r\n";
+    s.append(static_cast<std::size_t>(rng() % 1200), 'x'); // 同一个段里的正文
+    return s;
+}
+
+std::string makeOther(std::mt19937_64 &rng)
+{
+    std::string s;
+    const std::size_t len = 64 + rng() % 1400;
+    if (rng() % 2 == 0) {
+        s = "\x16\x03\x01"; // TLS握手记录
+    }
+    while (s.size() < len) {
+        s.push_back(static_cast<char>(rng()));
+    }
+    return s;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::size_t payloads = static_cast<std::size_t>(Bench::option(argc, argv, "--payloads", 200000));
+    const int repeats = static_cast<int>(Bench::option(argc, argv, "--repeat", 5));
+
+    // 所有负载放在同一块缓冲区里, 与抓包缓冲区中的数据包一样首尾相接
+    std::mt19937_64 rng(1);
+    std::string buffer;
+    std::vector<std::pair<std::size_t, std::size_t>> spans;
+    for (std::size_t i = 0; i < payloads; ++i) {
+        const unsigned kind = static_cast<unsigned>(rng() % 10);
+        const std::string payload = kind < 4 ? makeRequest(rng) : kind < 7 ? makeResponse(rng) : makeOther(rng);
+        spans.emplace_back(buffer.size(), payload.size());
+        buffer += payload;
+    }
+    const auto *base = reinterpret_cast<const std::uint8_t *>(buffer.data());
+    std::printf("HttpScanner 实现: %s, %zu 个负载, 共 %.1f MB\n", HttpScanner::implementationName(), payloads,
+                buffer.size() / 1e6);
+
+    std::size_t mismatches = 0;
+    std::size_t http = 0;
+    for (const auto &span : spans) {
+        HttpMetadata fast;
+        NaiveResult naive;
+        const bool a = HttpScanner::scan(base + span.first, span.second, fast);
+        const bool b = naiveScan(base + span.first, span.second, naive);
+        http += a ? 1 : 0;
+        if (a != b || (a && !sameFields(fast, naive))) {
+            ++mismatches;
+        }
+    }
+    std::printf("识别为HTTP %zu 个, 与朴素扫描不一致 %zu 个\n\n", http, mismatches);
+
+    const Bench::Result fast = Bench::run(repeats, [&]() {
+        std::size_t found = 0;
+        HttpMetadata out;
+        for (const auto &span : spans) {
+            found += HttpScanner::scan(base + span.first, span.second, out) ? 1 : 0;
+        }
+        Bench::keep(found);
+    });
+    Bench::report("HttpScanner::scan", fast, static_cast<double>(payloads), "负载");
+
+    const Bench::Result naive = Bench::run(repeats, [&]() {
+        std::size_t found = 0;
+        NaiveResult out;
+        for (const auto &span : spans) {
+            found += naiveScan(base + span.first, span.second, out) ? 1 : 0;
+        }
+        Bench::keep(found);
+    });
+    Bench::report("朴素扫描 (逐行拷贝)", naive, static_cast<double>(payloads), "负载");
+    std::printf("\n加速比 %.1fx\n", naive.medianMs / fast.medianMs);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+// 结果表排序的基准: 在 1M/10M/50M 行上分别按时间、IPv4地址、端口和 (端口, 时间) 两个键排序,
+// 与对行号做 std::stable_sort 的做法比较, 并核对两者的结果一致。
+//
+//   RadixSortBench [--rows N] [--threads T] [--repeat R] [--no-baseline]
+//
+// 不给 --rows 时依次测 1M、10M、50M 行; 50M 行约需 2.5 GB 内存
+#include "BenchUtil.h"
+#include "RadixSort.h"
+#include <numeric>
+#include <random>
+
+namespace {
+
+using RadixSort::Key;
+
+// 与 ResultModel 中的比较规则相同: 按键的优先级逐个比较, 全部相同时保持行号顺序
+std::vector<std::uint32_t> baselineSort(const std::vector<Key> &keys, std::uint32_t rows)
+{
+    std::vector<std::uint32_t> order(rows);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&keys](std::uint32_t a, std::uint32_t b) {
+        for (const Key &key : keys) {
+            const std::uint64_t x = key.values[a];
+            const std::uint64_t y = key.values[b];
+            if (x != y) {
+                return key.descending ? x > y : x < y;
+            }
+        }
+        return false;
+    });
+    return order;
+}
+
+struct Case
+{
+    const char *name;
+    std::vector<Key> keys;
+};
+
+// 与抓包结果的取值分布相近: 一小时内的纳秒时间戳, IPv4映射地址 (高位全相同), 端口
+std::vector<Case> makeCases(std::uint32_t rows, std::mt19937_64 &rng)
+{
+    std::vector<Case> cases;
+    const std::uint64_t start = 1700000000ULL * 1000000000ULL;
+
+    Case time{"时间", std::vector<Key>(1)};
+    time.keys[0].values.resize(rows);
+    for (std::uint64_t &value : time.keys[0].values) {
+        value = start + rng() % 3600000000000ULL;
+    }
+    cases.push_back(std::move(time));
+
+    Case address{"IPv4地址 (两个字)", std::vector<Key>(2)};
+    address.keys[0].values.assign(rows, 0);
+    address.keys[1].values.resize(rows);
+    for (std::uint64_t &value : address.keys[1].values) {
+        value = 0x0000ffff00000000ULL | (rng() & 0xffffffffULL);
+    }
+    cases.push_back(std::move(address));
+
+    Case port{"端口 (降序)", std::vector<Key>(1)};
+    port.keys[0].descending = true;
+    port.keys[0].values.resize(rows);
+    for (std::uint64_t &value : port.keys[0].values) {
+        value = rng() % 4 == 0 ? rng() % 65536 : 443; // 大量相同的值, 检查稳定性
+    }
+    cases.push_back(std::move(port));
+
+    Case portTime{"端口, 时间", std::vector<Key>(2)};
+    portTime.keys[0].values.resize(rows);
+    portTime.keys[1].values.resize(rows);
+    for (std::uint32_t i = 0; i < rows; ++i) {
+        portTime.keys[0].values[i] = rng() % 16;
+        portTime.keys[1].values[i] = start + rng() % 3600000000000ULL;
+    }
+    cases.push_back(std::move(portTime));
+    return cases;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const long long rowsOption = Bench::option(argc, argv, "--rows", 0);
+    const int threads = static_cast<int>(Bench::option(argc, argv, "--threads", RadixSort::defaultThreads()));
+    const int repeats = static_cast<int>(Bench::option(argc, argv, "--repeat", 3));
+    const bool baseline = !Bench::flag(argc, argv, "--no-baseline");
+
+    std::vector<std::uint32_t> sizes = {1000000u, 10000000u, 50000000u};
+    if (rowsOption > 0) {
+        sizes = {static_cast<std::uint32_t>(rowsOption)};
+    }
+    std::printf("线程数 %d, 每项 %d 次\n", threads, repeats);
+
+    std::mt19937_64 rng(1);
+    int failures = 0;
+    for (std::uint32_t rows : sizes) {
+        std::printf("\n%u 行\n", rows);
+        std::vector<Case> cases = makeCases(rows, rng);
+        for (Case &c : cases) {
+            std::vector<std::uint32_t> order;
+            const Bench::Result radix = Bench::run(repeats, [&]() { RadixSort::sort(c.keys, rows, threads, order); });
+            Bench::report((std::string("基数排序 ") + c.name).c_str(), radix, rows, "行");
+            if (!baseline) {
+                continue;
+            }
+            std::vector<std::uint32_t> expected;
+            // 比较排序在大数据量上很慢, 只跑一次
+            const Bench::Result reference = Bench::run(1, [&]() { expected = baselineSort(c.keys, rows); });
+            Bench::report((std::string("std::stable_sort ") + c.name).c_str(), reference, rows, "行");
+            if (order != expected) {
+                std::printf("  结果不一致!\n");
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
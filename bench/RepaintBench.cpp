@@ -0,0 +1,190 @@
+// 结果表重绘的基准: 与分析页相同的 QTableView + ResultModel + ResultFilterProxy, 按分析引擎的批量
+// 追加行并跟随到表尾, 每批之后处理事件让视图重绘一帧, 测出帧率。比较三种着色方式:
+//   样式表        表格祖先上设样式表, 默认委托 (改成调色板之前的做法)
+//   代理样式      调色板和 AppStyle::styleDataView 的代理样式, 默认委托
+//   RowDelegate   调色板和代理样式, 单元格由 RowDelegate 直接绘制 (分析页现在的做法)
+// 追加完之后再对静止的表格连续强制重绘, 单独看绘制可见单元格的开销。
+//
+//   RepaintBench [--rows N] [--batch B] [--width W] [--height H]
+//
+// 没有设置 QT_QPA_PLATFORM 时使用 offscreen 平台, 只包括Qt自己的光栅绘制;
+// 设为 xcb 或 windows 可以在真实窗口上测, 结果还包括把窗口内容送到屏幕的时间
+#include "AppStyle.h"
+#include "BenchUtil.h"
+#include "ResultModel.h"
+#include "RowDelegate.h"
+#include <QApplication>
+#include <QHeaderView>
+#include <QTableView>
+#include <QVBoxLayout>
+#include <random>
+
+namespace {
+
+// 改成调色板之前主窗口样式表中作用于分析页和数据表格的规则
+const char *const kSheetRules = R"(
+    QWidget#page, QWidget#page QWidget {
+        background-color: #f5f5f5;
+    }
+    QTableView#dataTable { gridline-color: #d0d0d0; }
+    QTableView#dataTable QHeaderView::section {
+        background-color: #ecf0f1;
+        font-weight: bold;
+    }
+)";
+
+enum class Styling { Sheet, ProxyStyle, Delegate };
+
+const char *stylingName(Styling styling)
+{
+    switch (styling) {
+    case Styling::Sheet: return "样式表";
+    case Styling::ProxyStyle: return "代理样式";
+    case Styling::Delegate: return "RowDelegate";
+    }
+    return "";
+}
+
+// 模拟的几类流量: 目的端口、传输层协议、应用协议和流量类型
+struct Kind
+{
+    quint16 port;
+    quint8 l4Proto;
+    AppProtocol app;
+    const char *type;
+};
+
+const Kind kKinds[] = {
+    {80, 6, AppProtocol::Http, nullptr}, // 流量类型是HTTP请求的描述
+    {443, 6, AppProtocol::Https, "加密网页"},
+    {53, 17, AppProtocol::Dns, "域名解析"},
+    {21, 6, AppProtocol::Ftp, "文件传输"},
+    {22, 6, AppProtocol::Ssh, "远程登录"},
+    {8443, 6, AppProtocol::None, "其他"},
+};
+
+// 模拟分析引擎交出的结果行: 时间递增, 地址和端口随机, 一半的行带目的地址的地理信息
+QVector<QVector<ResultRow>> makeBatches(int rows, int batchRows)
+{
+    static const char *const kCountries[] = {"CN", "US", "JP", "DE"};
+    std::mt19937_64 rng(1);
+    QVector<QVector<ResultRow>> batches;
+    quint64 tsNs = 1700000000ull * 1000000000ull;
+    for (int done = 0; done < rows;) {
+        QVector<ResultRow> batch;
+        for (int i = 0; i < batchRows && done < rows; ++i, ++done) {
+            const Kind &kind = kKinds[rng() % (sizeof(kKinds) / sizeof(kKinds[0]))];
+            ResultRow row;
+            tsNs += 1000 + rng() % 200000;
+            row.tsNs = tsNs;
+            row.srcIp = IpAddress::fromV4(0x0a000000u | static_cast<quint32>(rng() % 65536));
+            row.dstIp = IpAddress::fromV4(0xc0a80000u | static_cast<quint32>(rng() % 65536));
+            row.srcPort = static_cast<quint16>(30000 + rng() % 30000);
+            row.dstPort = kind.port;
+            row.l4Proto = kind.l4Proto;
+            row.app = kind.app;
+            if (rng() % 2 == 0) {
+                const char *country = kCountries[rng() % 4];
+                row.dstGeo.asn = static_cast<quint32>(4000 + rng() % 60000);
+                row.dstGeo.country[0] = country[0];
+                row.dstGeo.country[1] = country[1];
+            }
+            row.trafficType = kind.type != nullptr ? QString::fromUtf8(kind.type)
+                                                   : QString("GET www%1.example.com/index.html").arg(rng() % 50);
+            batch.append(row);
+        }
+        batches.append(batch);
+    }
+    return batches;
+}
+
+struct Frames
+{
+    Bench::Result streaming;
+    double streamingFps = 0;
+    Bench::Result still;
+};
+
+Frames measure(Styling styling, const QVector<QVector<ResultRow>> &batches, int width, int height)
+{
+    QWidget page;
+    page.setObjectName("page");
+    auto *layout = new QVBoxLayout(&page);
+    auto *model = new ResultModel(&page);
+    auto *proxy = new ResultFilterProxy(&page);
+    proxy->setSourceModel(model);
+
+    // 与分析页结果表的设置相同
+    auto *view = new QTableView();
+    view->setModel(proxy);
+    view->setSortingEnabled(true);
+    view->sortByColumn(ResultModel::ColTime, Qt::AscendingOrder);
+    view->setColumnHidden(ResultModel::ColSource, true);
+    view->horizontalHeader()->setStretchLastSection(true);
+    view->verticalHeader()->setDefaultSectionSize(22);
+    view->setAlternatingRowColors(true);
+    view->setSelectionBehavior(QAbstractItemView::SelectRows);
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    layout->addWidget(view);
+
+    if (styling == Styling::Sheet) {
+        view->setObjectName("dataTable");
+        page.setStyleSheet(kSheetRules);
+    } else {
+        AppStyle::setPageBackground(&page, QColor(0xf5, 0xf5, 0xf5));
+        AppStyle::styleDataView(view);
+        if (styling == Styling::Delegate) {
+            view->setItemDelegate(new RowDelegate(view));
+        }
+    }
+
+    page.resize(width, height);
+    page.show();
+    QApplication::processEvents();
+
+    // 每批追加后跟随到表尾, 可见行全部换掉; 处理事件时视图完成布局并重绘一帧
+    std::vector<double> times;
+    times.reserve(static_cast<std::size_t>(batches.size()));
+    const Bench::Clock::time_point streamStart = Bench::Clock::now();
+    for (const QVector<ResultRow> &batch : batches) {
+        const Bench::Clock::time_point start = Bench::Clock::now();
+        model->appendRows(batch);
+        view->scrollToBottom();
+        QApplication::processEvents();
+        times.push_back(Bench::elapsedMs(start));
+    }
+    const double streamMs = Bench::elapsedMs(streamStart);
+    std::sort(times.begin(), times.end());
+
+    Frames frames;
+    frames.streaming = Bench::Result{times.front(), times[times.size() / 2], times.back()};
+    frames.streamingFps = times.size() / (streamMs / 1000.0);
+    frames.still = Bench::run(200, [&]() { view->viewport()->repaint(); });
+    return frames;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    const int rows = static_cast<int>(Bench::option(argc, argv, "--rows", 100000));
+    const int batchRows = static_cast<int>(Bench::option(argc, argv, "--batch", 512));
+    const int width = static_cast<int>(Bench::option(argc, argv, "--width", 1280));
+    const int height = static_cast<int>(Bench::option(argc, argv, "--height", 720));
+
+    const QVector<QVector<ResultRow>> batches = makeBatches(rows, batchRows);
+    std::printf("平台 %s, 窗口 %dx%d, %d 行, 每批 %d 行, 共 %d 帧\n", qPrintable(QApplication::platformName()),
+                width, height, rows, batchRows, batches.size());
+
+    for (Styling styling : {Styling::Sheet, Styling::ProxyStyle, Styling::Delegate}) {
+        const Frames frames = measure(styling, batches, width, height);
+        std::printf("\n%s: 追加过程中平均 %.1f 帧/s\n", stylingName(styling), frames.streamingFps);
+        Bench::report("  追加一批并重绘", frames.streaming, 1, "帧");
+        Bench::report("  静止时强制重绘", frames.still, 1, "帧");
+    }
+    return 0;
+}
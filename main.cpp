@@ -1,12 +1,28 @@
 #include <QApplication>
+#include <QTimer>
+#include <cstring>
 #include "MainWindow.h"
+#include "StartupTrace.h"
 
 int main(int argc, char *argv[])
 {
+    // 在创建 QApplication 之前检查, 这样它本身的耗时也计入启动时间
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--startup-trace") == 0) {
+            StartupTrace::enable();
+        }
+    }
+
     QApplication app(argc, argv);
+    StartupTrace::mark("QApplication");
 
     MainWindow window;
     window.show();
+    StartupTrace::mark("显示主窗口");
+    // 事件循环开始后的第一个空闲点, 此时窗口已经可以响应操作
+    QTimer::singleShot(0, &window, []() {
+        StartupTrace::mark("进入事件循环");
+    });
 
     return QApplication::exec();
 }
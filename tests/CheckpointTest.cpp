@@ -0,0 +1,355 @@
+// 检查点的读写: 完整段加增量段合并后与分析状态一致、尾部写了一半的段被忽略、
+// 写入失败后下一段改写完整状态、增量积累到上限后改写完整段、第一段损坏时拒绝整个文件
+#include "Checkpoint.h"
+#include "MemoryBudget.h"
+#include "TestUtil.h"
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace {
+
+constexpr std::uint64_t kSecondNs = 1000000000ull;
+
+// 分析线程持有的、会写进检查点的状态
+struct LiveState
+{
+    LiveState()
+    {
+        stats.sources.resize(1);
+        stats.sources[0].name = "in0";
+        stats.sources[0].bytes = 999;
+        flows.setChangeTracking(true);
+        scanSources.setChangeTracking(true);
+        scanTargets.setChangeTracking(true);
+    }
+
+    FlowTable flows{60 * kSecondNs, 300 * kSecondNs};
+    ScanStateTable scanSources{64};
+    ScanStateTable scanTargets{64};
+    ThroughputHistory history;
+    QVector<ThroughputSample> pendingSamples; // 上一段以来结束的整秒
+    qint64 second = 1000;
+    TrafficStats stats;
+    std::uint64_t nowNs = 1000 * kSecondNs;
+    std::uint8_t addresses[1024][4] = {};
+};
+
+DecodedPacket makePacket(LiveState &live, int client, bool reply)
+{
+    static std::uint8_t server[4] = {192, 168, 1, 1};
+    std::uint8_t *address = live.addresses[client];
+    address[0] = 10;
+    address[2] = static_cast<std::uint8_t>(client >> 8);
+    address[3] = static_cast<std::uint8_t>(client);
+
+    DecodedPacket pkt;
+    pkt.tsNs = live.nowNs + static_cast<std::uint64_t>(client);
+    pkt.wireLen = static_cast<std::uint32_t>(100 + client);
+    pkt.ipVersion = 4;
+    pkt.l4Proto = 6;
+    pkt.srcAddr = reply ? server : address;
+    pkt.dstAddr = reply ? address : server;
+    pkt.srcPort = static_cast<std::uint16_t>(reply ? 443 : 40000 + client);
+    pkt.dstPort = static_cast<std::uint16_t>(reply ? 40000 + client : 443);
+    pkt.tcpFlags = 0x10;
+    return pkt;
+}
+
+// clients 个客户端各发一个包, 然后推进 seconds 秒并过期空闲的流
+void advance(LiveState &live, int firstClient, int clients, int seconds, bool reply = false)
+{
+    for (int client = firstClient; client < firstClient + clients; ++client) {
+        bool fromInitiator = false;
+        live.flows.update(makePacket(live, client, reply && (client & 1)), fromInitiator);
+        ++live.stats.total;
+        ++live.stats.tcp;
+    }
+    for (int i = 0; i < clients / 2; ++i) {
+        bool created = false;
+        live.scanSources.acquire(IpAddress::fromV4(static_cast<std::uint32_t>(firstClient + i)), created).syns += 1;
+        live.scanTargets.acquire(IpAddress::fromV4(static_cast<std::uint32_t>(firstClient * 7 + i)), created).completed += 2;
+    }
+    for (int i = 0; i < seconds; ++i) {
+        ThroughputSample sample;
+        sample.second = live.second++;
+        sample.bytes[0] = static_cast<quint64>(sample.second) * 3;
+        sample.packets[0] = static_cast<quint64>(sample.second);
+        live.history.append(sample);
+        live.pendingSamples.append(sample);
+    }
+    live.nowNs += static_cast<std::uint64_t>(seconds) * kSecondNs;
+    QVector<FlowSummary> expired;
+    live.flows.expire(live.nowNs, expired, 100000);
+}
+
+// 与分析线程相同的方式收集一段
+std::unique_ptr<CheckpointSegment> collect(LiveState &live, bool full)
+{
+    auto segment = std::make_unique<CheckpointSegment>();
+    segment->full = full;
+    segment->source = "capture.pcap";
+    segment->stats = live.stats;
+    segment->lastPacketNs = live.nowNs;
+    segment->tcpVariance = 1.5;
+    segment->haveSecond = true;
+    segment->currentSecond.second = live.second;
+    segment->groupTraffic.groups = QStringList{"office", "servers"};
+    segment->groupTraffic.bytes.fill(3, 4);
+    segment->groupTraffic.packets.fill(5, 4);
+    live.flows.takeChanges(full, segment->flows, segment->removedFlows);
+    live.scanSources.takeChanges(full, segment->scanSourceSlots, segment->scanSourceEntries);
+    live.scanTargets.takeChanges(full, segment->scanTargetSlots, segment->scanTargetEntries);
+    segment->scanSourceState = live.scanSources.state();
+    segment->scanTargetState = live.scanTargets.state();
+    if (full) {
+        live.history.save(segment->history);
+    } else {
+        segment->samples = live.pendingSamples;
+    }
+    live.pendingSamples.clear();
+    return segment;
+}
+
+bool writeSegment(CheckpointWriter &writer, LiveState &live)
+{
+    CHECK(!writer.isBusy());
+    const bool submitted = writer.submit(collect(live, writer.wantsFull()));
+    writer.waitIdle();
+    return submitted && writer.errorString().isEmpty();
+}
+
+std::map<std::string, std::string> flowImages(const std::vector<FlowSnapshot> &flows)
+{
+    std::map<std::string, std::string> images;
+    for (const FlowSnapshot &flow : flows) {
+        images[std::string(reinterpret_cast<const char *>(&flow.key), sizeof(FlowKey))] =
+            std::string(reinterpret_cast<const char *>(&flow), sizeof(FlowSnapshot));
+    }
+    return images;
+}
+
+void checkScanTable(ScanStateTable &live, const ScanTableState &savedState, const std::vector<ScanEntry> &savedEntries)
+{
+    ScanStateTable restored(64);
+    CHECK(restored.restore(savedState, savedEntries));
+    std::vector<std::uint32_t> liveSlots;
+    std::vector<std::uint32_t> restoredSlots;
+    std::vector<ScanEntry> liveEntries;
+    std::vector<ScanEntry> restoredEntries;
+    live.takeChanges(true, liveSlots, liveEntries);
+    restored.takeChanges(true, restoredSlots, restoredEntries);
+    CHECK(liveSlots == restoredSlots);
+    if (liveEntries.size() != restoredEntries.size()) {
+        CHECK(liveEntries.size() == restoredEntries.size());
+        return;
+    }
+    for (std::size_t i = 0; i < liveEntries.size(); ++i) {
+        CHECK(liveEntries[i].address == restoredEntries[i].address);
+        CHECK(liveEntries[i].syns == restoredEntries[i].syns);
+        CHECK(liveEntries[i].completed == restoredEntries[i].completed);
+    }
+    CHECK(live.state().used == restored.state().used);
+    CHECK(live.state().hand == restored.state().hand);
+    CHECK(live.state().evicted == restored.state().evicted);
+    // 重建的散列链能找到每个地址
+    for (const ScanEntry &entry : liveEntries) {
+        bool created = true;
+        restored.acquire(entry.address, created);
+        CHECK(!created);
+    }
+}
+
+// 读出文件与分析状态比较。会取走全部变化标记, 之后应当写完整段
+void checkMatches(LiveState &live, const QString &path, int segments)
+{
+    CheckpointState state;
+    QString error;
+    if (!CHECK(Checkpoint::load(path, state, &error))) {
+        std::printf("  %s\n", qPrintable(error));
+        return;
+    }
+    CHECK(state.segments == segments);
+    CHECK(state.source == "capture.pcap");
+    CHECK(state.stats.total == live.stats.total && state.stats.tcp == live.stats.tcp);
+    CHECK(state.stats.sources.size() == 1 && state.stats.sources[0].name == "in0"
+          && state.stats.sources[0].bytes == 999);
+    CHECK(state.lastPacketNs == live.nowNs && state.tcpVariance == 1.5);
+    CHECK(state.haveSecond && state.currentSecond.second == live.second);
+    CHECK(state.groupTraffic.groups.size() == 2 && state.groupTraffic.bytes[3] == 3
+          && state.groupTraffic.packets[2] == 5);
+
+    std::vector<FlowSnapshot> liveFlows;
+    std::vector<FlowKey> removed;
+    live.flows.takeChanges(true, liveFlows, removed);
+    CHECK(flowImages(liveFlows) == flowImages(state.flows));
+    FlowTable restored(60 * kSecondNs, 300 * kSecondNs);
+    for (const FlowSnapshot &flow : state.flows) {
+        CHECK(restored.restore(flow));
+    }
+    std::vector<FlowSnapshot> restoredFlows;
+    restored.takeChanges(true, restoredFlows, removed);
+    CHECK(flowImages(restoredFlows) == flowImages(liveFlows));
+
+    checkScanTable(live.scanSources, state.scanSourceState, state.scanSources);
+    checkScanTable(live.scanTargets, state.scanTargetState, state.scanTargets);
+
+    CHECK(state.history.oldest() == live.history.oldest() && state.history.newest() == live.history.newest());
+    std::vector<std::uint8_t> liveHistory;
+    std::vector<std::uint8_t> restoredHistory;
+    live.history.save(liveHistory);
+    state.history.save(restoredHistory);
+    CHECK(liveHistory == restoredHistory);
+}
+
+class TempDir
+{
+public:
+    TempDir()
+        : dir(std::filesystem::temp_directory_path() / "checkpoint-test")
+    {
+        std::filesystem::remove_all(dir);
+    }
+    ~TempDir() { std::filesystem::remove_all(dir); }
+
+    QString file(const char *name) const { return QString::fromStdString((dir / name).string()); }
+
+private:
+    std::filesystem::path dir;
+};
+
+void testDeltaRoundTrip()
+{
+    TempDir dir;
+    const QString path = dir.file("round-trip.ckpt");
+    LiveState live;
+    advance(live, 0, 500, 100);
+
+    CheckpointWriter writer;
+    QString error;
+    CHECK(writer.open(path, &error));
+    CHECK(writer.wantsFull());
+    CHECK(writeSegment(writer, live));
+    CHECK(!writer.wantsFull());
+
+    // 每轮更新一部分旧流 (一半是回应方向)、新建一些流、过期空闲的流, 扫描表发生淘汰
+    for (int round = 0; round < 5; ++round) {
+        advance(live, round * 50, 60, 30, true);
+        advance(live, 500 + round * 20, 20, 0);
+        CHECK(!writer.wantsFull());
+        CHECK(writeSegment(writer, live));
+    }
+    writer.close();
+    checkMatches(live, path, 6);
+}
+
+void testTornTrailingSegment()
+{
+    TempDir dir;
+    const QString path = dir.file("torn.ckpt");
+    LiveState live;
+    advance(live, 0, 200, 10);
+
+    CheckpointWriter writer;
+    CHECK(writer.open(path));
+    CHECK(writeSegment(writer, live));
+    advance(live, 100, 50, 10);
+    CHECK(writeSegment(writer, live));
+    writer.close();
+
+    // 程序在追加下一段的中途退出: 只写出了段头的魔数和一部分内容
+    const std::string file = path.toStdString();
+    std::FILE *out = std::fopen(file.c_str(), "ab");
+    const std::uint32_t segmentMagic = 0x31474553;
+    char partial[100];
+    std::memset(partial, 0x53, sizeof(partial));
+    std::fwrite(&segmentMagic, sizeof(segmentMagic), 1, out);
+    std::fwrite(partial, 1, sizeof(partial), out);
+    std::fclose(out);
+    checkMatches(live, path, 2);
+
+    // 第一段损坏时没有可用的状态
+    std::FILE *io = std::fopen(file.c_str(), "r+b");
+    std::fseek(io, 200, SEEK_SET);
+    std::fputc(0x7f, io);
+    std::fclose(io);
+    CheckpointState state;
+    QString error;
+    CHECK(!Checkpoint::load(path, state, &error));
+    CHECK(!error.isEmpty());
+    CHECK(!Checkpoint::load(dir.file("missing.ckpt"), state));
+}
+
+void testFailedWriteFallsBackToFull()
+{
+    TempDir dir;
+    const QString path = dir.file("failed.ckpt");
+    LiveState live;
+    advance(live, 0, 300, 20);
+
+    CheckpointWriter writer;
+    CHECK(writer.open(path));
+    CHECK(writeSegment(writer, live));
+    advance(live, 0, 40, 5);
+    CHECK(writeSegment(writer, live));
+
+    // 检查点文件的位置被目录占住, 追加增量段失败
+    const std::string file = path.toStdString();
+    std::filesystem::remove(file);
+    std::filesystem::create_directory(file);
+    advance(live, 40, 40, 5);
+    CHECK(!writer.wantsFull());
+    CHECK(!writeSegment(writer, live));
+    CHECK(!writer.errorString().isEmpty());
+    CHECK(writer.wantsFull());
+
+    // 失败的那一段的变化已经取走, 恢复后靠完整段补上
+    std::filesystem::remove(file);
+    advance(live, 80, 40, 5);
+    CHECK(writer.wantsFull());
+    CHECK(writeSegment(writer, live));
+    CHECK(writer.errorString().isEmpty());
+    CHECK(!writer.wantsFull());
+    writer.close();
+    checkMatches(live, path, 1);
+}
+
+void testCompactionAfterMaxDeltas()
+{
+    TempDir dir;
+    const QString path = dir.file("compaction.ckpt");
+    LiveState live;
+    advance(live, 0, 500, 10);
+
+    CheckpointWriter writer;
+    CHECK(writer.open(path));
+    CHECK(writeSegment(writer, live));
+    for (int i = 0; i < CheckpointWriter::kMaxDeltas; ++i) {
+        CHECK(!writer.wantsFull());
+        advance(live, i * 10, 10, 1);
+        CHECK(writeSegment(writer, live));
+    }
+    CHECK(writer.wantsFull());
+
+    // 完整段替换整个文件, 之前的增量段不再保留
+    advance(live, 0, 10, 1);
+    CHECK(writeSegment(writer, live));
+    CHECK(!writer.wantsFull());
+    advance(live, 10, 10, 1);
+    CHECK(writeSegment(writer, live));
+    writer.close();
+    checkMatches(live, path, 2);
+}
+
+} // namespace
+
+int main()
+{
+    MemoryBudget::global().setLimit(1ull << 30);
+    Test::run("增量段往返", testDeltaRoundTrip);
+    Test::run("尾部写了一半的段", testTornTrailingSegment);
+    Test::run("写入失败后改写完整段", testFailedWriteFallsBackToFull);
+    Test::run("增量到上限后改写完整段", testCompactionAfterMaxDeltas);
+    return Test::failures() == 0 ? 0 : 1;
+}
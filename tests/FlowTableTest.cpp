@@ -0,0 +1,134 @@
+// 流表上的TLS拼接缓冲区计入内存预算: 拼接时记账, 放弃或流结束时归还, 预算用完时放弃拼接;
+// 活动超时分段导出后, 按流采样误差估计用的整条流包数继续累计
+#include "FlowTable.h"
+#include "TestUtil.h"
+#include <array>
+#include <vector>
+
+namespace {
+
+std::uint8_t gServer[4] = {192, 168, 1, 1};
+
+std::uint64_t flowBytes()
+{
+    return MemoryBudget::global().snapshot().categories[MemoryBudget::Flows].bytes;
+}
+
+// 只有开头一段的ClientHello: 记录声明 16000 字节, 实际只带 length 字节
+std::vector<std::uint8_t> partialHello(std::size_t length)
+{
+    std::vector<std::uint8_t> payload(length, 0);
+    payload[0] = 0x16;
+    payload[1] = 0x03;
+    payload[2] = 0x01;
+    payload[3] = static_cast<std::uint8_t>(16000 >> 8);
+    payload[4] = static_cast<std::uint8_t>(16000 & 0xff);
+    payload[5] = 0x01;
+    return payload;
+}
+
+DecodedPacket clientPacket(const std::uint8_t *client, std::uint32_t seq, const std::vector<std::uint8_t> &payload)
+{
+    DecodedPacket pkt;
+    pkt.tsNs = 1000000000ull;
+    pkt.wireLen = static_cast<std::uint32_t>(54 + payload.size());
+    pkt.ipVersion = 4;
+    pkt.l4Proto = ProtoTcp;
+    pkt.srcAddr = client;
+    pkt.dstAddr = gServer;
+    pkt.srcPort = 40000;
+    pkt.dstPort = 443;
+    pkt.tcpFlags = 0x18;
+    pkt.tcpSeq = seq;
+    pkt.payload = payload.data();
+    pkt.payloadLen = payload.size();
+    return pkt;
+}
+
+void testStashCharged()
+{
+    constexpr int kFlows = 200;
+    const std::vector<std::uint8_t> payload = partialHello(1000);
+    std::vector<std::array<std::uint8_t, 4>> clients(kFlows);
+    FlowTable table(60000000000ull, 300000000000ull);
+    std::vector<FlowRecord *> flows;
+    for (int i = 0; i < kFlows; ++i) {
+        clients[i] = {10, 0, static_cast<std::uint8_t>(i >> 8), static_cast<std::uint8_t>(i)};
+        bool fromInitiator = false;
+        flows.push_back(&table.update(clientPacket(clients[i].data(), 1, payload), fromInitiator));
+    }
+    const std::uint64_t withoutStash = flowBytes();
+    for (int i = 0; i < kFlows; ++i) {
+        FlowInspector::inspectTls(*flows[i], clientPacket(clients[i].data(), 1, payload), true);
+        CHECK(flows[i]->tlsState == TlsState::Pending && flows[i]->tlsStash.size() == payload.size());
+    }
+    CHECK(flowBytes() >= withoutStash + kFlows * payload.size());
+
+    // 一半的流有丢包而放弃, 拼接缓冲区归还
+    for (int i = 0; i < kFlows / 2; ++i) {
+        FlowInspector::inspectTls(*flows[i], clientPacket(clients[i].data(), 5000, payload), true);
+        CHECK(flows[i]->tlsState == TlsState::NotTls && flows[i]->tlsStash.capacity() == 0);
+    }
+    CHECK(flowBytes() < withoutStash + kFlows * payload.size());
+
+    // 其余的流随流表清空归还
+    table.clear();
+    CHECK(flowBytes() <= withoutStash);
+}
+
+void testBudgetExhausted()
+{
+    FlowTable table(60000000000ull, 300000000000ull);
+    std::uint8_t client[4] = {10, 1, 0, 1};
+    const std::vector<std::uint8_t> payload = partialHello(8000);
+    bool fromInitiator = false;
+    FlowRecord &flow = table.update(clientPacket(client, 1, payload), fromInitiator);
+
+    MemoryBudget &budget = MemoryBudget::global();
+    const std::uint64_t limit = budget.limit();
+    budget.setLimit(budget.used() + 4000);
+    const std::uint64_t before = flowBytes();
+    FlowInspector::inspectTls(flow, clientPacket(client, 1, payload), true);
+    CHECK(flow.tlsState == TlsState::NotTls);
+    CHECK(flow.tlsStash.capacity() == 0);
+    CHECK(flowBytes() == before);
+    budget.setLimit(limit);
+}
+
+void testSampledPacketsSurviveActiveTimeout()
+{
+    constexpr std::uint64_t kSecond = 1000000000ull;
+    FlowTable table(60 * kSecond, 2 * kSecond);
+    std::uint8_t client[4] = {10, 2, 0, 1};
+    const std::vector<std::uint8_t> payload(10, 0);
+    FlowRecord *flow = nullptr;
+    for (int i = 0; i < 3; ++i) {
+        DecodedPacket pkt = clientPacket(client, 1, payload);
+        pkt.tsNs = 10 * kSecond + static_cast<std::uint64_t>(i) * kSecond / 2;
+        bool fromInitiator = false;
+        flow = &table.update(pkt, fromInitiator, 4);
+    }
+    CHECK(flow->packets == 12 && flow->sampledPackets == 3);
+    CHECK(!table.isUntracked(*flow));
+
+    QVector<FlowSummary> out;
+    table.expire(13 * kSecond, out, 100);
+    CHECK(out.size() == 1 && out[0].reason == FlowEndReason::Active && out[0].packets == 12);
+    DecodedPacket pkt = clientPacket(client, 1, payload);
+    pkt.tsNs = 13 * kSecond;
+    bool fromInitiator = false;
+    FlowRecord &after = table.update(pkt, fromInitiator, 4);
+    CHECK(&after == flow);
+    CHECK(after.packets == 4 && after.sampledPackets == 4);
+}
+
+} // namespace
+
+int main()
+{
+    MemoryBudget::global().setLimit(1ull << 30);
+    Test::run("拼接缓冲区记账和归还", testStashCharged);
+    Test::run("预算用完时放弃拼接", testBudgetExhausted);
+    Test::run("活动超时后整条流的包数继续累计", testSampledPacketsSurviveActiveTimeout);
+    return Test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+// 分片的解码和重组: 首片短于TCP头部时仍然交给重组, 重组后的数据报解出端口和负载;
+// 不是分片的截断TCP包仍然解码失败
+#include "FragmentReassembler.h"
+#include "MemoryBudget.h"
+#include "TestUtil.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char kPayload[] = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+
+void putBe16(std::vector<std::uint8_t> &bytes, std::size_t offset, std::uint16_t value)
+{
+    bytes[offset] = static_cast<std::uint8_t>(value >> 8);
+    bytes[offset + 1] = static_cast<std::uint8_t>(value);
+}
+
+std::vector<std::uint8_t> tcpSegment()
+{
+    std::vector<std::uint8_t> tcp(20, 0);
+    putBe16(tcp, 0, 40000);
+    putBe16(tcp, 2, 80);
+    tcp[12] = 0x50;
+    tcp[13] = 0x18;
+    tcp.insert(tcp.end(), kPayload, kPayload + std::strlen(kPayload));
+    return tcp;
+}
+
+// 以太网帧, 承载 tcp 从 offset 开始的 length 字节; more 为还有后续分片
+std::vector<std::uint8_t> fragmentFrame(bool ipv6, const std::vector<std::uint8_t> &tcp, std::size_t offset,
+                                        std::size_t length, bool more)
+{
+    std::vector<std::uint8_t> frame(14, 0);
+    if (!ipv6) {
+        putBe16(frame, 12, 0x0800);
+        std::vector<std::uint8_t> ip(20, 0);
+        ip[0] = 0x45;
+        putBe16(ip, 2, static_cast<std::uint16_t>(20 + length));
+        putBe16(ip, 4, 77);
+        putBe16(ip, 6, static_cast<std::uint16_t>((more ? 0x2000 : 0) | (offset / 8)));
+        ip[8] = 64;
+        ip[9] = 6;
+        ip[12] = 10;
+        ip[15] = 1;
+        ip[16] = 10;
+        ip[19] = 2;
+        frame.insert(frame.end(), ip.begin(), ip.end());
+    } else {
+        putBe16(frame, 12, 0x86dd);
+        std::vector<std::uint8_t> ip(48, 0);
+        ip[0] = 0x60;
+        putBe16(ip, 4, static_cast<std::uint16_t>(8 + length));
+        ip[6] = 44; // 分片头
+        ip[7] = 64;
+        ip[23] = 1;
+        ip[39] = 2;
+        ip[40] = 6;
+        putBe16(ip, 42, static_cast<std::uint16_t>(offset | (more ? 1 : 0)));
+        ip[47] = 9;
+        frame.insert(frame.end(), ip.begin(), ip.end());
+    }
+    frame.insert(frame.end(), tcp.begin() + static_cast<std::ptrdiff_t>(offset),
+                 tcp.begin() + static_cast<std::ptrdiff_t>(offset + length));
+    return frame;
+}
+
+RawPacket rawPacket(const std::vector<std::uint8_t> &frame, std::uint64_t tsNs)
+{
+    RawPacket raw;
+    raw.data = frame.data();
+    raw.capLen = static_cast<std::uint32_t>(frame.size());
+    raw.origLen = raw.capLen;
+    raw.tsNs = tsNs;
+    return raw;
+}
+
+// 首片只带TCP头部的前8字节, 其余在第二片中
+void checkShortFirstFragment(bool ipv6)
+{
+    const std::vector<std::uint8_t> tcp = tcpSegment();
+    const std::vector<std::uint8_t> first = fragmentFrame(ipv6, tcp, 0, 8, true);
+    const std::vector<std::uint8_t> second = fragmentFrame(ipv6, tcp, 8, tcp.size() - 8, false);
+
+    FragmentReassembler reassembler(1 << 20);
+    DecodedPacket pkt;
+    DecodedPacket datagram;
+    CHECK(PacketDecoder::decode(rawPacket(first, 1000), pkt));
+    CHECK(pkt.isFragment && pkt.fragOffset == 0 && pkt.moreFragments);
+    CHECK(pkt.l4 == nullptr && pkt.srcPort == 0);
+    CHECK(reassembler.add(pkt, datagram) == FragmentReassembler::Result::Consumed);
+
+    CHECK(PacketDecoder::decode(rawPacket(second, 2000), pkt));
+    if (!CHECK(reassembler.add(pkt, datagram) == FragmentReassembler::Result::Completed)) {
+        return;
+    }
+    CHECK(datagram.l4Proto == ProtoTcp);
+    CHECK(datagram.srcPort == 40000 && datagram.dstPort == 80);
+    CHECK(datagram.payloadLen == std::strlen(kPayload)
+          && std::memcmp(datagram.payload, kPayload, datagram.payloadLen) == 0);
+}
+
+void testShortFirstFragmentIpv4()
+{
+    checkShortFirstFragment(false);
+}
+
+void testShortFirstFragmentIpv6()
+{
+    checkShortFirstFragment(true);
+}
+
+void testTruncatedTcpStillRejected()
+{
+    const std::vector<std::uint8_t> tcp = tcpSegment();
+    std::vector<std::uint8_t> frame = fragmentFrame(false, tcp, 0, 8, false);
+    DecodedPacket pkt;
+    CHECK(!PacketDecoder::decode(rawPacket(frame, 1000), pkt));
+}
+
+} // namespace
+
+int main()
+{
+    MemoryBudget::global().setLimit(1ull << 30);
+    Test::run("IPv4首片短于TCP头部", testShortFirstFragmentIpv4);
+    Test::run("IPv6首片短于TCP头部", testShortFirstFragmentIpv6);
+    Test::run("不是分片的截断TCP包", testTruncatedTcpStillRejected);
+    return Test::failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+// 连续输出: 分析结束时流表一次导出的流多于输出端队列上限时仍然全部写出, 不计为丢弃
+#include "FlowTable.h"
+#include "OutputSink.h"
+#include "TestUtil.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+constexpr int kFlows = 3000;
+constexpr quint32 kQueueRecords = 1000;
+
+// 与分析结束时相同: 流表里的流全部导出
+QVector<FlowSummary> drainFlows()
+{
+    FlowTable table(60000000000ull, 300000000000ull);
+    std::uint8_t server[4] = {192, 168, 1, 1};
+    std::uint8_t client[4] = {10, 0, 0, 0};
+    for (int i = 0; i < kFlows; ++i) {
+        client[2] = static_cast<std::uint8_t>(i >> 8);
+        client[3] = static_cast<std::uint8_t>(i);
+        DecodedPacket pkt;
+        pkt.tsNs = 1000000000ull + static_cast<std::uint64_t>(i);
+        pkt.wireLen = 100;
+        pkt.ipVersion = 4;
+        pkt.l4Proto = ProtoUdp;
+        pkt.srcAddr = client;
+        pkt.dstAddr = server;
+        pkt.srcPort = 40000;
+        pkt.dstPort = 53;
+        bool fromInitiator = false;
+        table.update(pkt, fromInitiator);
+    }
+    QVector<FlowSummary> flows;
+    table.drain(flows);
+    return flows;
+}
+
+void checkFinalBatch(OutputDropPolicy policy)
+{
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "output-sink-test";
+    std::filesystem::remove_all(dir);
+
+    OutputSinkOptions options;
+    options.target = OutputTarget::File;
+    options.format = OutputFormat::Csv;
+    options.path = QString::fromStdString(dir.string());
+    options.records = OutputFlows;
+    options.queueRecords = kQueueRecords;
+    options.dropPolicy = policy;
+
+    const QVector<FlowSummary> flows = drainFlows();
+    CHECK(flows.size() == kFlows);
+    OutputFanout fanout;
+    QString error;
+    QVector<OutputSinkOptions> sinks;
+    sinks.append(options);
+    if (!CHECK(fanout.open(sinks, &error))) {
+        std::printf("  %s\n", qPrintable(error));
+        return;
+    }
+    fanout.publish(QVector<ResultRow>(), flows, QVector<SecurityAlert>());
+    fanout.close();
+
+    const OutputSink::Stats stats = fanout.stats();
+    CHECK(stats.written == static_cast<std::uint64_t>(kFlows));
+    CHECK(stats.dropped == 0);
+
+    int lines = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+        std::ifstream in(entry.path());
+        std::string line;
+        while (std::getline(in, line)) {
+            lines += line.compare(0, 5, "flow,") == 0 ? 1 : 0;
+        }
+    }
+    CHECK(lines == kFlows);
+    std::filesystem::remove_all(dir);
+}
+
+void testFinalBatchDropNewest()
+{
+    checkFinalBatch(OutputDropPolicy::DropNewest);
+}
+
+void testFinalBatchDropOldest()
+{
+    checkFinalBatch(OutputDropPolicy::DropOldest);
+}
+
+} // namespace
+
+int main()
+{
+    MemoryBudget::global().setLimit(1ull << 30);
+    Test::run("超过队列上限的最后一批 (丢弃最新)", testFinalBatchDropNewest);
+    Test::run("超过队列上限的最后一批 (丢弃最早)", testFinalBatchDropOldest);
+    return Test::failures() == 0 ? 0 : 1;
+}
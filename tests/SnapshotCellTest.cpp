@@ -0,0 +1,118 @@
+// SnapshotCell 的并发压力测试: 10个读方 (超过 kMaxReaders, 其中两个退回加锁复制) 不断读取,
+// 写方连续发布2万个快照。读方拿到的快照在下一次 acquire 之前必须一直完整, 版本不能倒退,
+// 所有快照最终都要释放。用 -fsanitize=thread 或 address 构建时还能发现数据竞争和释放后读取
+#include "SnapshotCell.h"
+#include "TestUtil.h"
+#include <thread>
+
+namespace {
+
+// 析构时改写内容, 读方读到已释放的快照时不变式被破坏
+struct Config
+{
+    Config() = default;
+    Config(long version, std::atomic<int> *live)
+        : version(version)
+        , negated(-version)
+        , live(live)
+    {
+        ++*live;
+    }
+    Config(const Config &other)
+        : version(other.version)
+        , negated(other.negated)
+        , live(other.live)
+    {
+        if (live != nullptr) {
+            ++*live;
+        }
+    }
+    ~Config()
+    {
+        if (live != nullptr) {
+            --*live;
+        }
+        version = 12345;
+        negated = 12345;
+    }
+
+    long version = 0;
+    long negated = 0;
+    std::atomic<int> *live = nullptr;
+};
+
+void testConcurrentPublish()
+{
+    constexpr int kReaders = 10;
+    constexpr long kPublishes = 20000;
+    std::atomic<int> live{0};
+    std::atomic<long> violations{0};
+    std::atomic<long> reads{0};
+    {
+        SnapshotCell<Config> cell(std::make_unique<const Config>(1, &live));
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> readers;
+        for (int r = 0; r < kReaders; ++r) {
+            readers.emplace_back([&]() {
+                SnapshotCell<Config>::Reader reader(cell);
+                const Config *config = &reader.acquire();
+                long last = 0;
+                while (!stop.load()) {
+                    for (int i = 0; i < 100; ++i) {
+                        if (config->version != -config->negated || config->version < last) {
+                            ++violations;
+                        }
+                    }
+                    last = config->version;
+                    if (reader.stale()) {
+                        config = &reader.acquire();
+                    }
+                    ++reads;
+                }
+            });
+        }
+        for (long version = 2; version <= kPublishes; ++version) {
+            cell.publish(std::make_unique<const Config>(version, &live));
+        }
+        stop = true;
+        for (std::thread &reader : readers) {
+            reader.join();
+        }
+    }
+    CHECK(violations.load() == 0);
+    CHECK(reads.load() > 0);
+    CHECK(live.load() == 0);
+}
+
+void testReclaim()
+{
+    std::atomic<int> live{0};
+    SnapshotCell<Config> cell(std::make_unique<const Config>(1, &live));
+    // 没有读方时每次发布都回收上一个
+    for (long version = 2; version <= 100; ++version) {
+        cell.publish(std::make_unique<const Config>(version, &live));
+    }
+    CHECK(live.load() == 1);
+
+    // 读方持有的快照在它再次 acquire 之前不释放
+    SnapshotCell<Config>::Reader reader(cell);
+    reader.acquire();
+    cell.publish(std::make_unique<const Config>(101, &live));
+    cell.publish(std::make_unique<const Config>(102, &live));
+    CHECK(live.load() == 3);
+    CHECK(reader.stale());
+    CHECK(reader.get().version == 100);
+    reader.acquire();
+    CHECK(!reader.stale());
+    cell.publish(std::make_unique<const Config>(103, &live));
+    CHECK(live.load() == 2);
+}
+
+} // namespace
+
+int main()
+{
+    Test::run("10个读方和2万次发布", testConcurrentPublish);
+    Test::run("快照回收", testReclaim);
+    return Test::failures() == 0 ? 0 : 1;
+}
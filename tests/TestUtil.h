@@ -0,0 +1,38 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <cstdio>
+
+// 单元测试共用的检查。不用 assert, Release 构建下检查也照常进行; 失败时打印位置并继续,
+// main 以失败个数作为返回值
+namespace Test {
+
+inline int &failures()
+{
+    static int count = 0;
+    return count;
+}
+
+inline bool check(bool ok, const char *expression, const char *file, int line)
+{
+    if (!ok) {
+        std::printf("%s:%d: 检查失败: %s\n", file, line, expression);
+        ++failures();
+    }
+    return ok;
+}
+
+// 运行一个测试函数并打印名字, 便于在 ctest 输出中定位
+template<typename Fn>
+void run(const char *name, Fn &&fn)
+{
+    const int before = failures();
+    fn();
+    std::printf("%s %s\n", failures() == before ? "通过" : "失败", name);
+}
+
+} // namespace Test
+
+#define CHECK(condition) Test::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#endif // TESTUTIL_H